@@ -0,0 +1,355 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include "thirdparty/perfevent/PerfEvent.hpp"
+#include "version.h"
+
+#include <dtl/dtl.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Shared infrastructure of the unified benchmark driver (teb_bench): options,
+// data generation, timing, perf counters and the JSON result format.
+//===----------------------------------------------------------------------===//
+namespace bench {
+//===----------------------------------------------------------------------===//
+/// The command line options of the benchmark driver.
+struct options {
+  /// The workloads to run.
+  std::vector<std::string> workloads;
+  /// The codecs under test. Empty refers to the default set of codecs.
+  std::vector<std::string> codecs;
+  /// The length of the generated bitmaps.
+  $u64 n = 1ull << 20;
+  /// The bit densities of the generated bitmaps.
+  std::vector<$f64> densities = { 0.001, 0.01, 0.1 };
+  /// The clustering factors of the generated bitmaps.
+  std::vector<$f64> clustering_factors = { 1.0, 8.0, 64.0 };
+  /// The number of samples per measurement.
+  $u64 reps = 10;
+  /// The minimum duration of a single sample. The measured function is invoked
+  /// repeatedly until this time is elapsed.
+  $u64 min_sample_nanos = 50000000; // 50ms
+  /// The seed of the random number generator. The generated data only depends
+  /// on the seed, which makes the results of different runs comparable.
+  $u64 seed = 42;
+  /// The number of random point lookups per invocation.
+  $u64 lookup_cnt = 1ull << 16;
+  /// The number of random point updates per sample.
+  $u64 update_cnt = 1ull << 12;
+  /// The distance between two consecutive skip targets.
+  $u64 skip_distance = 1ull << 10;
+  /// Record hardware counters (using PerfEvent).
+  $u1 perf = false;
+  /// The file where the results are written to. Empty refers to stdout.
+  std::string output;
+  /// The results file to read (compare only).
+  std::string input;
+  /// The baseline results to compare with. Empty disables the comparison.
+  std::string baseline;
+  /// The significance level of the regression test.
+  $f64 alpha = 0.01;
+  /// The minimum relative throughput change that is reported.
+  $f64 threshold = 0.05;
+  /// The minimum relative size change that is reported.
+  $f64 size_threshold = 0.01;
+};
+//===----------------------------------------------------------------------===//
+/// The input data of a single benchmark configuration.
+struct dataset {
+  $u64 n;
+  $f64 density;
+  $f64 clustering_factor;
+  /// The bitmap under test.
+  boost::dynamic_bitset<$u32> bs;
+  /// A second bitmap with the same parameters (used by binary operations).
+  boost::dynamic_bitset<$u32> bs2;
+  /// Random positions (used by point lookups and updates).
+  std::vector<$u32> positions;
+};
+//===----------------------------------------------------------------------===//
+/// The outcome of a single measurement, which is identified by the workload,
+/// the codec and the data parameters.
+struct result {
+  std::string workload;
+  std::string codec;
+  /// The name and parameters of the encoded bitmap in JSON (see info()).
+  std::string info;
+  $u64 n = 0;
+  $f64 density = 0.0;
+  $f64 clustering_factor = 0.0;
+  /// The size of the encoded bitmap in bytes.
+  $u64 size_in_bytes = 0;
+  /// The unit of work, e.g., 'bits' or 'lookups'.
+  std::string unit;
+  /// The units of work per invocation.
+  $f64 units = 0.0;
+  /// The throughput in units per second, one entry per sample. Empty, if the
+  /// workload is not timed.
+  std::vector<$f64> throughput;
+  /// Hardware counters per unit of work and derived metrics, e.g., the
+  /// overhead factor of type-erased iterators.
+  std::map<std::string, $f64> counters;
+  /// Prevents the compiler from optimizing away the measured code.
+  $u64 checksum = 0;
+
+  /// Returns the string that identifies the measurement across runs.
+  std::string
+  key() const {
+    return make_key(workload, codec, n, density, clustering_factor);
+  }
+
+  static std::string
+  make_key(const std::string& workload, const std::string& codec, u64 n,
+      f64 density, f64 clustering_factor) {
+    std::stringstream s;
+    s << workload << "/" << codec << "/n=" << n << "/d=" << density
+      << "/f=" << clustering_factor;
+    return s.str();
+  }
+};
+//===----------------------------------------------------------------------===//
+// Statistics
+//===----------------------------------------------------------------------===//
+static f64
+mean(const std::vector<$f64>& v) {
+  if (v.empty()) return 0.0;
+  $f64 sum = 0.0;
+  for (auto x : v) sum += x;
+  return sum / v.size();
+}
+//===----------------------------------------------------------------------===//
+/// Returns the (unbiased) sample variance.
+static f64
+variance(const std::vector<$f64>& v) {
+  if (v.size() < 2) return 0.0;
+  const auto m = mean(v);
+  $f64 sum = 0.0;
+  for (auto x : v) sum += (x - m) * (x - m);
+  return sum / (v.size() - 1);
+}
+//===----------------------------------------------------------------------===//
+static f64
+stddev(const std::vector<$f64>& v) {
+  return std::sqrt(variance(v));
+}
+//===----------------------------------------------------------------------===//
+// Data generation
+//===----------------------------------------------------------------------===//
+/// Generates a random bitmap of length n using a two-state Markov process with
+/// the bit density d and the clustering factor f (the average length of
+/// 1-runs). Unlike the generators in experiments/util, the result only
+/// depends on the given seed.
+static boost::dynamic_bitset<$u32>
+gen_bitmap(u64 n, f64 d, f64 f, u64 seed) {
+  if (d < 0.0 || d > 1.0 || f < 1.0 || (d < 1.0 && f < d / (1.0 - d))) {
+    throw std::invalid_argument(
+        "Invalid parameters for the Markov process: n="
+        + std::to_string(n) + ", f=" + std::to_string(f) + ", d="
+        + std::to_string(d));
+  }
+  boost::dynamic_bitset<$u32> bs(n);
+  if (d == 0.0) return bs;
+  if (d == 1.0) {
+    bs.set();
+    return bs;
+  }
+  // The transition probabilities 1 -> 0 and 0 -> 1.
+  f64 p = 1.0 / f;
+  f64 q = d * p / (1.0 - d);
+  std::mt19937_64 gen(seed);
+  std::uniform_real_distribution<$f64> dis(0.0, 1.0);
+  $u1 state = dis(gen) < d;
+  for (std::size_t i = 0; i < n; ++i) {
+    bs[i] = state;
+    state = state ? dis(gen) >= p : dis(gen) < q;
+  }
+  return bs;
+}
+//===----------------------------------------------------------------------===//
+/// Generates the input data for the given parameters.
+static dataset
+gen_dataset(const options& o, f64 d, f64 f) {
+  dataset ds;
+  ds.n = o.n;
+  ds.density = d;
+  ds.clustering_factor = f;
+  // Derive the seeds from the parameters, so that the data of a configuration
+  // does not depend on which other configurations are part of the run.
+  const auto seed = o.seed
+      ^ (std::hash<$f64>()(d) * 31 + std::hash<$f64>()(f));
+  ds.bs = gen_bitmap(o.n, d, f, seed);
+  ds.bs2 = gen_bitmap(o.n, d, f, seed + 1);
+  std::mt19937_64 gen(seed + 2);
+  std::uniform_int_distribution<$u32> dis(0, static_cast<$u32>(o.n - 1));
+  ds.positions.resize(std::max(o.lookup_cnt, o.update_cnt));
+  for (auto& p : ds.positions) p = dis(gen);
+  return ds;
+}
+//===----------------------------------------------------------------------===//
+// Timing
+//===----------------------------------------------------------------------===//
+static u64
+now_nanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+//===----------------------------------------------------------------------===//
+/// Records the hardware counters, if enabled.
+class perf_counters {
+  std::unique_ptr<PerfEvent> e_;
+
+public:
+  explicit perf_counters(u1 enabled)
+      : e_(enabled ? new PerfEvent() : nullptr) {}
+
+  void
+  start() {
+    if (e_) e_->startCounters();
+  }
+
+  void
+  stop() {
+    if (e_) e_->stopCounters();
+  }
+
+  /// Writes the counter values, normalized by the given number of units, to
+  /// the result.
+  void
+  report(result& r, f64 units) {
+    if (!e_) return;
+    for (const auto& name : e_->names) {
+      r.counters[name] = e_->getCounter(name) / units;
+    }
+  }
+};
+//===----------------------------------------------------------------------===//
+/// Invokes the given function repeatedly and records the throughput of each
+/// sample in the result. The function needs to return a value which is
+/// accumulated in the checksum. The number of units of work per invocation
+/// needs to be set in the result.
+template<typename Fn>
+static void __attribute__((noinline))
+measure(const options& o, Fn&& fn, result& r) {
+  // Warm up.
+  r.checksum += fn();
+
+  perf_counters perf(o.perf);
+  $u64 total_invocation_cnt = 0;
+  perf.start();
+  for (std::size_t rep = 0; rep < o.reps; ++rep) {
+    $u64 invocation_cnt = 0;
+    const auto nanos_begin = now_nanos();
+    $u64 nanos_end = nanos_begin;
+    do {
+      r.checksum += fn();
+      ++invocation_cnt;
+      nanos_end = now_nanos();
+    } while (nanos_end - nanos_begin < o.min_sample_nanos);
+    const auto nanos_per_invocation =
+        static_cast<$f64>(nanos_end - nanos_begin) / invocation_cnt;
+    r.throughput.push_back(r.units / nanos_per_invocation * 1e9);
+    total_invocation_cnt += invocation_cnt;
+  }
+  perf.stop();
+  perf.report(r, r.units * total_invocation_cnt);
+}
+//===----------------------------------------------------------------------===//
+// JSON output
+//===----------------------------------------------------------------------===//
+static std::string
+json_escape(const std::string& s) {
+  std::string ret;
+  for (auto c : s) {
+    switch (c) {
+      case '"': ret += "\\\""; break;
+      case '\\': ret += "\\\\"; break;
+      case '\n': ret += "\\n"; break;
+      case '\t': ret += "\\t"; break;
+      default: ret += c;
+    }
+  }
+  return ret;
+}
+//===----------------------------------------------------------------------===//
+/// Prints a floating point value. JSON does not support NaN and infinity.
+static void
+print_json_number(std::ostream& os, f64 value) {
+  if (std::isfinite(value)) {
+    os << value;
+  }
+  else {
+    os << "null";
+  }
+}
+//===----------------------------------------------------------------------===//
+static void
+print_json(std::ostream& os, const result& r) {
+  os << "{\"workload\":\"" << json_escape(r.workload) << "\""
+     << ",\"codec\":\"" << json_escape(r.codec) << "\""
+     << ",\"n\":" << r.n
+     << ",\"density\":" << r.density
+     << ",\"clustering_factor\":" << r.clustering_factor
+     << ",\"size_in_bytes\":" << r.size_in_bytes
+     << ",\"unit\":\"" << json_escape(r.unit) << "\""
+     << ",\"units\":" << r.units
+     << ",\"throughput\":[";
+  for (std::size_t i = 0; i < r.throughput.size(); ++i) {
+    if (i > 0) os << ",";
+    print_json_number(os, r.throughput[i]);
+  }
+  os << "],\"throughput_mean\":";
+  print_json_number(os, mean(r.throughput));
+  os << ",\"throughput_stddev\":";
+  print_json_number(os, stddev(r.throughput));
+  os << ",\"counters\":{";
+  $u1 first = true;
+  for (const auto& c : r.counters) {
+    if (!first) os << ",";
+    first = false;
+    os << "\"" << json_escape(c.first) << "\":";
+    print_json_number(os, c.second);
+  }
+  os << "}"
+     << ",\"info\":" << (r.info.empty() ? "null" : r.info)
+     << ",\"checksum\":" << r.checksum
+     << "}";
+}
+//===----------------------------------------------------------------------===//
+/// Prints the header, which identifies the build and the configuration.
+static void
+print_json_header(std::ostream& os, const options& o) {
+  os << "\"git_commit_hash\":\"" << json_escape(GIT_COMMIT_HASH) << "\""
+     << ",\"git_version\":\"" << json_escape(GIT_VERSION) << "\""
+     << ",\"build_id\":\"" << json_escape(BUILD_ID) << "\""
+     << ",\"timestamp\":"
+     << std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count()
+     << ",\"config\":{\"n\":" << o.n
+     << ",\"reps\":" << o.reps
+     << ",\"min_sample_nanos\":" << o.min_sample_nanos
+     << ",\"seed\":" << o.seed
+     << ",\"lookup_cnt\":" << o.lookup_cnt
+     << ",\"update_cnt\":" << o.update_cnt
+     << ",\"skip_distance\":" << o.skip_distance
+     << "}";
+}
+//===----------------------------------------------------------------------===//
+} // namespace bench
+//===----------------------------------------------------------------------===//
@@ -0,0 +1,206 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include "common.hpp"
+
+#include <dtl/dtl.hpp>
+
+#include <boost/math/distributions/students_t.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Compares benchmark results with a baseline and flags statistically
+// significant regressions in throughput and size.
+//===----------------------------------------------------------------------===//
+namespace bench {
+//===----------------------------------------------------------------------===//
+/// Reads the results from a JSON file that has been written by the benchmark
+/// driver.
+static std::vector<result>
+read_results(const std::string& filename, std::string& git_commit_hash) {
+  namespace pt = boost::property_tree;
+  pt::ptree root;
+  pt::read_json(filename, root);
+  git_commit_hash = root.get<std::string>("git_commit_hash", "");
+  std::vector<result> results;
+  for (const auto& entry : root.get_child("results")) {
+    const auto& e = entry.second;
+    result r;
+    r.workload = e.get<std::string>("workload");
+    r.codec = e.get<std::string>("codec");
+    r.n = e.get<$u64>("n");
+    r.density = e.get<$f64>("density");
+    r.clustering_factor = e.get<$f64>("clustering_factor");
+    r.size_in_bytes = e.get<$u64>("size_in_bytes");
+    r.unit = e.get<std::string>("unit", "");
+    r.units = e.get<$f64>("units", 0.0);
+    for (const auto& t : e.get_child("throughput")) {
+      r.throughput.push_back(t.second.get_value<$f64>());
+    }
+    results.push_back(r);
+  }
+  return results;
+}
+//===----------------------------------------------------------------------===//
+/// The outcome of the comparison of a single metric.
+struct comparison {
+  enum class verdict_t { unchanged, improvement, regression };
+
+  std::string key;
+  /// Either 'throughput' or 'size'.
+  std::string metric;
+  $f64 baseline;
+  $f64 current;
+  /// The relative change (current / baseline - 1).
+  $f64 change;
+  /// The p-value of Welch's t-test (throughput only).
+  $f64 p_value;
+  verdict_t verdict;
+
+  static std::string
+  to_string(verdict_t v) {
+    switch (v) {
+      case verdict_t::improvement: return "improvement";
+      case verdict_t::regression: return "regression";
+      default: return "unchanged";
+    }
+  }
+};
+//===----------------------------------------------------------------------===//
+/// Returns the two-sided p-value of Welch's t-test, i.e., the probability that
+/// the means of the two samples are equal.
+static f64
+welch_t_test(const std::vector<$f64>& a, const std::vector<$f64>& b) {
+  if (a.size() < 2 || b.size() < 2) return 0.0;
+  const auto va = variance(a) / a.size();
+  const auto vb = variance(b) / b.size();
+  const auto se = std::sqrt(va + vb);
+  const auto diff = mean(a) - mean(b);
+  if (se == 0.0) return diff == 0.0 ? 1.0 : 0.0;
+  const auto t = std::abs(diff) / se;
+  // The Welch-Satterthwaite approximation of the degrees of freedom.
+  const auto df = ((va + vb) * (va + vb))
+      / ((va * va) / (a.size() - 1) + (vb * vb) / (b.size() - 1));
+  boost::math::students_t dist(df);
+  return 2.0 * boost::math::cdf(boost::math::complement(dist, t));
+}
+//===----------------------------------------------------------------------===//
+/// Compares the given results with the baseline. A throughput change is
+/// considered significant if it exceeds the threshold and the p-value is below
+/// alpha. The size is deterministic (given the same seed), thus a size change
+/// is considered significant if it exceeds the size threshold.
+///
+/// If less than two samples are available on either side, the decision is
+/// solely based on the threshold.
+static std::vector<comparison>
+compare(const options& o,
+    const std::vector<result>& current,
+    const std::vector<result>& baseline) {
+  std::map<std::string, const result*> baseline_map;
+  for (const auto& r : baseline) {
+    baseline_map[r.key()] = &r;
+  }
+  std::vector<comparison> comparisons;
+  for (const auto& r : current) {
+    const auto search = baseline_map.find(r.key());
+    if (search == baseline_map.end()) continue;
+    const auto& b = *search->second;
+
+    // Size.
+    {
+      comparison c;
+      c.key = r.key();
+      c.metric = "size";
+      c.baseline = b.size_in_bytes;
+      c.current = r.size_in_bytes;
+      c.change = c.baseline > 0 ? c.current / c.baseline - 1.0 : 0.0;
+      c.p_value = 0.0;
+      c.verdict = comparison::verdict_t::unchanged;
+      if (c.change > o.size_threshold) {
+        c.verdict = comparison::verdict_t::regression;
+      }
+      else if (c.change < -o.size_threshold) {
+        c.verdict = comparison::verdict_t::improvement;
+      }
+      comparisons.push_back(c);
+    }
+
+    // Throughput.
+    if (!r.throughput.empty() && !b.throughput.empty()) {
+      comparison c;
+      c.key = r.key();
+      c.metric = "throughput";
+      c.baseline = mean(b.throughput);
+      c.current = mean(r.throughput);
+      c.change = c.baseline > 0 ? c.current / c.baseline - 1.0 : 0.0;
+      const auto has_samples =
+          r.throughput.size() >= 2 && b.throughput.size() >= 2;
+      c.p_value = has_samples ? welch_t_test(r.throughput, b.throughput) : 0.0;
+      c.verdict = comparison::verdict_t::unchanged;
+      if (c.p_value < o.alpha) {
+        if (c.change < -o.threshold) {
+          c.verdict = comparison::verdict_t::regression;
+        }
+        else if (c.change > o.threshold) {
+          c.verdict = comparison::verdict_t::improvement;
+        }
+      }
+      comparisons.push_back(c);
+    }
+  }
+  return comparisons;
+}
+//===----------------------------------------------------------------------===//
+static void
+print_json(std::ostream& os, const comparison& c) {
+  os << "{\"key\":\"" << json_escape(c.key) << "\""
+     << ",\"metric\":\"" << c.metric << "\""
+     << ",\"baseline\":";
+  print_json_number(os, c.baseline);
+  os << ",\"current\":";
+  print_json_number(os, c.current);
+  os << ",\"change\":";
+  print_json_number(os, c.change);
+  os << ",\"p_value\":";
+  print_json_number(os, c.p_value);
+  os << ",\"verdict\":\"" << comparison::to_string(c.verdict) << "\""
+     << "}";
+}
+//===----------------------------------------------------------------------===//
+/// Prints a human readable summary of the significant changes. Returns the
+/// number of regressions.
+static std::size_t
+print_summary(std::ostream& os, const std::vector<comparison>& comparisons,
+    const std::string& baseline_hash) {
+  std::size_t regression_cnt = 0;
+  std::size_t improvement_cnt = 0;
+  for (const auto& c : comparisons) {
+    if (c.verdict == comparison::verdict_t::unchanged) continue;
+    if (c.verdict == comparison::verdict_t::regression) ++regression_cnt;
+    if (c.verdict == comparison::verdict_t::improvement) ++improvement_cnt;
+    os << std::left << std::setw(12) << comparison::to_string(c.verdict)
+       << std::setw(11) << c.metric
+       << std::right << std::showpos << std::fixed << std::setprecision(1)
+       << std::setw(8) << (c.change * 100.0) << "%"
+       << std::noshowpos << std::defaultfloat << std::setprecision(6)
+       << "  " << c.key;
+    if (c.metric == "throughput") {
+      os << "  (p=" << c.p_value << ")";
+    }
+    os << std::endl;
+  }
+  os << "Compared " << comparisons.size() << " metrics with baseline "
+     << (baseline_hash.empty() ? "<unknown>" : baseline_hash) << ": "
+     << regression_cnt << " regression(s), "
+     << improvement_cnt << " improvement(s)." << std::endl;
+  return regression_cnt;
+}
+//===----------------------------------------------------------------------===//
+} // namespace bench
+//===----------------------------------------------------------------------===//
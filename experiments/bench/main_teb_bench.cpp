@@ -0,0 +1,394 @@
+#include "common.hpp"
+#include "compare.hpp"
+#include "experiments/util/bitmap_types.hpp"
+#include "experiments/util/differential_bitmap_types.hpp"
+#include "workloads.hpp"
+
+#include <dtl/dtl.hpp>
+
+#include <boost/algorithm/string.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// The unified benchmark driver.
+//
+// Usage: teb_bench <workload>[,<workload>...] [options]
+//        teb_bench compare --input <results.json> --compare <baseline.json>
+//
+// The results are written in JSON, including the git commit hash of the build.
+// If a baseline is given, significant regressions are reported to stderr and
+// the exit code is set to 2.
+//===----------------------------------------------------------------------===//
+/// All supported workloads.
+static const std::vector<std::string> workload_names = {
+    "compression", "construction", "scan", "skip", "intersect", "predicate",
+    "erased", "update", "lookup" };
+/// The codecs that are used, if none are specified.
+static const std::vector<std::string> default_codecs = {
+    "bitmap", "roaring", "wah", "concise", "teb_wrapper",
+    "partitioned_teb_wrapper", "bah", "elias_fano", "delta_bp128" };
+/// The updatable codecs that are used, if none are specified.
+static const std::vector<std::string> default_update_codecs = {
+    "roaring", "wah", "partitioned_teb", "partitioned_differential_teb" };
+//===----------------------------------------------------------------------===//
+template<typename T>
+struct type_tag {
+  using type = T;
+};
+//===----------------------------------------------------------------------===//
+/// Invokes fn(type_tag<T>, name) for the given bitmap type.
+template<typename Fn>
+static void
+dispatch(bitmap_t bitmap_type, Fn&& fn) {
+  switch (bitmap_type) {
+#define __GENERATE_CASE(name)                              \
+  case bitmap_t::name:                                     \
+    fn(type_tag<type_of<bitmap_t::name>::type>(), #name); \
+    break;
+
+    __GENERATE_CASE(bitmap)
+
+    __GENERATE_CASE(roaring)
+
+    __GENERATE_CASE(teb_wrapper)
+    __GENERATE_CASE(partitioned_teb_wrapper)
+
+    __GENERATE_CASE(wah)
+    __GENERATE_CASE(partitioned_wah)
+
+    __GENERATE_CASE(position_list)
+    __GENERATE_CASE(partitioned_position_list_u8)
+    __GENERATE_CASE(partitioned_position_list_u16)
+
+    __GENERATE_CASE(range_list)
+    __GENERATE_CASE(partitioned_range_list_u8)
+    __GENERATE_CASE(partitioned_range_list_u16)
+
+    __GENERATE_CASE(uah8)
+    __GENERATE_CASE(uah8_skip)
+    __GENERATE_CASE(uah16)
+    __GENERATE_CASE(uah16_skip)
+    __GENERATE_CASE(uah32)
+    __GENERATE_CASE(uah32_skip)
+    __GENERATE_CASE(uah64)
+    __GENERATE_CASE(uah64_skip)
+    __GENERATE_CASE(partitioned_uah8)
+    __GENERATE_CASE(partitioned_uah8_skip)
+    __GENERATE_CASE(partitioned_uah16)
+    __GENERATE_CASE(partitioned_uah16_skip)
+    __GENERATE_CASE(partitioned_uah32)
+    __GENERATE_CASE(partitioned_uah32_skip)
+    __GENERATE_CASE(partitioned_uah64)
+    __GENERATE_CASE(partitioned_uah64_skip)
+
+    __GENERATE_CASE(xah8)
+    __GENERATE_CASE(xah8_skip)
+    __GENERATE_CASE(xah16)
+    __GENERATE_CASE(xah16_skip)
+    __GENERATE_CASE(xah32)
+    __GENERATE_CASE(xah32_skip)
+    __GENERATE_CASE(xah64)
+    __GENERATE_CASE(xah64_skip)
+    __GENERATE_CASE(partitioned_xah8)
+    __GENERATE_CASE(partitioned_xah8_skip)
+    __GENERATE_CASE(partitioned_xah16)
+    __GENERATE_CASE(partitioned_xah16_skip)
+    __GENERATE_CASE(partitioned_xah32)
+    __GENERATE_CASE(partitioned_xah32_skip)
+    __GENERATE_CASE(partitioned_xah64)
+    __GENERATE_CASE(partitioned_xah64_skip)
+
+    __GENERATE_CASE(bah)
+    __GENERATE_CASE(partitioned_bah)
+
+    __GENERATE_CASE(concise)
+    __GENERATE_CASE(concise_skip)
+
+    __GENERATE_CASE(elias_fano)
+    __GENERATE_CASE(partitioned_elias_fano)
+
+    __GENERATE_CASE(delta_bp128)
+    __GENERATE_CASE(partitioned_delta_bp128)
+
+    __GENERATE_CASE(bbc)
+    __GENERATE_CASE(bbc_skip)
+#undef __GENERATE_CASE
+    default:
+      break;
+  }
+}
+//===----------------------------------------------------------------------===//
+/// Invokes fn(type_tag<T>, name) for each updatable bitmap type.
+template<typename Fn>
+static void
+dispatch_updatable(Fn&& fn) {
+  fn(type_tag<dtl::dynamic_roaring_bitmap>(), "roaring");
+  fn(type_tag<dtl::dynamic_wah32>(), "wah");
+  fn(type_tag<partitioned_teb>(), "partitioned_teb");
+  fn(type_tag<partitioned_differential_teb>(), "partitioned_differential_teb");
+  fn(type_tag<partitioned_differential_wah>(), "partitioned_differential_wah");
+  fn(type_tag<partitioned_differential_roaring>(),
+      "partitioned_differential_roaring");
+}
+//===----------------------------------------------------------------------===//
+/// Returns true if the codec has been selected on the command line.
+static u1
+is_selected(const std::vector<std::string>& selected,
+    const std::vector<std::string>& defaults, const std::string& name) {
+  const auto& l = selected.empty() ? defaults : selected;
+  if (l.size() == 1 && l[0] == "all") return true;
+  return std::find(l.begin(), l.end(), name) != l.end();
+}
+//===----------------------------------------------------------------------===//
+/// Runs the given workload for all selected codecs on the given data set.
+static void
+run(const bench::options& o, const std::string& workload,
+    const bench::dataset& ds, std::vector<bench::result>& results) {
+  auto fn = [&](auto tag, const std::string& codec) {
+    using T = typename decltype(tag)::type;
+    std::cerr << "running " << workload << " " << codec
+              << " (d=" << ds.density << ", f=" << ds.clustering_factor << ")"
+              << std::endl;
+    if (workload == "compression") {
+      results.push_back(bench::run_compression<T>(o, codec, ds));
+    }
+    else if (workload == "construction") {
+      results.push_back(bench::run_construction<T>(o, codec, ds));
+    }
+    else if (workload == "scan") {
+      results.push_back(bench::run_scan<T>(o, codec, ds));
+    }
+    else if (workload == "skip") {
+      results.push_back(bench::run_skip<T>(o, codec, ds));
+    }
+    else if (workload == "intersect") {
+      results.push_back(bench::run_intersect<T>(o, codec, ds));
+    }
+    else if (workload == "predicate") {
+      bench::run_predicate<T>(o, codec, ds, results);
+    }
+    else if (workload == "erased") {
+      bench::run_erased<T>(o, codec, ds, results);
+    }
+    else if (workload == "lookup") {
+      results.push_back(bench::run_lookup<T>(o, codec, ds));
+    }
+  };
+
+  if (workload == "update") {
+    dispatch_updatable([&](auto tag, const std::string& codec) {
+      using T = typename decltype(tag)::type;
+      if (!is_selected(o.codecs, default_update_codecs, codec)) return;
+      std::cerr << "running " << workload << " " << codec
+                << " (d=" << ds.density << ", f=" << ds.clustering_factor
+                << ")" << std::endl;
+      results.push_back(bench::run_update<T>(o, codec, ds));
+    });
+    return;
+  }
+  for (auto bitmap_type : bitmap_t_list) {
+    dispatch(bitmap_type, [&](auto tag, const std::string& codec) {
+      if (!is_selected(o.codecs, default_codecs, codec)) return;
+      fn(tag, codec);
+    });
+  }
+}
+//===----------------------------------------------------------------------===//
+template<typename T>
+static std::vector<T>
+parse_list(const std::string& value) {
+  std::vector<std::string> tokens;
+  boost::split(tokens, value, boost::is_any_of(","));
+  std::vector<T> ret;
+  for (const auto& token : tokens) {
+    if (token.empty()) continue;
+    std::stringstream s(token);
+    T v;
+    s >> v;
+    ret.push_back(v);
+  }
+  return ret;
+}
+//===----------------------------------------------------------------------===//
+static void
+print_usage(std::ostream& os) {
+  os << "Usage: teb_bench <workload>[,<workload>...] [options]\n"
+     << "       teb_bench compare --input <file> --compare <baseline>\n"
+     << "\nWorkloads: all";
+  for (const auto& w : workload_names) os << ", " << w;
+  os << "\n\nOptions:\n"
+     << "  --codecs <list>          codecs under test or 'all'\n"
+     << "  --n <n>                  bitmap length\n"
+     << "  --densities <list>       bit densities\n"
+     << "  --clustering <list>      clustering factors\n"
+     << "  --reps <n>               samples per measurement\n"
+     << "  --min-sample-ms <n>      minimum duration of a sample\n"
+     << "  --seed <n>               random seed\n"
+     << "  --lookups <n>            point lookups per invocation\n"
+     << "  --updates <n>            point updates per sample\n"
+     << "  --skip-distance <n>      distance between skip targets\n"
+     << "  --perf                   record hardware counters\n"
+     << "  --output <file>          write the results to the file\n"
+     << "  --input <file>           the results to compare (compare only)\n"
+     << "  --compare <file>         compare with the baseline results\n"
+     << "  --alpha <p>              significance level (default 0.01)\n"
+     << "  --threshold <r>          min. relative throughput change (0.05)\n"
+     << "  --size-threshold <r>     min. relative size change (0.01)\n"
+     << std::endl;
+}
+//===----------------------------------------------------------------------===//
+/// Parses the command line arguments. Terminates the process in case of
+/// invalid arguments.
+static bench::options
+parse_options(int argc, char** argv) {
+  bench::options o;
+  if (argc < 2) {
+    print_usage(std::cerr);
+    std::exit(1);
+  }
+  o.workloads = parse_list<std::string>(argv[1]);
+  if (o.workloads.size() == 1 && o.workloads[0] == "all") {
+    o.workloads = workload_names;
+  }
+  if (o.workloads.size() > 1
+      && std::find(o.workloads.begin(), o.workloads.end(), "compare")
+          != o.workloads.end()) {
+    std::cerr << "The compare command cannot be combined with workloads."
+              << std::endl;
+    std::exit(1);
+  }
+  for (const auto& w : o.workloads) {
+    if (w != "compare"
+        && std::find(workload_names.begin(), workload_names.end(), w)
+            == workload_names.end()) {
+      std::cerr << "Unknown workload: " << w << std::endl;
+      print_usage(std::cerr);
+      std::exit(1);
+    }
+  }
+
+  for (int i = 2; i < argc; ++i) {
+    std::string arg = argv[i];
+    std::string value;
+    const auto eq = arg.find('=');
+    if (eq != std::string::npos) {
+      value = arg.substr(eq + 1);
+      arg = arg.substr(0, eq);
+    }
+    if (arg == "--perf") {
+      o.perf = true;
+      continue;
+    }
+    if (eq == std::string::npos) {
+      if (i + 1 >= argc) {
+        std::cerr << "Missing value for argument: " << arg << std::endl;
+        std::exit(1);
+      }
+      value = argv[++i];
+    }
+
+    if (arg == "--codecs") o.codecs = parse_list<std::string>(value);
+    else if (arg == "--n") o.n = std::stoull(value);
+    else if (arg == "--densities") o.densities = parse_list<$f64>(value);
+    else if (arg == "--clustering") o.clustering_factors = parse_list<$f64>(value);
+    else if (arg == "--reps") o.reps = std::stoull(value);
+    else if (arg == "--min-sample-ms") o.min_sample_nanos = std::stoull(value) * 1000000;
+    else if (arg == "--seed") o.seed = std::stoull(value);
+    else if (arg == "--lookups") o.lookup_cnt = std::stoull(value);
+    else if (arg == "--updates") o.update_cnt = std::stoull(value);
+    else if (arg == "--skip-distance") o.skip_distance = std::stoull(value);
+    else if (arg == "--output") o.output = value;
+    else if (arg == "--input") o.input = value;
+    else if (arg == "--compare") o.baseline = value;
+    else if (arg == "--alpha") o.alpha = std::stod(value);
+    else if (arg == "--threshold") o.threshold = std::stod(value);
+    else if (arg == "--size-threshold") o.size_threshold = std::stod(value);
+    else {
+      std::cerr << "Unknown argument: " << arg << std::endl;
+      print_usage(std::cerr);
+      std::exit(1);
+    }
+  }
+  if (o.n == 0 || o.n > (1ull << 32) || o.reps == 0 || o.skip_distance == 0) {
+    std::cerr << "Invalid arguments." << std::endl;
+    std::exit(1);
+  }
+  return o;
+}
+//===----------------------------------------------------------------------===//
+$i32 main(int argc, char** argv) {
+  const auto o = parse_options(argc, argv);
+
+  std::vector<bench::result> results;
+  const auto is_compare_only =
+      o.workloads.size() == 1 && o.workloads[0] == "compare";
+  if (is_compare_only) {
+    if (o.input.empty() || o.baseline.empty()) {
+      std::cerr << "The compare command requires --input and --compare."
+                << std::endl;
+      std::exit(1);
+    }
+    std::string hash;
+    results = bench::read_results(o.input, hash);
+  }
+  else {
+    for (auto d : o.densities) {
+      for (auto f : o.clustering_factors) {
+        const auto ds = bench::gen_dataset(o, d, f);
+        for (const auto& workload : o.workloads) {
+          run(o, workload, ds, results);
+        }
+      }
+    }
+  }
+
+  std::vector<bench::comparison> comparisons;
+  std::size_t regression_cnt = 0;
+  if (!o.baseline.empty()) {
+    std::string baseline_hash;
+    const auto baseline = bench::read_results(o.baseline, baseline_hash);
+    comparisons = bench::compare(o, results, baseline);
+    regression_cnt =
+        bench::print_summary(std::cerr, comparisons, baseline_hash);
+  }
+
+  // Write the results.
+  std::ofstream file;
+  if (!o.output.empty()) {
+    file.open(o.output);
+    if (!file) {
+      std::cerr << "Failed to open the output file: " << o.output
+                << std::endl;
+      std::exit(1);
+    }
+  }
+  std::ostream& os = o.output.empty() ? std::cout : file;
+  os << std::setprecision(10);
+  os << "{";
+  bench::print_json_header(os, o);
+  os << ",\"results\":[";
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    os << (i > 0 ? ",\n" : "\n");
+    bench::print_json(os, results[i]);
+  }
+  os << "\n]";
+  if (!o.baseline.empty()) {
+    os << ",\"comparison\":[";
+    for (std::size_t i = 0; i < comparisons.size(); ++i) {
+      os << (i > 0 ? ",\n" : "\n");
+      bench::print_json(os, comparisons[i]);
+    }
+    os << "\n]";
+  }
+  os << "}" << std::endl;
+
+  return regression_cnt > 0 ? 2 : 0;
+}
+//===----------------------------------------------------------------------===//
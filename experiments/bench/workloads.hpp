@@ -0,0 +1,446 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include "common.hpp"
+
+#include <dtl/bitmap/any_bitmap.hpp>
+#include <dtl/bitmap/bitwise_expression.hpp>
+#include <dtl/bitmap/bitwise_operations.hpp>
+#include <dtl/dtl.hpp>
+
+#include <cstddef>
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// The workloads of the benchmark driver. Each workload encodes the bitmap(s)
+// of the given data set using the codec T, validates the encoding and appends
+// a single result.
+//===----------------------------------------------------------------------===//
+namespace bench {
+//===----------------------------------------------------------------------===//
+/// Initializes the result of a measurement.
+template<typename T>
+static result
+make_result(const std::string& workload, const std::string& codec,
+    const T& enc, const dataset& ds) {
+  result r;
+  r.workload = workload;
+  r.codec = codec;
+  r.info = enc.info();
+  r.n = ds.n;
+  r.density = ds.density;
+  r.clustering_factor = ds.clustering_factor;
+  r.size_in_bytes = enc.size_in_bytes();
+  r.unit = "bits";
+  r.units = static_cast<$f64>(ds.n);
+  return r;
+}
+//===----------------------------------------------------------------------===//
+/// Terminates the process if the encoded bitmap does not match the original
+/// bitmap. (Fail fast)
+template<typename T>
+static void
+validate(const std::string& codec, const T& enc,
+    const boost::dynamic_bitset<$u32>& bs) {
+  std::size_t length_sink = 0;
+  auto it = enc.scan_it();
+  $u1 valid = enc.size() == bs.size();
+  while (valid && !it.end()) {
+    for (std::size_t i = it.pos(); i < it.pos() + it.length(); ++i) {
+      valid &= bs[i];
+    }
+    length_sink += it.length();
+    it.next();
+  }
+  if (!valid || length_sink != bs.count()) {
+    std::cerr << "Validation failed: " << codec << std::endl;
+    std::cerr << "Failed to decode the bitmap " << enc.info() << "."
+              << std::endl;
+    std::exit(1);
+  }
+}
+//===----------------------------------------------------------------------===//
+/// Measures the size of the encoded bitmap.
+template<typename T>
+static result
+run_compression(const options& o, const std::string& codec,
+    const dataset& ds) {
+  const T enc(ds.bs);
+  validate(codec, enc, ds.bs);
+  return make_result("compression", codec, enc, ds);
+}
+//===----------------------------------------------------------------------===//
+/// Measures the construction throughput.
+template<typename T>
+static result
+run_construction(const options& o, const std::string& codec,
+    const dataset& ds) {
+  const T enc(ds.bs);
+  validate(codec, enc, ds.bs);
+  auto r = make_result("construction", codec, enc, ds);
+  measure(o,
+      [&]() {
+        const T tmp(ds.bs);
+        return tmp.size_in_bytes();
+      },
+      r);
+  return r;
+}
+//===----------------------------------------------------------------------===//
+/// Measures the throughput of a full scan using the scan iterator.
+template<typename T>
+static result
+run_scan(const options& o, const std::string& codec, const dataset& ds) {
+  const T enc(ds.bs);
+  validate(codec, enc, ds.bs);
+  auto r = make_result("scan", codec, enc, ds);
+  measure(o,
+      [&]() {
+        std::size_t pos_sink = 0;
+        std::size_t length_sink = 0;
+        auto it = enc.scan_it();
+        while (!it.end()) {
+          pos_sink += it.pos();
+          length_sink += it.length();
+          it.next();
+        }
+        return pos_sink + length_sink;
+      },
+      r);
+  return r;
+}
+//===----------------------------------------------------------------------===//
+/// Measures the throughput of the skip iterator, when the consumer skips ahead
+/// to every 'skip_distance'-th position.
+template<typename T>
+static result
+run_skip(const options& o, const std::string& codec, const dataset& ds) {
+  const T enc(ds.bs);
+  validate(codec, enc, ds.bs);
+  auto r = make_result("skip", codec, enc, ds);
+  const std::size_t skip_distance = o.skip_distance;
+  measure(o,
+      [&]() {
+        std::size_t pos_sink = 0;
+        std::size_t length_sink = 0;
+        std::size_t target = skip_distance;
+        auto it = enc.it();
+        while (!it.end()) {
+          pos_sink += it.pos();
+          ++length_sink;
+          while (target <= it.pos()) target += skip_distance;
+          if (target < it.pos() + it.length()) {
+            // The target is covered by the current run.
+            target += skip_distance;
+            it.next();
+          }
+          else {
+            it.skip_to(target);
+          }
+        }
+        return pos_sink + length_sink;
+      },
+      r);
+  return r;
+}
+//===----------------------------------------------------------------------===//
+/// Measures the throughput of the intersection of two encoded bitmaps.
+template<typename T>
+static result
+run_intersect(const options& o, const std::string& codec,
+    const dataset& ds) {
+  const T enc1(ds.bs);
+  const T enc2(ds.bs2);
+  validate(codec, enc1, ds.bs);
+  validate(codec, enc2, ds.bs2);
+  auto r = make_result("intersect", codec, enc1, ds);
+  r.size_in_bytes += enc2.size_in_bytes();
+  {
+    std::size_t length_sink = 0;
+    auto it = dtl::bitwise_and_it(enc1.it(), enc2.it());
+    while (!it.end()) {
+      length_sink += it.length();
+      it.next();
+    }
+    if (length_sink != (ds.bs & ds.bs2).count()) {
+      std::cerr << "Validation failed (intersect): " << codec << std::endl;
+      std::exit(1);
+    }
+  }
+  measure(o,
+      [&]() {
+        std::size_t pos_sink = 0;
+        std::size_t length_sink = 0;
+        auto it = dtl::bitwise_and_it(enc1.it(), enc2.it());
+        while (!it.end()) {
+          pos_sink += it.pos();
+          length_sink += it.length();
+          it.next();
+        }
+        return pos_sink + length_sink;
+      },
+      r);
+  return r;
+}
+//===----------------------------------------------------------------------===//
+/// The predicate with k operands, which is evaluated using nested bitwise_iter
+/// instances, i.e., (b[0] OR b[1]) AND b[2] AND ... AND b[k-1].
+template<std::size_t k>
+struct nested_predicate {
+  template<typename T>
+  static auto
+  it(const std::vector<T>& operands) {
+    return dtl::bitwise_and_it(nested_predicate<k - 1>::it(operands),
+        operands[k - 1].it());
+  }
+};
+template<>
+struct nested_predicate<2> {
+  template<typename T>
+  static auto
+  it(const std::vector<T>& operands) {
+    return dtl::bitwise_or_it(operands[0].it(), operands[1].it());
+  }
+};
+//===----------------------------------------------------------------------===//
+/// Measures the throughput of the evaluation of a predicate with k operands.
+/// The predicate is evaluated (i) using nested bitwise_iter instances and (ii)
+/// as a bitwise expression, where the consumer is fused with the evaluation
+/// loop. Appends one result per variant.
+template<typename T, std::size_t k>
+static void
+run_predicate_k(const options& o, const std::string& codec,
+    const dataset& ds, std::vector<result>& results) {
+  static_assert(k >= 3, "The predicate requires at least three operands.");
+  // The operands are ordered by density (descending), which is the worst case
+  // for the nested evaluation.
+  const auto seed = o.seed ^ (std::hash<$f64>()(ds.density) * 31
+      + std::hash<$f64>()(ds.clustering_factor));
+  std::vector<boost::dynamic_bitset<$u32>> bitsets;
+  for (std::size_t i = 0; i < k; ++i) {
+    const auto d_max = ds.clustering_factor / (1.0 + ds.clustering_factor);
+    const auto d = std::max(ds.density,
+        std::min(ds.density * (k - i), std::min(0.9, d_max)));
+    bitsets.push_back(i == 0 ? ds.bs
+        : i == 1 ? ds.bs2
+        : gen_bitmap(ds.n, d, ds.clustering_factor, seed + 100 + i));
+  }
+  std::vector<T> operands;
+  operands.reserve(k);
+  std::size_t size_in_bytes = 0;
+  for (const auto& bs : bitsets) {
+    operands.emplace_back(bs);
+    validate(codec, operands.back(), bs);
+    size_in_bytes += operands.back().size_in_bytes();
+  }
+  auto e = dtl::bitwise_or_expr(dtl::bitwise_leaf_expr(operands[0]),
+      dtl::bitwise_leaf_expr(operands[1]));
+  auto expected = bitsets[0] | bitsets[1];
+  for (std::size_t i = 2; i < k; ++i) {
+    e = dtl::bitwise_and_expr(std::move(e),
+        dtl::bitwise_leaf_expr(operands[i]));
+    expected &= bitsets[i];
+  }
+
+  const auto workload = "predicate/k=" + std::to_string(k);
+  {
+    std::size_t length_sink = 0;
+    auto it = nested_predicate<k>::it(operands);
+    while (!it.end()) {
+      length_sink += it.length();
+      it.next();
+    }
+    if (length_sink != expected.count()
+        || dtl::bitwise_count(e) != expected.count()) {
+      std::cerr << "Validation failed (" << workload << "): " << codec
+                << std::endl;
+      std::exit(1);
+    }
+  }
+
+  auto r_nested = make_result(workload + "/nested", codec, operands[0], ds);
+  r_nested.size_in_bytes = size_in_bytes;
+  measure(o,
+      [&]() {
+        std::size_t pos_sink = 0;
+        std::size_t length_sink = 0;
+        auto it = nested_predicate<k>::it(operands);
+        while (!it.end()) {
+          pos_sink += it.pos();
+          length_sink += it.length();
+          it.next();
+        }
+        return pos_sink + length_sink;
+      },
+      r_nested);
+  results.push_back(std::move(r_nested));
+
+  auto r_fused = make_result(workload + "/fused", codec, operands[0], ds);
+  r_fused.size_in_bytes = size_in_bytes;
+  measure(o,
+      [&]() {
+        std::size_t pos_sink = 0;
+        std::size_t length_sink = 0;
+        dtl::bitwise_expr_it(e).for_each([&](u64 pos, u64 length) {
+          pos_sink += pos;
+          length_sink += length;
+        });
+        return pos_sink + length_sink;
+      },
+      r_fused);
+  results.push_back(std::move(r_fused));
+}
+//===----------------------------------------------------------------------===//
+/// Measures the throughput of the evaluation of predicates with 3 to 8
+/// operands (see run_predicate_k).
+template<typename T>
+static void
+run_predicate(const options& o, const std::string& codec, const dataset& ds,
+    std::vector<result>& results) {
+  run_predicate_k<T, 3>(o, codec, ds, results);
+  run_predicate_k<T, 4>(o, codec, ds, results);
+  run_predicate_k<T, 5>(o, codec, ds, results);
+  run_predicate_k<T, 6>(o, codec, ds, results);
+  run_predicate_k<T, 7>(o, codec, ds, results);
+  run_predicate_k<T, 8>(o, codec, ds, results);
+}
+//===----------------------------------------------------------------------===//
+/// Consumes the given run iterator and returns the sum of the positions and
+/// lengths of the 1-runs.
+template<typename iter_t>
+static std::size_t __forceinline__
+consume(iter_t&& it) {
+  std::size_t pos_sink = 0;
+  std::size_t length_sink = 0;
+  while (!it.end()) {
+    pos_sink += it.pos();
+    length_sink += it.length();
+    it.next();
+  }
+  return pos_sink + length_sink;
+}
+//===----------------------------------------------------------------------===//
+/// Measures the throughput of the type-erased (runtime-composable) iterators
+/// for scans and intersections. The results contain the counter
+/// 'overhead_factor', which refers to the throughput of the templated
+/// iterators divided by the throughput of the type-erased iterators.
+template<typename T>
+static void
+run_erased(const options& o, const std::string& codec, const dataset& ds,
+    std::vector<result>& results) {
+  const T enc1(ds.bs);
+  const T enc2(ds.bs2);
+  validate(codec, enc1, ds.bs);
+  validate(codec, enc2, ds.bs2);
+  // The codec is not known to the type-erased iterators.
+  const auto any1 = dtl::any_bitmap::wrap(T(ds.bs));
+  const auto any2 = dtl::any_bitmap::wrap(T(ds.bs2));
+  if (consume(any1.scan_it()) != consume(enc1.scan_it())
+      || consume(dtl::any_and_it(any1.it(), any2.it()))
+          != consume(dtl::bitwise_and_it(enc1.it(), enc2.it()))) {
+    std::cerr << "Validation failed (erased): " << codec << std::endl;
+    std::exit(1);
+  }
+
+  auto r_scan = make_result("erased/scan", codec, enc1, ds);
+  auto r_scan_templated = r_scan;
+  measure(o, [&]() { return consume(enc1.scan_it()); }, r_scan_templated);
+  measure(o, [&]() { return consume(any1.scan_it()); }, r_scan);
+  r_scan.counters["overhead_factor"] =
+      mean(r_scan_templated.throughput) / mean(r_scan.throughput);
+  results.push_back(std::move(r_scan));
+
+  auto r_and = make_result("erased/intersect", codec, enc1, ds);
+  r_and.size_in_bytes += enc2.size_in_bytes();
+  auto r_and_templated = r_and;
+  measure(o,
+      [&]() { return consume(dtl::bitwise_and_it(enc1.it(), enc2.it())); },
+      r_and_templated);
+  measure(o,
+      [&]() { return consume(dtl::any_and_it(any1.it(), any2.it())); },
+      r_and);
+  r_and.counters["overhead_factor"] =
+      mean(r_and_templated.throughput) / mean(r_and.throughput);
+  results.push_back(std::move(r_and));
+}
+//===----------------------------------------------------------------------===//
+/// Measures the throughput of random point lookups.
+template<typename T>
+static result
+run_lookup(const options& o, const std::string& codec, const dataset& ds) {
+  const T enc(ds.bs);
+  validate(codec, enc, ds.bs);
+  auto r = make_result("lookup", codec, enc, ds);
+  r.unit = "lookups";
+  r.units = static_cast<$f64>(o.lookup_cnt);
+  const $u32* positions = ds.positions.data();
+  const std::size_t lookup_cnt = o.lookup_cnt;
+  for (std::size_t i = 0; i < lookup_cnt; ++i) {
+    if (enc.test(positions[i]) != ds.bs[positions[i]]) {
+      std::cerr << "Validation failed (lookup): " << codec << std::endl;
+      std::exit(1);
+    }
+  }
+  measure(o,
+      [&]() {
+        std::size_t hit_cnt = 0;
+        for (std::size_t i = 0; i < lookup_cnt; ++i) {
+          hit_cnt += enc.test(positions[i]);
+        }
+        return hit_cnt;
+      },
+      r);
+  return r;
+}
+//===----------------------------------------------------------------------===//
+/// Measures the throughput of random point updates. The bitmap type needs to
+/// be updatable. Each sample starts with a freshly encoded bitmap, as the
+/// updates change the bitmap and thereby the costs of subsequent updates.
+template<typename T>
+static result
+run_update(const options& o, const std::string& codec, const dataset& ds) {
+  const std::size_t update_cnt = o.update_cnt;
+  const $u32* positions = ds.positions.data();
+  auto updated_bs = ds.bs;
+  for (std::size_t i = 0; i < update_cnt; ++i) {
+    updated_bs[positions[i]] = i & 1;
+  }
+
+  // Encode the bitmaps upfront to exclude the encoding costs from the
+  // hardware counters.
+  std::vector<T> encs;
+  encs.reserve(o.reps);
+  for (std::size_t rep = 0; rep < o.reps; ++rep) {
+    encs.emplace_back(ds.bs);
+  }
+
+  auto r = make_result("update", codec, encs.front(), ds);
+  r.unit = "updates";
+  r.units = static_cast<$f64>(update_cnt);
+  perf_counters perf(o.perf);
+  perf.start();
+  for (auto& enc : encs) {
+    const auto nanos_begin = now_nanos();
+    for (std::size_t i = 0; i < update_cnt; ++i) {
+      enc.set(positions[i], i & 1);
+    }
+    const auto nanos_end = now_nanos();
+    r.throughput.push_back(
+        update_cnt / static_cast<$f64>(nanos_end - nanos_begin) * 1e9);
+  }
+  perf.stop();
+  perf.report(r, r.units * o.reps);
+
+  // Report the size after the updates have been applied.
+  validate(codec, encs.front(), updated_bs);
+  r.info = encs.front().info();
+  r.size_in_bytes = encs.front().size_in_bytes();
+  for (const auto& enc : encs) r.checksum += enc.size_in_bytes();
+  return r;
+}
+//===----------------------------------------------------------------------===//
+} // namespace bench
+//===----------------------------------------------------------------------===//
@@ -2,6 +2,7 @@
 //===----------------------------------------------------------------------===//
 #include "experiments/util/bitmap_db.hpp"
 #include "experiments/util/bitmap_types.hpp"
+#include "experiments/util/dataset.hpp"
 #include "experiments/util/threading.hpp"
 #include "version.h"
 
@@ -37,13 +38,8 @@ static const i64 RUN_ID =
     std::chrono::duration_cast<std::chrono::seconds>(
         std::chrono::system_clock::now().time_since_epoch())
         .count();
-/// The database file where the bitmaps are stored.
-static const std::string DB_FILE =
-    dtl::env<std::string>::get("DB_FILE", "./random_bitmaps.sqlite3");
 /// 0 = run experiment, 1 = generate data for the experiment
 static u64 GEN_DATA = dtl::env<$u64>::get("GEN_DATA", 0);
-/// The database instance where the bitmaps are stored.
-static bitmap_db db(DB_FILE);
 //===----------------------------------------------------------------------===//
 /// Refers to a single independent task that is executed during the experiment.
 struct config {
@@ -58,7 +54,7 @@ template<typename T>
 static void
 run(const config& c, std::ostream& os) {
   // Load the bitmap from DB.
-  auto bs = db.load_bitmap(c.bitmap_id);
+  auto bs = load_bitmap(c.bitmap_id);
   // Encode the bitmap.
   T enc_bs(bs);
 
@@ -155,6 +151,18 @@ run(config c, std::ostream& os) {
 
     __GENERATE_CASE(bah)
     __GENERATE_CASE(partitioned_bah)
+
+    __GENERATE_CASE(concise)
+    __GENERATE_CASE(concise_skip)
+
+    __GENERATE_CASE(elias_fano)
+    __GENERATE_CASE(partitioned_elias_fano)
+
+    __GENERATE_CASE(delta_bp128)
+    __GENERATE_CASE(partitioned_delta_bp128)
+
+    __GENERATE_CASE(bbc)
+    __GENERATE_CASE(bbc_skip)
 #undef __GENERATE_CASE
   }
 }
@@ -33,11 +33,11 @@ struct task {
 template<typename T>
 void do_measurement(task t, std::ostream& os) {
   // The bitmap that is used as starting point.
-  const auto bm_a = db.load_bitmap(t.bitmap_id_a);
+  const auto bm_a = load_bitmap(t.bitmap_id_a);
   const auto bm_a_density = dtl::determine_bit_density(bm_a);
   const auto bm_a_clustering_factor = dtl::determine_clustering_factor(bm_a);
   // The second bitmap determines the updates to perform.
-  const auto bm_b = db.load_bitmap(t.bitmap_id_b);
+  const auto bm_b = load_bitmap(t.bitmap_id_b);
   const auto bm_b_density = dtl::determine_bit_density(bm_b);
   const auto bm_b_clustering_factor = dtl::determine_clustering_factor(bm_b);
 
@@ -150,7 +150,7 @@ void do_measurement(diff_bitmap_t bitmap_type, _Params&&... params) {
 //===----------------------------------------------------------------------===//
 std::size_t
 get_max(u64 bitmap_id) {
-  const auto plain = db.load_bitmap(bitmap_id);
+  const auto plain = load_bitmap(bitmap_id);
   const auto plain_size = plain.size() / 8;
   const auto roaring_size = dtl::dynamic_roaring_bitmap(plain).size_in_bytes();
   const auto teb_size = dtl::teb_wrapper(plain).size_in_bytes();
@@ -194,11 +194,11 @@ $i32 main() {
         }
       }
     }
-    prep_data(params, RUNS, db);
+    prep_data(params, RUNS);
     std::exit(0);
   }
   else {
-    if (db.empty()) {
+    if (empty()) {
       std::cerr << "Bitmap database is empty. Use GEN_DATA=1 to populate the "
                    "database."
                 << std::endl;
@@ -221,7 +221,7 @@ $i32 main() {
       for (auto n : n_values) {
         if (!markov_parameters_are_valid(n, f, d)) continue;
 
-        auto bitmap_ids = db.find_bitmaps(n, f, d);
+        auto bitmap_ids = find_bitmaps(n, f, d);
         if (bitmap_ids.empty()) {
           continue;
         }
@@ -44,7 +44,7 @@ void run(const config_t& config, std::ostream& os) {
   for ($u64 r = 0; r < RUNS; r++) {
     auto bm = gen_random_bitmap_markov(config.n,
         config.clustering_factor,
-        config.bit_density);
+        config.bit_density, 1);
 
     dtl::dynamic_wah32 wah(bm);
     size_wah += wah.size_in_bytes();
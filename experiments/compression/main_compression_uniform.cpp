@@ -7,6 +7,7 @@
 
 #include <functional>
 #include <iostream>
+#include <mutex>
 #include <random>
 #include <sstream>
 #include <vector>
@@ -24,7 +25,7 @@ void gen_data_uniform(
     for (auto n : n_values) {
       if (d < 0 || d > 1.0) continue;
 
-      auto ids = db.find_bitmaps(n, d);
+      auto ids = find_bitmaps(n, d);
       if (ids.size() < RUNS) {
         config c;
         c.n = n;
@@ -50,13 +51,16 @@ void gen_data_uniform(
     }
 
     std::atomic<std::size_t> failure_cntr { 0 };
+    // The dataset store must not be read while it is appended to.
+    std::mutex mutex;
     std::function<void(const config&, std::ostream&)> fn =
         [&](const config c, std::ostream& os) -> void {
       try {
-        const auto b = gen_random_bitmap_uniform(c.n, c.density);
-        const auto id = db.store_bitmap(c.n, c.density, b);
+        const auto b = gen_random_bitmap_uniform(c.n, c.density, 1);
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto id = store_bitmap(c.n, c.density, b);
         // Validation.
-        const auto loaded = db.load_bitmap(id);
+        const auto loaded = load_bitmap(id);
         if (b != loaded) {
           // Fatal!
           std::cerr << "Validation failed" << std::endl;
@@ -113,11 +117,11 @@ $i32 main() {
         params.push_back(p);
       }
     }
-    prep_data(params, RUNS, db);
+    prep_data(params, RUNS);
     std::exit(0);
   }
   else {
-    if (db.empty()) {
+    if (empty()) {
       std::cerr << "Bitmap database is empty. Use GEN_DATA=1 to populate the "
                    "database."
                 << std::endl;
@@ -135,7 +139,7 @@ $i32 main() {
       c.clustering_factor = 0.0;
       c.density = d;
 
-      auto bitmap_ids = db.find_bitmaps(n, d);
+      auto bitmap_ids = find_bitmaps(n, d);
       if (bitmap_ids.empty()) {
         std::cerr
             << "Couldn't find any bitmap with n=" << n << " and d=" << d << "."
@@ -49,11 +49,11 @@ $i32 main() {
         }
       }
     }
-    prep_data(params, RUNS, db);
+    prep_data(params, RUNS);
     std::exit(0);
   }
   else {
-    if (db.empty()) {
+    if (empty()) {
       std::cerr << "Bitmap database is empty. Use GEN_DATA=1 to populate the "
                    "database."
                 << std::endl;
@@ -71,7 +71,7 @@ $i32 main() {
         c.clustering_factor = f;
         c.density = d;
 
-        auto bitmap_ids = db.find_bitmaps(n, f, d);
+        auto bitmap_ids = find_bitmaps(n, f, d);
         if (bitmap_ids.empty()) {
           continue;
         }
@@ -0,0 +1,150 @@
+#include "experiments/util/bitmap_types.hpp"
+#include "experiments/util/gen.hpp"
+#include "version.h"
+
+#include <dtl/bitmap.hpp>
+#include <dtl/bitmap/index/bsi.hpp>
+#include <dtl/dtl.hpp>
+#include <dtl/env.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Experiment: Compares the evaluation of aggregates and comparisons using
+//             bit-sliced indexes with a scan of the raw column.
+//===----------------------------------------------------------------------===//
+// Identifies the benchmark run.
+static const i64 RUN_ID =
+    std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch())
+        .count();
+// The number of rows.
+static u64 N = dtl::env<$u64>::get("N", 1ull << 20);
+// The number of repetitions per query.
+static u64 REPS = dtl::env<$u64>::get("REPS", 10);
+// The k in the top-k queries.
+static u64 TOP_K = dtl::env<$u64>::get("TOP_K", 100);
+//===----------------------------------------------------------------------===//
+static u64
+now_nanos() {
+  return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+//===----------------------------------------------------------------------===//
+/// Measures the (average) execution time of the given query.
+static void
+measure(u32 c, f64 f, const std::string& method, const std::string& query,
+    u64 size_in_bytes, const std::function<u64()>& fn, std::ostream& os) {
+  $u64 checksum = fn(); // Warm up run.
+  const auto nanos_begin = now_nanos();
+  for (std::size_t r = 0; r < REPS; ++r) {
+    checksum += fn();
+  }
+  const auto nanos = (now_nanos() - nanos_begin) / REPS;
+  os << RUN_ID
+     << ",\"" << BUILD_ID << "\""
+     << "," << N
+     << "," << c
+     << "," << f
+     << ",\"" << method << "\""
+     << ",\"" << query << "\""
+     << "," << size_in_bytes
+     << "," << nanos
+     << "," << checksum
+     << std::endl;
+}
+//===----------------------------------------------------------------------===//
+template<typename B>
+void __attribute__((noinline))
+run_bsi(u32 c, f64 f, const std::vector<$u32>& values, std::ostream& os) {
+  using index_t = dtl::bsi<B>;
+  const index_t index(values);
+  const auto name = index_t::name();
+  const auto size = index.size_in_bytes();
+  const u32 lo = c / 4;
+  const u32 hi = (3 * c) / 4;
+  measure(c, f, name, "sum", size, [&]() { return index.sum(); }, os);
+  measure(c, f, name, "count_lt", size,
+      [&]() { return index.count_lt(c / 2); }, os);
+  measure(c, f, name, "count_between", size,
+      [&]() { return index.count_between(lo, hi); }, os);
+  measure(c, f, name, "lt", size,
+      [&]() { return u64(index.lt(c / 2).ranges_.size()); }, os);
+  measure(c, f, name, "sum_lt", size,
+      [&]() { return index.sum(index.lt(c / 2)); }, os);
+  measure(c, f, name, "top_k", size,
+      [&]() { return u64(index.top_k(TOP_K).ranges_.size()); }, os);
+}
+//===----------------------------------------------------------------------===//
+void __attribute__((noinline))
+run_scan(u32 c, f64 f, const std::vector<$u32>& values, std::ostream& os) {
+  const std::string name = "scan";
+  const auto size = values.size() * sizeof($u32);
+  const u32 lo = c / 4;
+  const u32 hi = (3 * c) / 4;
+  const u32 m = c / 2;
+  measure(c, f, name, "sum", size, [&]() {
+    $u64 ret = 0;
+    for (auto v : values) ret += v;
+    return ret;
+  }, os);
+  measure(c, f, name, "count_lt", size, [&]() {
+    $u64 ret = 0;
+    for (auto v : values) ret += v < m;
+    return ret;
+  }, os);
+  measure(c, f, name, "count_between", size, [&]() {
+    $u64 ret = 0;
+    for (auto v : values) ret += v >= lo && v <= hi;
+    return ret;
+  }, os);
+  measure(c, f, name, "lt", size, [&]() {
+    dtl::bitmap ret(values.size());
+    for (std::size_t i = 0; i < values.size(); ++i) ret[i] = values[i] < m;
+    return u64(ret.count());
+  }, os);
+  measure(c, f, name, "sum_lt", size, [&]() {
+    $u64 ret = 0;
+    for (auto v : values) ret += v < m ? v : 0;
+    return ret;
+  }, os);
+  measure(c, f, name, "top_k", size, [&]() {
+    std::vector<$u32> cpy = values;
+    const auto k = std::min(TOP_K, u64(cpy.size()));
+    std::nth_element(cpy.begin(), cpy.begin() + k, cpy.end(),
+        std::greater<$u32>());
+    return u64(cpy[k - 1]);
+  }, os);
+}
+//===----------------------------------------------------------------------===//
+$i32 main() {
+  std::cerr << "run_id=" << RUN_ID << std::endl;
+  std::cerr << "build_id=" << BUILD_ID << std::endl;
+
+  for ($f64 f : {1.0, 8.0, 64.0}) {
+    for ($u32 c = 16; c <= (1u << 16); c <<= 2) {
+      if (c * f >= N / 4) continue;
+      std::vector<$u32> values;
+      try {
+        values = gen_random_integer_sequence_markov(N, c, f);
+      }
+      catch (std::exception& ex) {
+        std::cerr << "Skipping c=" << c << ", f=" << f << std::endl;
+        continue;
+      }
+      std::cerr << "c=" << c << ", f=" << f << std::endl;
+      run_scan(c, f, values, std::cout);
+      run_bsi<type_of<bitmap_t::teb_wrapper>::type>(c, f, values, std::cout);
+      run_bsi<type_of<bitmap_t::wah>::type>(c, f, values, std::cout);
+      run_bsi<type_of<bitmap_t::roaring>::type>(c, f, values, std::cout);
+      run_bsi<type_of<bitmap_t::xah32>::type>(c, f, values, std::cout);
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
@@ -0,0 +1,123 @@
+#include "experiments/util/bitmap_types.hpp"
+#include "experiments/util/gen.hpp"
+#include "version.h"
+
+#include <dtl/bitmap.hpp>
+#include <dtl/bitmap/index/bitmap_index.hpp>
+#include <dtl/bitmap/index/bitmap_index_loader.hpp>
+#include <dtl/dtl.hpp>
+#include <dtl/env.hpp>
+#include <dtl/thread.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Experiment: Load throughput of the (parallel) bitmap index bulk loader with
+//             a varying number of distinct values c (up to 10^5), clustering
+//             factors f and number of threads.
+//===----------------------------------------------------------------------===//
+// Identifies the benchmark run.
+static const i64 RUN_ID =
+    std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch())
+        .count();
+// The number of rows.
+static u64 N = dtl::env<$u64>::get("N", 1ull << 24);
+// The number of repetitions per configuration.
+static u64 REPS = dtl::env<$u64>::get("REPS", 3);
+//===----------------------------------------------------------------------===//
+static u64
+now_nanos() {
+  return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+//===----------------------------------------------------------------------===//
+template<typename B, dtl::bitmap_index_encoding E>
+void __attribute__((noinline))
+run(u32 c, f64 f, u64 thread_cnt, const std::vector<$u32>& values,
+    std::ostream& os) {
+  using index_t = dtl::bitmap_index<B, E>;
+
+  // Measure the partitioning phase separately.
+  $u64 partition_nanos = ~0ull;
+  for (std::size_t r = 0; r < REPS; ++r) {
+    const auto begin = now_nanos();
+    const auto rows = dtl::partition_rows(values, c, thread_cnt);
+    partition_nanos = std::min(partition_nanos, now_nanos() - begin);
+  }
+
+  $u64 load_nanos = ~0ull;
+  std::size_t size_in_bytes = 0;
+  for (std::size_t r = 0; r < REPS; ++r) {
+    const auto begin = now_nanos();
+    const index_t index(values, c, thread_cnt);
+    load_nanos = std::min(load_nanos, now_nanos() - begin);
+    size_in_bytes = index.size_in_bytes();
+  }
+
+  const auto rows_per_sec = (values.size() * 1e9) / load_nanos;
+  os << RUN_ID
+     << ",\"" << BUILD_ID << "\""
+     << "," << values.size()
+     << "," << c
+     << "," << f
+     << ",\"" << index_t::name() << "\""
+     << "," << (dtl::internal::is_position_constructible<B>::value ? 1 : 0)
+     << "," << thread_cnt
+     << "," << partition_nanos
+     << "," << load_nanos
+     << "," << rows_per_sec
+     << "," << size_in_bytes
+     << std::endl;
+}
+//===----------------------------------------------------------------------===//
+$i32 main() {
+  std::cerr << "run_id=" << RUN_ID << std::endl;
+  std::cerr << "build_id=" << BUILD_ID << std::endl;
+
+  const auto max_thread_cnt = dtl::this_thread::get_cpu_affinity().count();
+  std::vector<$u64> thread_cnts;
+  for ($u64 t = 1; t < max_thread_cnt; t <<= 1) {
+    thread_cnts.push_back(t);
+  }
+  thread_cnts.push_back(max_thread_cnt);
+
+  using enc = dtl::bitmap_index_encoding;
+  for ($f64 f : {1.0, 8.0, 64.0}) {
+    for ($u32 c : {10u, 100u, 1000u, 10000u, 100000u}) {
+      if (c * f >= N / 4) continue;
+      std::vector<$u32> values;
+      try {
+        values = gen_random_integer_sequence_markov(N, c, f);
+      }
+      catch (std::exception& ex) {
+        std::cerr << "Skipping n=" << N << ", c=" << c << ", f=" << f
+                  << std::endl;
+        continue;
+      }
+      for (auto thread_cnt : thread_cnts) {
+        std::cerr << "c=" << c << ", f=" << f
+                  << ", thread_cnt=" << thread_cnt << std::endl;
+        run<type_of<bitmap_t::teb_wrapper>::type, enc::EQUALITY>(
+            c, f, thread_cnt, values, std::cout);
+        run<type_of<bitmap_t::wah>::type, enc::EQUALITY>(
+            c, f, thread_cnt, values, std::cout);
+        run<type_of<bitmap_t::xah32>::type, enc::EQUALITY>(
+            c, f, thread_cnt, values, std::cout);
+        run<type_of<bitmap_t::uah32>::type, enc::EQUALITY>(
+            c, f, thread_cnt, values, std::cout);
+        if (c <= 1000) {
+          run<type_of<bitmap_t::teb_wrapper>::type, enc::INTERVAL>(
+              c, f, thread_cnt, values, std::cout);
+          run<type_of<bitmap_t::xah32>::type, enc::RANGE>(
+              c, f, thread_cnt, values, std::cout);
+        }
+      }
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
@@ -0,0 +1,160 @@
+#include "experiments/util/bitmap_types.hpp"
+#include "experiments/util/seq_db.hpp"
+#include "version.h"
+
+#include <dtl/bitmap.hpp>
+#include <dtl/bitmap/index/bitmap_index.hpp>
+#include <dtl/dtl.hpp>
+#include <dtl/env.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Experiment: This experiment constructs bitmap indexes (equality, range and
+//             interval encoded) from the integer sequences in the sequence
+//             database and measures the query performance of equality,
+//             IN-list and range predicates with varying c and f.
+//
+//             The sequences need to be generated first, e.g., by running
+//             ex_index_compression with GEN_DATA=1.
+//===----------------------------------------------------------------------===//
+// Identifies the benchmark run.
+static const i64 RUN_ID =
+    std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch())
+        .count();
+// The data set.
+static const std::string DB_FILE =
+    dtl::env<std::string>::get("DB_FILE", "./random_sequences.sqlite3");
+static seq_db db(DB_FILE);
+// The number of rows.
+static u64 N = dtl::env<$u64>::get("N", 1ull << 20);
+// The number of queries per predicate type.
+static u64 QUERY_CNT = dtl::env<$u64>::get("QUERY_CNT", 100);
+// The number of values in the IN-lists.
+static u64 IN_LIST_LENGTH = dtl::env<$u64>::get("IN_LIST_LENGTH", 8);
+// The selectivity of the range predicates (fraction of the value domain).
+static f64 RANGE_SEL = dtl::env<$f64>::get("RANGE_SEL", 0.1);
+//===----------------------------------------------------------------------===//
+static u64
+now_nanos() {
+  return static_cast<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+//===----------------------------------------------------------------------===//
+/// Counts the 1-bits produced by the given run iterator.
+template<typename It>
+static std::size_t __attribute__((noinline))
+consume(It&& it) {
+  std::size_t cnt = 0;
+  while (!it.end()) {
+    cnt += it.length();
+    it.next();
+  }
+  return cnt;
+}
+//===----------------------------------------------------------------------===//
+template<typename B, dtl::bitmap_index_encoding E>
+void __attribute__((noinline))
+run(u64 seq_id, u64 n, u32 c, f64 f, const std::vector<$u32>& values,
+    std::ostream& os) {
+  using index_t = dtl::bitmap_index<B, E>;
+
+  const auto build_begin = now_nanos();
+  const index_t index(values, c);
+  const auto build_nanos = now_nanos() - build_begin;
+
+  // Generate the queries (the same for all types and encodings).
+  std::mt19937 gen(static_cast<u32>(seq_id));
+  std::vector<$u32> eq_values(QUERY_CNT);
+  std::vector<std::vector<$u32>> in_lists(QUERY_CNT);
+  std::vector<std::pair<$u32, $u32>> ranges(QUERY_CNT);
+  const u32 range_width =
+      std::max(1u, static_cast<$u32>(c * RANGE_SEL));
+  for (std::size_t q = 0; q < QUERY_CNT; ++q) {
+    eq_values[q] = gen() % c;
+    in_lists[q].resize(IN_LIST_LENGTH);
+    for (auto& v : in_lists[q]) v = gen() % c;
+    const u32 lo = gen() % (c - range_width + 1);
+    ranges[q] = std::make_pair(lo, lo + range_width - 1);
+  }
+
+  auto measure = [&](const std::string& predicate, auto fn) {
+    std::size_t checksum = 0;
+    const auto nanos_begin = now_nanos();
+    for (std::size_t q = 0; q < QUERY_CNT; ++q) {
+      checksum += fn(q);
+    }
+    const auto nanos = (now_nanos() - nanos_begin) / QUERY_CNT;
+    os << RUN_ID
+       << ",\"" << BUILD_ID << "\""
+       << "," << n
+       << "," << c
+       << "," << f
+       << "," << seq_id
+       << ",\"" << B::name() << "\""
+       << ",\"" << index_t::name() << "\""
+       << "," << index.bitmap_cnt()
+       << "," << index.size_in_bytes()
+       << "," << build_nanos
+       << ",\"" << predicate << "\""
+       << "," << nanos
+       << "," << checksum
+       << std::endl;
+  };
+  measure("eq", [&](std::size_t q) {
+    return consume(index.eq_it(eq_values[q]));
+  });
+  measure("in", [&](std::size_t q) {
+    return consume(index.in_it(in_lists[q]));
+  });
+  measure("range", [&](std::size_t q) {
+    return consume(index.range_it(ranges[q].first, ranges[q].second));
+  });
+}
+//===----------------------------------------------------------------------===//
+template<typename B>
+void
+run_all_encodings(u64 seq_id, u64 n, u32 c, f64 f,
+    const std::vector<$u32>& values, std::ostream& os) {
+  using enc = dtl::bitmap_index_encoding;
+  run<B, enc::EQUALITY>(seq_id, n, c, f, values, os);
+  run<B, enc::RANGE>(seq_id, n, c, f, values, os);
+  run<B, enc::INTERVAL>(seq_id, n, c, f, values, os);
+}
+//===----------------------------------------------------------------------===//
+$i32 main() {
+  std::cerr << "run_id=" << RUN_ID << std::endl;
+  if (db.empty()) {
+    std::cerr << "Integer sequence database is empty. Use ex_index_compression "
+                 "with GEN_DATA=1 to populate the database."
+              << std::endl;
+    std::exit(1);
+  }
+
+  for ($f64 f = 1; f <= 128; f *= 2) {
+    for ($u32 c = 8; c <= 8192; c *= 2) {
+      const auto seq_ids = db.find(N, c, f);
+      if (seq_ids.empty()) continue;
+      // A single sequence per configuration is sufficient to measure the
+      // query performance.
+      const auto seq_id = seq_ids.front();
+      const auto values = db.get(seq_id);
+      std::cerr << "n=" << N << ", c=" << c << ", f=" << f << std::endl;
+      run_all_encodings<type_of<bitmap_t::teb_wrapper>::type>(
+          seq_id, N, c, f, values, std::cout);
+      run_all_encodings<type_of<bitmap_t::wah>::type>(
+          seq_id, N, c, f, values, std::cout);
+      run_all_encodings<type_of<bitmap_t::roaring>::type>(
+          seq_id, N, c, f, values, std::cout);
+      run_all_encodings<type_of<bitmap_t::xah32>::type>(
+          seq_id, N, c, f, values, std::cout);
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
@@ -3,6 +3,7 @@
 #include "experiments/util/bitmap_db.hpp"
 #include "experiments/util/bitmap_types.hpp"
 #include "experiments/util/config.hpp"
+#include "experiments/util/dataset.hpp"
 #include "experiments/util/threading.hpp"
 #include "version.h"
 
@@ -39,13 +40,9 @@ static const i64 RUN_ID =
     std::chrono::duration_cast<std::chrono::seconds>(
         std::chrono::system_clock::now().time_since_epoch())
         .count();
-/// The database file where the bitmaps are stored.
-static const std::string DB_FILE =
-    dtl::env<std::string>::get("DB_FILE", "./random_bitmaps.sqlite3");
 /// 0 = run experiment, 1 = generate data for the experiment
 static u64 GEN_DATA = dtl::env<$u64>::get("GEN_DATA", 0);
-/// The database instance where the bitmaps are stored.
-static bitmap_db db(DB_FILE);
+//===----------------------------------------------------------------------===//
 /// Each measurement is repeated until the time below is elapsed.
 //static $u64 RUN_DURATION_NANOS = 250e6; // run for at least 250ms
 static $u64 RUN_DURATION_NANOS = 1250e6; // run for at least 1250ms
@@ -62,7 +59,7 @@ run(const config& c, std::ostream& os) {
   const auto duration_nanos = RUN_DURATION_NANOS;
   const std::size_t MIN_REPS = 10;
   // Load the bitmap from DB.
-  const auto bs = db.load_bitmap(c.bitmap_id);
+  const auto bs = load_bitmap(c.bitmap_id);
   const auto bs_count = bs.count();
   // Encode the bitmap.
   const T enc_bs(bs);
@@ -217,6 +214,22 @@ void run(config c, std::ostream& os) {
     case bitmap_t::wah:
       run<dtl::dynamic_wah32>(c, os);
       break;
+
+#define __GENERATE_CASE(name)                  \
+  case bitmap_t::name:                         \
+    run<type_of<bitmap_t::name>::type>(c, os); \
+    break;
+
+    __GENERATE_CASE(elias_fano)
+    __GENERATE_CASE(partitioned_elias_fano)
+
+    __GENERATE_CASE(delta_bp128)
+    __GENERATE_CASE(partitioned_delta_bp128)
+
+    __GENERATE_CASE(bbc)
+    __GENERATE_CASE(bbc_skip)
+
+#undef __GENERATE_CASE
       // clang-format off
 //    case bitmap_t::teb_scan: /* deprecated*/
 //      run<dtl::teb_scan<>>(c, os);
@@ -10,8 +10,8 @@ run_intersect(const config_pair& c, std::ostream& os) {
   const auto duration_nanos = RUN_DURATION_NANOS;
   const std::size_t MIN_REPS = 10;
   // Load the bitmap from DB.
-  const auto bs1 = db.load_bitmap(c.bitmap_id1);
-  const auto bs2 = db.load_bitmap(c.bitmap_id2);
+  const auto bs1 = load_bitmap(c.bitmap_id1);
+  const auto bs2 = load_bitmap(c.bitmap_id2);
   // Encode the bitmap.
   const T enc_bs1(bs1);
   const T enc_bs2(bs2);
@@ -162,6 +162,19 @@ void run_intersect(config_pair c, std::ostream& os) {
     case bitmap_t::teb_wrapper:
       run_intersect<dtl::teb_wrapper>(c, os);
       break;
+
+#define __GENERATE_CASE(name)                            \
+  case bitmap_t::name:                                   \
+    run_intersect<type_of<bitmap_t::name>::type>(c, os); \
+    break;
+
+    __GENERATE_CASE(elias_fano)
+    __GENERATE_CASE(partitioned_elias_fano)
+
+    __GENERATE_CASE(delta_bp128)
+    __GENERATE_CASE(partitioned_delta_bp128)
+
+#undef __GENERATE_CASE
       // clang-format off
 //    case bitmap_t::teb_scan:
 //      run_intersect<dtl::teb_scan<>>(c, os);
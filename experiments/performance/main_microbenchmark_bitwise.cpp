@@ -0,0 +1,94 @@
+#include <dtl/bitmap/util/bitmap_fun.hpp>
+#include <dtl/bitmap/util/plain_bitmap.hpp>
+#include <dtl/dtl.hpp>
+#include <dtl/env.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Micro-Experiment: Compare the fused (multi-operand) bitwise operations of
+// plain bitmaps with the evaluation using binary operators, which
+// materializes the intermediate results.
+//===----------------------------------------------------------------------===//
+/// The number of repetitions per measurement.
+static u64 REPEAT_CNT = dtl::env<$u64>::get("REPEAT_CNT", 10);
+/// The bitmap lengths (in number of 64-bit words) we test.
+std::vector<$u64> word_cnts = { 1ull << 10, 1ull << 14, 1ull << 18,
+    1ull << 20, 1ull << 22 };
+//===----------------------------------------------------------------------===//
+// Helper
+auto now_nanos = []() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+};
+//===----------------------------------------------------------------------===//
+/// Measures the given function and prints the throughput.
+void
+measure(const std::string& name, u64 word_cnt,
+    const std::function<std::size_t()>& fn) {
+  std::size_t checksum = 0;
+  // Warm up.
+  checksum += fn();
+  const auto nanos_begin = now_nanos();
+  for (std::size_t r = 0; r < REPEAT_CNT; ++r) {
+    checksum += fn();
+  }
+  const auto nanos_end = now_nanos();
+  const auto nanos = (nanos_end - nanos_begin) * 1.0 / REPEAT_CNT;
+  std::cout << name
+            << "," << word_cnt
+            << "," << (nanos / word_cnt)
+            << "," << (nanos / 1e6) // ms
+            << "," << checksum
+            << std::endl;
+}
+//===----------------------------------------------------------------------===//
+$i32 main() {
+  using bitmap_t = dtl::plain_bitmap<$u64>;
+  using fn = dtl::bitmap_fun<$u64>;
+  constexpr u8 a_and_b_and_not_c =
+      u8(fn::ternary_a & fn::ternary_b & ~fn::ternary_c);
+
+  std::mt19937_64 gen(42);
+  std::cout << "name,word_cnt,ns_per_word,ms,checksum" << std::endl;
+  for (auto word_cnt : word_cnts) {
+    const std::size_t n = word_cnt * 64;
+    std::vector<bitmap_t> bms(4, bitmap_t(n, false));
+    for (auto& bm : bms) {
+      for (std::size_t i = 0; i < word_cnt; ++i) {
+        bm.data()[i] = gen();
+      }
+    }
+    const auto& a = bms[0];
+    const auto& b = bms[1];
+    const auto& c = bms[2];
+    const auto& d = bms[3];
+
+    // (a & b & ~c) | d
+    measure("expr_materialized", word_cnt,
+        [&]() { return ((a & b & ~c) | d).data()[0]; });
+    measure("expr_fused", word_cnt,
+        [&]() {
+          auto r = bitmap_t::ternary<a_and_b_and_not_c>(a, b, c);
+          r |= d;
+          return r.data()[0];
+        });
+
+    // a & b & c & d
+    measure("and4_materialized", word_cnt,
+        [&]() { return (a & b & c & d).data()[0]; });
+    measure("and4_fused", word_cnt,
+        [&]() {
+          auto r = a;
+          r.and_assign({ &b, &c, &d });
+          return r.data()[0];
+        });
+  }
+}
+//===----------------------------------------------------------------------===//
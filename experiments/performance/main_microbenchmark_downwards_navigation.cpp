@@ -1,9 +1,10 @@
-#include "experiments/util/bitmap_db.hpp"
+#include "experiments/util/dataset.hpp"
 #include "experiments/util/gen.hpp"
 #include "experiments/util/threading.hpp"
 #include "thirdparty/perfevent/PerfEvent.hpp"
 
 #include <dtl/bitmap/teb_legacy.hpp>
+#include <dtl/bitmap/teb_stats.hpp>
 #include <dtl/bitmap/teb_wrapper.hpp>
 #include <dtl/bitmap/util/convert.hpp>
 #include <dtl/dtl.hpp>
@@ -19,11 +20,6 @@
 //===----------------------------------------------------------------------===//
 // Micro-Experiment: Determine the costs of downward navigational steps.
 //===----------------------------------------------------------------------===//
-/// The database file where the bitmaps are stored.
-static const std::string DB_FILE =
-    dtl::env<std::string>::get("DB_FILE", "./random_bitmaps.sqlite3");
-/// The database instance where the bitmaps are stored.
-bitmap_db db(DB_FILE);
 /// The clustering factor needs to be 1, to ensure that we navigate downwards
 /// the tree until the very last level.
 f64 F = 1.0;
@@ -47,7 +43,7 @@ auto now_nanos = []() {
 //===----------------------------------------------------------------------===//
 void run(u64 n, f64 f, f64 d, i64 bitmap_id) {
   const auto bid = bitmap_id;
-  const auto plain_bitmap = db.load_bitmap(bid);
+  const auto plain_bitmap = load_bitmap(bid);
 
   using T = dtl::teb_wrapper;
   //  using T = dtl::teb<3>;
@@ -72,6 +68,8 @@ void run(u64 n, f64 f, f64 d, i64 bitmap_id) {
 
   auto it = enc_bitmap.it();
   std::size_t repeat_cnt = 0;
+  auto& stats = dtl::teb_stats::local();
+  stats.reset();
   PerfEvent e;
   e.startCounters();
   std::size_t chksum = 0;
@@ -94,6 +92,11 @@ void run(u64 n, f64 f, f64 d, i64 bitmap_id) {
             << "," << (e.getCounter("instructions") / down_step_sum)
             << "," << (e.getCounter("branch-misses") / down_step_sum)
             << "," << e.getIPC()
+            // The TEB counters are zero unless compiled with TEB_STATS.
+            << "," << (static_cast<$f64>(stats.descent_steps) / down_step_sum)
+            << "," << (static_cast<$f64>(stats.rank_calls) / down_step_sum)
+            << "," << (static_cast<$f64>(stats.lut_cache_line_touches) / down_step_sum)
+            << "," << (static_cast<$f64>(stats.label_lookups) / down_step_sum)
             << "," << type_info
             << "," << chksum
             << std::endl;
@@ -103,18 +106,20 @@ $i32 main() {
   std::vector<$i64> bitmap_ids;
 
   for (auto d : bit_densities) {
-    const auto ids = db.find_bitmaps(N, F, d);
+    const auto ids = find_bitmaps(N, F, d);
     if (ids.empty()) {
       const auto bitmap = gen_random_bitmap_markov(N, F, d);
-      const auto id = db.store_bitmap(N, F, d, bitmap);
+      const auto id = store_bitmap(N, F, d, bitmap);
       bitmap_ids.push_back(id);
     }
   }
 
   // CSV header
-  std::cerr << "n,f,d,cycles,instructions,branch-misses,ipc,info,dontcare" << std::endl;
+  std::cerr << "n,f,d,cycles,instructions,branch-misses,ipc,"
+               "descent_steps,rank_calls,lut_cache_line_touches,label_lookups,"
+               "info,dontcare" << std::endl;
   for (auto d : bit_densities) {
-    const auto ids = db.find_bitmaps(N, F, d);
+    const auto ids = find_bitmaps(N, F, d);
     if (!ids.empty()) {
       run(N, F, d, ids[0]);
     }
@@ -0,0 +1,146 @@
+#include <dtl/bitmap/util/plain_bitmap.hpp>
+#include <dtl/bitmap/util/popcount.hpp>
+#include <dtl/bitmap/util/rank1_logic_surf.hpp>
+#include <dtl/bits.hpp>
+#include <dtl/dtl.hpp>
+#include <dtl/env.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Micro-Experiment: Compare the popcount implementations with the original
+// word-at-a-time loop.
+//===----------------------------------------------------------------------===//
+/// The number of repetitions per measurement.
+static u64 REPEAT_CNT = dtl::env<$u64>::get("REPEAT_CNT", 10);
+/// The bitmap lengths (in number of 64-bit words) we test.
+std::vector<$u64> word_cnts = { 1ull << 6, 1ull << 10, 1ull << 14, 1ull << 18,
+    1ull << 22 };
+//===----------------------------------------------------------------------===//
+// Helper
+auto now_nanos = []() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+};
+//===----------------------------------------------------------------------===//
+/// The original implementation of bitmap_fun::count().
+static std::size_t __attribute__((noinline))
+count_baseline(const $u64* a, const $u64* b, std::size_t word_cnt) {
+  std::size_t pop_cnt = 0;
+  for (std::size_t word_idx = 0; word_idx < word_cnt; ++word_idx) {
+    pop_cnt += dtl::bits::pop_count(
+        b == nullptr ? a[word_idx] : a[word_idx] & b[word_idx]);
+  }
+  return pop_cnt;
+}
+//===----------------------------------------------------------------------===//
+/// The original construction of the rank LuT (512-bit blocks).
+static void __attribute__((noinline))
+rank_lut_baseline(const $u64* data, std::size_t word_cnt, $u32* lut) {
+  using rank_t = dtl::rank1_logic_surf<$u64, false, 512>;
+  const std::size_t words_per_block = rank_t::words_per_block;
+  const std::size_t block_cnt =
+      (word_cnt + words_per_block - 1) / words_per_block;
+  $u32 bit_cntr = 0;
+  for (std::size_t i = 0; i < block_cnt; ++i) {
+    lut[i] = bit_cntr;
+    const auto word_cnt_in_current_block =
+        (i + 1) * words_per_block <= word_cnt
+        ? words_per_block
+        : word_cnt % words_per_block;
+    bit_cntr += rank_t::popcount_linear(data, i * words_per_block,
+        word_cnt_in_current_block * 64);
+  }
+  lut[block_cnt] = bit_cntr;
+}
+//===----------------------------------------------------------------------===//
+/// Measures the given function and prints the throughput.
+void
+measure(const std::string& name, u64 word_cnt,
+    const std::function<std::size_t()>& fn) {
+  std::size_t checksum = 0;
+  // Warm up.
+  checksum += fn();
+  const auto nanos_begin = now_nanos();
+  for (std::size_t r = 0; r < REPEAT_CNT; ++r) {
+    checksum += fn();
+  }
+  const auto nanos_end = now_nanos();
+  const auto nanos = (nanos_end - nanos_begin) * 1.0 / REPEAT_CNT;
+  std::cout << name
+            << "," << word_cnt
+            << "," << (nanos / word_cnt)
+            << "," << ((word_cnt * sizeof($u64)) / nanos) // GB/s
+            << "," << checksum
+            << std::endl;
+}
+//===----------------------------------------------------------------------===//
+$i32 main() {
+  std::cerr << "runtime dispatch: " << dtl::popcount::name() << std::endl;
+  __builtin_cpu_init();
+  const auto avx2 = __builtin_cpu_supports("avx2");
+  const auto avx512 = __builtin_cpu_supports("avx512vpopcntdq");
+
+  std::mt19937_64 gen(42);
+  std::cout << "name,word_cnt,ns_per_word,gb_per_sec,checksum" << std::endl;
+  for (auto word_cnt : word_cnts) {
+    const std::size_t n = word_cnt * 64;
+    dtl::plain_bitmap<$u64> a(n, false);
+    dtl::plain_bitmap<$u64> b(n, false);
+    for (std::size_t i = 0; i < word_cnt; ++i) {
+      a.data()[i] = gen();
+      b.data()[i] = gen();
+    }
+    const $u64* a_ptr = a.data();
+    const $u64* b_ptr = b.data();
+
+    // Count.
+    measure("count_baseline", word_cnt,
+        [&]() { return count_baseline(a_ptr, nullptr, word_cnt); });
+    measure("count_x86", word_cnt,
+        [&]() { return dtl::popcount::count_x86(a_ptr, nullptr, word_cnt); });
+    if (avx2) {
+      measure("count_avx2", word_cnt,
+          [&]() { return dtl::popcount::count_avx2(a_ptr, nullptr, word_cnt); });
+    }
+    if (avx512) {
+      measure("count_avx512", word_cnt,
+          [&]() { return dtl::popcount::count_avx512(a_ptr, nullptr, word_cnt); });
+    }
+    measure("count_dispatch", word_cnt,
+        [&]() { return dtl::popcount::count(a_ptr, word_cnt); });
+
+    // Range count with unaligned head and tail.
+    measure("range_count", word_cnt,
+        [&]() { return a.count(3, n - 5); });
+
+    // AND count.
+    measure("and_count_materialized", word_cnt,
+        [&]() { return (a & b).count(); });
+    measure("and_count_baseline", word_cnt,
+        [&]() { return count_baseline(a_ptr, b_ptr, word_cnt); });
+    measure("and_count", word_cnt,
+        [&]() { return a.and_count(b); });
+
+    // Rank LuT construction.
+    using rank_t = dtl::rank1_logic_surf<$u64, false, 512>;
+    std::vector<$u32> lut(rank_t::lut_entry_cnt(n));
+    measure("rank_lut_baseline", word_cnt,
+        [&]() {
+          rank_lut_baseline(a_ptr, word_cnt, lut.data());
+          return lut.back();
+        });
+    measure("rank_lut", word_cnt,
+        [&]() {
+          rank_t::init_inplace(a_ptr, a_ptr + word_cnt, lut.data());
+          return lut.back();
+        });
+  }
+}
+//===----------------------------------------------------------------------===//
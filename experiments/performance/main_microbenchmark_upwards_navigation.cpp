@@ -1,4 +1,4 @@
-#include "experiments/util/bitmap_db.hpp"
+#include "experiments/util/dataset.hpp"
 #include "experiments/util/gen.hpp"
 #include "experiments/util/threading.hpp"
 #include "thirdparty/perfevent/PerfEvent.hpp"
@@ -18,11 +18,6 @@
 //===----------------------------------------------------------------------===//
 // Micro-Experiment: Determine the costs of upward navigational steps.
 //===----------------------------------------------------------------------===//
-/// The database file where the bitmaps are stored.
-static const std::string DB_FILE =
-    dtl::env<std::string>::get("DB_FILE", "./random_bitmaps.sqlite3");
-/// The database instance where the bitmaps are stored.
-static bitmap_db db(DB_FILE);
 /// The clustering factor.
 f64 F = 1.0;
 /// The bit densities we test. Note that with higher density, the number of
@@ -42,7 +37,7 @@ auto now_nanos = []() {
 //===----------------------------------------------------------------------===//
 void run(u64 n, f64 f, f64 d, i64 bitmap_id) {
   const auto bid = bitmap_id;
-  const auto plain_bitmap = db.load_bitmap(bid);
+  const auto plain_bitmap = load_bitmap(bid);
 
   // We need to use an unoptimized TEB, otherwise the stack would be too small
   // to get reliable results.
@@ -95,17 +90,17 @@ $i32 main() {
   std::vector<$i64> bitmap_ids;
 
   for (auto d : bit_densities) {
-    const auto ids = db.find_bitmaps(N, F, d);
+    const auto ids = find_bitmaps(N, F, d);
     if (ids.empty()) {
       const auto bitmap = gen_random_bitmap_markov(N, F, d);
-      const auto id = db.store_bitmap(N, F, d, bitmap);
+      const auto id = store_bitmap(N, F, d, bitmap);
       bitmap_ids.push_back(id);
     }
   }
 
   std::cerr << "n,f,d,cycles,info" << std::endl;
   for (auto d : bit_densities) {
-    const auto ids = db.find_bitmaps(N, F, d);
+    const auto ids = find_bitmaps(N, F, d);
     if (!ids.empty()) {
       run(N, F, d, ids[0]);
     }
@@ -4,6 +4,8 @@
 #include "experiments/util/prep_data.hpp"
 
 #include <dtl/bitmap/part/part.hpp>
+#include <dtl/bitmap/uah.hpp>
+#include <dtl/bitmap/xah.hpp>
 #include <dtl/dtl.hpp>
 
 #include <iostream>
@@ -29,7 +31,7 @@ void gen_data(const std::vector<$u64>& n_values,
       }
     }
   }
-  prep_data(params, RUNS, db);
+  prep_data(params, RUNS);
   std::exit(0);
 }
 //===----------------------------------------------------------------------===//
@@ -44,7 +46,7 @@ run_construction_benchmark(const config& c, std::ostream& os) {
 #endif
 
   // Load the bitmap from DB.
-  const auto bs = db.load_bitmap(c.bitmap_id);
+  const auto bs = load_bitmap(c.bitmap_id);
   // Encode the bitmap.
   const T enc_bs(bs);
   // Validation code.
@@ -131,7 +133,7 @@ $i32 main() {
     std::exit(0);
   }
   else {
-    if (db.empty()) {
+    if (empty()) {
       std::cerr << "Bitmap database is empty. Use GEN_DATA=1 to populate the "
                    "database."
                 << std::endl;
@@ -151,7 +153,7 @@ $i32 main() {
         c.clustering_factor = f;
         c.density = d;
 
-        auto bitmap_ids = db.find_bitmaps(n, f, d);
+        auto bitmap_ids = find_bitmaps(n, f, d);
         if (bitmap_ids.empty()) {
           continue;
         }
@@ -177,6 +179,14 @@ $i32 main() {
         run_construction_benchmark<dtl::dynamic_roaring_bitmap>(c, os);
         run_construction_benchmark<dtl::teb_wrapper>(c, os);
         run_construction_benchmark<dtl::part<dtl::teb_wrapper, 1ull << 16>>(c, os);
+        run_construction_benchmark<dtl::uah8>(c, os);
+        run_construction_benchmark<dtl::uah16>(c, os);
+        run_construction_benchmark<dtl::uah32>(c, os);
+        run_construction_benchmark<dtl::uah64>(c, os);
+        run_construction_benchmark<dtl::xah8>(c, os);
+        run_construction_benchmark<dtl::xah16>(c, os);
+        run_construction_benchmark<dtl::xah32>(c, os);
+        run_construction_benchmark<dtl::xah64>(c, os);
   };
   const auto thread_cnt = 1; // run performance measurements single-threaded
   dispatch(configs, fn, thread_cnt);
@@ -106,7 +106,7 @@ $i32 main() {
         params.push_back(p);
       }
     }
-    prep_data(params, RUNS, db);
+    prep_data(params, RUNS);
     std::exit(0);
   }
 
@@ -121,8 +121,8 @@ $i32 main() {
   std::vector<config_pair> benchmark_configs;
 
   for (auto c : configs) {
-    auto bitmap_ids1 = db.find_bitmaps(c.n, c.clustering_factor1, c.density1);
-    auto bitmap_ids2 = db.find_bitmaps(c.n, c.clustering_factor2, c.density2);
+    auto bitmap_ids1 = find_bitmaps(c.n, c.clustering_factor1, c.density1);
+    auto bitmap_ids2 = find_bitmaps(c.n, c.clustering_factor2, c.density2);
     if (bitmap_ids1.size() < RUNS) {
       std::cerr << "There are only " << bitmap_ids1.size() << " prepared "
                 << "bitmaps for the parameters n=" << c.n << ", f="
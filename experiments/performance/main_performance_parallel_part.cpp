@@ -0,0 +1,117 @@
+#include "common.hpp"
+#include "experiments/util/gen.hpp"
+
+#include <dtl/bitmap/part/part.hpp>
+#include <dtl/bitmap/part/part_parallel.hpp>
+#include <dtl/bitmap/teb_wrapper.hpp>
+#include <dtl/dtl.hpp>
+#include <dtl/env.hpp>
+
+#include <iostream>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Experiment: Scalability of the parallel (partition-wise) bitwise operations
+//             on partitioned bitmaps with a varying number of threads.
+//===----------------------------------------------------------------------===//
+/// The length of the bitmaps.
+static u64 PAR_N = dtl::env<$u64>::get("N", 1ull << 26);
+/// The clustering factor of the bitmaps.
+static f64 PAR_F = dtl::env<$f64>::get("F", 8);
+/// The bit density of the bitmaps.
+static f64 PAR_D = dtl::env<$f64>::get("D", 0.1);
+//===----------------------------------------------------------------------===//
+/// The output modes.
+enum class output_t {
+  /// Produce a (compressed) partitioned bitmap.
+  PART,
+  /// Produce a concatenated stream of 1-runs.
+  RUNS,
+};
+//===----------------------------------------------------------------------===//
+template<typename T>
+void __attribute__((noinline))
+run_parallel_benchmark(const dtl::bitmap& bs_a, const dtl::bitmap& bs_b,
+    const std::string& op, output_t output, u64 thread_cnt, std::ostream& os) {
+  const auto duration_nanos = RUN_DURATION_NANOS;
+  const std::size_t MIN_REPS = 3;
+
+  const T enc_a(bs_a);
+  const T enc_b(bs_b);
+
+  auto exec = [&]() -> std::size_t {
+    if (output == output_t::PART) {
+      if (op == "and") return dtl::parallel_and(enc_a, enc_b, thread_cnt).size_in_bytes();
+      if (op == "or") return dtl::parallel_or(enc_a, enc_b, thread_cnt).size_in_bytes();
+      return dtl::parallel_xor(enc_a, enc_b, thread_cnt).size_in_bytes();
+    }
+    else {
+      if (op == "and") return dtl::parallel_and_runs(enc_a, enc_b, thread_cnt).size();
+      if (op == "or") return dtl::parallel_or_runs(enc_a, enc_b, thread_cnt).size();
+      return dtl::parallel_xor_runs(enc_a, enc_b, thread_cnt).size();
+    }
+  };
+
+  // Warm up run.
+  std::size_t checksum = exec();
+
+  // The actual measurement.
+  $u64 runtime_nanos = 0;
+  {
+    const auto nanos_begin = now_nanos();
+    std::size_t rep_cntr = 0;
+    while (now_nanos() - nanos_begin < duration_nanos || rep_cntr < MIN_REPS) {
+      ++rep_cntr;
+      checksum += exec();
+    }
+    const auto nanos_end = now_nanos();
+    runtime_nanos = (nanos_end - nanos_begin) / rep_cntr;
+  }
+
+  std::string type_info = enc_a.info();
+  boost::replace_all(type_info, "\"", "\"\""); // Escape JSON for CSV output.
+
+  os << RUN_ID
+     << ",\"" << BUILD_ID << "\""
+     << "," << bs_a.size()
+     << "," << "\"" << T::name() << "\""
+     << "," << "\"" << op << "\""
+     << "," << "\"" << (output == output_t::PART ? "part" : "runs") << "\""
+     << "," << thread_cnt
+     << "," << runtime_nanos
+     << "," << PAR_D
+     << "," << PAR_F
+     << ","
+     << "\"" << type_info << "\""
+     << "," << checksum
+     << std::endl;
+}
+//===----------------------------------------------------------------------===//
+$i32 main() {
+  std::cerr << "run_id=" << RUN_ID << std::endl;
+  std::cerr << "build_id=" << BUILD_ID << std::endl;
+
+  const auto bs_a = gen_random_bitmap_markov(PAR_N, PAR_F, PAR_D);
+  const auto bs_b = gen_random_bitmap_markov(PAR_N, PAR_F, PAR_D);
+
+  // Double the number of threads up to the number of available cores.
+  std::vector<$u64> thread_cnts;
+  for ($u64 t = 1; t < cpu_mask.count(); t <<= 1) {
+    thread_cnts.push_back(t);
+  }
+  thread_cnts.push_back(cpu_mask.count());
+
+  using part_teb = dtl::part<dtl::teb_wrapper, 1ull << 16>;
+  using part_wah = dtl::part<dtl::dynamic_wah32, 1ull << 16>;
+  for (auto output : {output_t::RUNS, output_t::PART}) {
+    for (const std::string op : {"and", "or", "xor"}) {
+      for (auto thread_cnt : thread_cnts) {
+        std::cerr << "op=" << op << ", thread_cnt=" << thread_cnt << std::endl;
+        run_parallel_benchmark<part_teb>(bs_a, bs_b, op, output, thread_cnt,
+            std::cout);
+        run_parallel_benchmark<part_wah>(bs_a, bs_b, op, output, thread_cnt,
+            std::cout);
+      }
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
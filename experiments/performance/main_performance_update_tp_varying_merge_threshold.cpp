@@ -156,11 +156,11 @@ template<typename T, typename M>
 void
 do_measurement(task& t) {
   // The bitmap that is used as starting point.
-  const auto bm_a = db.load_bitmap(t.bitmap_id_a);
+  const auto bm_a = load_bitmap(t.bitmap_id_a);
   const auto bm_a_density = dtl::determine_bit_density(bm_a);
   const auto bm_a_clustering_factor = dtl::determine_clustering_factor(bm_a);
   // The second bitmap determines the updates to perform.
-  const auto bm_b = db.load_bitmap(t.bitmap_id_b);
+  const auto bm_b = load_bitmap(t.bitmap_id_b);
   const auto bm_b_density = dtl::determine_bit_density(bm_b);
   const auto bm_b_clustering_factor = dtl::determine_clustering_factor(bm_b);
 
@@ -275,11 +275,11 @@ $i32 main() {
         }
       }
     }
-    prep_data(params, RUNS, db);
+    prep_data(params, RUNS);
     std::exit(0);
   }
   else {
-    if (db.empty()) {
+    if (empty()) {
       std::cerr << "Bitmap database is empty. Use GEN_DATA=1 to populate the "
                    "database."
                 << std::endl;
@@ -292,7 +292,7 @@ $i32 main() {
       for (auto n : n_values) {
         if (!markov_parameters_are_valid(n, f, d)) continue;
 
-        auto bitmap_ids = db.find_bitmaps(n, f, d);
+        auto bitmap_ids = find_bitmaps(n, f, d);
         if (bitmap_ids.empty()) {
           continue;
         }
@@ -306,7 +306,7 @@ $i32 main() {
           task t;
           t.bitmap_id_a = bitmap_ids[0];
           t.bitmap_id_b = bitmap_ids[1];
-          const auto bm_b = db.load_bitmap(t.bitmap_id_b);
+          const auto bm_b = load_bitmap(t.bitmap_id_b);
           t.update_threshold = std::min(std::size_t(100000), bm_b.count());
           std::cerr<< t.update_threshold << std::endl;
 //          do_measurement<diff_bitmap_t::part_teb,        diff_merge_t::no>(t); // DON'T! VERY SLOW
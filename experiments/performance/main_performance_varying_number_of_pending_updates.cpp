@@ -166,11 +166,11 @@ template<typename T, typename Tnodiff>
 void
 do_measurement(uint64_t bid_a, uint64_t bid_b) {
   // The bitmap that is used as starting point.
-  const auto bm_a = db.load_bitmap(bid_a);
+  const auto bm_a = load_bitmap(bid_a);
   const auto bm_a_density = dtl::determine_bit_density(bm_a);
   const auto bm_a_clustering_factor = dtl::determine_clustering_factor(bm_a);
   // The second bitmap determines the updates to perform.
-  const auto bm_b = db.load_bitmap(bid_b);
+  const auto bm_b = load_bitmap(bid_b);
   const auto bm_b_density = dtl::determine_bit_density(bm_b);
   const auto bm_b_clustering_factor = dtl::determine_clustering_factor(bm_b);
 
@@ -322,11 +322,11 @@ $i32 main() {
         }
       }
     }
-    prep_data(params, RUNS, db);
+    prep_data(params, RUNS);
     std::exit(0);
   }
   else {
-    if (db.empty()) {
+    if (empty()) {
       std::cerr << "Bitmap database is empty. Use GEN_DATA=1 to populate the "
                    "database."
                 << std::endl;
@@ -339,7 +339,7 @@ $i32 main() {
       for (auto n : n_values) {
         if (!markov_parameters_are_valid(n, f, d)) continue;
 
-        auto bitmap_ids = db.find_bitmaps(n, f, d);
+        auto bitmap_ids = find_bitmaps(n, f, d);
         if (bitmap_ids.empty()) {
           continue;
         }
@@ -352,7 +352,7 @@ $i32 main() {
         if (bitmap_ids.size() >= 2) {
           const auto bid_a = bitmap_ids[0];
           const auto bid_b = bitmap_ids[1];
-          auto bm_b = db.load_bitmap(bid_b);
+          auto bm_b = load_bitmap(bid_b);
           std::cerr << "popcount(bm_b)=" << bm_b.count() << std::endl;
           // The bitmap type to use as differential data structure.
           using D = dtl::dynamic_roaring_bitmap;
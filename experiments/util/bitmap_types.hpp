@@ -1,9 +1,15 @@
 #pragma once
 //===----------------------------------------------------------------------===//
 #include <dtl/bitmap/bah.hpp>
+#include <dtl/bitmap/bbc.hpp>
+#include <dtl/bitmap/bbc_skip.hpp>
+#include <dtl/bitmap/concise.hpp>
+#include <dtl/bitmap/concise_skip.hpp>
+#include <dtl/bitmap/delta_bp128.hpp>
 #include <dtl/bitmap/dynamic_bitmap.hpp>
 #include <dtl/bitmap/dynamic_roaring_bitmap.hpp>
 #include <dtl/bitmap/dynamic_wah.hpp>
+#include <dtl/bitmap/elias_fano.hpp>
 #include <dtl/bitmap/part/part.hpp>
 #include <dtl/bitmap/position_list.hpp>
 #include <dtl/bitmap/range_list.hpp>
@@ -77,8 +83,20 @@ enum class bitmap_t {
   bah,
   partitioned_bah,
 
+  concise,
+  concise_skip,
+
+  elias_fano,
+  partitioned_elias_fano,
+
+  delta_bp128,
+  partitioned_delta_bp128,
+
+  bbc,
+  bbc_skip,
+
   _first = bitmap,
-  _last = partitioned_bah
+  _last = bbc_skip
 };
 static const std::vector<bitmap_t>
     bitmap_t_list = []() {
@@ -349,4 +367,40 @@ template<>
 struct type_of<bitmap_t::partitioned_bah> {
   using type = dtl::part<dtl::bah, 1ull << 16>;
 };
+
+template<>
+struct type_of<bitmap_t::concise> {
+  using type = dtl::concise;
+};
+template<>
+struct type_of<bitmap_t::concise_skip> {
+  using type = dtl::concise_skip<>;
+};
+
+template<>
+struct type_of<bitmap_t::elias_fano> {
+  using type = dtl::elias_fano;
+};
+template<>
+struct type_of<bitmap_t::partitioned_elias_fano> {
+  using type = dtl::part<dtl::elias_fano, 1ull << 16>;
+};
+
+template<>
+struct type_of<bitmap_t::delta_bp128> {
+  using type = dtl::delta_bp128;
+};
+template<>
+struct type_of<bitmap_t::partitioned_delta_bp128> {
+  using type = dtl::part<dtl::delta_bp128, 1ull << 16>;
+};
+
+template<>
+struct type_of<bitmap_t::bbc> {
+  using type = dtl::bbc;
+};
+template<>
+struct type_of<bitmap_t::bbc_skip> {
+  using type = dtl::bbc_skip<>;
+};
 //===----------------------------------------------------------------------===//
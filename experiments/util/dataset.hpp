@@ -0,0 +1,81 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include "bitmap_db.hpp"
+#include "dataset_store.hpp"
+#include "params.hpp"
+#include "prep_data.hpp"
+
+#include <dtl/bitmap.hpp>
+#include <dtl/dtl.hpp>
+#include <dtl/env.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// The data sources of the experiments with synthetic bitmaps. The experiments
+// access the bitmaps only through the functions below, which use the binary
+// dataset store if it is set, and the database otherwise.
+//===----------------------------------------------------------------------===//
+/// The database file where the bitmaps are stored.
+static const std::string DB_FILE =
+    dtl::env<std::string>::get("DB_FILE", "./random_bitmaps.sqlite3");
+/// The (optional) binary dataset store, see experiments/util/dataset_store.hpp.
+/// If set, the bitmaps are stored in and loaded from the store instead of the
+/// database. The store can be created from the database using convert_db.
+static const std::string STORE_FILE =
+    dtl::env<std::string>::get("STORE_FILE", "");
+static std::unique_ptr<dataset_store> store(
+    STORE_FILE.empty() ? nullptr : new dataset_store(STORE_FILE));
+/// The database instance where the bitmaps are stored. The database is only
+/// opened if there is no store.
+static std::unique_ptr<bitmap_db> db(
+    store ? nullptr : new bitmap_db(DB_FILE));
+//===----------------------------------------------------------------------===//
+/// Loads the bitmap with the given ID.
+static dtl::bitmap
+load_bitmap(i64 id) {
+  return store ? store->load_bitmap(id) : db->load_bitmap(id);
+}
+//===----------------------------------------------------------------------===//
+/// Returns the IDs of the bitmaps that match n, f, and d.
+static std::vector<$i64>
+find_bitmaps(u64 n, f64 f, f64 d) {
+  return store ? store->find_bitmaps(n, f, d) : db->find_bitmaps(n, f, d);
+}
+static std::vector<$i64>
+find_bitmaps(u64 n, f64 d) {
+  return find_bitmaps(n, 0.0, d);
+}
+//===----------------------------------------------------------------------===//
+/// Returns true if there are no bitmaps.
+static u1
+empty() {
+  return store ? store->empty() : db->empty();
+}
+//===----------------------------------------------------------------------===//
+/// Stores the given bitmap and returns the ID.
+static i64
+store_bitmap(u64 n, f64 f, f64 d, const dtl::bitmap& b) {
+  return store
+      ? store->store_bitmap(n, f, d, b)
+      : db->store_bitmap(n, f, d, b);
+}
+static i64
+store_bitmap(u64 n, f64 d, const dtl::bitmap& b) {
+  return store_bitmap(n, 0.0, d, b);
+}
+//===----------------------------------------------------------------------===//
+/// Ensures that 'cnt' random bitmaps for each configuration are available,
+/// see prep_data.hpp.
+template<typename params_t>
+static void
+prep_data(std::vector<params_t>& params, std::size_t cnt) {
+  if (store) {
+    prep_data(params, cnt, *store);
+  }
+  else {
+    prep_data(params, cnt, *db);
+  }
+}
+//===----------------------------------------------------------------------===//
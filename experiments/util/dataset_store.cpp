@@ -0,0 +1,336 @@
+#include "dataset_store.hpp"
+
+#include <dtl/bitmap.hpp>
+#include <dtl/bitmap/util/random.hpp>
+#include <dtl/dtl.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+//===----------------------------------------------------------------------===//
+namespace {
+//===----------------------------------------------------------------------===//
+/// Identifies the file format.
+static constexpr char file_magic[8] = { 'D', 'T', 'L', 'D', 'A', 'T', 'A', '1' };
+//===----------------------------------------------------------------------===//
+/// Writes the given buffer to the file at the given offset.
+void
+write_fully(i32 fd, const void* buf, std::size_t len, u64 offset) {
+  auto* ptr = static_cast<u8*>(buf);
+  std::size_t written = 0;
+  while (written < len) {
+    const auto rc = ::pwrite(fd, ptr + written, len - written, offset + written);
+    if (rc < 0) {
+      if (errno == EINTR) continue;
+      std::stringstream err;
+      err << "Can't write data. Error: " << std::strerror(errno) << std::endl;
+      throw std::runtime_error(err.str());
+    }
+    written += static_cast<std::size_t>(rc);
+  }
+}
+//===----------------------------------------------------------------------===//
+/// Flushes the data written to the file to the storage device.
+void
+sync_data(i32 fd) {
+  while (::fdatasync(fd) != 0) {
+    if (errno == EINTR) continue;
+    std::stringstream err;
+    err << "Can't sync data. Error: " << std::strerror(errno) << std::endl;
+    throw std::runtime_error(err.str());
+  }
+}
+//===----------------------------------------------------------------------===//
+/// Inserts the given ID into the sorted vector.
+void
+insert_sorted(std::vector<$i64>& ids, i64 id) {
+  if (ids.empty() || ids.back() < id) {
+    ids.push_back(id);
+  }
+  else {
+    ids.insert(std::lower_bound(ids.begin(), ids.end(), id), id);
+  }
+}
+//===----------------------------------------------------------------------===//
+} // anonymous namespace
+//===----------------------------------------------------------------------===//
+dataset_store::dataset_store(const std::string& file)
+    : file_(file),
+      fd_(-1),
+      data_(nullptr),
+      file_size_(0),
+      next_id_ { 1, 1 },
+      offsets_(),
+      ids_(),
+      all_ids_(),
+      mutex_() {
+  open();
+}
+//===----------------------------------------------------------------------===//
+dataset_store::~dataset_store() {
+  close();
+}
+//===----------------------------------------------------------------------===//
+void dataset_store::open() {
+  fd_ = ::open(file_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) {
+    std::stringstream err;
+    err << "Can't open dataset store: " << file_ << ". Error: "
+        << std::strerror(errno)
+        << std::endl;
+    throw std::invalid_argument(err.str());
+  }
+  struct stat st;
+  if (::fstat(fd_, &st) != 0) {
+    std::stringstream err;
+    err << "Can't stat dataset store: " << file_ << ". Error: "
+        << std::strerror(errno)
+        << std::endl;
+    close();
+    throw std::runtime_error(err.str());
+  }
+  u64 size = static_cast<$u64>(st.st_size);
+
+  // Reserve the address range for the entire (max.) file. The pages become
+  // accessible as the file grows.
+  auto* addr = ::mmap(nullptr, max_file_size, PROT_READ,
+      MAP_SHARED | MAP_NORESERVE, fd_, 0);
+  if (addr == MAP_FAILED) {
+    std::stringstream err;
+    err << "Can't map dataset store: " << file_ << ". Error: "
+        << std::strerror(errno)
+        << std::endl;
+    close();
+    throw std::runtime_error(err.str());
+  }
+  data_ = reinterpret_cast<u8*>(addr);
+
+  if (size == 0) {
+    // A new file. Write the file header.
+    $u8 header[header_size] = {};
+    std::memcpy(header, file_magic, sizeof(file_magic));
+    write_fully(fd_, header, header_size, 0);
+    file_size_ = header_size;
+    return;
+  }
+  if (size < header_size
+      || std::memcmp(data_, file_magic, sizeof(file_magic)) != 0) {
+    std::stringstream err;
+    err << "Not a dataset store: " << file_ << std::endl;
+    close();
+    throw std::invalid_argument(err.str());
+  }
+
+  // Read the catalog. A truncated record at the end of the file (e.g., due to
+  // a crash while appending) is ignored and discarded.
+  $u64 offset = header_size;
+  while (offset + header_size <= size) {
+    const auto& e = *reinterpret_cast<const entry*>(data_ + offset);
+    if (e.record_kind != kind::bitmap && e.record_kind != kind::sequence) {
+      break;
+    }
+    const auto payload_size = (e.word_cnt * sizeof($u32) + header_size - 1)
+        / header_size * header_size;
+    if (offset + header_size + payload_size > size) break;
+    add_to_catalog(offset);
+    offset += header_size + payload_size;
+  }
+  file_size_ = offset;
+  if (file_size_ < size) {
+    // Discard the incomplete record, so that it cannot be mistaken for a valid
+    // one after a shorter record has been appended.
+    if (::ftruncate(fd_, static_cast<off_t>(file_size_)) != 0) {
+      std::stringstream err;
+      err << "Can't truncate dataset store: " << file_ << ". Error: "
+          << std::strerror(errno)
+          << std::endl;
+      close();
+      throw std::runtime_error(err.str());
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+void dataset_store::close() {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<$u8*>(data_), max_file_size);
+    data_ = nullptr;
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+//===----------------------------------------------------------------------===//
+i64 dataset_store::append(entry e, const void* words, u1 assign_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Critical section.
+  const auto k = kind_idx(e.record_kind);
+  if (assign_id) e.id = next_id_[k];
+  if (offsets_[k].count(e.id) != 0) {
+    std::stringstream err;
+    err << "Duplicate " << (k == 0 ? "bitmap" : "sequence") << " ID: " << e.id
+        << std::endl;
+    throw std::invalid_argument(err.str());
+  }
+  const auto payload_bytes = e.word_cnt * sizeof($u32);
+  const auto padding = (header_size - payload_bytes % header_size)
+      % header_size;
+  if (file_size_ + header_size + payload_bytes + padding > max_file_size) {
+    std::stringstream err;
+    err << "The dataset store exceeds the max. size of " << max_file_size
+        << " bytes." << std::endl;
+    throw std::runtime_error(err.str());
+  }
+  const $u8 zeros[header_size] = {};
+  // The payload is flushed to the storage device before the header is
+  // written, so that a record with a valid header always has a complete
+  // payload, even after a crash.
+  write_fully(fd_, words, payload_bytes, file_size_ + header_size);
+  write_fully(fd_, zeros, padding, file_size_ + header_size + payload_bytes);
+  sync_data(fd_);
+  write_fully(fd_, &e, header_size, file_size_);
+  add_to_catalog(file_size_);
+  file_size_ += header_size + payload_bytes + padding;
+  return e.id;
+}
+//===----------------------------------------------------------------------===//
+void dataset_store::add_to_catalog(u64 offset) {
+  const auto& e = *reinterpret_cast<const entry*>(data_ + offset);
+  const auto k = kind_idx(e.record_kind);
+  offsets_[k][e.id] = offset;
+  const auto key = e.record_kind == kind::bitmap
+      ? std::make_tuple(e.record_kind, e.n, e.f, e.d)
+      : std::make_tuple(e.record_kind, e.n, e.f, static_cast<$f64>(e.c));
+  insert_sorted(ids_[key], e.id);
+  insert_sorted(all_ids_[k], e.id);
+  next_id_[k] = std::max(next_id_[k], e.id + 1);
+}
+//===----------------------------------------------------------------------===//
+const dataset_store::entry&
+dataset_store::lookup(i64 id, kind k) const {
+  const auto& offsets = offsets_[kind_idx(k)];
+  const auto it = offsets.find(id);
+  if (it == offsets.end()) {
+    std::stringstream err;
+    err << "Can't fetch data. Unknown "
+        << (k == kind::bitmap ? "bitmap" : "sequence") << " ID: " << id
+        << std::endl;
+    throw std::runtime_error(err.str());
+  }
+  return *reinterpret_cast<const entry*>(data_ + it->second);
+}
+//===----------------------------------------------------------------------===//
+i64 dataset_store::store_bitmap(u64 n, f64 f, f64 d, const dtl::bitmap& b) {
+  return put_bitmap(0, n, f, d, b, true);
+}
+//===----------------------------------------------------------------------===//
+void dataset_store::import_bitmap(i64 id, u64 n, f64 f, f64 d,
+    const dtl::bitmap& b) {
+  put_bitmap(id, n, f, d, b, false);
+}
+//===----------------------------------------------------------------------===//
+i64 dataset_store::put_bitmap(i64 id, u64 n, f64 f, f64 d,
+    const dtl::bitmap& b, u1 assign_id) {
+  if (n != b.size()) {
+    std::stringstream err;
+    err << "The length of the bitmap (" << b.size() << ") does not match n ("
+        << n << ")." << std::endl;
+    throw std::invalid_argument(err.str());
+  }
+  entry e;
+  std::memset(&e, 0, sizeof(e));
+  e.record_kind = kind::bitmap;
+  e.id = id;
+  e.n = n;
+  e.f = f;
+  e.d = d;
+  // Determine the actual bit density and clustering factor.
+  e.f_actual = dtl::determine_clustering_factor(b);
+  e.d_actual = dtl::determine_bit_density(b);
+  e.word_cnt = b.num_blocks();
+  std::vector<$u32> words(b.num_blocks());
+  boost::to_block_range(b, words.begin());
+  return append(e, words.data(), assign_id);
+}
+//===----------------------------------------------------------------------===//
+dtl::bitmap
+dataset_store::load_bitmap(i64 id) const {
+  const auto& e = lookup(id, kind::bitmap);
+  const auto* words = reinterpret_cast<u32*>(payload(e));
+  dtl::bitmap ret(e.n);
+  boost::from_block_range(words, words + e.word_cnt, ret);
+  return ret;
+}
+//===----------------------------------------------------------------------===//
+std::vector<$i64>
+dataset_store::find_bitmaps(u64 n, f64 f, f64 d) const {
+  const auto it = ids_.find(std::make_tuple(kind::bitmap, n, f, d));
+  return it == ids_.end() ? std::vector<$i64>() : it->second;
+}
+//===----------------------------------------------------------------------===//
+i64 dataset_store::store_sequence(u64 n, u32 c, f64 f, const seq_t& s) {
+  return put_sequence(0, n, c, f, s, true);
+}
+//===----------------------------------------------------------------------===//
+void dataset_store::import_sequence(i64 id, u64 n, u32 c, f64 f,
+    const seq_t& s) {
+  put_sequence(id, n, c, f, s, false);
+}
+//===----------------------------------------------------------------------===//
+i64 dataset_store::put_sequence(i64 id, u64 n, u32 c, f64 f, const seq_t& s,
+    u1 assign_id) {
+  entry e;
+  std::memset(&e, 0, sizeof(e));
+  e.record_kind = kind::sequence;
+  e.c = c;
+  e.id = id;
+  e.n = n;
+  e.f = f;
+  // Determine the actual clustering factor.
+  e.f_actual = dtl::determine_clustering_factor(s);
+  e.word_cnt = s.size();
+  return append(e, s.data(), assign_id);
+}
+//===----------------------------------------------------------------------===//
+dataset_store::seq_t
+dataset_store::load_sequence(i64 id) const {
+  const auto v = view_sequence(id);
+  return seq_t(v.begin(), v.end());
+}
+//===----------------------------------------------------------------------===//
+dtl::data_view<u32>
+dataset_store::view_sequence(i64 id) const {
+  const auto& e = lookup(id, kind::sequence);
+  const auto* begin = reinterpret_cast<u32*>(payload(e));
+  return dtl::data_view<u32> { begin, begin + e.word_cnt };
+}
+//===----------------------------------------------------------------------===//
+std::vector<$i64>
+dataset_store::find_sequences(u64 n, u32 c, f64 f) const {
+  const auto it = ids_.find(
+      std::make_tuple(kind::sequence, n, f, static_cast<$f64>(c)));
+  return it == ids_.end() ? std::vector<$i64>() : it->second;
+}
+//===----------------------------------------------------------------------===//
+std::size_t
+dataset_store::count(kind k) const {
+  return all_ids_[kind_idx(k)].size();
+}
+//===----------------------------------------------------------------------===//
+u1 dataset_store::empty(kind k) const {
+  return count(k) == 0;
+}
+//===----------------------------------------------------------------------===//
+std::vector<$i64>
+dataset_store::ids(kind k) const {
+  return all_ids_[kind_idx(k)];
+}
+//===----------------------------------------------------------------------===//
@@ -0,0 +1,172 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include <dtl/bitmap.hpp>
+#include <dtl/bitmap/util/bitmap_view.hpp>
+#include <dtl/dtl.hpp>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+//===----------------------------------------------------------------------===//
+/// A binary store for the (randomly generated) bitmaps and integer sequences
+/// of the experiments, which is an alternative to bitmap_db and seq_db.
+///
+/// The data is stored uncompressed in a single append-only file. Each record
+/// consists of a 64-byte header (the parameters of the bitmap or sequence)
+/// followed by the raw words, padded to a multiple of 64 bytes. Thus, all
+/// words are 64-bit aligned. The file is memory-mapped, so that bitmaps can be
+/// accessed without copying or decoding them. The catalog, which maps IDs to
+/// records and the parameters (n, f, d) or (n, c, f) to IDs, is built when the
+/// file is opened.
+///
+/// Lookups and loads are lock-free and can be performed by any number of
+/// threads concurrently. Appends are serialized internally, but they must not
+/// run concurrently with lookups. In the experiments, the data is generated
+/// (GEN_DATA=1) and consumed in separate runs.
+class dataset_store {
+public:
+  using seq_t = std::vector<$u32>;
+
+  /// The kind of a record.
+  enum class kind : $u32 {
+    bitmap = 0x504d5442,   // "BTMP"
+    sequence = 0x20514553, // "SEQ "
+  };
+
+  /// A catalog entry.
+  struct entry {
+    kind record_kind;
+    /// The number of distinct values (sequences only).
+    $u32 c;
+    $i64 id;
+    /// The length of the bitmap or the sequence.
+    $u64 n;
+    $f64 f;
+    $f64 d;
+    $f64 f_actual;
+    $f64 d_actual;
+    /// The number of words (32 bit) that follow the header.
+    $u64 word_cnt;
+  };
+  static_assert(sizeof(entry) == 64, "The record header must be 64 bytes.");
+
+private:
+  const std::string file_;
+  /// The file descriptor.
+  $i32 fd_;
+  /// The beginning of the mapped address range.
+  u8* data_;
+  /// The size of the file, i.e., the offset of the next record.
+  $u64 file_size_;
+  /// The next ID per kind.
+  $i64 next_id_[2];
+  /// Maps IDs to the offsets of the records (per kind). Bitmaps and sequences
+  /// have separate ID spaces, like the tables in bitmap_db and seq_db.
+  std::unordered_map<$i64, $u64> offsets_[2];
+  /// Maps the parameters to the IDs.
+  std::map<std::tuple<kind, $u64, $f64, $f64>, std::vector<$i64>> ids_;
+  /// All IDs in ascending order.
+  std::vector<$i64> all_ids_[2];
+  /// Serializes appends.
+  std::mutex mutex_;
+
+public:
+  /// The size of the file header and of the record headers in bytes.
+  static constexpr std::size_t header_size = 64;
+  /// The max. size of the file. The address range is reserved upfront so that
+  /// the mapping remains valid when the file grows.
+  static constexpr std::size_t max_file_size = 1ull << 40;
+
+  /// Opens the given file, or creates it if it does not exist.
+  explicit dataset_store(const std::string& file);
+  virtual ~dataset_store();
+  dataset_store(const dataset_store& other) = delete;
+  dataset_store& operator=(const dataset_store& other) = delete;
+
+  /// Appends the given bitmap and returns the ID (thread-safe).
+  i64 store_bitmap(u64 n, f64 f, f64 d, const dtl::bitmap& b);
+  i64 store_bitmap(u64 n, f64 d, const dtl::bitmap& b) {
+    return store_bitmap(n, 0.0, d, b);
+  };
+  /// Appends the given bitmap using the given ID, e.g., when converting an
+  /// existing database (thread-safe).
+  void import_bitmap(i64 id, u64 n, f64 f, f64 d, const dtl::bitmap& b);
+  /// Loads (copies) the bitmap with the given ID.
+  dtl::bitmap load_bitmap(i64 id) const;
+  /// Returns a zero-copy view of the bitmap with the given ID. The words that
+  /// exceed the length of the bitmap are zero.
+  template<typename word_type = $u32>
+  dtl::bitmap_view<const word_type>
+  view_bitmap(i64 id) const {
+    const auto& e = lookup(id, kind::bitmap);
+    const auto* begin = reinterpret_cast<const word_type*>(payload(e));
+    const auto word_cnt = (e.n + sizeof(word_type) * 8 - 1)
+        / (sizeof(word_type) * 8);
+    return dtl::bitmap_view<const word_type>(begin, begin + word_cnt);
+  }
+  /// Returns the IDs of the bitmaps that match n, f, and d.
+  std::vector<$i64> find_bitmaps(u64 n, f64 f, f64 d) const;
+  std::vector<$i64> find_bitmaps(u64 n, f64 d) const {
+    return find_bitmaps(n, 0.0, d);
+  };
+
+  /// Appends the given sequence and returns the ID (thread-safe).
+  i64 store_sequence(u64 n, u32 c, f64 f, const seq_t& s);
+  /// Appends the given sequence using the given ID (thread-safe).
+  void import_sequence(i64 id, u64 n, u32 c, f64 f, const seq_t& s);
+  /// Loads (copies) the sequence with the given ID.
+  seq_t load_sequence(i64 id) const;
+  /// Returns a zero-copy view of the sequence with the given ID.
+  dtl::data_view<u32> view_sequence(i64 id) const;
+  /// Returns the IDs of the sequences that match n, c, and f.
+  std::vector<$i64> find_sequences(u64 n, u32 c, f64 f) const;
+
+  /// Returns true if the store contains a record of the given kind with the
+  /// given ID.
+  u1 contains(kind k, i64 id) const {
+    return offsets_[kind_idx(k)].count(id) != 0;
+  }
+  /// Returns the catalog entry of the record of the given kind and ID.
+  const entry& info(kind k, i64 id) const {
+    return lookup(id, k);
+  }
+  /// Returns the number of records of the given kind.
+  std::size_t count(kind k = kind::bitmap) const;
+  /// Returns true if the store does not contain any records of the given kind.
+  u1 empty(kind k = kind::bitmap) const;
+  /// Returns all IDs of the given kind.
+  std::vector<$i64> ids(kind k = kind::bitmap) const;
+
+private:
+  /// Maps the file and reads the catalog.
+  void open();
+  /// Unmaps and closes the file. Called by the destructor.
+  void close();
+  /// Prepares a bitmap record and appends it. If assign_id is set, the next
+  /// ID is used instead of the given one.
+  i64 put_bitmap(i64 id, u64 n, f64 f, f64 d, const dtl::bitmap& b,
+      u1 assign_id);
+  /// Prepares a sequence record and appends it.
+  i64 put_sequence(i64 id, u64 n, u32 c, f64 f, const seq_t& s,
+      u1 assign_id);
+  /// Appends a record and returns its ID (thread-safe).
+  i64 append(entry e, const void* words, u1 assign_id);
+  /// Adds the record at the given offset to the catalog.
+  void add_to_catalog(u64 offset);
+  /// Returns the catalog entry of the given kind and ID, or throws if there is
+  /// no such record.
+  const entry& lookup(i64 id, kind k) const;
+  /// Returns a pointer to the words of the given record.
+  static u8*
+  payload(const entry& e) {
+    return reinterpret_cast<u8*>(&e) + header_size;
+  }
+  static std::size_t
+  kind_idx(kind k) {
+    return k == kind::bitmap ? 0 : 1;
+  }
+};
+//===----------------------------------------------------------------------===//
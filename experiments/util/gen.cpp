@@ -1,6 +1,7 @@
 #include "gen.hpp"
 
 #include "bitmap_db.hpp"
+#include "dataset_store.hpp"
 #include "params.hpp"
 #include "threading.hpp"
 
@@ -11,13 +12,49 @@
 #include <cstddef>
 #include <functional>
 #include <iostream>
+#include <mutex>
 #include <random>
 #include <string>
 #include <vector>
 //===----------------------------------------------------------------------===//
+namespace {
+//===----------------------------------------------------------------------===//
+/// Returns true if the bitmap with the given ID matches the given bitmap.
+u1
+is_stored(bitmap_db& db, i64 id, const dtl::bitmap& b) {
+  return db.load_bitmap(id) == b;
+}
+/// Returns true if the bitmap with the given ID matches the given bitmap. The
+/// stored words are compared in place, without loading the bitmap.
+u1
+is_stored(dataset_store& store, i64 id, const dtl::bitmap& b) {
+  const auto view = store.view_bitmap<$u32>(id);
+  std::vector<$u32> words(b.num_blocks());
+  boost::to_block_range(b, words.begin());
+  return words.size() == view.data_.size()
+      && std::equal(words.begin(), words.end(), view.data_.begin());
+}
+//===----------------------------------------------------------------------===//
+/// Stores the given bitmap and validates the stored bitmap. The dataset store
+/// must not be read while it is appended to. Therefore, storing and validating
+/// is serialized, whereas the (expensive) generation runs in parallel.
+template<typename db_t>
+void
+store_and_validate(db_t& db, std::mutex& mutex, u64 n, f64 f, f64 d,
+    const dtl::bitmap& b) {
+  std::lock_guard<std::mutex> lock(mutex);
+  const auto id = db.store_bitmap(n, f, d, b);
+  if (!is_stored(db, id, b)) {
+    // Fatal!
+    std::cerr << "Validation failed" << std::endl;
+    std::exit(1);
+  }
+}
+//===----------------------------------------------------------------------===//
+template<typename db_t>
 std::size_t
-gen(std::vector<params_markov>& params,
-    bitmap_db& db // the database, where the generated bitmaps are stored
+gen_markov(std::vector<params_markov>& params,
+    db_t& db // the database, where the generated bitmaps are stored
 ) {
   // Shuffle the configurations to better predict the overall runtime of the
   // benchmark.
@@ -26,20 +63,15 @@ gen(std::vector<params_markov>& params,
   std::shuffle(params.begin(), params.end(), gen);
 
   std::atomic<std::size_t> failure_cntr { 0 };
+  std::mutex mutex;
   std::function<void(const params_markov&, std::ostream&)> fn =
       [&](const params_markov c, std::ostream& os) -> void {
     try {
+      // The configurations are processed in parallel. Thus, each bitmap is
+      // generated by a single thread.
       const auto b = gen_random_bitmap_markov(
-          c.n, c.clustering_factor, c.density);
-      const auto id =
-          db.store_bitmap(c.n, c.clustering_factor, c.density, b);
-      // Validation.
-      const auto loaded = db.load_bitmap(id);
-      if (b != loaded) {
-        // Fatal!
-        std::cerr << "Validation failed" << std::endl;
-        std::exit(1);
-      }
+          c.n, c.clustering_factor, c.density, 1);
+      store_and_validate(db, mutex, c.n, c.clustering_factor, c.density, b);
     }
     catch (std::exception& ex) {
       ++failure_cntr;
@@ -49,9 +81,10 @@ gen(std::vector<params_markov>& params,
   return failure_cntr;
 }
 //===----------------------------------------------------------------------===//
+template<typename db_t>
 std::size_t
-gen(std::vector<params_uniform>& params,
-    bitmap_db& db // the database, where the generated bitmaps are stored
+gen_uniform(std::vector<params_uniform>& params,
+    db_t& db // the database, where the generated bitmaps are stored
 ) {
   // Shuffle the configurations to better predict the overall runtime of the
   // benchmark.
@@ -60,18 +93,12 @@ gen(std::vector<params_uniform>& params,
   std::shuffle(params.begin(), params.end(), gen);
 
   std::atomic<std::size_t> failure_cntr { 0 };
+  std::mutex mutex;
   std::function<void(const params_uniform&, std::ostream&)> fn =
       [&](const params_uniform c, std::ostream& os) -> void {
     try {
-      const auto b = gen_random_bitmap_uniform(c.n, c.density);
-      const auto id = db.store_bitmap(c.n, c.density, b);
-      // Validation.
-      const auto loaded = db.load_bitmap(id);
-      if (b != loaded) {
-        // Fatal!
-        std::cerr << "Validation failed" << std::endl;
-        std::exit(1);
-      }
+      const auto b = gen_random_bitmap_uniform(c.n, c.density, 1);
+      store_and_validate(db, mutex, c.n, 0.0, c.density, b);
     }
     catch (std::exception& ex) {
       ++failure_cntr;
@@ -81,3 +108,25 @@ gen(std::vector<params_uniform>& params,
   return failure_cntr;
 }
 //===----------------------------------------------------------------------===//
+} // anonymous namespace
+//===----------------------------------------------------------------------===//
+std::size_t
+gen(std::vector<params_markov>& params, bitmap_db& db) {
+  return gen_markov(params, db);
+}
+//===----------------------------------------------------------------------===//
+std::size_t
+gen(std::vector<params_uniform>& params, bitmap_db& db) {
+  return gen_uniform(params, db);
+}
+//===----------------------------------------------------------------------===//
+std::size_t
+gen(std::vector<params_markov>& params, dataset_store& store) {
+  return gen_markov(params, store);
+}
+//===----------------------------------------------------------------------===//
+std::size_t
+gen(std::vector<params_uniform>& params, dataset_store& store) {
+  return gen_uniform(params, store);
+}
+//===----------------------------------------------------------------------===//
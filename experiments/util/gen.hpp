@@ -1,14 +1,19 @@
 #pragma once
 //===----------------------------------------------------------------------===//
 #include "bitmap_db.hpp"
+#include "dataset_store.hpp"
 #include "params.hpp"
 
 #include <dtl/bitmap/util/markov_process.hpp>
 #include <dtl/bitmap/util/random.hpp>
+#include <dtl/bitmap/util/random_runs.hpp>
 #include <dtl/bitmap/util/two_state_markov_process.hpp>
 #include <dtl/dtl.hpp>
+#include <dtl/env.hpp>
+#include <dtl/thread.hpp>
 
 #include <iostream>
+#include <random>
 #include <sstream>
 #include <vector>
 //===----------------------------------------------------------------------===//
@@ -20,22 +25,35 @@ markov_parameters_are_valid(u64 n, $f64 f, $f64 d) {
       && f <= d * n;
 }
 //===----------------------------------------------------------------------===//
+/// The default number of threads used to generate a single bitmap. Callers
+/// that generate several bitmaps concurrently should pass 1 instead.
+static u64
+default_gen_thread_cnt() {
+  return dtl::env<$u64>::get("THREAD_CNT",
+      dtl::this_thread::get_cpu_affinity().count());
+}
+//===----------------------------------------------------------------------===//
 /// Generate a random bitmap with the given parameters.
 /// The actual f and d are at most 2% off.
 ///
+/// The run lengths are sampled directly (see dtl/bitmap/util/random_runs.hpp)
+/// and scaled to match f and d. Only if the rounding errors exceed the error
+/// bounds, which can happen if the number of 1-runs is very small, the bitmap
+/// is generated bit by bit using rejection sampling.
+///
+/// The bitmap is generated using the given number of threads.
+///
 /// Throws an exception if the parameters are invalid or a random bitmap could
 /// not be constructed after several retries.
 static dtl::bitmap
-gen_random_bitmap_markov(u64 n, $f64 f, $f64 d) {
+gen_random_bitmap_markov(u64 n, $f64 f, $f64 d,
+    u64 thread_cnt = default_gen_thread_cnt()) {
   if (!markov_parameters_are_valid(n, f, d)) {
     throw std::invalid_argument(
         "Invalid parameters for the Markov process: n="
         + std::to_string(n) + ", f=" + std::to_string(f) + ", d="
         + std::to_string(d));
   }
-  two_state_markov_process mp(f, d);
-  dtl::bitmap bs(n);
-
   // Error bounds.
   f64 e = 0.02;
   f64 f_min = f - f * e;
@@ -43,6 +61,21 @@ gen_random_bitmap_markov(u64 n, $f64 f, $f64 d) {
   f64 d_min = d - d * e;
   f64 d_max = d + d * e;
 
+  std::random_device rd;
+  dtl::bitmap bs = dtl::gen_random_bitmap_markov_runs(n, f, d,
+      (static_cast<$u64>(rd()) << 32) | rd(), thread_cnt);
+  {
+    const auto f_actual = dtl::determine_clustering_factor(bs);
+    const auto d_actual = dtl::determine_bit_density(bs);
+    if (f_actual >= f_min
+        && f_actual <= f_max
+        && d_actual >= d_min
+        && d_actual <= d_max) {
+      return bs;
+    }
+  }
+
+  two_state_markov_process mp(f, d);
   // Retry if error is too large.
   for ($u64 r = 0; r < 10000; ++r) {
     bs.reset();
@@ -71,15 +104,19 @@ gen_random_bitmap_markov(u64 n, $f64 f, $f64 d) {
       "several retries.");
 }
 //===----------------------------------------------------------------------===//
-/// Generate a uniformly populated random bitmap with the given density.
-// TODO max error
+/// Generate a uniformly populated random bitmap with the given density, i.e.,
+/// each bit is set independently with probability d. The bitmap is generated
+/// using the given number of threads.
 static dtl::bitmap
-gen_random_bitmap_uniform(u64 n, $f64 d) {
+gen_random_bitmap_uniform(u64 n, $f64 d,
+    u64 thread_cnt = default_gen_thread_cnt()) {
   if (d < 0 || d > 1.0) {
     throw std::invalid_argument("Invalid bit density.");
   }
 
-  dtl::bitmap bs = dtl::gen_random_bitmap_uniform(n, d);
+  std::random_device rd;
+  dtl::bitmap bs = dtl::gen_random_bitmap_uniform_runs(n, d,
+      (static_cast<$u64>(rd()) << 32) | rd(), thread_cnt);
 
   return bs;
 }
@@ -148,3 +185,14 @@ gen(std::vector<params_uniform>& params,
     bitmap_db& db // the database, where the generated bitmaps are stored
 );
 //===----------------------------------------------------------------------===//
+/// Same as above, but the generated bitmaps are stored in the dataset store.
+std::size_t
+gen(std::vector<params_markov>& params,
+    dataset_store& store // the store, where the generated bitmaps are stored
+);
+//===----------------------------------------------------------------------===//
+std::size_t
+gen(std::vector<params_uniform>& params,
+    dataset_store& store // the store, where the generated bitmaps are stored
+);
+//===----------------------------------------------------------------------===//
@@ -0,0 +1,120 @@
+#include "experiments/util/bitmap_db.hpp"
+#include "experiments/util/dataset_store.hpp"
+#include "experiments/util/seq_db.hpp"
+#include "sqlite/sqlite3.h"
+
+#include <dtl/dtl.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Converts a bitmap or sequence database (SQLite) into a binary dataset store,
+// which allows for loading the data without decoding it. The IDs are
+// preserved, so that existing results can still be related to the data. An
+// interrupted conversion can be resumed.
+//
+// Usage: convert_db <database file> <store file>
+//===----------------------------------------------------------------------===//
+/// Returns true if the given table exists.
+static u1
+table_exists(sqlite3* db, const std::string& table) {
+  sqlite3_stmt* stmt = nullptr;
+  const std::string sql =
+      "select count(*) from sqlite_master where type = 'table' and name = ?";
+  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr)) return false;
+  sqlite3_bind_text(stmt, 1, table.c_str(), -1, SQLITE_TRANSIENT);
+  $u1 ret = false;
+  if (sqlite3_step(stmt) == SQLITE_ROW) {
+    ret = sqlite3_column_int64(stmt, 0) > 0;
+  }
+  sqlite3_finalize(stmt);
+  return ret;
+}
+//===----------------------------------------------------------------------===//
+/// Reads the given query, which returns (id, n, x, y) tuples.
+static std::vector<std::tuple<$i64, $u64, $f64, $f64>>
+read_catalog(sqlite3* db, const std::string& sql) {
+  std::vector<std::tuple<$i64, $u64, $f64, $f64>> ret;
+  sqlite3_stmt* stmt = nullptr;
+  if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr)) {
+    std::cerr << "Can't prepare SQL statement. "
+              << sqlite3_errmsg(db) << std::endl;
+    std::exit(1);
+  }
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    ret.emplace_back(sqlite3_column_int64(stmt, 0),
+        sqlite3_column_int64(stmt, 1),
+        sqlite3_column_double(stmt, 2),
+        sqlite3_column_double(stmt, 3));
+  }
+  sqlite3_finalize(stmt);
+  return ret;
+}
+//===----------------------------------------------------------------------===//
+$i32 main(i32 argc, char** argv) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <database file> <store file>"
+              << std::endl;
+    return 1;
+  }
+  const std::string db_file = argv[1];
+  const std::string store_file = argv[2];
+
+  sqlite3* db = nullptr;
+  if (sqlite3_open_v2(db_file.c_str(), &db, SQLITE_OPEN_READONLY, nullptr)) {
+    std::cerr << "Can't open database: " << db_file << ". Error: "
+              << sqlite3_errmsg(db) << std::endl;
+    sqlite3_close(db);
+    return 1;
+  }
+  const auto has_bitmaps = table_exists(db, "bitmaps");
+  const auto has_sequences = table_exists(db, "seq_def");
+  const auto bitmaps = has_bitmaps
+      ? read_catalog(db, "select id, n, f, d from bitmaps order by id")
+      : std::vector<std::tuple<$i64, $u64, $f64, $f64>>();
+  const auto sequences = has_sequences
+      ? read_catalog(db, "select id, n, f, c from seq_def order by id")
+      : std::vector<std::tuple<$i64, $u64, $f64, $f64>>();
+  sqlite3_close(db);
+
+  dataset_store store(store_file);
+  if (has_bitmaps) {
+    bitmap_db src(db_file);
+    std::size_t converted_cnt = 0;
+    for (const auto& t : bitmaps) {
+      const auto id = std::get<0>(t);
+      // Skip the bitmaps that have been converted in a previous run.
+      if (store.contains(dataset_store::kind::bitmap, id)) continue;
+      store.import_bitmap(id, std::get<1>(t), std::get<2>(t), std::get<3>(t),
+          src.load_bitmap(id));
+      ++converted_cnt;
+    }
+    std::cerr << "Converted " << converted_cnt << " bitmap(s), skipped "
+              << (bitmaps.size() - converted_cnt) << " existing bitmap(s)."
+              << std::endl;
+  }
+  if (has_sequences) {
+    seq_db src(db_file);
+    std::size_t converted_cnt = 0;
+    for (const auto& t : sequences) {
+      const auto id = std::get<0>(t);
+      if (store.contains(dataset_store::kind::sequence, id)) continue;
+      store.import_sequence(id, std::get<1>(t),
+          static_cast<$u32>(std::get<3>(t)), std::get<2>(t), src.get(id));
+      ++converted_cnt;
+    }
+    std::cerr << "Converted " << converted_cnt << " sequence(s), skipped "
+              << (sequences.size() - converted_cnt) << " existing sequence(s)."
+              << std::endl;
+  }
+  if (!has_bitmaps && !has_sequences) {
+    std::cerr << "The database does not contain any bitmaps or sequences."
+              << std::endl;
+    return 1;
+  }
+  return 0;
+}
+//===----------------------------------------------------------------------===//
@@ -5,10 +5,13 @@
 
 #include <dtl/dtl.hpp>
 //===----------------------------------------------------------------------===//
-void prep_data(
+namespace {
+//===----------------------------------------------------------------------===//
+template<typename db_t>
+void prep_data_markov(
     std::vector<params_markov>& params,
     const std::size_t cnt,
-    bitmap_db& db) {
+    db_t& db) {
   // Prepare the random bitmaps.
   std::cout << "Preparing the data set." << std::endl;
   std::vector<params_markov> missing_bitmaps;
@@ -88,10 +91,11 @@ void prep_data(
             << pass << " passes." << std::endl;
 }
 //===----------------------------------------------------------------------===//
-void prep_data(
+template<typename db_t>
+void prep_data_uniform(
     std::vector<params_uniform>& params,
     const std::size_t cnt,
-    bitmap_db& db) {
+    db_t& db) {
   // Prepare the random bitmaps.
   std::cout << "Preparing the data set." << std::endl;
   std::vector<params_uniform> missing_bitmaps;
@@ -161,3 +165,33 @@ void prep_data(
             << pass << " passes." << std::endl;
 }
 //===----------------------------------------------------------------------===//
+} // anonymous namespace
+//===----------------------------------------------------------------------===//
+void prep_data(
+    std::vector<params_markov>& params,
+    const std::size_t cnt,
+    bitmap_db& db) {
+  prep_data_markov(params, cnt, db);
+}
+//===----------------------------------------------------------------------===//
+void prep_data(
+    std::vector<params_uniform>& params,
+    const std::size_t cnt,
+    bitmap_db& db) {
+  prep_data_uniform(params, cnt, db);
+}
+//===----------------------------------------------------------------------===//
+void prep_data(
+    std::vector<params_markov>& params,
+    const std::size_t cnt,
+    dataset_store& store) {
+  prep_data_markov(params, cnt, store);
+}
+//===----------------------------------------------------------------------===//
+void prep_data(
+    std::vector<params_uniform>& params,
+    const std::size_t cnt,
+    dataset_store& store) {
+  prep_data_uniform(params, cnt, store);
+}
+//===----------------------------------------------------------------------===//
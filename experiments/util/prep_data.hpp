@@ -1,14 +1,15 @@
 #pragma once
 //===----------------------------------------------------------------------===//
 #include "bitmap_db.hpp"
+#include "dataset_store.hpp"
 #include "params.hpp"
 
 #include <cstddef>
 #include <vector>
 //===----------------------------------------------------------------------===//
 /// Ensures that 'cnt' random bitmaps for each configuration are stored in the
-/// database. The function first consults the database, and generates new
-/// bitmaps only if they are not present.
+/// database (or in the dataset store). The function first consults the
+/// database, and generates new bitmaps only if they are not present.
 /// Note that invalid configurations are silently skipped.
 void prep_data(
     std::vector<params_markov>& params,
@@ -20,4 +21,14 @@ void prep_data(
     std::size_t cnt, // the number of bitmaps to generate for each setting (typically corresponds to the number of independent runs)
     bitmap_db& db // the database, where the bitmaps are stored
 );
+void prep_data(
+    std::vector<params_markov>& params,
+    std::size_t cnt, // the number of bitmaps to generate for each setting (typically corresponds to the number of independent runs)
+    dataset_store& store // the store, where the bitmaps are stored
+);
+void prep_data(
+    std::vector<params_uniform>& params,
+    std::size_t cnt, // the number of bitmaps to generate for each setting (typically corresponds to the number of independent runs)
+    dataset_store& store // the store, where the bitmaps are stored
+);
 //===----------------------------------------------------------------------===//
@@ -5,6 +5,7 @@
 
 #include <boost/dynamic_bitset.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <string>
 #include <vector>
@@ -296,9 +297,86 @@ struct position_list {
     }
   };
   //===--------------------------------------------------------------------===//
+  /// Reverse 1-run iterator. Produces the 1-runs in descending order.
+  class riter {
+    const position_list& outer_;
+
+    //===------------------------------------------------------------------===//
+    // Iterator state
+    //===------------------------------------------------------------------===//
+    /// Read position within the list. Refers to the first position of the
+    /// current range.
+    $u64 read_pos_;
+    /// Points to the beginning of the current range.
+    $u64 range_begin_;
+    /// The length of the current range.
+    $u64 range_length_;
+    //===------------------------------------------------------------------===//
+
+  public:
+    explicit __forceinline__
+    riter(const position_list& outer)
+        : outer_(outer),
+          read_pos_(outer.positions_.size()),
+          range_begin_(outer.n_),
+          range_length_(0) {
+      prev();
+    }
+
+    void __forceinline__
+    prev() {
+      if (read_pos_ == 0) {
+        range_begin_ = outer_.n_;
+        range_length_ = 0;
+        return;
+      }
+      --read_pos_;
+      range_begin_ = outer_.positions_[read_pos_];
+      range_length_ = 1;
+      while (read_pos_ > 0
+          && outer_.positions_[read_pos_ - 1] + 1 == range_begin_) {
+        --read_pos_;
+        --range_begin_;
+        ++range_length_;
+      }
+    }
+
+    void __forceinline__
+    skip_back_to(const std::size_t to_pos) {
+      if (end() || to_pos + 1 >= range_begin_ + range_length_) {
+        return;
+      }
+      if (to_pos >= range_begin_) {
+        range_length_ = to_pos + 1 - range_begin_;
+        return;
+      }
+      auto search = std::upper_bound(
+          outer_.positions_.begin(), outer_.positions_.begin() + read_pos_,
+          to_pos);
+      read_pos_ = std::distance(outer_.positions_.begin(), search);
+      prev();
+    }
+
+    u1 __forceinline__
+    end() const noexcept {
+      return range_length_ == 0;
+    }
+
+    u64 __forceinline__
+    pos() const noexcept {
+      return range_begin_;
+    }
+
+    u64 __forceinline__
+    length() const noexcept {
+      return range_length_;
+    }
+  };
+  //===--------------------------------------------------------------------===//
 
   using skip_iter_type = iter;
   using scan_iter_type = iter;
+  using rev_iter_type = riter;
 
   skip_iter_type __forceinline__
   it() const {
@@ -310,6 +388,11 @@ struct position_list {
     return scan_iter_type(*this);
   }
 
+  rev_iter_type __forceinline__
+  rit() const {
+    return rev_iter_type(*this);
+  }
+
   /// Returns the name of the instance including the most important parameters
   /// in JSON.
   std::string
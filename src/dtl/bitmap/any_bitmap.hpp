@@ -0,0 +1,328 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include "bitwise_operations.hpp"
+
+#include <dtl/dtl.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+//===----------------------------------------------------------------------===//
+// Type-erased bitmaps and run iterators, which allow for composing queries at
+// runtime, e.g., when the operands and their codecs are not known at compile
+// time.
+//
+// The run iterators of the codecs are wrapped in a batch_run_iter, which
+// produces the 1-runs in batches. Thus, the costs of the dynamic dispatch (a
+// single virtual call) are amortized over a batch of runs. On top of that,
+// any_run_iter provides the usual run iterator interface (next, skip_to, end,
+// pos, length) so that type-erased iterators can be combined using the
+// existing bitwise operations.
+//===----------------------------------------------------------------------===//
+namespace dtl {
+//===----------------------------------------------------------------------===//
+/// Interface of a type-erased run iterator that produces batches of 1-runs.
+class batch_run_iter {
+public:
+  /// The max. number of 1-runs per batch.
+  static constexpr std::size_t batch_size = 64;
+
+  virtual ~batch_run_iter() = default;
+
+  /// Writes the next (up to batch_size) 1-runs to the given arrays. Returns
+  /// the number of 1-runs written, or zero if the iterator reached the end.
+  virtual std::size_t
+  next_batch($u64* pos, $u64* length) noexcept = 0;
+
+  /// Forwards the iterator, such that the next batch starts with the 1-run
+  /// that contains the given position or with the first 1-run after the given
+  /// position. The runs that have been produced already are not affected.
+  virtual void
+  skip_to(u64 to_pos) noexcept = 0;
+};
+//===----------------------------------------------------------------------===//
+namespace internal {
+//===----------------------------------------------------------------------===//
+/// Adapts a run iterator to the batch_run_iter interface.
+template<typename iter_t>
+class batch_run_iter_impl final : public batch_run_iter {
+  iter_t it_;
+
+public:
+  explicit batch_run_iter_impl(iter_t&& it) : it_(std::move(it)) {}
+
+  std::size_t
+  next_batch($u64* pos, $u64* length) noexcept override {
+    std::size_t cnt = 0;
+    while (cnt < batch_size && !it_.end()) {
+      pos[cnt] = it_.pos();
+      length[cnt] = it_.length();
+      ++cnt;
+      it_.next();
+    }
+    return cnt;
+  }
+
+  void
+  skip_to(u64 to_pos) noexcept override {
+    if (!it_.end() && to_pos > it_.pos()) it_.skip_to(to_pos);
+  }
+};
+//===----------------------------------------------------------------------===//
+} // namespace internal
+//===----------------------------------------------------------------------===//
+/// A type-erased run iterator. The 1-runs are fetched batch-wise from the
+/// underlying batch_run_iter and buffered.
+class any_run_iter {
+  using batch_size_t = std::integral_constant<std::size_t,
+      batch_run_iter::batch_size>;
+
+  /// The underlying iterator.
+  std::unique_ptr<batch_run_iter> src_;
+  /// The length of the bitmap.
+  $u64 n_;
+  /// The buffered 1-runs.
+  $u64 pos_[batch_size_t::value];
+  $u64 length_[batch_size_t::value];
+  /// The number of buffered 1-runs.
+  std::size_t cnt_ = 0;
+  /// The index of the current 1-run.
+  std::size_t idx_ = 0;
+
+  /// Fetches the next batch of 1-runs.
+  void
+  fetch() noexcept {
+    cnt_ = src_->next_batch(pos_, length_);
+    idx_ = 0;
+  }
+
+public:
+  any_run_iter(std::unique_ptr<batch_run_iter>&& src, u64 n)
+      : src_(std::move(src)), n_(n) {
+    fetch();
+  }
+
+  any_run_iter(any_run_iter&&) noexcept = default;
+  any_run_iter& operator=(any_run_iter&&) noexcept = default;
+
+  /// Forwards the iterator to the next 1-run.
+  void __forceinline__
+  next() noexcept {
+    if (++idx_ == cnt_) fetch();
+  }
+
+  /// Forwards the iterator to the given position.
+  void __forceinline__
+  skip_to(const std::size_t to_pos) noexcept {
+    // Skip the buffered runs that end before the destination.
+    while (idx_ < cnt_ && pos_[idx_] + length_[idx_] <= to_pos) ++idx_;
+    if (idx_ == cnt_) {
+      if (cnt_ == 0) return;
+      src_->skip_to(to_pos);
+      fetch();
+      if (cnt_ == 0) return;
+    }
+    if (pos_[idx_] < to_pos) {
+      // The destination is within the current run.
+      length_[idx_] -= to_pos - pos_[idx_];
+      pos_[idx_] = to_pos;
+    }
+  }
+
+  /// Returns true if the iterator reached the end, false otherwise.
+  u1 __forceinline__
+  end() const noexcept {
+    return cnt_ == 0;
+  }
+
+  /// Returns the starting position of the current 1-run.
+  u64 __forceinline__
+  pos() const noexcept {
+    return cnt_ == 0 ? n_ : pos_[idx_];
+  }
+
+  /// Returns the length of the current 1-run.
+  u64 __forceinline__
+  length() const noexcept {
+    return cnt_ == 0 ? 0 : length_[idx_];
+  }
+
+  /// Returns the length of the bitmap.
+  u64 __forceinline__
+  size() const noexcept {
+    return n_;
+  }
+};
+//===----------------------------------------------------------------------===//
+/// Wraps the given run iterator in a type-erased iterator. The parameter n
+/// refers to the length of the bitmap.
+template<typename iter_t>
+any_run_iter
+make_any_run_iter(iter_t it, u64 n) {
+  using impl_t = internal::batch_run_iter_impl<iter_t>;
+  return any_run_iter(
+      std::unique_ptr<batch_run_iter>(new impl_t(std::move(it))), n);
+}
+//===----------------------------------------------------------------------===//
+// Runtime composition of type-erased iterators. The operators are the
+// templated bitwise operations instantiated for any_run_iter, which are
+// type-erased themselves. Thus, operators can be nested arbitrarily.
+//===----------------------------------------------------------------------===//
+/// Returns a type-erased iterator over the conjunction of the given inputs.
+inline any_run_iter
+any_and_it(any_run_iter&& a, any_run_iter&& b) {
+  const auto n = a.size();
+  return make_any_run_iter(bitwise_and_it(std::move(a), std::move(b)), n);
+}
+//===----------------------------------------------------------------------===//
+/// Returns a type-erased iterator over the disjunction of the given inputs.
+inline any_run_iter
+any_or_it(any_run_iter&& a, any_run_iter&& b) {
+  const auto n = a.size();
+  return make_any_run_iter(bitwise_or_it(std::move(a), std::move(b)), n);
+}
+//===----------------------------------------------------------------------===//
+/// Returns a type-erased iterator over the exclusive disjunction of the given
+/// inputs.
+inline any_run_iter
+any_xor_it(any_run_iter&& a, any_run_iter&& b) {
+  const auto n = a.size();
+  return make_any_run_iter(bitwise_xor_it(std::move(a), std::move(b)), n);
+}
+//===----------------------------------------------------------------------===//
+/// Returns a type-erased iterator over a AND NOT b.
+inline any_run_iter
+any_and_not_it(any_run_iter&& a, any_run_iter&& b) {
+  const auto n = a.size();
+  return make_any_run_iter(bitwise_and_not_it(std::move(a), std::move(b)), n);
+}
+//===----------------------------------------------------------------------===//
+/// Returns a type-erased iterator over the negation of the given input.
+inline any_run_iter
+any_not_it(any_run_iter&& a) {
+  const auto n = a.size();
+  return make_any_run_iter(not_it(std::move(a), n), n);
+}
+//===----------------------------------------------------------------------===//
+/// A type-erased (immutable) bitmap. Instances are cheap to copy, as the
+/// encoded bitmap is shared.
+class any_bitmap {
+  /// The interface of the wrapped bitmap.
+  struct holder_base {
+    virtual ~holder_base() = default;
+    virtual any_run_iter it() const = 0;
+    virtual any_run_iter scan_it() const = 0;
+    virtual u64 size() const = 0;
+    virtual u64 size_in_bytes() const = 0;
+    virtual u1 test(std::size_t pos) const = 0;
+    virtual std::string name() const = 0;
+    virtual std::string info() const = 0;
+  };
+
+  template<typename bitmap_t>
+  struct holder final : holder_base {
+    bitmap_t bitmap;
+
+    explicit holder(bitmap_t&& b) : bitmap(std::move(b)) {}
+
+    any_run_iter
+    it() const override {
+      return make_any_run_iter(bitmap.it(), bitmap.size());
+    }
+    any_run_iter
+    scan_it() const override {
+      return make_any_run_iter(bitmap.scan_it(), bitmap.size());
+    }
+    u64
+    size() const override {
+      return bitmap.size();
+    }
+    u64
+    size_in_bytes() const override {
+      return bitmap.size_in_bytes();
+    }
+    u1
+    test(std::size_t pos) const override {
+      return bitmap.test(pos);
+    }
+    std::string
+    name() const override {
+      return bitmap.name();
+    }
+    std::string
+    info() const override {
+      return bitmap.info();
+    }
+  };
+
+  std::shared_ptr<const holder_base> impl_;
+
+  explicit any_bitmap(std::shared_ptr<const holder_base>&& impl)
+      : impl_(std::move(impl)) {}
+
+public:
+  using skip_iter_type = any_run_iter;
+  using scan_iter_type = any_run_iter;
+
+  /// Wraps the given (encoded) bitmap.
+  template<typename bitmap_t>
+  static any_bitmap
+  wrap(bitmap_t bitmap) {
+    using holder_t = holder<bitmap_t>;
+    return any_bitmap(std::make_shared<const holder_t>(std::move(bitmap)));
+  }
+
+  /// Encodes the given bitmap using the codec bitmap_t.
+  template<typename bitmap_t>
+  static any_bitmap
+  encode(const boost::dynamic_bitset<$u32>& in) {
+    return wrap(bitmap_t(in));
+  }
+
+  /// Returns a type-erased 1-run iterator (with skip support).
+  any_run_iter
+  it() const {
+    return impl_->it();
+  }
+
+  /// Returns a type-erased 1-run iterator, which is optimized for scans.
+  any_run_iter
+  scan_it() const {
+    return impl_->scan_it();
+  }
+
+  /// Returns the length of the bitmap.
+  u64
+  size() const {
+    return impl_->size();
+  }
+
+  /// Returns the size of the encoded bitmap in bytes.
+  u64
+  size_in_bytes() const {
+    return impl_->size_in_bytes();
+  }
+
+  /// Returns the value of the bit at the given position.
+  u1
+  test(const std::size_t pos) const {
+    return impl_->test(pos);
+  }
+
+  /// Returns the name of the wrapped codec.
+  std::string
+  name() const {
+    return impl_->name();
+  }
+
+  /// Returns the name and the parameters of the wrapped bitmap in JSON.
+  std::string
+  info() const {
+    return impl_->info();
+  }
+};
+//===----------------------------------------------------------------------===//
+} // namespace dtl
@@ -0,0 +1,569 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include "any_bitmap.hpp"
+#include "concise.hpp"
+#include "delta_bp128.hpp"
+#include "elias_fano.hpp"
+#include "teb_wrapper.hpp"
+#include "util/bitmap_fun.hpp"
+#include "util/bitmap_tree.hpp"
+#include "xah.hpp"
+
+#include <dtl/bitmap/dynamic_bitmap.hpp>
+#include <dtl/bitmap/position_list.hpp>
+#include <dtl/bitmap/range_list.hpp>
+#include <dtl/dtl.hpp>
+#include <dtl/math.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Automatic codec selection. The encoded sizes (and the scan and skip costs)
+// of the candidate codecs are estimated based on the statistics of the runs
+// in the bitmap, which are obtained in a single pass. No candidate is
+// constructed, except for the winner.
+//===----------------------------------------------------------------------===//
+namespace dtl {
+//===----------------------------------------------------------------------===//
+/// The candidate codecs.
+enum class auto_codec : $u8 {
+  bitmap,
+  position_list,
+  range_list,
+  elias_fano,
+  delta_bp128,
+  xah32,
+  concise,
+  teb,
+};
+//===----------------------------------------------------------------------===//
+/// Returns the name of the given codec.
+static inline std::string
+auto_codec_name(const auto_codec c) {
+  switch (c) {
+    case auto_codec::bitmap: return "bitmap";
+    case auto_codec::position_list: return "position_list";
+    case auto_codec::range_list: return "range_list";
+    case auto_codec::elias_fano: return "elias_fano";
+    case auto_codec::delta_bp128: return "delta_bp128";
+    case auto_codec::xah32: return "xah32";
+    case auto_codec::concise: return "concise";
+    case auto_codec::teb: return "teb";
+  }
+  return "unknown";
+}
+//===----------------------------------------------------------------------===//
+/// The objective of the codec selection, given as the weights of the (size,
+/// scan and skip) costs. The costs of each candidate are normalized by the
+/// lowest costs among all candidates before they are weighted.
+struct codec_objective {
+  $f64 size_weight = 1.0;
+  $f64 scan_weight = 0.0;
+  $f64 skip_weight = 0.0;
+
+  /// Minimizes the encoded size.
+  static codec_objective
+  size() {
+    return codec_objective { 1.0, 0.0, 0.0 };
+  }
+
+  /// Minimizes the costs of a full scan.
+  static codec_objective
+  scan() {
+    return codec_objective { 0.0, 1.0, 0.0 };
+  }
+
+  /// Minimizes the costs of a (random) skip.
+  static codec_objective
+  skip() {
+    return codec_objective { 0.0, 0.0, 1.0 };
+  }
+
+  /// A weighted mix of the three objectives.
+  static codec_objective
+  mix(f64 size_weight, f64 scan_weight, f64 skip_weight) {
+    return codec_objective { size_weight, scan_weight, skip_weight };
+  }
+};
+//===----------------------------------------------------------------------===//
+/// The estimated costs of a codec for a particular bitmap. The scan and skip
+/// costs are given in abstract units of work (e.g., words, tree nodes or
+/// positions that need to be processed) and are only meaningful relative to
+/// the costs of other codecs.
+struct codec_estimate {
+  auto_codec codec;
+  /// The estimated size of the encoded bitmap.
+  $u64 size_in_bytes;
+  /// The estimated costs of a full scan.
+  $f64 scan_cost;
+  /// The estimated costs of a single skip.
+  $f64 skip_cost;
+};
+//===----------------------------------------------------------------------===//
+namespace internal {
+//===----------------------------------------------------------------------===//
+/// Counts the literal and fill words of a word-aligned hybrid encoding with
+/// the given payload size (in bits), based on the bit transitions in the
+/// bitmap. A group of payload bits is encoded as a literal word, if a
+/// transition occurs within the group. Consecutive groups of the same value
+/// are encoded as a fill.
+class word_aligned_counter {
+  /// The number of payload bits per word.
+  $u64 group_size_;
+  /// The max. number of groups that can be encoded in a single fill word.
+  $u64 max_fill_repetitions_;
+  /// The first group that has not been assigned to a word yet.
+  $u64 current_group_ = 0;
+  $u64 literal_word_cnt_ = 0;
+  $u64 fill_word_cnt_ = 0;
+
+  /// Assigns the groups [current_group_, group_idx) to fill words.
+  void
+  close_fill(u64 group_idx) {
+    if (group_idx <= current_group_) return;
+    const auto rep = group_idx - current_group_;
+    fill_word_cnt_ += (rep + max_fill_repetitions_ - 1) / max_fill_repetitions_;
+    current_group_ = group_idx;
+  }
+
+public:
+  word_aligned_counter(u64 word_bitlength)
+      : group_size_(word_bitlength - 1),
+        max_fill_repetitions_((1ull << std::min(word_bitlength - 2, $u64(62))) - 1) {}
+
+  word_aligned_counter(u64 word_bitlength, u64 max_fill_repetitions)
+      : group_size_(word_bitlength - 1),
+        max_fill_repetitions_(max_fill_repetitions) {}
+
+  /// Adds a transition, i.e., the bits at position t-1 and t differ.
+  /// Transitions need to be added in ascending order.
+  void
+  add_transition(u64 t) {
+    const auto group_idx = t / group_size_;
+    if (t % group_size_ == 0) {
+      // The transition is aligned with a group boundary.
+      close_fill(group_idx);
+      return;
+    }
+    if (group_idx < current_group_) {
+      // The group is already a literal.
+      return;
+    }
+    close_fill(group_idx);
+    ++literal_word_cnt_;
+    current_group_ = group_idx + 1;
+  }
+
+  /// Returns the number of words required to encode a bitmap of length n.
+  u64
+  word_cnt(u64 n) {
+    const auto full_group_cnt = n / group_size_;
+    // Transitions within the trailing (incomplete) group are counted as
+    // literals. Thus, the number of literals needs to be corrected.
+    $u64 literal_cnt = literal_word_cnt_;
+    if (current_group_ > full_group_cnt) --literal_cnt;
+    close_fill(full_group_cnt);
+    const $u64 tail = (n % group_size_) != 0 ? 1 : 0;
+    return literal_cnt + fill_word_cnt_ + tail;
+  }
+};
+//===----------------------------------------------------------------------===//
+/// Statistics about the runs in a bitmap, which are collected in a single
+/// pass over the 1-runs.
+class run_stats {
+  /// The length of the bitmap.
+  $u64 n_;
+  /// The length rounded up to the next power of two.
+  $u64 n_pow2_;
+  /// The height of the (TEB) tree.
+  $u64 tree_height_;
+  /// The number of 1-bits.
+  $u64 one_cnt_ = 0;
+  /// The number of 1-runs.
+  $u64 run_cnt_ = 0;
+  /// The position of the first and the last 1-bit.
+  $u64 first_bit_idx_ = 0;
+  $u64 last_bit_idx_ = 0;
+  /// The number of inner nodes per tree level.
+  std::vector<$u64> inner_node_cnt_;
+  /// The index of the last inner node per tree level.
+  std::vector<$u64> last_inner_node_;
+  /// The word counter for xah32.
+  word_aligned_counter xah32_;
+  /// The word counter for CONCISE (31 payload bits, 25-bit fill counters).
+  word_aligned_counter concise_;
+  /// The number of 32-bit words occupied by the packed gaps (delta_bp128),
+  /// excluding the current block.
+  $u64 bp128_word_cnt_ = 0;
+  /// The index of the current block (delta_bp128).
+  $u64 bp128_block_idx_ = 0;
+  /// The bitwise OR of the gaps within the current block (delta_bp128).
+  $u32 bp128_acc_ = 0;
+
+  /// Returns the number of bits required to pack the given gaps.
+  static u64
+  bit_width(u32 acc) {
+    return acc == 0 ? 0 : 32 - dtl::bits::lz_count(acc);
+  }
+
+  /// Adds a transition, i.e., the bits at position t-1 and t differ.
+  void
+  add_transition(u64 t) {
+    // A transition at position t (0 < t < n_pow2) lies strictly within all
+    // the tree nodes that cover more than 2^tz(t) bits. Exactly these nodes
+    // are inner nodes of the (fully) pruned tree.
+    const auto level_cnt = tree_height_ - dtl::bits::tz_count(t);
+    for (std::size_t level = 0; level < level_cnt; ++level) {
+      const auto node = t >> (tree_height_ - level);
+      if (inner_node_cnt_[level] == 0 || last_inner_node_[level] != node) {
+        last_inner_node_[level] = node;
+        ++inner_node_cnt_[level];
+      }
+    }
+    xah32_.add_transition(t);
+    concise_.add_transition(t);
+  }
+
+public:
+  explicit run_stats(u64 n)
+      : n_(n),
+        n_pow2_(dtl::next_power_of_two(std::max(n, $u64(2)))),
+        tree_height_(dtl::log_2(n_pow2_)),
+        inner_node_cnt_(tree_height_ + 1, 0),
+        last_inner_node_(tree_height_ + 1, 0),
+        xah32_(32),
+        concise_(32, (1ull << 25) - 1) {}
+
+  /// Adds the 1-run [begin, end). The runs need to be added in ascending
+  /// order and must not overlap or touch.
+  void
+  add_run(u64 begin, u64 end) {
+    assert(begin < end && end <= n_);
+    assert(run_cnt_ == 0 || last_bit_idx_ + 1 < begin);
+    // delta_bp128: The gaps between the positions within a run are zero.
+    // Thus, only the first position of a run contributes to the bit-width of
+    // the block it belongs to.
+    {
+      const $u32 gap = static_cast<$u32>(
+          run_cnt_ == 0 ? begin : begin - last_bit_idx_ - 1);
+      const auto block_idx = one_cnt_ / 128;
+      if (block_idx != bp128_block_idx_) {
+        bp128_word_cnt_ += bit_width(bp128_acc_) * 4;
+        bp128_block_idx_ = block_idx;
+        bp128_acc_ = 0;
+      }
+      bp128_acc_ |= gap;
+    }
+    if (run_cnt_ == 0) first_bit_idx_ = begin;
+    last_bit_idx_ = end - 1;
+    ++run_cnt_;
+    one_cnt_ += end - begin;
+    if (begin > 0) add_transition(begin);
+    // Note: TEBs are padded with 0-bits to the next power of two.
+    if (end < n_pow2_) add_transition(end);
+  }
+
+  /// Collects the statistics of the given bitmap.
+  static run_stats
+  of(const boost::dynamic_bitset<$u32>& bs) {
+    using fn = dtl::bitmap_fun<$u32>;
+    const auto n = bs.size();
+    run_stats stats(n);
+#ifndef BOOST_DYNAMIC_BITSET_DONT_USE_FRIENDS
+    std::vector<$u32> blocks(bs.num_blocks());
+    boost::to_block_range(bs, blocks.begin());
+    const $u32* bits = blocks.data();
+#else
+    // HACK: This gives access to the private members of the boost::dynamic_bitset.
+    const $u32* bits = bs.m_bits.data();
+#endif
+    auto begin = fn::find_first(bits, 0, n);
+    while (begin < n) {
+      const auto end = fn::find_first_zero(bits, begin, n);
+      stats.add_run(begin, end);
+      begin = fn::find_first(bits, end, n);
+    }
+    return stats;
+  }
+
+  /// Returns the estimates for all candidate codecs.
+  std::vector<codec_estimate>
+  estimate() {
+    const f64 c = static_cast<$f64>(one_cnt_);
+    const f64 r = static_cast<$f64>(run_cnt_);
+    std::vector<codec_estimate> ret;
+
+    // Plain bitmap. (Random access)
+    {
+      const $u64 word_cnt = (n_ + 31) / 32;
+      ret.push_back({ auto_codec::bitmap, word_cnt * 4 + 4,
+          word_cnt + c, 1.0 });
+    }
+    // Position list. (Binary search)
+    {
+      ret.push_back({ auto_codec::position_list,
+          one_cnt_ * sizeof($u32) + sizeof($u32) + sizeof($u64),
+          c, std::log2(c + 1.0) + 1.0 });
+    }
+    // Range list. (Binary search)
+    {
+      ret.push_back({ auto_codec::range_list,
+          run_cnt_ * 2 * sizeof($u32) + sizeof(std::size_t) + sizeof($u64),
+          r, std::log2(r + 1.0) + 1.0 });
+    }
+    // Elias-Fano. (A sample lookup, followed by a scan of at most 256 0-bits
+    // in the upper bits)
+    {
+      $u64 l = 0;
+      if (one_cnt_ == 0) {
+        l = 32;
+      }
+      else if (n_ > one_cnt_) {
+        l = dtl::log_2(n_ / one_cnt_);
+      }
+      const $u64 upper_bitlength = one_cnt_ + (n_ >> l) + 1;
+      const $u64 lower_word_cnt = (one_cnt_ * l + 63) / 64 + 1;
+      const $u64 upper_word_cnt = (upper_bitlength + 63) / 64;
+      const $u64 sample_cnt = ((n_ >> l) + 1 + 255) / 256;
+      ret.push_back({ auto_codec::elias_fano,
+          (lower_word_cnt + upper_word_cnt) * sizeof($u64)
+              + sample_cnt * sizeof($u32)
+              + 2 * sizeof($u64) + sizeof($u32),
+          c + static_cast<$f64>(upper_word_cnt), 256.0 / 64.0 + 1.0 });
+    }
+    // Binary packing of the gaps. (Binary search over the blocks, followed by
+    // the decoding of a block)
+    {
+      const $u64 block_cnt = (one_cnt_ + 127) / 128;
+      const $u64 word_cnt = bp128_word_cnt_ + bit_width(bp128_acc_) * 4;
+      ret.push_back({ auto_codec::delta_bp128,
+          word_cnt * sizeof($u32) + (2 * block_cnt + 1) * sizeof($u32)
+              + 2 * sizeof($u64),
+          c + static_cast<$f64>(word_cnt),
+          std::log2(static_cast<$f64>(block_cnt) + 1.0) + 128.0 / 4.0 });
+    }
+    // Word-aligned hybrid. (Linear search)
+    {
+      const auto word_cnt = xah32_.word_cnt(n_);
+      const f64 w = static_cast<$f64>(word_cnt);
+      ret.push_back({ auto_codec::xah32,
+          word_cnt * sizeof($u32) + sizeof(std::size_t),
+          w + r, w / 2.0 + 1.0 });
+    }
+    // CONCISE. (Linear search) The trailing 0-bits are not encoded. Note: The
+    // estimate does not account for the dirty bits that are piggybacked by
+    // the fill words. Thus, the estimate is an upper bound.
+    {
+      const auto word_cnt =
+          one_cnt_ == 0 ? 0 : concise_.word_cnt(last_bit_idx_ + 1);
+      const f64 w = static_cast<$f64>(word_cnt);
+      ret.push_back({ auto_codec::concise,
+          word_cnt * sizeof($u32) + sizeof(std::size_t),
+          w + r, w / 2.0 + 1.0 });
+    }
+    // TEB. (Tree navigation) The estimate refers to the bitmap tree after
+    // pruning. A node of the pruned tree is an inner node, iff a transition
+    // lies strictly within the node, unless the pruning terminated early
+    // (see bitmap_tree::prune_tree), in which case all the nodes above are
+    // inner nodes. Only the leading perfect levels are considered implicit.
+    // The size of the uncompressed (perfect) tree serves as the fallback.
+    //
+    // The space optimizations of the TEB (implicit nodes and labels, gradual
+    // decompression) never result in a tree that is larger than the pruned
+    // or the uncompressed one. Thus, the estimate is an upper bound.
+    {
+      std::vector<$u64> inner_node_cnt_per_level = inner_node_cnt_;
+      for (std::size_t level = tree_height_; level > 0; --level) {
+        const $u64 node_cnt = 1ull << (level - 1);
+        const $u64 inner_node_cnt = inner_node_cnt_per_level[level - 1];
+        if (node_cnt - inner_node_cnt < inner_node_cnt / 2) {
+          for (std::size_t l = 0; l + 1 < level; ++l) {
+            inner_node_cnt_per_level[l] = 1ull << l;
+          }
+          break;
+        }
+      }
+      $u64 inner_node_cnt = 0;
+      for (auto cnt : inner_node_cnt_per_level) inner_node_cnt += cnt;
+      $u64 perfect_level_cnt = 1;
+      while (perfect_level_cnt - 1 < tree_height_
+          && inner_node_cnt_per_level[perfect_level_cnt - 1]
+              == (1ull << (perfect_level_cnt - 1))) {
+        ++perfect_level_cnt;
+      }
+      const $u64 leading_inner_node_cnt = (1ull << (perfect_level_cnt - 1)) - 1;
+      const $u64 explicit_tree_node_cnt =
+          2 * inner_node_cnt + 1 - leading_inner_node_cnt;
+      const $u64 explicit_label_cnt = inner_node_cnt + 1;
+      const auto pruned_size =
+          dtl::bitmap_tree<>::estimate_encoded_size_in_bytes(n_pow2_,
+              explicit_tree_node_cnt, explicit_label_cnt, perfect_level_cnt);
+      const $u64 uncompressed_label_cnt =
+          one_cnt_ == 0 ? 0 : last_bit_idx_ - first_bit_idx_ + 1;
+      const auto uncompressed_size =
+          dtl::bitmap_tree<>::estimate_encoded_size_in_bytes(n_pow2_, 0,
+              uncompressed_label_cnt, tree_height_ + 1);
+      if (pruned_size <= uncompressed_size) {
+        ret.push_back({ auto_codec::teb, pruned_size,
+            static_cast<$f64>(explicit_tree_node_cnt) + r,
+            static_cast<$f64>(tree_height_) + 1.0 });
+      }
+      else {
+        ret.push_back({ auto_codec::teb, uncompressed_size,
+            static_cast<$f64>(uncompressed_label_cnt) + r,
+            static_cast<$f64>(tree_height_) + 1.0 });
+      }
+    }
+    return ret;
+  }
+};
+//===----------------------------------------------------------------------===//
+} // namespace internal
+//===----------------------------------------------------------------------===//
+/// Returns the estimated costs of all candidate codecs for the given bitmap.
+static inline std::vector<codec_estimate>
+estimate_codecs(const boost::dynamic_bitset<$u32>& bitmap) {
+  return internal::run_stats::of(bitmap).estimate();
+}
+//===----------------------------------------------------------------------===//
+/// Returns the best codec for the given estimates and objective.
+static inline codec_estimate
+select_codec(const std::vector<codec_estimate>& estimates,
+    const codec_objective& objective) {
+  assert(!estimates.empty());
+  $f64 min_size = std::numeric_limits<$f64>::max();
+  $f64 min_scan = std::numeric_limits<$f64>::max();
+  $f64 min_skip = std::numeric_limits<$f64>::max();
+  for (const auto& e : estimates) {
+    min_size = std::min(min_size, static_cast<$f64>(e.size_in_bytes));
+    min_scan = std::min(min_scan, e.scan_cost);
+    min_skip = std::min(min_skip, e.skip_cost);
+  }
+  auto normalize = [](f64 cost, f64 min_cost) {
+    return min_cost > 0.0 ? cost / min_cost : 1.0;
+  };
+  std::size_t best = 0;
+  $f64 best_score = std::numeric_limits<$f64>::max();
+  for (std::size_t i = 0; i < estimates.size(); ++i) {
+    const auto& e = estimates[i];
+    const auto score =
+        objective.size_weight
+            * normalize(static_cast<$f64>(e.size_in_bytes), min_size)
+        + objective.scan_weight * normalize(e.scan_cost, min_scan)
+        + objective.skip_weight * normalize(e.skip_cost, min_skip);
+    if (score < best_score) {
+      best_score = score;
+      best = i;
+    }
+  }
+  return estimates[best];
+}
+//===----------------------------------------------------------------------===//
+/// A bitmap that is encoded using the codec that fits best to the given
+/// objective (see choose_codec).
+class auto_bitmap {
+  /// The encoded bitmap.
+  any_bitmap bitmap_;
+  /// The estimates of the selected codec.
+  codec_estimate estimate_;
+
+public:
+  using skip_iter_type = any_run_iter;
+  using scan_iter_type = any_run_iter;
+
+  auto_bitmap(any_bitmap&& bitmap, const codec_estimate& estimate)
+      : bitmap_(std::move(bitmap)), estimate_(estimate) {}
+
+  /// Returns the selected codec.
+  auto_codec
+  codec() const noexcept {
+    return estimate_.codec;
+  }
+
+  /// Returns the estimates of the selected codec.
+  const codec_estimate&
+  estimate() const noexcept {
+    return estimate_;
+  }
+
+  /// Returns the wrapped bitmap.
+  const any_bitmap&
+  bitmap() const noexcept {
+    return bitmap_;
+  }
+
+  any_run_iter
+  it() const {
+    return bitmap_.it();
+  }
+
+  any_run_iter
+  scan_it() const {
+    return bitmap_.scan_it();
+  }
+
+  u64
+  size() const {
+    return bitmap_.size();
+  }
+
+  u64
+  size_in_bytes() const {
+    return bitmap_.size_in_bytes();
+  }
+
+  u1
+  test(const std::size_t pos) const {
+    return bitmap_.test(pos);
+  }
+
+  std::string
+  name() const {
+    return "auto(" + bitmap_.name() + ")";
+  }
+
+  std::string
+  info() const {
+    return bitmap_.info();
+  }
+};
+//===----------------------------------------------------------------------===//
+/// Encodes the given bitmap using the given codec.
+static inline any_bitmap
+encode_with(const auto_codec codec, const boost::dynamic_bitset<$u32>& bitmap) {
+  switch (codec) {
+    case auto_codec::bitmap:
+      return any_bitmap::encode<dtl::dynamic_bitmap<$u32>>(bitmap);
+    case auto_codec::position_list:
+      return any_bitmap::encode<dtl::position_list<$u32>>(bitmap);
+    case auto_codec::range_list:
+      return any_bitmap::encode<dtl::range_list<$u32>>(bitmap);
+    case auto_codec::elias_fano:
+      return any_bitmap::encode<dtl::elias_fano>(bitmap);
+    case auto_codec::delta_bp128:
+      return any_bitmap::encode<dtl::delta_bp128>(bitmap);
+    case auto_codec::xah32:
+      return any_bitmap::encode<dtl::xah32>(bitmap);
+    case auto_codec::concise:
+      return any_bitmap::encode<dtl::concise>(bitmap);
+    case auto_codec::teb:
+    default:
+      return any_bitmap::encode<dtl::teb_wrapper>(bitmap);
+  }
+}
+//===----------------------------------------------------------------------===//
+/// Chooses the codec that fits best to the given objective and encodes the
+/// bitmap. Only the selected codec is constructed.
+static inline auto_bitmap
+choose_codec(const boost::dynamic_bitset<$u32>& bitmap,
+    const codec_objective& objective = codec_objective::size()) {
+  const auto best = select_codec(estimate_codecs(bitmap), objective);
+  return auto_bitmap(encode_with(best.codec, bitmap), best);
+}
+//===----------------------------------------------------------------------===//
+} // namespace dtl
@@ -3,11 +3,13 @@
 #include "bah_patterns.hpp"
 #include "bah_types.hpp"
 
+#include <dtl/bitmap/util/bitmap_fun.hpp>
 #include <dtl/bitmap/util/plain_bitmap.hpp>
 #include <dtl/dtl.hpp>
 
 #include <boost/dynamic_bitset.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <iomanip>
 #include <type_traits>
@@ -18,6 +20,11 @@ namespace dtl {
 /// Implementation of the Byte Aligned Hybrid bitmap compression technique as
 /// described in the paper 'BAH: A Bitmap Index Compression Algorithm for Fast
 /// Data Retrieval' by Li et al.
+///
+/// The encoder classifies the input words one at a time. Only the skip over
+/// runs of 0-words is vectorized (see bitmap_fun::find_first_mismatch, AVX2
+/// and AVX-512BW); there is no batched SIMD classification of the remaining
+/// words, as the pattern lookup is a hash table probe.
 class bah {
   static constexpr std::size_t word_bitlength = sizeof(bah_word_t) * 8;
 
@@ -29,95 +36,72 @@ class bah {
   /// The length of the encoded bitmap.
   std::size_t encoded_bitmap_length_ = 0;
 
-  /// The different word kinds.
-  enum class word_kind {
-    ZERO,
-    ENCODABLE,
-    LITERAL
-  };
-
-  /// Determines the word kind for a single word of the plain bitmap.
-  static word_kind
-  get_word_kind(bah_word_t word) {
-    if (word == 0) {
-      return word_kind::ZERO;
-    }
-    if (get_oep_code(word) != dtl::bah_code_not_found) {
-      return word_kind::ENCODABLE;
+  /// Appends a segment of the given number of 0-words.
+  void
+  append_zero_words(std::size_t len) {
+    if (len > 252) {
+      main_.push_back(bah_byte_t(0));
+      counter_.push_back(len);
     }
-    if (get_tep_code(word) != dtl::bah_code_not_found) {
-      return word_kind::ENCODABLE;
+    else {
+      while (len > 0) {
+        auto l = std::min(len, std::size_t(63));
+        main_.push_back(static_cast<bah_byte_t>(l));
+        len -= l;
+      }
     }
-    return word_kind::LITERAL;
   }
 
 public:
   bah() = default;
 
   explicit bah(const boost::dynamic_bitset<$u32>& in) {
-    auto* bitmap_begin = in.m_bits.data();
-    auto* bitmap_end = in.m_bits.data() + in.m_bits.size();
-    const auto word_cnt = bitmap_end - bitmap_begin; // TODO handle the case when the bitmap size is not a multiple of the word size
-
-    // The plain bitmap is segmented into words of the same kind.
-    // Keep track of the first and last word of the current segment.
-    std::size_t seg_begin = 0;
-    std::size_t seg_end = 0;
-
-    // Encode the bitmap segment by segment.
-    while (seg_begin < word_cnt) {
-      auto& w = bitmap_begin[seg_begin];
-      auto seg_kind = get_word_kind(w);
-      seg_end = seg_begin + 1;
-      // Find the end of the current 'segment'.
-      while (seg_end < word_cnt
-          && get_word_kind(bitmap_begin[seg_end]) == seg_kind) {
-        auto seg_len = seg_end - seg_begin;
-        if ((seg_kind == word_kind::LITERAL && seg_len == 63)
-            || (seg_kind == word_kind::ENCODABLE)) {
-          break;
-        }
-        ++seg_end;
+    const bah_word_t* words = in.m_bits.data();
+    const std::size_t word_cnt = in.m_bits.size(); // TODO handle the case when the bitmap size is not a multiple of the word size
+
+    // Points to the header byte of the current literal segment, if any.
+    constexpr std::size_t no_literal_seg = std::size_t(-1);
+    std::size_t literal_seg_idx = no_literal_seg;
+    auto close_literal_seg = [&]() { literal_seg_idx = no_literal_seg; };
+
+    // Encode the bitmap word by word. Each word is classified exactly once.
+    std::size_t i = 0;
+    while (i < word_cnt) {
+      const auto w = words[i];
+      if (w == 0) {
+        // Skip over the entire 0-segment. (Compares multiple words at once.)
+        const auto len = dtl::bitmap_fun<bah_word_t>::find_first_mismatch(
+            words + i, words + word_cnt, bah_word_t(0));
+        append_zero_words(len);
+        close_literal_seg();
+        i += len;
+        continue;
       }
-      // Encode the segment.
-      if (seg_kind == word_kind::ZERO) {
-        auto len = seg_end - seg_begin;
-        if (len > 252) {
-          main_.push_back(bah_byte_t(0));
-          counter_.push_back(len);
-        }
-        else {
-          while (len > 0) {
-            auto l = std::min(len, 63ul);
-            main_.push_back(static_cast<bah_byte_t>(l));
-            len -= l;
-          }
-        }
+      auto code = get_oep_code(w);
+      if (code != dtl::bah_code_not_found) {
+        main_.push_back(
+            static_cast<bah_byte_t>(code) | (bah_byte_t(0b10) << 6));
+        close_literal_seg();
       }
-      else if (seg_kind == word_kind::LITERAL) {
-        auto len = seg_end - seg_begin;
-        main_.push_back(static_cast<bah_byte_t>(len) | (bah_byte_t(0b01) << 6));
-        for (std::size_t i = seg_begin; i < seg_end; ++i) {
-          data_.push_back(bitmap_begin[i]);
-        }
+      else if ((code = get_tep_code(w)) != dtl::bah_code_not_found) {
+        bah_byte_t code_lo = code & 0b111111;
+        bah_byte_t code_hi = code >> 6;
+        main_.push_back(code_lo | (bah_byte_t(0b11) << 6));
+        index_.push_back(code_hi);
+        close_literal_seg();
       }
-      else { /* ENCODABLE */
-        auto code = get_oep_code(w);
-        if (code != dtl::bah_code_not_found) {
-          main_.push_back(
-              static_cast<bah_byte_t>(code) | (bah_byte_t(0b10) << 6));
-        }
-        else {
-          code = get_tep_code(w);
-          bah_byte_t code_lo = code & 0b111111;
-          bah_byte_t code_hi = code >> 6;
-          main_.push_back(code_lo | (bah_byte_t(0b11) << 6));
-          index_.push_back(code_hi);
+      else {
+        // Literal. Append to the current literal segment, which can hold up
+        // to 63 words.
+        if (literal_seg_idx == no_literal_seg
+            || (main_[literal_seg_idx] & 0b111111) == 63) {
+          main_.push_back(bah_byte_t(0b01) << 6);
+          literal_seg_idx = main_.size() - 1;
         }
+        ++main_[literal_seg_idx];
+        data_.push_back(w);
       }
-
-      // Next.
-      seg_begin = seg_end;
+      ++i;
     }
     encoded_bitmap_length_ = in.size();
 
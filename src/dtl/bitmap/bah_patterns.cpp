@@ -4,7 +4,8 @@
 
 #include <dtl/dtl.hpp>
 
-#include <iterator>
+#include <cstddef>
+#include <vector>
 //===----------------------------------------------------------------------===//
 namespace dtl {
 //===----------------------------------------------------------------------===//
@@ -11511,16 +11512,10 @@ static const bah_word_t bah_tep[] {
   4294967295,
 };
 //===----------------------------------------------------------------------===//
-bah_word_t
-get_oep_code(bah_word_t word) {
-  auto* begin = &bah_oep[0];
-  auto* end = &bah_oep[0] + sizeof(bah_oep) / sizeof(bah_word_t);
-  auto search = std::lower_bound(begin, end, word);
-  if (search == end || *search != word) {
-    return bah_code_not_found;
-  }
-  return std::distance(begin, search);
-}
+static_assert(sizeof(bah_oep) / sizeof(bah_word_t) == bah_oep_cnt,
+    "Unexpected number of one-byte encodable patterns.");
+static_assert(sizeof(bah_tep) / sizeof(bah_word_t) == bah_tep_cnt,
+    "Unexpected number of two-byte encodable patterns.");
 //===----------------------------------------------------------------------===//
 bah_word_t
 get_oep(bah_word_t code) {
@@ -11528,15 +11523,53 @@ get_oep(bah_word_t code) {
   return bah_oep[code];
 }
 //===----------------------------------------------------------------------===//
-bah_word_t
-get_tep_code(bah_word_t word) {
-  auto* begin = &bah_tep[0];
-  auto* end = &bah_tep[0] + sizeof(bah_tep) / sizeof(bah_word_t);
-  auto search = std::lower_bound(begin, end, word);
-  if (search == end || *search != word) {
+namespace {
+//===----------------------------------------------------------------------===//
+/// Maps the two-byte encodable patterns to their codes. The map uses open
+/// addressing with linear probing. With a load factor of about 0.35, a lookup
+/// probes less than 1.3 slots on average.
+class bah_tep_map {
+  static constexpr std::size_t capacity = 1ull << 15;
+  static constexpr $u16 empty = $u16(~$u16(0));
+
+  std::vector<bah_word_t> keys_;
+  std::vector<$u16> codes_;
+
+  static std::size_t
+  hash(bah_word_t word) noexcept {
+    return ($u32(word) * 0x9E3779B1u) >> (32 - 15);
+  }
+
+public:
+  bah_tep_map() : keys_(capacity, 0), codes_(capacity, empty) {
+    static_assert(bah_tep_cnt < capacity / 2, "Hash table capacity too low.");
+    for (std::size_t code = 0; code < bah_tep_cnt; ++code) {
+      auto slot = hash(bah_tep[code]);
+      while (codes_[slot] != empty) {
+        slot = (slot + 1) & (capacity - 1);
+      }
+      keys_[slot] = bah_tep[code];
+      codes_[slot] = static_cast<$u16>(code);
+    }
+  }
+
+  bah_word_t
+  lookup(bah_word_t word) const noexcept {
+    auto slot = hash(word);
+    while (codes_[slot] != empty) {
+      if (keys_[slot] == word) return codes_[slot];
+      slot = (slot + 1) & (capacity - 1);
+    }
     return bah_code_not_found;
   }
-  return std::distance(begin, search);
+};
+//===----------------------------------------------------------------------===//
+} // anonymous namespace
+//===----------------------------------------------------------------------===//
+bah_word_t
+get_tep_code(bah_word_t word) {
+  static const bah_tep_map map;
+  return map.lookup(word);
 }
 //===----------------------------------------------------------------------===//
 bah_word_t
@@ -2,7 +2,10 @@
 //===----------------------------------------------------------------------===//
 #include "bah_types.hpp"
 
+#include <dtl/bits.hpp>
 #include <dtl/dtl.hpp>
+
+#include <cstddef>
 //===----------------------------------------------------------------------===//
 namespace dtl {
 //===----------------------------------------------------------------------===//
@@ -12,12 +15,29 @@ namespace dtl {
 //===----------------------------------------------------------------------===//
 /// Special value that signals, that no code for the given bit pattern exists.
 static constexpr bah_word_t bah_code_not_found = bah_word_t(~0ull);
+/// The number of one-byte encodable patterns.
+static constexpr std::size_t bah_oep_cnt = 64;
+/// The number of two-byte encodable patterns.
+static constexpr std::size_t bah_tep_cnt = 11431;
 //===----------------------------------------------------------------------===//
 /// Determines the code for the given word. If no code exists,
 /// 'bah_code_not_found' is returned.
-/// Time complexity: Logarithmic in the LuT size.
-bah_word_t
-get_oep_code(bah_word_t word); // TODO should be in O(1)
+///
+/// The one-byte encodable patterns are the words with a single 1-bit, the
+/// words with two adjacent 1-bits, and the all-1 word. In the (sorted) LuT,
+/// the pattern 1 << p is at index 2p-1 (p > 0), the pattern 3 << p at index
+/// 2p+2, and the all-1 word at index 63. Thus, the code is computed directly.
+/// Time complexity: O(1).
+inline bah_word_t
+get_oep_code(bah_word_t word) {
+  if (word == 0) return bah_code_not_found;
+  if (word == bah_word_t(~bah_word_t(0))) return 63;
+  const auto p = dtl::bits::tz_count(word);
+  const auto w = word >> p;
+  if (w == 1) return p == 0 ? 0 : 2 * p - 1;
+  if (w == 3) return 2 * p + 2;
+  return bah_code_not_found;
+}
 //===----------------------------------------------------------------------===//
 /// Returns the word (or pattern) associated with the given code.
 bah_word_t
@@ -25,9 +45,9 @@ get_oep(bah_word_t code);
 //===----------------------------------------------------------------------===//
 /// Determines the code for the given word. If no code exists,
 /// 'bah_code_not_found' is returned.
-/// Time complexity: Logarithmic in the LuT size.
+/// Time complexity: O(1) expected (hash table lookup).
 bah_word_t
-get_tep_code(bah_word_t word); // TODO should be in O(1)
+get_tep_code(bah_word_t word);
 //===----------------------------------------------------------------------===//
 /// Returns the word (or pattern) associated with the given code.
 bah_word_t
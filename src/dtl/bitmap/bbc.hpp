@@ -1,11 +1,11 @@
 #pragma once
 //===----------------------------------------------------------------------===//
 #include <dtl/bitmap/util/plain_bitmap.hpp>
-#include <dtl/bitmap/util/plain_bitmap_iter.hpp>
 #include <dtl/dtl.hpp>
 
 #include <boost/dynamic_bitset.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <type_traits>
 #include <vector>
@@ -80,6 +80,103 @@ protected:
     return MIXED;
   }
   //===--------------------------------------------------------------------===//
+  /// A decoded atom, which consists of a header byte, an optional
+  /// variable-byte counter and the tail, which is either a dirty byte or a
+  /// sequence of literal bytes.
+  struct atom_t {
+    /// The number of fill bytes.
+    $u64 fill_byte_cnt = 0;
+    /// The fill value.
+    $u1 fill_val = false;
+    /// True, if the tail consists of a single dirty byte.
+    $u1 dirty = false;
+    /// The dirty byte (if any).
+    byte_t dirty_byte = 0;
+    /// The number of literal bytes.
+    $u32 literal_byte_cnt = 0;
+    /// The index of the first literal byte in the compressed bitmap.
+    $u64 literal_idx = 0;
+    /// The index of the next header in the compressed bitmap.
+    $u64 next_idx = 0;
+
+    /// Returns the number of tail bytes.
+    u32 __forceinline__
+    tail_byte_cnt() const noexcept {
+      return dirty ? 1 : literal_byte_cnt;
+    }
+
+    /// Returns the number of (uncompressed) bytes covered by the atom.
+    u64 __forceinline__
+    byte_cnt() const noexcept {
+      return fill_byte_cnt + tail_byte_cnt();
+    }
+  };
+
+  /// Decodes the atom whose header is at index i.
+  static void __forceinline__
+  decode_atom(const std::vector<byte_t>& data, std::size_t i, atom_t& atom) {
+    const auto hdr = data[i];
+    const auto bbc_case = dtl::bits::lz_count(u32(hdr)) - 23;
+    atom.dirty = false;
+    atom.literal_byte_cnt = 0;
+    switch (bbc_case) {
+      case 1: {
+        atom.fill_val = (hdr & 0b01000000) != 0;
+        atom.fill_byte_cnt = (hdr & 0b00110000) >> 4;
+        atom.literal_byte_cnt = hdr & 0b00001111;
+        atom.literal_idx = i + 1;
+        atom.next_idx = i + 1 + atom.literal_byte_cnt;
+        break;
+      }
+      case 2: {
+        atom.fill_val = (hdr & 0b00100000) != 0;
+        atom.fill_byte_cnt = (hdr & 0b00011000) >> 3;
+        atom.dirty = true;
+        atom.dirty_byte = (atom.fill_val ? all_one : all_zero)
+            ^ (1 << (hdr & 0b00000111));
+        atom.next_idx = i + 1;
+        break;
+      }
+      case 3:
+      case 4: {
+        atom.fill_val = bbc_case == 3
+            ? (hdr & 0b00010000) != 0
+            : (hdr & 0b00001000) != 0;
+        // Read the variable-byte (VB) counter.
+        std::size_t fill_byte_cnt = 0;
+        std::size_t fill_byte_cntr_len = 1;
+        for (; fill_byte_cntr_len <= 4; ++fill_byte_cntr_len) {
+          const auto x = data[i + fill_byte_cntr_len];
+          fill_byte_cnt <<= 7;
+          fill_byte_cnt |= (x & 0b01111111);
+          if ((x & 0b10000000) == 0) break;
+        }
+        atom.fill_byte_cnt = fill_byte_cnt;
+        if (bbc_case == 3) {
+          atom.literal_byte_cnt = hdr & 0b00001111;
+          atom.literal_idx = i + 1 + fill_byte_cntr_len;
+          atom.next_idx = atom.literal_idx + atom.literal_byte_cnt;
+        }
+        else {
+          atom.dirty = true;
+          atom.dirty_byte = (atom.fill_val ? all_one : all_zero)
+              ^ (1 << (hdr & 0b00000111));
+          atom.next_idx = i + 1 + fill_byte_cntr_len;
+        }
+        break;
+      }
+    }
+  }
+
+  /// A sampled position within the compressed bitmap, which allows the
+  /// iterator to skip without decoding all the preceding atoms.
+  struct skip_offset_t {
+    /// The index of an atom header in the compressed bitmap.
+    $u32 data_idx;
+    /// The (uncompressed) byte position where the atom begins.
+    $u32 byte_pos;
+  };
+  //===--------------------------------------------------------------------===//
 
   /// Compress the given input bitmap.
   void
@@ -251,115 +348,27 @@ public:
     byte_t* byte_array = reinterpret_cast<byte_t*>(bitmap.data());
     std::size_t o = 0;
     std::size_t i = 0;
-    if (data_.empty()) return bitmap;
-
+    atom_t atom;
     while (i < data_.size()) {
-      const auto hdr = data_[i];
-      const auto bbc_case = dtl::bits::lz_count(u32(hdr)) - 23;
-      switch (bbc_case) {
-        case 1: {
-          u1 fill_val = (hdr & 0b01000000) != 0;
-          const std::size_t fill_byte_cnt = (hdr & 0b00110000) >> 4;
-          const std::size_t tail_byte_cnt = hdr & 0b00001111;
-
-          // Write the fill.
-          const byte_t fill_byte = fill_val ? all_one : all_zero;
-          for (std::size_t k = 0; k < fill_byte_cnt; ++k) {
-            byte_array[o + k] = fill_byte;
-          }
-          o += fill_byte_cnt;
-
-          // Write the literals.
-          for (std::size_t k = 0; k < tail_byte_cnt; ++k) {
-            byte_array[o + k] = data_[i + 1 + k];
-          }
-          o += tail_byte_cnt;
-
-          i += 1 + tail_byte_cnt;
-          break;
-        }
-
-        case 2: {
-          u1 fill_val = (hdr & 0b00100000) != 0;
-          const std::size_t fill_byte_cnt = (hdr & 0b00011000) >> 3;
-          const std::size_t dirty_bit_pos = hdr & 0b00000111;
-
-          // Write the fill.
-          const byte_t fill_byte = fill_val ? all_one : all_zero;
-          for (std::size_t k = 0; k < fill_byte_cnt; ++k) {
-            byte_array[o + k] = fill_byte;
-          }
-          o += fill_byte_cnt;
-
-          // Write the tail.
-          const byte_t dirty_tail_byte = fill_byte ^ (1 << dirty_bit_pos);
-          byte_array[o] = dirty_tail_byte;
-          o += 1;
-
-          i += 1;
-          break;
-        }
-
-        case 3: {
-          u1 fill_val = (hdr & 0b00010000) != 0;
-          // Read the variable-byte (VB) counter.
-          std::size_t fill_byte_cnt = 0;
-          std::size_t fill_byte_cntr_len = 1;
-          for (; fill_byte_cntr_len <= 4; ++fill_byte_cntr_len) {
-            const auto x = data_[i + fill_byte_cntr_len];
-            fill_byte_cnt <<= 7;
-            fill_byte_cnt |= (x & 0b01111111);
-            if ((x & 0b10000000) == 0) break;
-          }
-          const std::size_t tail_byte_cnt = hdr & 0b00001111;
-
-          // Write the fill.
-          const byte_t fill_byte = fill_val ? all_one : all_zero;
-          for (std::size_t k = 0; k < fill_byte_cnt; ++k) {
-            byte_array[o + k] = fill_byte;
-          }
-          o += fill_byte_cnt;
-
-          // Write the literals.
-          for (std::size_t k = 0; k < tail_byte_cnt; ++k) {
-            byte_array[o + k] = data_[i + 1 + k + fill_byte_cntr_len];
-          }
-          o += tail_byte_cnt;
-
-          i += 1 + fill_byte_cntr_len + tail_byte_cnt;
-          break;
-        }
-
-        case 4: {
-          u1 fill_val = (hdr & 0b00001000) != 0;
-          // Read the variable-byte (VB) counter.
-          std::size_t fill_byte_cnt = 0;
-          std::size_t fill_byte_cntr_len = 1;
-          for (; fill_byte_cntr_len <= 4; ++fill_byte_cntr_len) {
-            const auto x = data_[i + fill_byte_cntr_len];
-            fill_byte_cnt <<= 7;
-            fill_byte_cnt |= (x & 0b01111111);
-            if ((x & 0b10000000) == 0) break;
-          }
-          const std::size_t dirty_bit_pos = hdr & 0b00000111;
-
-          // Write the fill.
-          const byte_t fill_byte = fill_val ? all_one : all_zero;
-          for (std::size_t k = 0; k < fill_byte_cnt; ++k) {
-            byte_array[o + k] = fill_byte;
-          }
-          o += fill_byte_cnt;
-
-          // Write the tail.
-          const byte_t dirty_tail_byte = fill_byte ^ (1 << dirty_bit_pos);
-          byte_array[o] = dirty_tail_byte;
-          o += 1;
-
-          i += 1 + fill_byte_cntr_len;
-          break;
+      decode_atom(data_, i, atom);
+      // Write the fill.
+      const byte_t fill_byte = atom.fill_val ? all_one : all_zero;
+      for (std::size_t k = 0; k < atom.fill_byte_cnt; ++k) {
+        byte_array[o + k] = fill_byte;
+      }
+      o += atom.fill_byte_cnt;
+      // Write the tail.
+      if (atom.dirty) {
+        byte_array[o] = atom.dirty_byte;
+        o += 1;
+      }
+      else {
+        for (std::size_t k = 0; k < atom.literal_byte_cnt; ++k) {
+          byte_array[o + k] = data_[atom.literal_idx + k];
         }
-
+        o += atom.literal_byte_cnt;
       }
+      i = atom.next_idx;
     }
     return bitmap;
   }
@@ -369,11 +378,15 @@ public:
     return "bbc";
   }
 
-  /// Returns the value of the bit at the position pos.
+  /// Returns the value of the bit at the position pos. The atoms are decoded
+  /// from the beginning, i.e., the time complexity is O(n). See bbc_skip for
+  /// a variant that uses sampled atom offsets.
   u1 __forceinline__
   test(const std::size_t pos) const {
-    const auto dec = to_plain_bitmap(); // FIXME HACK
-    return dec.test(pos);
+    iter it(*this);
+    if (it.end() || pos < it.pos()) return false;
+    it.skip_to(pos);
+    return !it.end() && it.pos() == pos;
   }
 
   /// Try to reduce the memory consumption. This function is supposed to be
@@ -384,52 +397,239 @@ public:
   }
 
   //===--------------------------------------------------------------------===//
-  /// 1-run iterator
+  /// 1-run iterator, which decodes the atoms on the fly. Internally, the
+  /// atoms are split into segments, which are either fills (of arbitrary
+  /// length) or single literal bytes.
   class iter {
     const bbc& outer_;
+    /// Optional skip offsets (sampled atom positions).
+    const std::vector<skip_offset_t>* skip_offsets_;
 
     //===------------------------------------------------------------------===//
     // Iterator state
     //===------------------------------------------------------------------===//
-    using plain_bitmap_t = dtl::plain_bitmap<$u64>;
-    std::unique_ptr<plain_bitmap_t> plain_bitmap_; // FIXME HACK
-    using nested_iter_t = dtl::plain_bitmap_iter<dtl::plain_bitmap<$u64>>;
-    std::unique_ptr<nested_iter_t> plain_bitmap_iter_;
+    /// The index of the next atom header.
+    $u64 data_idx_;
+    /// The current atom.
+    atom_t atom_;
+    /// The index of the next tail byte within the current atom.
+    $u32 tail_idx_;
+    /// The (bit) position where the current segment begins.
+    $u64 seg_begin_;
+    /// The length of the current segment in bits. 0, if all segments have
+    /// been consumed.
+    $u64 seg_length_;
+    /// True, if the current segment is a fill.
+    $u1 seg_is_fill_;
+    /// The fill value or the literal byte of the current segment.
+    byte_t seg_val_;
+    /// The position from where to search for the next 1-run.
+    $u64 cursor_;
+    /// Points to the beginning of the current 1-run.
+    $u64 pos_;
+    /// The length of the current 1-run.
+    $u64 length_;
     //===------------------------------------------------------------------===//
 
+    /// Returns the literal byte at index i within the tail of the current
+    /// atom.
+    byte_t __forceinline__
+    tail_byte(u32 i) const noexcept {
+      return atom_.dirty
+          ? atom_.dirty_byte
+          : outer_.data_[atom_.literal_idx + i];
+    }
+
+    /// Forwards to the next segment.
+    void __forceinline__
+    next_segment() noexcept {
+      seg_begin_ += seg_length_;
+      if (tail_idx_ < atom_.tail_byte_cnt()) {
+        seg_is_fill_ = false;
+        seg_val_ = tail_byte(tail_idx_);
+        seg_length_ = 8;
+        ++tail_idx_;
+        return;
+      }
+      // Decode the next atom.
+      const auto& data = outer_.data_;
+      while (data_idx_ < data.size()) {
+        decode_atom(data, data_idx_, atom_);
+        data_idx_ = atom_.next_idx;
+        tail_idx_ = 0;
+        if (atom_.fill_byte_cnt > 0) {
+          seg_is_fill_ = true;
+          seg_val_ = atom_.fill_val;
+          seg_length_ = atom_.fill_byte_cnt * 8;
+          return;
+        }
+        if (atom_.tail_byte_cnt() > 0) {
+          seg_is_fill_ = false;
+          seg_val_ = tail_byte(0);
+          seg_length_ = 8;
+          tail_idx_ = 1;
+          return;
+        }
+      }
+      seg_length_ = 0;
+    }
+
+    /// Repositions the iterator at the beginning of the given atom.
+    void __forceinline__
+    seek(const skip_offset_t& offset) noexcept {
+      data_idx_ = offset.data_idx;
+      atom_ = atom_t();
+      tail_idx_ = 0;
+      seg_begin_ = u64(offset.byte_pos) * 8;
+      seg_length_ = 0;
+      next_segment();
+    }
+
+    /// Searches for the next 1-run, starting at the given position, which
+    /// needs to be within the current segment.
+    void __forceinline__
+    find_run(u64 from) noexcept {
+      const auto n = outer_.encoded_bitmap_length_;
+      $u64 c = from;
+      // Search for the next 1-bit.
+      while (seg_length_ > 0) {
+        const auto seg_end = seg_begin_ + seg_length_;
+        if (c >= seg_end) {
+          next_segment();
+          continue;
+        }
+        if (seg_is_fill_) {
+          if (seg_val_) break;
+        }
+        else {
+          const u32 bits = u32(seg_val_) >> (c - seg_begin_);
+          if (bits != 0) {
+            c += dtl::bits::tz_count(bits);
+            break;
+          }
+        }
+        c = seg_end;
+        next_segment();
+      }
+      if (seg_length_ == 0 || c >= n) {
+        cursor_ = n;
+        pos_ = n;
+        length_ = 0;
+        return;
+      }
+      const auto b = c;
+      // Search for the next 0-bit.
+      while (seg_length_ > 0) {
+        const auto seg_end = seg_begin_ + seg_length_;
+        if (c >= seg_end) {
+          next_segment();
+          continue;
+        }
+        if (seg_is_fill_) {
+          if (!seg_val_) break;
+        }
+        else {
+          const u32 bits = (~u32(seg_val_) & 0xFFu) >> (c - seg_begin_);
+          if (bits != 0) {
+            c += dtl::bits::tz_count(bits);
+            break;
+          }
+        }
+        c = seg_end;
+        next_segment();
+      }
+      cursor_ = c;
+      pos_ = b;
+      length_ = std::min(c, u64(n)) - b;
+    }
+
   public:
     explicit __forceinline__
-    iter(const bbc& outer)
-        : outer_(outer) {
-      plain_bitmap_ = std::make_unique<plain_bitmap_t>(outer.to_plain_bitmap());
-      plain_bitmap_iter_ = std::make_unique<nested_iter_t>(*plain_bitmap_);
+    iter(const bbc& outer,
+        const std::vector<skip_offset_t>* skip_offsets = nullptr)
+        : outer_(outer),
+          skip_offsets_(skip_offsets),
+          data_idx_(0),
+          atom_(),
+          tail_idx_(0),
+          seg_begin_(0),
+          seg_length_(0),
+          seg_is_fill_(false),
+          seg_val_(0),
+          cursor_(0),
+          pos_(0),
+          length_(0) {
+      next_segment();
+      find_run(0);
     }
 
+    iter(iter&&) noexcept = default;
+
     /// Forward the iterator to the next 1-run.
     void __forceinline__
     next() {
-      plain_bitmap_iter_->next();
+      find_run(cursor_);
     }
 
     /// Forward the iterator to the desired position.
     void __forceinline__
     skip_to(const std::size_t to_pos) {
-      plain_bitmap_iter_->skip_to(to_pos);
+      if (to_pos < (pos_ + length_)) {
+        length_ -= to_pos - pos_;
+        pos_ = to_pos;
+        return;
+      }
+      if (to_pos >= outer_.encoded_bitmap_length_) {
+        cursor_ = pos_ = outer_.encoded_bitmap_length_;
+        length_ = 0;
+        return;
+      }
+      // Use the skip offsets, if the destination is beyond the current
+      // segment.
+      if (skip_offsets_ != nullptr
+          && to_pos >= seg_begin_ + seg_length_) {
+        const auto& offsets = *skip_offsets_;
+        auto search = std::upper_bound(offsets.begin(), offsets.end(), to_pos,
+            [](const std::size_t lhs, const skip_offset_t& rhs) {
+              return lhs < u64(rhs.byte_pos) * 8;
+            });
+        if (search != offsets.begin()) {
+          const auto& offset = *(search - 1);
+          if (u64(offset.byte_pos) * 8 > seg_begin_ + seg_length_) {
+            seek(offset);
+          }
+        }
+      }
+      // Skip over entire segments.
+      while (seg_length_ > 0 && seg_begin_ + seg_length_ <= to_pos) {
+        if (!seg_is_fill_) {
+          // Skip over multiple literal bytes at once.
+          const auto remaining = atom_.tail_byte_cnt() - tail_idx_;
+          const auto tail_end = seg_begin_ + 8 * (1 + remaining);
+          const auto k = (tail_end <= to_pos)
+              ? remaining + 1
+              : (to_pos - seg_begin_) / 8;
+          seg_begin_ += 8 * (k - 1);
+          tail_idx_ += static_cast<$u32>(k - 1);
+        }
+        next_segment();
+      }
+      find_run(std::max(u64(to_pos), seg_begin_));
     }
 
     u1 __forceinline__
     end() const noexcept {
-      return plain_bitmap_iter_->end();
+      return length_ == 0;
     }
 
     u64 __forceinline__
     pos() const noexcept {
-      return plain_bitmap_iter_->pos();
+      return pos_;
     }
 
     u64 __forceinline__
     length() const noexcept {
-      return plain_bitmap_iter_->length();
+      return length_;
     }
   };
   //===--------------------------------------------------------------------===//
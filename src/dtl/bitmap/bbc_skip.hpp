@@ -0,0 +1,121 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include "bbc.hpp"
+
+#include <dtl/dtl.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+//===----------------------------------------------------------------------===//
+namespace dtl {
+//===----------------------------------------------------------------------===//
+/// Byte-aligned Bitmap Code (BBC). This implementation maintains a small index
+/// that allows for faster skips.
+template<std::size_t _skip_distance = 1024>
+class bbc_skip : public bbc {
+  using super = bbc;
+
+  /// The sampled atom positions. An offset is recorded for every
+  /// _skip_distance-th atom.
+  std::vector<skip_offset_t> offsets_;
+
+  /// Initialize the skip offsets.
+  void
+  init_skip_offsets() {
+    std::size_t i = 0;
+    std::size_t byte_pos = 0;
+    std::size_t atom_idx = 0;
+    atom_t atom;
+    while (i < this->data_.size()) {
+      if (atom_idx % _skip_distance == 0) {
+        offsets_.push_back(skip_offset_t {
+            static_cast<$u32>(i), static_cast<$u32>(byte_pos)});
+      }
+      decode_atom(this->data_, i, atom);
+      byte_pos += atom.byte_cnt();
+      i = atom.next_idx;
+      ++atom_idx;
+    }
+  }
+
+public:
+  bbc_skip() = default;
+
+  explicit bbc_skip(const boost::dynamic_bitset<$u32>& in)
+      : super(in), offsets_() {
+    init_skip_offsets();
+    shrink();
+  }
+
+  ~bbc_skip() = default;
+  bbc_skip(const bbc_skip& other) = default;
+  bbc_skip(bbc_skip&& other) noexcept = default;
+  bbc_skip& operator=(const bbc_skip& other) = default;
+  bbc_skip& operator=(bbc_skip&& other) noexcept = default;
+
+  /// Return the size in bytes.
+  std::size_t __forceinline__
+  size_in_bytes() const {
+    return super::size_in_bytes()
+        + offsets_.size() * sizeof(skip_offset_t);
+  }
+
+  static std::string
+  name() {
+    return "bbc_skip";
+  }
+
+  /// Returns the value of the bit at the position pos. The closest preceding
+  /// atom offset is binary-searched, so that at most _skip_distance atoms are
+  /// decoded.
+  u1 __forceinline__
+  test(const std::size_t pos) const {
+    iter it(*this, &offsets_);
+    if (it.end() || pos < it.pos()) return false;
+    it.skip_to(pos);
+    return !it.end() && it.pos() == pos;
+  }
+
+  /// Try to reduce the memory consumption. This function is supposed to be
+  /// called after the bitmap has been modified.
+  __forceinline__ void
+  shrink() {
+    super::shrink();
+    offsets_.shrink_to_fit();
+  }
+
+  using skip_iter_type = iter;
+  using scan_iter_type = iter;
+
+  /// Returns a 1-run iterator.
+  skip_iter_type __forceinline__
+  it() const {
+    return skip_iter_type(*this, &offsets_);
+  }
+
+  /// Returns a 1-run iterator. (The skip offsets are not required for
+  /// scans.)
+  scan_iter_type __forceinline__
+  scan_it() const {
+    return scan_iter_type(*this);
+  }
+
+  /// Returns the name of the instance including the most important parameters
+  /// in JSON.
+  std::string
+  info() const {
+    return "{\"name\":\"" + name() + "\""
+        + ",\"n\":" + std::to_string(encoded_bitmap_length_)
+        + ",\"size\":" + std::to_string(size_in_bytes())
+        + ",\"word_size\":" + std::to_string(sizeof(byte_t))
+        + ",\"skip_distance\":" + std::to_string(_skip_distance)
+        + ",\"skip_offsets_size\":"
+        + std::to_string(offsets_.size() * sizeof(skip_offset_t))
+        + "}";
+  }
+};
+//===----------------------------------------------------------------------===//
+} // namespace dtl
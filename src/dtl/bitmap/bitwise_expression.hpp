@@ -0,0 +1,486 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include <dtl/dtl.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <utility>
+#include <vector>
+//===----------------------------------------------------------------------===//
+namespace dtl {
+//===----------------------------------------------------------------------===//
+/// An expression tree over bitmaps of the same type that consists of
+/// conjunctions and disjunctions. Unlike nested bitwise_iter instances, the
+/// expression is evaluated by a single iterator (see bitwise_expr_iter), which
+/// operates on flattened n-ary operators.
+///
+/// Associative chains of the same operator are flattened during construction,
+/// i.e., (a AND b) AND c results in a single conjunction with three inputs.
+template<typename bitmap_t>
+class bitwise_expr {
+public:
+  enum class kind : $u8 { leaf, conjunction, disjunction };
+
+private:
+  kind kind_;
+  /// The bitmap (leaf nodes only).
+  const bitmap_t* bitmap_;
+  /// The (optional) number of 1-bits in the bitmap (leaf nodes only).
+  $u64 cardinality_hint_;
+  /// The inputs of the operator (inner nodes only).
+  std::vector<bitwise_expr> children_;
+
+  bitwise_expr(kind k, const bitmap_t* bitmap, u64 cardinality_hint)
+      : kind_(k), bitmap_(bitmap), cardinality_hint_(cardinality_hint) {}
+
+  /// Combines the two expressions using the given operator. If an input is an
+  /// operator of the same kind, its inputs are adopted.
+  static bitwise_expr
+  combine(kind k, bitwise_expr&& a, bitwise_expr&& b) {
+    bitwise_expr ret(k, nullptr, 0);
+    for (auto* e : { &a, &b }) {
+      if (e->kind_ == k) {
+        for (auto& c : e->children_) ret.children_.push_back(std::move(c));
+      }
+      else {
+        ret.children_.push_back(std::move(*e));
+      }
+    }
+    return ret;
+  }
+
+public:
+  bitwise_expr(bitwise_expr&&) = default;
+  bitwise_expr(const bitwise_expr&) = default;
+  bitwise_expr& operator=(bitwise_expr&&) = default;
+  bitwise_expr& operator=(const bitwise_expr&) = default;
+
+  /// Constructs a leaf node that refers to the given bitmap. The bitmap needs
+  /// to outlive the expression and its iterators. The cardinality hint is
+  /// used to estimate the selectivity of the input. If no hint is given
+  /// (= 0), the size of the compressed bitmap is used as an estimate instead.
+  static bitwise_expr
+  leaf(const bitmap_t& bitmap, u64 cardinality_hint = 0) {
+    return bitwise_expr(kind::leaf, &bitmap, cardinality_hint);
+  }
+
+  /// Constructs the conjunction of the given expressions.
+  static bitwise_expr
+  conjunction(bitwise_expr&& a, bitwise_expr&& b) {
+    return combine(kind::conjunction, std::move(a), std::move(b));
+  }
+
+  /// Constructs the disjunction of the given expressions.
+  static bitwise_expr
+  disjunction(bitwise_expr&& a, bitwise_expr&& b) {
+    return combine(kind::disjunction, std::move(a), std::move(b));
+  }
+
+  kind
+  get_kind() const noexcept {
+    return kind_;
+  }
+
+  const bitmap_t&
+  bitmap() const noexcept {
+    assert(kind_ == kind::leaf);
+    return *bitmap_;
+  }
+
+  const std::vector<bitwise_expr>&
+  children() const noexcept {
+    return children_;
+  }
+
+  /// Returns the estimated number of 1-bits produced by the expression. The
+  /// estimate is only used to order the inputs of conjunctions, thus the
+  /// estimates need to be comparable, i.e., the cardinality hints should be
+  /// given either for all or for none of the leaves.
+  u64
+  estimated_cardinality() const noexcept {
+    switch (kind_) {
+      case kind::leaf:
+        return cardinality_hint_ != 0
+            ? cardinality_hint_
+            : static_cast<$u64>(bitmap_->size_in_bytes());
+      case kind::conjunction: {
+        $u64 ret = std::numeric_limits<$u64>::max();
+        for (const auto& c : children_) {
+          ret = std::min(ret, c.estimated_cardinality());
+        }
+        return ret;
+      }
+      case kind::disjunction: {
+        $u64 ret = 0;
+        for (const auto& c : children_) ret += c.estimated_cardinality();
+        return ret;
+      }
+    }
+    return 0;
+  }
+
+  /// Returns the length of the bitmaps.
+  u64
+  size() const noexcept {
+    return kind_ == kind::leaf ? bitmap_->size() : children_.front().size();
+  }
+
+  /// Returns the number of leaf nodes.
+  std::size_t
+  leaf_cnt() const noexcept {
+    if (kind_ == kind::leaf) return 1;
+    std::size_t ret = 0;
+    for (const auto& c : children_) ret += c.leaf_cnt();
+    return ret;
+  }
+};
+//===----------------------------------------------------------------------===//
+/// Run iterator that evaluates a bitwise expression. The expression is
+/// compiled into a flat array of n-ary operator nodes, where the inputs of
+/// conjunctions are ordered by their estimated cardinality (ascending). The
+/// most selective input thus determines the candidate positions, which the
+/// remaining inputs skip to (leapfrogging). Skips are pushed down to the
+/// (skip) iterators of the leaf bitmaps.
+template<typename bitmap_t>
+class bitwise_expr_iter {
+  using expr_t = bitwise_expr<bitmap_t>;
+  using kind = typename expr_t::kind;
+  using leaf_iter_t = decltype(std::declval<const bitmap_t&>().it());
+
+  struct node {
+    kind k;
+    /// The index of the leaf iterator (leaf nodes only).
+    $u32 leaf_idx;
+    /// The range of the child indexes in children_ (inner nodes only).
+    $u32 children_begin;
+    $u32 children_end;
+    /// Points to the beginning of the current 1-fill.
+    $u64 pos;
+    /// The length of the current 1-fill. A length of zero indicates that the
+    /// node reached the end.
+    $u64 length;
+  };
+
+  /// The operator nodes (in pre-order, i.e., the root node comes first).
+  std::vector<node> nodes_;
+  /// The child node indexes of the operator nodes.
+  std::vector<$u32> children_;
+  /// The iterators of the leaf bitmaps.
+  std::vector<leaf_iter_t> leaf_its_;
+  /// The length of the bitmaps.
+  $u64 n_;
+
+  /// Appends the nodes of the given (sub-)expression and returns the index of
+  /// its root node.
+  $u32
+  compile(const expr_t& e) {
+    const auto idx = static_cast<$u32>(nodes_.size());
+    nodes_.push_back(node { e.get_kind(), 0, 0, 0, 0, 0 });
+    if (e.get_kind() == kind::leaf) {
+      nodes_[idx].leaf_idx = static_cast<$u32>(leaf_its_.size());
+      leaf_its_.emplace_back(e.bitmap().it());
+      return idx;
+    }
+    std::vector<const expr_t*> inputs;
+    for (const auto& c : e.children()) inputs.push_back(&c);
+    if (e.get_kind() == kind::conjunction) {
+      std::stable_sort(inputs.begin(), inputs.end(),
+          [](const expr_t* a, const expr_t* b) {
+            return a->estimated_cardinality() < b->estimated_cardinality();
+          });
+    }
+    std::vector<$u32> child_idxs;
+    for (auto* c : inputs) child_idxs.push_back(compile(*c));
+    nodes_[idx].children_begin = static_cast<$u32>(children_.size());
+    children_.insert(children_.end(), child_idxs.begin(), child_idxs.end());
+    nodes_[idx].children_end = static_cast<$u32>(children_.size());
+    return idx;
+  }
+
+  /// Marks the given node as exhausted.
+  void __forceinline__
+  set_end(node& nd) noexcept {
+    nd.pos = n_;
+    nd.length = 0;
+  }
+
+  /// Updates the current 1-fill of a leaf node.
+  void __forceinline__
+  fetch_leaf(node& nd) noexcept {
+    const auto& it = leaf_its_[nd.leaf_idx];
+    if (it.end()) {
+      set_end(nd);
+    }
+    else {
+      nd.pos = it.pos();
+      nd.length = it.length();
+    }
+  }
+
+  /// Produces the first 1-fill of a conjunction that starts at or after the
+  /// given position. All inputs are positioned at or after 'begin'.
+  void
+  produce_and(node& nd, $u64 begin) noexcept {
+    while (true) {
+      $u64 end = std::numeric_limits<$u64>::max();
+      for (auto i = nd.children_begin; i < nd.children_end; ++i) {
+        auto& c = nodes_[children_[i]];
+        if (c.pos + c.length <= begin) skip_to(c, begin);
+        if (c.length == 0) {
+          set_end(nd);
+          return;
+        }
+        begin = std::max(begin, c.pos);
+        end = std::min(end, c.pos + c.length);
+      }
+      if (begin < end) {
+        nd.pos = begin;
+        nd.length = end - begin;
+        return;
+      }
+    }
+  }
+
+  /// Produces the first 1-fill of a disjunction. The inputs are positioned at
+  /// or after the end of the previous 1-fill.
+  void
+  produce_or(node& nd) noexcept {
+    $u64 begin = n_;
+    for (auto i = nd.children_begin; i < nd.children_end; ++i) {
+      const auto& c = nodes_[children_[i]];
+      if (c.length != 0) begin = std::min(begin, c.pos);
+    }
+    if (begin == n_) {
+      set_end(nd);
+      return;
+    }
+    // Extend the 1-fill by all the overlapping or adjacent 1-fills.
+    $u64 end = begin;
+    $u1 extended = true;
+    while (extended) {
+      extended = false;
+      for (auto i = nd.children_begin; i < nd.children_end; ++i) {
+        const auto& c = nodes_[children_[i]];
+        if (c.length != 0 && c.pos <= end && c.pos + c.length > end) {
+          end = c.pos + c.length;
+          extended = true;
+        }
+      }
+    }
+    nd.pos = begin;
+    nd.length = end - begin;
+  }
+
+  /// Moves the given node to its next 1-fill.
+  void
+  next(node& nd) noexcept {
+    const auto out_end = nd.pos + nd.length;
+    switch (nd.k) {
+      case kind::leaf: {
+        leaf_its_[nd.leaf_idx].next();
+        fetch_leaf(nd);
+        return;
+      }
+      case kind::conjunction: {
+        // The inputs that end with the current 1-fill are forwarded; all the
+        // others extend beyond.
+        for (auto i = nd.children_begin; i < nd.children_end; ++i) {
+          auto& c = nodes_[children_[i]];
+          if (c.pos + c.length == out_end) next(c);
+        }
+        produce_and(nd, out_end);
+        return;
+      }
+      case kind::disjunction: {
+        for (auto i = nd.children_begin; i < nd.children_end; ++i) {
+          auto& c = nodes_[children_[i]];
+          if (c.length == 0 || c.pos >= out_end) continue;
+          if (c.pos + c.length == out_end) {
+            next(c);
+          }
+          else {
+            // The input has multiple 1-fills within the current output.
+            skip_to(c, out_end);
+          }
+        }
+        produce_or(nd);
+        return;
+      }
+    }
+  }
+
+  /// Moves the given node to the 1-fill that contains the given position or
+  /// to the first 1-fill after the given position.
+  void
+  skip_to(node& nd, u64 to_pos) noexcept {
+    if (nd.length == 0 || to_pos <= nd.pos) return;
+    if (to_pos < nd.pos + nd.length) {
+      // The destination is within the current 1-fill.
+      nd.length -= to_pos - nd.pos;
+      nd.pos = to_pos;
+      if (nd.k == kind::leaf) leaf_its_[nd.leaf_idx].skip_to(to_pos);
+      return;
+    }
+    switch (nd.k) {
+      case kind::leaf: {
+        leaf_its_[nd.leaf_idx].skip_to(to_pos);
+        fetch_leaf(nd);
+        return;
+      }
+      case kind::conjunction: {
+        produce_and(nd, to_pos);
+        return;
+      }
+      case kind::disjunction: {
+        for (auto i = nd.children_begin; i < nd.children_end; ++i) {
+          skip_to(nodes_[children_[i]], to_pos);
+        }
+        produce_or(nd);
+        return;
+      }
+    }
+  }
+
+  /// Positions the given node (and its inputs) at the first 1-fill.
+  void
+  init(node& nd) noexcept {
+    switch (nd.k) {
+      case kind::leaf:
+        fetch_leaf(nd);
+        return;
+      case kind::conjunction:
+        for (auto i = nd.children_begin; i < nd.children_end; ++i) {
+          init(nodes_[children_[i]]);
+        }
+        produce_and(nd, 0);
+        return;
+      case kind::disjunction:
+        for (auto i = nd.children_begin; i < nd.children_end; ++i) {
+          init(nodes_[children_[i]]);
+        }
+        produce_or(nd);
+        return;
+    }
+  }
+
+public:
+  explicit
+  bitwise_expr_iter(const expr_t& e) : n_(e.size()) {
+    leaf_its_.reserve(e.leaf_cnt());
+    compile(e);
+    init(nodes_.front());
+  }
+
+  bitwise_expr_iter(bitwise_expr_iter&&) = default;
+
+  /// Forwards the iterator to the next 1-fill (if any).
+  void __forceinline__
+  next() noexcept {
+    next(nodes_.front());
+  }
+
+  /// Forwards the iterator to the given position.
+  void __forceinline__
+  skip_to(const std::size_t to_pos) noexcept {
+    skip_to(nodes_.front(), to_pos);
+  }
+
+  /// Returns true if the iterator reached the end, false otherwise.
+  u1 __forceinline__
+  end() const noexcept {
+    return nodes_.front().length == 0;
+  }
+
+  /// Returns the starting position of the current 1-fill.
+  u64 __forceinline__
+  pos() const noexcept {
+    return nodes_.front().pos;
+  }
+
+  /// Returns the length of the current 1-fill.
+  u64 __forceinline__
+  length() const noexcept {
+    return nodes_.front().length;
+  }
+
+  /// Invokes the given function for each remaining 1-fill, i.e., the consumer
+  /// is fused with the evaluation loop. The function is called with the
+  /// position and the length of the 1-fill.
+  template<typename fn_t>
+  void __forceinline__
+  for_each(fn_t&& fn) noexcept {
+    auto& root = nodes_.front();
+    while (root.length != 0) {
+      fn(root.pos, root.length);
+      next(root);
+    }
+  }
+};
+//===----------------------------------------------------------------------===//
+/// Constructs a leaf node of a bitwise expression. (See bitwise_expr::leaf)
+template<typename bitmap_t>
+bitwise_expr<bitmap_t>
+bitwise_leaf_expr(const bitmap_t& bitmap, u64 cardinality_hint = 0) {
+  return bitwise_expr<bitmap_t>::leaf(bitmap, cardinality_hint);
+}
+//===----------------------------------------------------------------------===//
+/// Constructs the conjunction of the given bitwise expressions.
+template<typename bitmap_t>
+bitwise_expr<bitmap_t>
+bitwise_and_expr(bitwise_expr<bitmap_t> a, bitwise_expr<bitmap_t> b) {
+  return bitwise_expr<bitmap_t>::conjunction(std::move(a), std::move(b));
+}
+//===----------------------------------------------------------------------===//
+/// Constructs the disjunction of the given bitwise expressions.
+template<typename bitmap_t>
+bitwise_expr<bitmap_t>
+bitwise_or_expr(bitwise_expr<bitmap_t> a, bitwise_expr<bitmap_t> b) {
+  return bitwise_expr<bitmap_t>::disjunction(std::move(a), std::move(b));
+}
+//===----------------------------------------------------------------------===//
+/// Constructs a run iterator that evaluates the given bitwise expression.
+template<typename bitmap_t>
+bitwise_expr_iter<bitmap_t>
+bitwise_expr_it(const bitwise_expr<bitmap_t>& e) {
+  return bitwise_expr_iter<bitmap_t>(e);
+}
+//===----------------------------------------------------------------------===//
+/// Returns the number of 1-bits produced by the given bitwise expression.
+template<typename bitmap_t>
+$u64
+bitwise_count(const bitwise_expr<bitmap_t>& e) {
+  $u64 cnt = 0;
+  bitwise_expr_iter<bitmap_t>(e).for_each(
+      [&](u64 pos, u64 length) { cnt += length; });
+  return cnt;
+}
+//===----------------------------------------------------------------------===//
+/// Appends the positions of the 1-bits produced by the given bitwise
+/// expression to the given vector.
+template<typename bitmap_t>
+void
+bitwise_positions(const bitwise_expr<bitmap_t>& e, std::vector<$u32>& out) {
+  bitwise_expr_iter<bitmap_t>(e).for_each(
+      [&](u64 pos, u64 length) {
+        for (auto i = pos; i < pos + length; ++i) {
+          out.push_back(static_cast<$u32>(i));
+        }
+      });
+}
+//===----------------------------------------------------------------------===//
+/// Materializes the result of the given bitwise expression.
+template<typename bitmap_t>
+boost::dynamic_bitset<$u32>
+bitwise_to_bitset(const bitwise_expr<bitmap_t>& e) {
+  boost::dynamic_bitset<$u32> ret(e.size());
+  bitwise_expr_iter<bitmap_t>(e).for_each(
+      [&](u64 pos, u64 length) {
+        for (auto i = pos; i < pos + length; ++i) ret[i] = true;
+      });
+  return ret;
+}
+//===----------------------------------------------------------------------===//
+} // namespace dtl
@@ -2,7 +2,9 @@
 //===----------------------------------------------------------------------===//
 #include <dtl/dtl.hpp>
 
+#include <algorithm>
 #include <type_traits>
+#include <vector>
 //===----------------------------------------------------------------------===//
 namespace dtl {
 namespace internal { // TODO should be dtl::bitmap::internal
@@ -301,6 +303,49 @@ struct bitwise_xor_re {
   }
 };
 //===----------------------------------------------------------------------===//
+/// Computes a AND NOT b. The 1-fills of b are skipped over, thus the
+/// complement of b is never materialized.
+struct bitwise_and_not {
+  template<typename iter_ta, typename iter_tb>
+  static void __forceinline__
+  first(iter_ta& it_a, iter_tb& it_b, $u64& output_pos, $u64& output_length) {
+    while (!it_a.end()) {
+      const auto a_begin = it_a.pos();
+      const auto a_end = it_a.pos() + it_a.length();
+      // Skip the 1-fills of b that end before the current 1-fill of a.
+      if (!it_b.end() && it_b.pos() + it_b.length() <= a_begin) {
+        it_b.skip_to(a_begin);
+      }
+      if (it_b.end() || it_b.pos() >= a_end) {
+        // No overlap. Produce an output.
+        output_pos = a_begin;
+        output_length = a_end - a_begin;
+        return;
+      }
+      const auto b_begin = it_b.pos();
+      if (b_begin > a_begin) {
+        // Produce an output, which ends where the 1-fill of b begins.
+        output_pos = a_begin;
+        output_length = b_begin - a_begin;
+        return;
+      }
+      // The current 1-fill of b covers the beginning of the current 1-fill
+      // of a.
+      it_a.skip_to(b_begin + it_b.length());
+    }
+    output_pos = 0;
+    output_length = 0;
+  }
+
+  template<typename iter_ta, typename iter_tb>
+  static void __forceinline__
+  next(iter_ta& it_a, iter_tb& it_b, $u64& output_pos, $u64& output_length) {
+    // The current output is a prefix of the current 1-fill of a.
+    it_a.skip_to(output_pos + output_length);
+    first(it_a, it_b, output_pos, output_length);
+  }
+};
+//===----------------------------------------------------------------------===//
 /// Iterator template for bitwise operations.
 template<typename iter_ta, typename iter_tb, typename operation>
 class bitwise_iter {
@@ -337,7 +382,10 @@ public:
     // TODO remove condition check. - the problem here is, that internally, the iterators were already advanced
     if (to_pos > it_a_.pos()) it_a_.skip_to(to_pos);
     if (to_pos > it_b_.pos()) it_b_.skip_to(to_pos);
-    operation::next(it_a_, it_b_, pos_, length_);
+    // Note: The input iterators are not necessarily positioned past the
+    // current output (e.g., in case of an AND), thus, the next output is
+    // determined the same way as the very first one.
+    operation::first(it_a_, it_b_, pos_, length_);
   }
 
   /// Returns true if the iterator reached the end, false otherwise.
@@ -359,8 +407,327 @@ public:
   }
 };
 //===----------------------------------------------------------------------===//
+/// Iterator template for the disjunction of an arbitrary number of input
+/// iterators (of the same type). The input iterators are organized in a
+/// min-heap, ordered by the beginning of their current 1-fills.
+template<typename iter_t>
+class bitwise_or_kway_iter {
+  /// The input iterators.
+  std::vector<iter_t> its_;
+  /// Min-heap of (indexes of) the input iterators that did not reach the end.
+  std::vector<$u32> heap_;
+  /// The length of the bitmap.
+  $u64 n_;
+  /// Points to the beginning of the current 1-fill.
+  $u64 pos_ = 0;
+  /// The length of the current 1-fill.
+  $u64 length_ = 0;
+
+  /// Heap order.
+  struct greater {
+    const std::vector<iter_t>& its;
+    u1 __forceinline__
+    operator()(u32 a, u32 b) const noexcept {
+      return its[a].pos() > its[b].pos();
+    }
+  };
+
+  /// Rebuilds the heap from scratch.
+  void
+  init_heap() {
+    heap_.clear();
+    for (std::size_t i = 0; i < its_.size(); ++i) {
+      if (!its_[i].end()) heap_.push_back(static_cast<$u32>(i));
+    }
+    std::make_heap(heap_.begin(), heap_.end(), greater {its_});
+  }
+
+  /// Produces the next (merged) 1-fill.
+  void __forceinline__
+  produce() {
+    if (heap_.empty()) {
+      pos_ = n_;
+      length_ = 0;
+      return;
+    }
+    const auto cmp = greater {its_};
+    $u64 begin = its_[heap_.front()].pos();
+    $u64 end = begin;
+    // Consume all 1-fills that overlap or touch the current output.
+    while (!heap_.empty() && its_[heap_.front()].pos() <= end) {
+      std::pop_heap(heap_.begin(), heap_.end(), cmp);
+      auto& it = its_[heap_.back()];
+      end = std::max(end, it.pos() + it.length());
+      it.next();
+      if (it.end()) {
+        heap_.pop_back();
+      }
+      else {
+        std::push_heap(heap_.begin(), heap_.end(), cmp);
+      }
+    }
+    pos_ = begin;
+    length_ = end - begin;
+  }
+
+public:
+  bitwise_or_kway_iter(std::vector<iter_t>&& its, u64 n)
+      : its_(std::move(its)), n_(n) {
+    heap_.reserve(its_.size());
+    init_heap();
+    produce();
+  }
+
+  bitwise_or_kway_iter(bitwise_or_kway_iter&&) = default;
+
+  void __forceinline__
+  next() noexcept {
+    produce();
+  }
+
+  void __forceinline__
+  skip_to(const std::size_t to_pos) noexcept {
+    if (to_pos < (pos_ + length_)) {
+      length_ -= to_pos - pos_;
+      pos_ = to_pos;
+      return;
+    }
+    for (auto idx : heap_) {
+      auto& it = its_[idx];
+      if (it.pos() < to_pos) it.skip_to(to_pos);
+    }
+    init_heap();
+    produce();
+  }
+
+  /// Returns true if the iterator reached the end, false otherwise.
+  u1 __forceinline__
+  end() const noexcept {
+    return length_ == 0;
+  }
+
+  /// Returns the starting position of the current 1-fill.
+  u64 __forceinline__
+  pos() const noexcept {
+    return pos_;
+  }
+
+  /// Returns the length of the current 1-fill.
+  u64 __forceinline__
+  length() const noexcept {
+    return length_;
+  }
+};
+//===----------------------------------------------------------------------===//
+/// Iterator template for the complement of a run iterator, i.e., the iterator
+/// produces the 0-fills of the input iterator within [0, n).
+template<typename iter_t>
+class not_iter {
+  /// The input iterator.
+  iter_t it_;
+  /// The length of the bitmap.
+  $u64 n_;
+  /// Points to the beginning of the current 0-fill.
+  $u64 pos_ = 0;
+  /// The length of the current 0-fill.
+  $u64 length_ = 0;
+
+  /// Returns the beginning of the current 1-fill of the input iterator, or n
+  /// if the input iterator reached the end.
+  u64 __forceinline__
+  input_pos() const noexcept {
+    return it_.end() ? n_ : std::min($u64(it_.pos()), n_);
+  }
+
+  /// Produces the 0-fill that follows the current 1-fill of the input
+  /// iterator.
+  void __forceinline__
+  advance() noexcept {
+    while (!it_.end()) {
+      const $u64 begin = it_.pos() + it_.length();
+      it_.next();
+      const auto end = input_pos();
+      if (begin < end) {
+        pos_ = begin;
+        length_ = end - begin;
+        return;
+      }
+    }
+    pos_ = n_;
+    length_ = 0;
+  }
+
+public:
+  not_iter(iter_t&& it, u64 n) : it_(std::move(it)), n_(n) {
+    const auto end = input_pos();
+    if (end > 0) {
+      pos_ = 0;
+      length_ = end;
+    }
+    else {
+      advance();
+    }
+  }
+
+  __forceinline__
+  not_iter(not_iter&&) = default;
+
+  void __forceinline__
+  next() noexcept {
+    advance();
+  }
+
+  void __forceinline__
+  skip_to(const std::size_t to_pos) noexcept {
+    if (to_pos < (pos_ + length_)) {
+      length_ -= to_pos - pos_;
+      pos_ = to_pos;
+      return;
+    }
+    if (to_pos >= n_) {
+      pos_ = n_;
+      length_ = 0;
+      return;
+    }
+    if (!it_.end() && to_pos > it_.pos()) it_.skip_to(to_pos);
+    if (!it_.end() && it_.pos() <= to_pos) {
+      // The desired position is covered by a 1-fill of the input iterator.
+      advance();
+      return;
+    }
+    pos_ = to_pos;
+    length_ = input_pos() - to_pos;
+  }
+
+  /// Returns true if the iterator reached the end, false otherwise.
+  u1 __forceinline__
+  end() const noexcept {
+    return length_ == 0;
+  }
+
+  /// Returns the starting position of the current 0-fill.
+  u64 __forceinline__
+  pos() const noexcept {
+    return pos_;
+  }
+
+  /// Returns the length of the current 0-fill.
+  u64 __forceinline__
+  length() const noexcept {
+    return length_;
+  }
+};
+//===----------------------------------------------------------------------===//
+/// The mirror point that is used to map reverse iterators to forward
+/// iterators and vice versa. The position p is mapped to position
+/// (mirror_pos - 1 - p).
+static constexpr u64 mirror_pos = 1ull << 62;
+//===----------------------------------------------------------------------===//
+/// Adapter that turns a reverse run iterator into a forward run iterator, by
+/// mirroring the positions at mirror_pos. This way, the reverse iterators can
+/// be used as inputs for the bitwise operations above.
+template<typename rev_iter_t>
+class forward_view {
+  /// The reverse iterator.
+  rev_iter_t it_;
+
+public:
+  explicit forward_view(rev_iter_t&& it) : it_(std::move(it)) {}
+
+  __forceinline__
+  forward_view(forward_view&&) = default;
+
+  void __forceinline__
+  next() noexcept {
+    it_.prev();
+  }
+
+  void __forceinline__
+  skip_to(const std::size_t to_pos) noexcept {
+    if (to_pos < mirror_pos) {
+      it_.skip_back_to(mirror_pos - 1 - to_pos);
+      return;
+    }
+    while (!it_.end()) it_.prev();
+  }
+
+  /// Returns true if the iterator reached the end, false otherwise.
+  u1 __forceinline__
+  end() const noexcept {
+    return it_.end();
+  }
+
+  /// Returns the starting position of the current (mirrored) 1-fill.
+  u64 __forceinline__
+  pos() const noexcept {
+    return it_.end() ? mirror_pos : mirror_pos - (it_.pos() + it_.length());
+  }
+
+  /// Returns the length of the current 1-fill.
+  u64 __forceinline__
+  length() const noexcept {
+    return it_.length();
+  }
+};
+//===----------------------------------------------------------------------===//
+/// Adapter that turns a forward run iterator that operates on mirrored
+/// positions (see forward_view) back into a reverse run iterator. The 1-fills
+/// are produced in descending order. If the iterator reached the end, pos()
+/// returns 0.
+template<typename iter_t>
+class reverse_view {
+  /// The (mirrored) forward iterator.
+  iter_t it_;
+
+public:
+  explicit reverse_view(iter_t&& it) : it_(std::move(it)) {}
+
+  __forceinline__
+  reverse_view(reverse_view&&) = default;
+
+  void __forceinline__
+  prev() noexcept {
+    it_.next();
+  }
+
+  void __forceinline__
+  skip_back_to(const std::size_t to_pos) noexcept {
+    if (it_.end() || to_pos >= mirror_pos) return;
+    const auto mirrored_to_pos = mirror_pos - 1 - to_pos;
+    if (mirrored_to_pos <= it_.pos()) return;
+    it_.skip_to(mirrored_to_pos);
+  }
+
+  /// Returns true if the iterator reached the end, false otherwise.
+  u1 __forceinline__
+  end() const noexcept {
+    return it_.end();
+  }
+
+  /// Returns the starting position of the current 1-fill.
+  u64 __forceinline__
+  pos() const noexcept {
+    return it_.end() ? 0 : mirror_pos - (it_.pos() + it_.length());
+  }
+
+  /// Returns the length of the current 1-fill.
+  u64 __forceinline__
+  length() const noexcept {
+    return it_.length();
+  }
+};
+//===----------------------------------------------------------------------===//
 } // namespace internal
 //===----------------------------------------------------------------------===//
+/// Constructs a run iterator that represents the logical disjunction of an
+/// arbitrary number of input iterators. The parameter n refers to the length
+/// of the bitmaps.
+template<typename iter_t>
+auto __forceinline__
+bitwise_or_kway_it(std::vector<iter_t>&& its, u64 n) {
+  return internal::bitwise_or_kway_iter<iter_t>(std::move(its), n);
+};
+//===----------------------------------------------------------------------===//
 /// Constructs a run iterator that represents the logical conjunction of the
 /// given input iterators.
 template<typename iter_ta, typename iter_tb>
@@ -379,6 +746,23 @@ bitwise_or_it(iter_ta&& it_a, iter_tb&& it_b) {
       std::forward<iter_ta>(it_a), std::forward<iter_tb>(it_b));
 };
 //===----------------------------------------------------------------------===//
+/// Constructs a run iterator that represents the logical conjunction of the
+/// first input iterator and the negation of the second one (a AND NOT b).
+template<typename iter_ta, typename iter_tb>
+auto __forceinline__
+bitwise_and_not_it(iter_ta&& it_a, iter_tb&& it_b) {
+  return internal::bitwise_iter<iter_ta, iter_tb, internal::bitwise_and_not>(
+      std::forward<iter_ta>(it_a), std::forward<iter_tb>(it_b));
+};
+//===----------------------------------------------------------------------===//
+/// Constructs a run iterator that represents the negation of the given input
+/// iterator. The parameter n refers to the length of the bitmap.
+template<typename iter_t>
+auto __forceinline__
+not_it(iter_t&& it, u64 n) {
+  return internal::not_iter<iter_t>(std::forward<iter_t>(it), n);
+};
+//===----------------------------------------------------------------------===//
 /// Constructs a run iterator that represents the logical exclusive
 /// disjunction of the given input iterators.
 template<typename iter_ta, typename iter_tb>
@@ -398,4 +782,40 @@ bitwise_xor_re_it(iter_ta&& it_a, iter_tb&& it_b) {
       std::forward<iter_ta>(it_a), std::forward<iter_tb>(it_b));
 };
 //===----------------------------------------------------------------------===//
+/// Constructs a reverse run iterator that represents the logical conjunction
+/// of the given reverse input iterators. The 1-fills are produced in
+/// descending order.
+template<typename rev_iter_ta, typename rev_iter_tb>
+auto __forceinline__
+bitwise_and_rit(rev_iter_ta&& it_a, rev_iter_tb&& it_b) {
+  auto it = bitwise_and_it(
+      internal::forward_view<rev_iter_ta>(std::forward<rev_iter_ta>(it_a)),
+      internal::forward_view<rev_iter_tb>(std::forward<rev_iter_tb>(it_b)));
+  return internal::reverse_view<decltype(it)>(std::move(it));
+};
+//===----------------------------------------------------------------------===//
+/// Constructs a reverse run iterator that represents the logical disjunction
+/// of the given reverse input iterators. The 1-fills are produced in
+/// descending order.
+template<typename rev_iter_ta, typename rev_iter_tb>
+auto __forceinline__
+bitwise_or_rit(rev_iter_ta&& it_a, rev_iter_tb&& it_b) {
+  auto it = bitwise_or_it(
+      internal::forward_view<rev_iter_ta>(std::forward<rev_iter_ta>(it_a)),
+      internal::forward_view<rev_iter_tb>(std::forward<rev_iter_tb>(it_b)));
+  return internal::reverse_view<decltype(it)>(std::move(it));
+};
+//===----------------------------------------------------------------------===//
+/// Constructs a reverse run iterator that represents the logical exclusive
+/// disjunction of the given reverse input iterators. The 1-fills are produced
+/// in descending order.
+template<typename rev_iter_ta, typename rev_iter_tb>
+auto __forceinline__
+bitwise_xor_rit(rev_iter_ta&& it_a, rev_iter_tb&& it_b) {
+  auto it = bitwise_xor_it(
+      internal::forward_view<rev_iter_ta>(std::forward<rev_iter_ta>(it_a)),
+      internal::forward_view<rev_iter_tb>(std::forward<rev_iter_tb>(it_b)));
+  return internal::reverse_view<decltype(it)>(std::move(it));
+};
+//===----------------------------------------------------------------------===//
 } // namespace dtl
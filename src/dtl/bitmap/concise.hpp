@@ -6,6 +6,7 @@
 
 #include <boost/dynamic_bitset.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <type_traits>
 #include <vector>
@@ -199,7 +200,7 @@ protected:
     }
 
     if ((last_word_is_all_zeros && prev_word_is_one_fill)
-        && (last_word_is_all_ones && prev_word_is_zero_fill)) {
+        || (last_word_is_all_ones && prev_word_is_zero_fill)) {
       return;
     }
 
@@ -256,7 +257,8 @@ protected:
       const auto zero_block_cnt = (bit_pos / payload_bit_cnt) - 1;
       if (zero_block_cnt > 0) {
         // Append a 0-fill.
-        if (contains_single_bit(data_.back())) {
+        if (is_literal_word(data_.back())
+            && contains_single_bit(data_.back())) {
           // Convert the last word into a fill word that piggybacks that bit.
           const auto dirty_bit_pos = dtl::bits::tz_count(
               extract_payload(data_.back()));
@@ -389,8 +391,28 @@ public:
   /// Returns the value of the bit at the position pos.
   u1 __forceinline__
   test(const std::size_t pos) const {
-    std::size_t i = 0;
-    std::size_t word_idx = 0;
+    return test(pos, 0, 0);
+  }
+
+  /// Try to reduce the memory consumption. This function is supposed to be
+  /// called after the bitmap has been modified.
+  __forceinline__ void
+  shrink() {
+    data_.shrink_to_fit();
+  }
+
+protected:
+  /// A sampled position within the encoded bitmap. The word at index word_idx
+  /// starts at bit position bit_pos.
+  struct skip_offset_t {
+    $u32 bit_pos;
+    $u32 word_idx;
+  };
+
+  /// Returns the value of the bit at the position pos. The search starts at
+  /// the given word, which begins at bit position i.
+  u1 __forceinline__
+  test(const std::size_t pos, std::size_t word_idx, std::size_t i) const {
     // Find the corresponding word.
     for (; word_idx < data_.size(); ++word_idx) {
       auto& w = data_[word_idx];
@@ -411,9 +433,10 @@ public:
         }
         else {
           $u1 val = extract_fill_value(w);
+          // The dirty bit (if any) is located in the first block of the fill.
           if (has_dirty_bit_position(w)
-              && (pos % payload_bit_cnt == extract_dirty_bit_position(w))) {
-              val = !val;
+              && (pos - i == extract_dirty_bit_position(w))) {
+            val = !val;
           }
           return val;
         }
@@ -422,17 +445,13 @@ public:
     return false;
   }
 
-  /// Try to reduce the memory consumption. This function is supposed to be
-  /// called after the bitmap has been modified.
-  __forceinline__ void
-  shrink() {
-    data_.shrink_to_fit();
-  }
-
+public:
   //===--------------------------------------------------------------------===//
   /// 1-run iterator
   class iter {
     const concise& outer_;
+    /// Optional skip offsets (sorted by bit position).
+    const std::vector<skip_offset_t>* skip_offsets_;
 
     std::size_t word_idx_;
     std::size_t in_word_idx_;
@@ -537,8 +556,10 @@ public:
 
   public:
     explicit __forceinline__
-    iter(const concise& outer)
+    iter(const concise& outer,
+        const std::vector<skip_offset_t>* skip_offsets = nullptr)
         : outer_(outer),
+          skip_offsets_(skip_offsets),
           word_idx_(0),
           in_word_idx_(0),
           pos_(0), length_(0) {
@@ -562,6 +583,26 @@ public:
         length_ = 0;
         return;
       }
+      // Use the skip offsets (if any) to jump to the last sampled word that
+      // starts at or before the desired position.
+      if (skip_offsets_ != nullptr && to_pos > pos_ + length_) {
+        const auto& offsets = *skip_offsets_;
+        auto search = std::upper_bound(offsets.begin(), offsets.end(), to_pos,
+            [](const std::size_t lhs, const skip_offset_t& rhs) {
+              return lhs < rhs.bit_pos;
+            });
+        if (search != offsets.begin()) {
+          --search;
+          // The sampled word needs to start after the current run.
+          if (search->bit_pos > pos_ + length_) {
+            word_idx_ = search->word_idx;
+            in_word_idx_ = 0;
+            pos_ = search->bit_pos;
+            length_ = 0;
+            increment();
+          }
+        }
+      }
       // Call next until the desired position has been reached.
       while (!end() && pos() + length() <= to_pos) {
         next();
@@ -589,9 +630,171 @@ public:
     }
   };
   //===--------------------------------------------------------------------===//
+  /// Reverse 1-run iterator. Produces the 1-runs in descending order. The
+  /// code words are self-describing, thus the bitmap is decoded backwards
+  /// starting at the last word.
+  class riter {
+    const concise& outer_;
+
+    /// The number of words that have not been loaded yet. The current word
+    /// is the one at index word_idx_.
+    std::size_t word_idx_;
+    /// The bit position where the current word starts.
+    $u64 word_begin_;
+    /// The number of (leading) bits of the current word, that have not been
+    /// consumed yet.
+    std::size_t in_word_idx_;
+
+    //===------------------------------------------------------------------===//
+    // Iterator state
+    //===------------------------------------------------------------------===//
+    /// Points to the beginning of a 1-run.
+    $u64 pos_;
+    /// The length of the current 1-run.
+    $u64 length_;
+    //===------------------------------------------------------------------===//
+
+    /// Returns the number of bits encoded in the given word.
+    static std::size_t __forceinline__
+    word_bit_cnt(const word_type w) {
+      return is_fill_word(w)
+          ? (extract_fill_repetitions(w) + 1) * payload_bit_cnt
+          : payload_bit_cnt;
+    }
+
+    /// Loads the preceding word. Returns false, if there is none.
+    u1 __forceinline__
+    load_prev_word() {
+      if (word_idx_ == 0) return false;
+      --word_idx_;
+      in_word_idx_ = word_bit_cnt(outer_.data_[word_idx_]);
+      word_begin_ -= in_word_idx_;
+      return true;
+    }
+
+  public:
+    explicit __forceinline__
+    riter(const concise& outer)
+        : outer_(outer),
+          word_idx_(outer.data_.size()),
+          word_begin_(0),
+          in_word_idx_(0),
+          pos_(outer.encoded_bitmap_length_), length_(0) {
+      // Trailing 0-bits are not necessarily encoded. Thus, we determine the
+      // end of the last word by summing up the word lengths.
+      for (auto w : outer_.data_) {
+        word_begin_ += word_bit_cnt(w);
+      }
+      prev();
+    }
+
+    /// Move the iterator to the preceding 1-run.
+    void __forceinline__
+    prev() {
+      while (in_word_idx_ > 0 || load_prev_word()) {
+        if (in_word_idx_ == 0) continue;
+        const word_type w = outer_.data_[word_idx_];
+        if (is_fill_word(w)) {
+          const u1 fill_val = extract_fill_value(w);
+          if (!has_dirty_bit_position(w)) {
+            if (fill_val) {
+              pos_ = word_begin_;
+              length_ = in_word_idx_;
+              in_word_idx_ = 0;
+              return;
+            }
+          }
+          else {
+            // The dirty bit is located in the first block of the fill.
+            const std::size_t d = extract_dirty_bit_position(w);
+            if (!fill_val) { // 000001000000
+              if (in_word_idx_ > d) {
+                pos_ = word_begin_ + d;
+                length_ = 1;
+                in_word_idx_ = d;
+                return;
+              }
+            }
+            else { // 11111011111
+              if (in_word_idx_ > d + 1) {
+                pos_ = word_begin_ + d + 1;
+                length_ = in_word_idx_ - (d + 1);
+                in_word_idx_ = d + 1;
+                return;
+              }
+              const std::size_t e = std::min(in_word_idx_, d);
+              if (e > 0) {
+                pos_ = word_begin_;
+                length_ = e;
+                in_word_idx_ = 0;
+                return;
+              }
+            }
+          }
+        }
+        else {
+          const $u64 payload = ($u64(w) >> 1)
+              & ((1ull << in_word_idx_) - 1);
+          if (payload != 0) {
+            const std::size_t e = 64 - dtl::bits::lz_count(payload);
+            const $u64 zeros = ~payload & ((1ull << e) - 1);
+            const std::size_t b =
+                zeros == 0 ? 0 : 64 - dtl::bits::lz_count(zeros);
+            pos_ = word_begin_ + b;
+            length_ = e - b;
+            in_word_idx_ = b;
+            return;
+          }
+        }
+        in_word_idx_ = 0;
+      }
+      pos_ = outer_.encoded_bitmap_length_;
+      length_ = 0;
+    }
+
+    /// Move the iterator backwards to the desired position. Afterwards, the
+    /// current 1-run ends at or before the given position (inclusive).
+    void __forceinline__
+    skip_back_to(const std::size_t to_pos) {
+      if (end() || to_pos + 1 >= pos_ + length_) {
+        return;
+      }
+      if (to_pos >= pos_) {
+        length_ = to_pos + 1 - pos_;
+        return;
+      }
+      // Skip over the words that start after the desired position.
+      while (word_begin_ > to_pos) {
+        if (!load_prev_word()) {
+          pos_ = outer_.encoded_bitmap_length_;
+          length_ = 0;
+          return;
+        }
+      }
+      in_word_idx_ = std::min(in_word_idx_, to_pos + 1 - word_begin_);
+      prev();
+    }
+
+    u1 __forceinline__
+    end() const noexcept {
+      return length_ == 0;
+    }
+
+    u64 __forceinline__
+    pos() const noexcept {
+      return pos_;
+    }
+
+    u64 __forceinline__
+    length() const noexcept {
+      return length_;
+    }
+  };
+  //===--------------------------------------------------------------------===//
 
   using skip_iter_type = iter;
   using scan_iter_type = iter;
+  using rev_iter_type = riter;
 
   /// Returns a 1-run iterator.
   skip_iter_type __forceinline__
@@ -605,6 +808,12 @@ public:
     return scan_iter_type(*this);
   }
 
+  /// Returns a reverse 1-run iterator.
+  rev_iter_type __forceinline__
+  rit() const {
+    return rev_iter_type(*this);
+  }
+
   /// Returns the name of the instance including the most important parameters
   /// in JSON.
   std::string
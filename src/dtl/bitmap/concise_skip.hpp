@@ -0,0 +1,126 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include "concise.hpp"
+
+#include <dtl/dtl.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+//===----------------------------------------------------------------------===//
+namespace dtl {
+//===----------------------------------------------------------------------===//
+/// CONCISE -- a variant of WAH that improves compression by dealing with dirty
+/// bits. This implementation maintains a small index that allows for faster
+/// skips.
+template<std::size_t _skip_distance = 1024>
+class concise_skip : public concise {
+  using super = concise;
+
+  /// The sampled (bit position, word index) pairs. An offset is recorded for
+  /// every _skip_distance-th word.
+  std::vector<skip_offset_t> offsets_;
+
+  /// Initialize the skip offsets.
+  void
+  init_skip_offsets() {
+    const auto word_cnt = this->data_.size();
+    offsets_.reserve((word_cnt + (_skip_distance - 1)) / _skip_distance);
+
+    std::size_t i = 0;
+    for (std::size_t word_idx = 0; word_idx < word_cnt; ++word_idx) {
+      if (word_idx % _skip_distance == 0) {
+        offsets_.push_back(skip_offset_t {
+            static_cast<$u32>(i), static_cast<$u32>(word_idx)});
+      }
+      const auto w = this->data_[word_idx];
+      i += is_fill_word(w)
+          ? (extract_fill_repetitions(w) + 1) * payload_bit_cnt
+          : payload_bit_cnt;
+    }
+
+    if (offsets_.empty()) {
+      offsets_.push_back(skip_offset_t { 0, 0 });
+    }
+  }
+
+public:
+  concise_skip() = default;
+
+  explicit concise_skip(const boost::dynamic_bitset<$u32>& in)
+      : super(in), offsets_() {
+    init_skip_offsets();
+    shrink();
+  }
+
+  ~concise_skip() = default;
+  concise_skip(const concise_skip& other) = default;
+  concise_skip(concise_skip&& other) noexcept = default;
+  concise_skip& operator=(const concise_skip& other) = default;
+  concise_skip& operator=(concise_skip&& other) noexcept = default;
+
+  /// Return the size in bytes.
+  std::size_t __forceinline__
+  size_in_bytes() const {
+    return super::size_in_bytes()
+        + offsets_.size() * sizeof(skip_offset_t);
+  }
+
+  static std::string
+  name() {
+    return "concise_skip" + std::to_string(word_bitlength);
+  }
+
+  /// Returns the value of the bit at the position pos.
+  u1 __forceinline__
+  test(const std::size_t pos) const {
+    auto search = std::upper_bound(offsets_.begin(), offsets_.end(), pos,
+        [](const std::size_t lhs, const skip_offset_t& rhs) {
+          return lhs < rhs.bit_pos;
+        });
+    const auto& offset = *(search - 1);
+    return super::test(pos, offset.word_idx, offset.bit_pos);
+  }
+
+  /// Try to reduce the memory consumption. This function is supposed to be
+  /// called after the bitmap has been modified.
+  __forceinline__ void
+  shrink() {
+    super::shrink();
+    offsets_.shrink_to_fit();
+  }
+
+  using skip_iter_type = iter;
+  using scan_iter_type = iter;
+
+  /// Returns a 1-run iterator.
+  skip_iter_type __forceinline__
+  it() const {
+    return skip_iter_type(*this, &offsets_);
+  }
+
+  /// Returns a 1-run iterator. (The skip offsets are not required for
+  /// scans.)
+  scan_iter_type __forceinline__
+  scan_it() const {
+    return scan_iter_type(*this);
+  }
+
+  /// Returns the name of the instance including the most important parameters
+  /// in JSON.
+  std::string
+  info() const {
+    return "{\"name\":\"" + name() + "\""
+        + ",\"n\":" + std::to_string(encoded_bitmap_length_)
+        + ",\"size\":" + std::to_string(size_in_bytes())
+        + ",\"word_size\":" + std::to_string(sizeof(word_type))
+        + ",\"skip_distance\":" + std::to_string(_skip_distance)
+        + ",\"skip_offsets_size\":"
+        + std::to_string(offsets_.size() * sizeof(skip_offset_t))
+        + "}";
+  }
+};
+//===----------------------------------------------------------------------===//
+} // namespace dtl
@@ -0,0 +1,419 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include <dtl/bits.hpp>
+#include <dtl/dtl.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <immintrin.h>
+//===----------------------------------------------------------------------===//
+namespace dtl {
+//===----------------------------------------------------------------------===//
+/// Delta encoded position list, where the deltas are bit-packed in blocks of
+/// 128 values (SIMD-BP128).
+///
+/// The deltas are stored as gaps, i.e., d_i = p_i - p_{i-1} - 1, thus a dense
+/// 1-run results in a sequence of zeros. The gaps of a block are packed using
+/// the minimum bit-width required by the largest gap in that block. The
+/// values are interleaved such that four consecutive values are packed and
+/// unpacked at once using SSE instructions. The decoding (including the
+/// prefix sum) is fully vectorized.
+///
+/// The largest position of each block is stored separately, which allows to
+/// skip entire blocks without decoding them.
+class delta_bp128 {
+  /// The number of positions per block.
+  static constexpr std::size_t block_size = 128;
+  /// The number of 32-bit values processed at once.
+  static constexpr std::size_t lane_cnt = 4;
+
+  /// The packed gaps.
+  std::vector<$u32> data_;
+  /// The largest position within each block.
+  std::vector<$u32> block_last_;
+  /// The offset of each block within data_. Contains an additional entry
+  /// that refers to the end of the data. The bit-width of a block is
+  /// implicitly given by the number of words it occupies.
+  std::vector<$u32> block_offset_;
+  /// The length of the encoded bitmap.
+  $u64 n_ = 0;
+  /// The number of encoded positions.
+  $u64 m_ = 0;
+
+  /// Packs 128 values using b bits each.
+  static void
+  pack(const $u32* in, $u32* out, const std::size_t b) {
+    if (b == 0) return;
+    __m128i acc = _mm_setzero_si128();
+    std::size_t shift = 0;
+    for (std::size_t r = 0; r < block_size / lane_cnt; ++r) {
+      const __m128i v = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(in + r * lane_cnt));
+      acc = _mm_or_si128(acc, _mm_sll_epi32(v, _mm_cvtsi32_si128(shift)));
+      shift += b;
+      if (shift >= 32) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), acc);
+        out += lane_cnt;
+        shift -= 32;
+        acc = shift > 0
+            ? _mm_srl_epi32(v, _mm_cvtsi32_si128(b - shift))
+            : _mm_setzero_si128();
+      }
+    }
+    assert(shift == 0);
+  }
+
+  /// Unpacks 128 values with b bits each and computes the prefix sum of the
+  /// gaps. The first position is derived from the given base, which refers
+  /// to the last position of the preceding block (or -1, if there is none).
+  static void
+  unpack(const $u32* in, $u32* out, const std::size_t b, const $u32 base) {
+    const __m128i one = _mm_set1_epi32(1);
+    __m128i carry = _mm_set1_epi32(static_cast<$i32>(base));
+    if (b == 0) {
+      const __m128i inc = _mm_setr_epi32(1, 2, 3, 4);
+      const __m128i step = _mm_set1_epi32(static_cast<$i32>(lane_cnt));
+      __m128i v = _mm_add_epi32(carry, inc);
+      for (std::size_t r = 0; r < block_size / lane_cnt; ++r) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + r * lane_cnt), v);
+        v = _mm_add_epi32(v, step);
+      }
+      return;
+    }
+    const __m128i mask = _mm_set1_epi32(
+        static_cast<$i32>(b == 32 ? ~$u32(0) : ($u32(1) << b) - 1));
+    __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    std::size_t shift = 0;
+    for (std::size_t r = 0; r < block_size / lane_cnt; ++r) {
+      __m128i v = _mm_srl_epi32(w, _mm_cvtsi32_si128(shift));
+      if (shift + b > 32) {
+        in += lane_cnt;
+        w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        v = _mm_or_si128(v, _mm_sll_epi32(w, _mm_cvtsi32_si128(32 - shift)));
+      }
+      shift += b;
+      if (shift >= 32) {
+        shift -= 32;
+        if (shift == 0 && r + 1 < block_size / lane_cnt) {
+          in += lane_cnt;
+          w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        }
+      }
+      // Restore the positions from the gaps (prefix sum).
+      v = _mm_add_epi32(_mm_and_si128(v, mask), one);
+      v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+      v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+      v = _mm_add_epi32(v, carry);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + r * lane_cnt), v);
+      carry = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+  }
+
+  /// Returns the number of positions in the given block.
+  std::size_t __forceinline__
+  block_cnt(const std::size_t block_idx) const {
+    return std::min(block_size, m_ - block_idx * block_size);
+  }
+
+  /// Decodes the given block.
+  void __forceinline__
+  decode_block(const std::size_t block_idx, $u32* out) const {
+    const auto begin = block_offset_[block_idx];
+    const auto b = (block_offset_[block_idx + 1] - begin) / lane_cnt;
+    const $u32 base = block_idx == 0 ? ~$u32(0) : block_last_[block_idx - 1];
+    unpack(&data_[begin], out, b, base);
+  }
+
+  /// Encodes the given (sorted) positions.
+  void
+  encode(const $u32* positions, const std::size_t cnt) {
+    assert(n_ <= (1ull << 32));
+    m_ = cnt;
+    const std::size_t block_cnt = (m_ + block_size - 1) / block_size;
+    block_last_.reserve(block_cnt);
+    block_offset_.reserve(block_cnt + 1);
+    block_offset_.push_back(0);
+
+    $u32 gaps[block_size];
+    $u32 prev = ~$u32(0);
+    for (std::size_t block_idx = 0; block_idx < block_cnt; ++block_idx) {
+      const std::size_t begin = block_idx * block_size;
+      const std::size_t end = std::min(begin + block_size, m_);
+      $u32 acc = 0;
+      for (std::size_t i = begin; i < end; ++i) {
+        assert(positions[i] < n_);
+        assert(i == 0 || positions[i - 1] < positions[i]);
+        const $u32 gap = positions[i] - prev - 1;
+        gaps[i - begin] = gap;
+        acc |= gap;
+        prev = positions[i];
+      }
+      // Pad the last block with zeros.
+      std::fill(gaps + (end - begin), gaps + block_size, 0u);
+      const std::size_t b = acc == 0 ? 0 : 32 - dtl::bits::lz_count(acc);
+      const std::size_t offset = data_.size();
+      data_.resize(offset + b * lane_cnt);
+      pack(gaps, data_.data() + offset, b);
+      block_last_.push_back(prev);
+      block_offset_.push_back(static_cast<$u32>(data_.size()));
+    }
+  }
+
+public:
+  delta_bp128() = default;
+
+  explicit delta_bp128(const boost::dynamic_bitset<$u32>& in) : n_(in.size()) {
+    std::vector<$u32> positions;
+    std::size_t current_pos = in.find_first();
+    while (current_pos < in.size()) {
+      positions.push_back(static_cast<$u32>(current_pos));
+      current_pos = in.find_next(current_pos);
+    }
+    encode(positions.data(), positions.size());
+    shrink();
+  }
+
+  /// Constructs a bitmap of length n from the given (sorted) positions of the
+  /// 1-bits, without using a plain bitmap as intermediate.
+  delta_bp128(const $u32* positions, std::size_t cnt, std::size_t n) : n_(n) {
+    encode(positions, cnt);
+    shrink();
+  }
+
+  ~delta_bp128() = default;
+  delta_bp128(const delta_bp128& other) = default;
+  delta_bp128(delta_bp128&& other) noexcept = default;
+  delta_bp128& operator=(const delta_bp128& other) = default;
+  delta_bp128& operator=(delta_bp128&& other) noexcept = default;
+
+  /// Return the size in bytes.
+  std::size_t __forceinline__
+  size_in_bytes() const {
+    return data_.size() * sizeof($u32) /* packed gaps */
+        + block_last_.size() * sizeof($u32) /* skip information */
+        + block_offset_.size() * sizeof($u32) /* block offsets */
+        + sizeof(n_) /* bit-length of the original bitmap */
+        + sizeof(m_); /* number of positions */
+  }
+
+  /// Returns the size of the bitmap.
+  std::size_t __forceinline__
+  size() const {
+    return n_;
+  }
+
+  static std::string
+  name() {
+    return "delta_bp128";
+  }
+
+  /// Returns the value of the bit at the position pos.
+  u1 __forceinline__
+  test(const std::size_t pos) const {
+    if (pos >= n_) return false;
+    const auto search =
+        std::lower_bound(block_last_.begin(), block_last_.end(), pos);
+    if (search == block_last_.end()) return false;
+    const std::size_t block_idx = search - block_last_.begin();
+    alignas(16) $u32 buf[block_size];
+    decode_block(block_idx, buf);
+    const auto cnt = block_cnt(block_idx);
+    return std::binary_search(buf, buf + cnt, static_cast<$u32>(pos));
+  }
+
+  /// Try to reduce the memory consumption. This function is supposed to be
+  /// called after the bitmap has been modified.
+  __forceinline__ void
+  shrink() {
+    data_.shrink_to_fit();
+    block_last_.shrink_to_fit();
+    block_offset_.shrink_to_fit();
+  }
+
+  //===--------------------------------------------------------------------===//
+  /// 1-run iterator. Consecutive positions are merged into runs, which may
+  /// span multiple blocks.
+  class iter {
+    const delta_bp128& outer_;
+
+    /// The decoded positions of the current block.
+    alignas(16) $u32 buf_[block_size];
+    /// The index of the current block.
+    $u64 block_idx_;
+    /// The index of the next position within the current block.
+    $u64 buf_idx_;
+    /// The number of positions within the current block.
+    $u64 buf_cnt_;
+    /// The next (already decoded) position, that is not part of the current
+    /// run. Refers to n, if there is none.
+    $u64 next_;
+
+    //===------------------------------------------------------------------===//
+    // Iterator state
+    //===------------------------------------------------------------------===//
+    /// Points to the beginning of a 1-run.
+    $u64 pos_;
+    /// The length of the current 1-run.
+    $u64 length_;
+    //===------------------------------------------------------------------===//
+
+    /// Decodes the given block and points to its first position.
+    void __forceinline__
+    load_block(const std::size_t block_idx) {
+      block_idx_ = block_idx;
+      outer_.decode_block(block_idx, buf_);
+      buf_idx_ = 0;
+      buf_cnt_ = outer_.block_cnt(block_idx);
+    }
+
+    /// Fetches the next position.
+    void __forceinline__
+    fetch() {
+      if (buf_idx_ == buf_cnt_) {
+        if (block_idx_ + 1 >= outer_.block_last_.size()) {
+          next_ = outer_.n_;
+          return;
+        }
+        load_block(block_idx_ + 1);
+      }
+      next_ = buf_[buf_idx_++];
+    }
+
+    /// Forms the next 1-run, starting with the lookahead position.
+    void __forceinline__
+    produce_run() {
+      pos_ = next_;
+      length_ = 0;
+      if (next_ == outer_.n_) return;
+      length_ = 1;
+      fetch();
+      while (next_ == pos_ + length_ && next_ != outer_.n_) {
+        // Consume the remaining run within the current block at once.
+        const auto remaining = buf_cnt_ - buf_idx_;
+        if (remaining > 0
+            && buf_[buf_cnt_ - 1] == next_ + remaining) {
+          length_ += remaining + 1;
+          buf_idx_ = buf_cnt_;
+        }
+        else {
+          ++length_;
+        }
+        fetch();
+      }
+    }
+
+  public:
+    explicit __forceinline__
+    iter(const delta_bp128& outer)
+        : outer_(outer),
+          block_idx_(0),
+          buf_idx_(0),
+          buf_cnt_(0),
+          next_(outer.n_),
+          pos_(outer.n_),
+          length_(0) {
+      if (!outer_.block_last_.empty()) {
+        load_block(0);
+        fetch();
+      }
+      produce_run();
+    }
+
+    iter(iter&&) noexcept = default;
+
+    /// Forward the iterator to the next 1-run.
+    void __forceinline__
+    next() {
+      produce_run();
+    }
+
+    /// Forward the iterator to the desired position.
+    void __forceinline__
+    skip_to(const std::size_t to_pos) {
+      if (to_pos <= pos_) return;
+      if (to_pos < pos_ + length_) {
+        length_ -= to_pos - pos_;
+        pos_ = to_pos;
+        return;
+      }
+      if (to_pos >= outer_.n_) {
+        pos_ = outer_.n_;
+        length_ = 0;
+        return;
+      }
+      if (next_ < to_pos) {
+        const auto& block_last = outer_.block_last_;
+        if (to_pos > block_last[block_idx_]) {
+          // Skip the blocks that do not contain the desired position.
+          const auto search = std::lower_bound(
+              block_last.begin() + block_idx_ + 1, block_last.end(), to_pos);
+          if (search == block_last.end()) {
+            pos_ = outer_.n_;
+            length_ = 0;
+            return;
+          }
+          load_block(search - block_last.begin());
+        }
+        // Search within the current block.
+        const auto search = std::lower_bound(
+            buf_ + buf_idx_, buf_ + buf_cnt_, static_cast<$u32>(to_pos));
+        assert(search != buf_ + buf_cnt_);
+        buf_idx_ = (search - buf_) + 1;
+        next_ = *search;
+      }
+      produce_run();
+    }
+
+    u1 __forceinline__
+    end() const noexcept {
+      return length_ == 0;
+    }
+
+    u64 __forceinline__
+    pos() const noexcept {
+      return pos_;
+    }
+
+    u64 __forceinline__
+    length() const noexcept {
+      return length_;
+    }
+  };
+  //===--------------------------------------------------------------------===//
+
+  using skip_iter_type = iter;
+  using scan_iter_type = iter;
+
+  /// Returns a 1-run iterator.
+  skip_iter_type __forceinline__
+  it() const {
+    return skip_iter_type(*this);
+  }
+
+  /// Returns a 1-run iterator.
+  scan_iter_type __forceinline__
+  scan_it() const {
+    return scan_iter_type(*this);
+  }
+
+  /// Returns the name of the instance including the most important parameters
+  /// in JSON.
+  std::string
+  info() const {
+    return "{\"name\":\"" + name() + "\""
+        + ",\"n\":" + std::to_string(n_)
+        + ",\"size\":" + std::to_string(size_in_bytes())
+        + ",\"positions\":" + std::to_string(m_)
+        + ",\"block_size\":" + std::to_string(block_size)
+        + ",\"block_cnt\":" + std::to_string(block_last_.size())
+        + "}";
+  }
+};
+//===----------------------------------------------------------------------===//
+} // namespace dtl
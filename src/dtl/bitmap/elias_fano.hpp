@@ -0,0 +1,372 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include <dtl/bitmap/util/bitmap_fun.hpp>
+#include <dtl/bits.hpp>
+#include <dtl/dtl.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <vector>
+//===----------------------------------------------------------------------===//
+namespace dtl {
+//===----------------------------------------------------------------------===//
+/// Elias-Fano encoded position list.
+///
+/// The positions p_0 < p_1 < ... < p_{m-1} of the 1-bits are split into
+/// l = floor(log2(n/m)) lower bits, which are stored verbatim, and the
+/// remaining upper bits, which are stored in unary (p_i >> l) + i in a bit
+/// sequence of length m + (n >> l) + 1. Every 'skip_distance'-th 0-bit of the
+/// upper bit sequence is sampled, which allows to jump to the first position
+/// with a given upper part in constant time.
+///
+/// The space consumption is at most 2 + log2(n/m) bits per position, plus
+/// the samples.
+class elias_fano {
+  using word_type = $u64;
+  using fn = dtl::bitmap_fun<word_type>;
+  static constexpr std::size_t word_bitlength = sizeof(word_type) * 8;
+  /// Every skip_distance-th 0-bit in the upper bit sequence is sampled.
+  static constexpr std::size_t skip_distance = 256;
+
+  /// The lower bits of the positions.
+  std::vector<word_type> lower_;
+  /// The upper bits of the positions (unary coded).
+  std::vector<word_type> upper_;
+  /// The positions of every skip_distance-th 0-bit in the upper bits.
+  std::vector<$u32> samples_;
+  /// The length of the encoded bitmap.
+  $u64 n_ = 0;
+  /// The number of encoded positions.
+  $u64 m_ = 0;
+  /// The number of lower bits per position.
+  $u32 l_ = 0;
+
+  /// Returns the lower bits of the i-th position.
+  word_type __forceinline__
+  lower(const std::size_t i) const {
+    if (l_ == 0) return 0;
+    return fn::fetch_bits(lower_.data(), i * l_, (i + 1) * l_);
+  }
+
+  /// Returns the position of the first 1-bit in the upper bits, that belongs
+  /// to a position whose upper part is >= h. The number of positions before
+  /// that 1-bit (the index of the position) is h less than the returned bit
+  /// position.
+  std::size_t
+  bucket_begin(const std::size_t h) const {
+    if (h == 0) return 0;
+    // Determine the position of the (h-1)-th 0-bit.
+    const std::size_t z = h - 1;
+    const std::size_t sample_idx = z / skip_distance;
+    std::size_t remaining = z - sample_idx * skip_distance;
+    std::size_t bit_pos = samples_[sample_idx];
+    if (remaining == 0) return bit_pos + 1;
+    ++bit_pos;
+    std::size_t word_idx = bit_pos / word_bitlength;
+    word_type w = ~upper_[word_idx] & (~word_type(0) << (bit_pos % word_bitlength));
+    while (true) {
+      const std::size_t cnt = dtl::bits::pop_count(w);
+      if (cnt >= remaining) break;
+      remaining -= cnt;
+      ++word_idx;
+      w = ~upper_[word_idx];
+    }
+    // Select the remaining-th 0-bit within the current word.
+    for (std::size_t i = 1; i < remaining; ++i) {
+      w &= w - 1;
+    }
+    return word_idx * word_bitlength + dtl::bits::tz_count(w) + 1;
+  }
+
+  /// Encodes the given (sorted) positions.
+  void
+  encode(const $u32* positions, const std::size_t cnt) {
+    assert(n_ <= (1ull << 32));
+    m_ = cnt;
+    l_ = 0;
+    if (m_ == 0) {
+      // Empty bitmap. Choose l such that the upper bits become negligible.
+      l_ = 32;
+    }
+    else if (n_ > m_) {
+      l_ = static_cast<$u32>(
+          word_bitlength - 1 - dtl::bits::lz_count(word_type(n_ / m_)));
+    }
+    const std::size_t upper_bitlength = m_ + (n_ >> l_) + 1;
+    lower_.assign((m_ * l_ + word_bitlength - 1) / word_bitlength + 1, 0);
+    upper_.assign((upper_bitlength + word_bitlength - 1) / word_bitlength, 0);
+    for (std::size_t i = 0; i < m_; ++i) {
+      const word_type p = positions[i];
+      assert(p < n_);
+      assert(i == 0 || positions[i - 1] < p);
+      if (l_ > 0) {
+        fn::store_bits(lower_.data(), i * l_, (i + 1) * l_,
+            p & ((word_type(1) << l_) - 1));
+      }
+      fn::set(upper_.data(), (p >> l_) + i);
+    }
+
+    // Sample the 0-bits.
+    samples_.clear();
+    std::size_t zero_cnt = 0;
+    for (std::size_t word_idx = 0; word_idx < upper_.size(); ++word_idx) {
+      word_type w = ~upper_[word_idx];
+      const std::size_t word_begin = word_idx * word_bitlength;
+      if (word_begin + word_bitlength > upper_bitlength) {
+        w &= ~word_type(0) >> (word_begin + word_bitlength - upper_bitlength);
+      }
+      const std::size_t cnt = dtl::bits::pop_count(w);
+      if (samples_.size() * skip_distance >= zero_cnt + cnt) {
+        zero_cnt += cnt;
+        continue;
+      }
+      while (w != 0) {
+        if (zero_cnt == samples_.size() * skip_distance) {
+          samples_.push_back(
+              static_cast<$u32>(word_begin + dtl::bits::tz_count(w)));
+        }
+        ++zero_cnt;
+        w &= w - 1;
+      }
+    }
+  }
+
+public:
+  elias_fano() = default;
+
+  explicit elias_fano(const boost::dynamic_bitset<$u32>& in) : n_(in.size()) {
+    std::vector<$u32> positions;
+    std::size_t current_pos = in.find_first();
+    while (current_pos < in.size()) {
+      positions.push_back(static_cast<$u32>(current_pos));
+      current_pos = in.find_next(current_pos);
+    }
+    encode(positions.data(), positions.size());
+    shrink();
+  }
+
+  /// Constructs a bitmap of length n from the given (sorted) positions of the
+  /// 1-bits, without using a plain bitmap as intermediate.
+  elias_fano(const $u32* positions, std::size_t cnt, std::size_t n) : n_(n) {
+    encode(positions, cnt);
+    shrink();
+  }
+
+  ~elias_fano() = default;
+  elias_fano(const elias_fano& other) = default;
+  elias_fano(elias_fano&& other) noexcept = default;
+  elias_fano& operator=(const elias_fano& other) = default;
+  elias_fano& operator=(elias_fano&& other) noexcept = default;
+
+  /// Return the size in bytes.
+  std::size_t __forceinline__
+  size_in_bytes() const {
+    return lower_.size() * sizeof(word_type) /* lower bits */
+        + upper_.size() * sizeof(word_type) /* upper bits */
+        + samples_.size() * sizeof($u32) /* samples */
+        + sizeof(n_) /* bit-length of the original bitmap */
+        + sizeof(m_) /* number of positions */
+        + sizeof(l_); /* number of lower bits */
+  }
+
+  /// Returns the size of the bitmap.
+  std::size_t __forceinline__
+  size() const {
+    return n_;
+  }
+
+  static std::string
+  name() {
+    return "elias_fano";
+  }
+
+  /// Returns the value of the bit at the position pos.
+  u1 __forceinline__
+  test(const std::size_t pos) const {
+    if (pos >= n_ || m_ == 0) return false;
+    // Scan the positions with the same upper part.
+    const std::size_t h = pos >> l_;
+    std::size_t bit_pos = bucket_begin(h);
+    const word_type low = pos - (h << l_);
+    for (std::size_t idx = bit_pos - h; idx < m_; ++idx, ++bit_pos) {
+      if (!dtl::bits::bit_test(upper_[bit_pos / word_bitlength],
+              bit_pos % word_bitlength)) {
+        break;
+      }
+      const word_type l = lower(idx);
+      if (l >= low) return l == low;
+    }
+    return false;
+  }
+
+  /// Try to reduce the memory consumption. This function is supposed to be
+  /// called after the bitmap has been modified.
+  __forceinline__ void
+  shrink() {
+    lower_.shrink_to_fit();
+    upper_.shrink_to_fit();
+    samples_.shrink_to_fit();
+  }
+
+  //===--------------------------------------------------------------------===//
+  /// 1-run iterator. Consecutive positions are merged into runs.
+  class iter {
+    const elias_fano& outer_;
+
+    /// The index of the next position to decode.
+    $u64 idx_;
+    /// The position in the upper bits where to continue decoding.
+    $u64 upper_pos_;
+    /// The next (already decoded) position, that is not part of the current
+    /// run. Refers to n, if there is none.
+    $u64 next_;
+
+    //===------------------------------------------------------------------===//
+    // Iterator state
+    //===------------------------------------------------------------------===//
+    /// Points to the beginning of a 1-run.
+    $u64 pos_;
+    /// The length of the current 1-run.
+    $u64 length_;
+    //===------------------------------------------------------------------===//
+
+    /// Decodes the next position.
+    void __forceinline__
+    fetch() {
+      if (idx_ == outer_.m_) {
+        next_ = outer_.n_;
+        return;
+      }
+      std::size_t word_idx = upper_pos_ / word_bitlength;
+      word_type w = outer_.upper_[word_idx]
+          & (~word_type(0) << (upper_pos_ % word_bitlength));
+      while (w == 0) {
+        w = outer_.upper_[++word_idx];
+      }
+      const std::size_t bit_pos =
+          word_idx * word_bitlength + dtl::bits::tz_count(w);
+      next_ = ((bit_pos - idx_) << outer_.l_) | outer_.lower(idx_);
+      upper_pos_ = bit_pos + 1;
+      ++idx_;
+    }
+
+    /// Forms the next 1-run, starting with the lookahead position.
+    void __forceinline__
+    produce_run() {
+      pos_ = next_;
+      length_ = 0;
+      if (next_ == outer_.n_) return;
+      length_ = 1;
+      fetch();
+      while (next_ == pos_ + length_ && next_ != outer_.n_) {
+        ++length_;
+        fetch();
+      }
+    }
+
+  public:
+    explicit __forceinline__
+    iter(const elias_fano& outer)
+        : outer_(outer),
+          idx_(0),
+          upper_pos_(0),
+          next_(outer.n_),
+          pos_(outer.n_),
+          length_(0) {
+      fetch();
+      produce_run();
+    }
+
+    iter(iter&&) noexcept = default;
+
+    /// Forward the iterator to the next 1-run.
+    void __forceinline__
+    next() {
+      produce_run();
+    }
+
+    /// Forward the iterator to the desired position.
+    void __forceinline__
+    skip_to(const std::size_t to_pos) {
+      if (to_pos <= pos_) return;
+      if (to_pos < pos_ + length_) {
+        length_ -= to_pos - pos_;
+        pos_ = to_pos;
+        return;
+      }
+      if (to_pos >= outer_.n_) {
+        pos_ = outer_.n_;
+        length_ = 0;
+        return;
+      }
+      if (next_ < to_pos) {
+        // Jump to the first position with the same upper part as to_pos.
+        const std::size_t h = to_pos >> outer_.l_;
+        if (h > (next_ >> outer_.l_)) {
+          const std::size_t bucket_begin = outer_.bucket_begin(h);
+          if (bucket_begin - h >= idx_) {
+            idx_ = bucket_begin - h;
+            upper_pos_ = bucket_begin;
+            fetch();
+          }
+        }
+        while (next_ < to_pos) {
+          fetch();
+        }
+      }
+      produce_run();
+    }
+
+    u1 __forceinline__
+    end() const noexcept {
+      return length_ == 0;
+    }
+
+    u64 __forceinline__
+    pos() const noexcept {
+      return pos_;
+    }
+
+    u64 __forceinline__
+    length() const noexcept {
+      return length_;
+    }
+  };
+  //===--------------------------------------------------------------------===//
+
+  using skip_iter_type = iter;
+  using scan_iter_type = iter;
+
+  /// Returns a 1-run iterator.
+  skip_iter_type __forceinline__
+  it() const {
+    return skip_iter_type(*this);
+  }
+
+  /// Returns a 1-run iterator.
+  scan_iter_type __forceinline__
+  scan_it() const {
+    return scan_iter_type(*this);
+  }
+
+  /// Returns the name of the instance including the most important parameters
+  /// in JSON.
+  std::string
+  info() const {
+    return "{\"name\":\"" + name() + "\""
+        + ",\"n\":" + std::to_string(n_)
+        + ",\"size\":" + std::to_string(size_in_bytes())
+        + ",\"positions\":" + std::to_string(m_)
+        + ",\"lower_bits\":" + std::to_string(l_)
+        + ",\"skip_distance\":" + std::to_string(skip_distance)
+        + ",\"samples_size\":"
+        + std::to_string(samples_.size() * sizeof($u32))
+        + "}";
+  }
+};
+//===----------------------------------------------------------------------===//
+} // namespace dtl
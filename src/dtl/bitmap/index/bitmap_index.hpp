@@ -0,0 +1,461 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include "bitmap_index_loader.hpp"
+
+#include <dtl/bitmap/bitwise_operations.hpp>
+#include <dtl/bitmap/iterator.hpp>
+#include <dtl/bitmap/util/convert.hpp>
+#include <dtl/dtl.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+//===----------------------------------------------------------------------===//
+namespace dtl {
+//===----------------------------------------------------------------------===//
+/// The supported bitmap index encodings.
+enum class bitmap_index_encoding {
+  /// One bitmap per value, E_v = {i | x_i == v}.
+  EQUALITY,
+  /// One bitmap per value, R_v = {i | x_i <= v}. The bitmap R_{c-1} has all
+  /// bits set and is therefore not stored. Any range predicate can be answered
+  /// using at most two bitmaps.
+  RANGE,
+  /// One bitmap per interval of m = ceil(c/2) consecutive values,
+  /// I_j = {i | j <= x_i < j + m}. Any range predicate can be answered using
+  /// at most two bitmaps, while only (roughly) half of the bitmaps need to be
+  /// stored compared to the range encoding.
+  INTERVAL
+};
+//===----------------------------------------------------------------------===//
+namespace internal {
+//===----------------------------------------------------------------------===//
+/// Determines the type of the iterator that evaluates a single range predicate
+/// [lo, hi] for the given encoding.
+template<typename B, bitmap_index_encoding E>
+struct bitmap_index_leaf {};
+
+template<typename B>
+struct bitmap_index_leaf<B, bitmap_index_encoding::EQUALITY> {
+  using skip_iter_type =
+      typename obtain_run_iterator<const B, run_iterator_type::SKIP>::type;
+  /// E_v
+  using type = skip_iter_type;
+};
+
+template<typename B>
+struct bitmap_index_leaf<B, bitmap_index_encoding::RANGE> {
+  using skip_iter_type =
+      typename obtain_run_iterator<const B, run_iterator_type::SKIP>::type;
+  /// R_hi XOR R_{lo-1}
+  using type = bitwise_iter<skip_iter_type, skip_iter_type, bitwise_xor>;
+};
+
+template<typename B>
+struct bitmap_index_leaf<B, bitmap_index_encoding::INTERVAL> {
+  using skip_iter_type =
+      typename obtain_run_iterator<const B, run_iterator_type::SKIP>::type;
+  /// (P XOR Q) XOR (R AND S), which covers a single bitmap, the intersection,
+  /// the difference and the union of two bitmaps.
+  using type = bitwise_iter<
+      bitwise_iter<skip_iter_type, skip_iter_type, bitwise_xor>,
+      bitwise_iter<skip_iter_type, skip_iter_type, bitwise_and>,
+      bitwise_xor>;
+};
+//===----------------------------------------------------------------------===//
+} // namespace internal
+//===----------------------------------------------------------------------===//
+/// A bitmap index on an integer column with the value domain [0, c). The
+/// index maps values (or intervals of values) to (compressed) bitmaps of
+/// type B. Predicates (equality, IN-lists, ranges) are evaluated lazily using
+/// run iterators, i.e., without materializing intermediate bitmaps.
+template<
+    /// The (compressed) bitmap type.
+    typename B,
+    /// The encoding of the index.
+    bitmap_index_encoding E = bitmap_index_encoding::EQUALITY>
+class bitmap_index {
+public:
+  /// The iterator type that evaluates a single range predicate.
+  using leaf_iter_type = typename internal::bitmap_index_leaf<B, E>::type;
+  /// The iterator type returned by the query functions.
+  using iter_type = internal::bitwise_or_kway_iter<leaf_iter_type>;
+
+private:
+  using bitmap_t = boost::dynamic_bitset<$u32>;
+  using skip_iter_type =
+      typename obtain_run_iterator<const B, run_iterator_type::SKIP>::type;
+  using encoding_tag = std::integral_constant<bitmap_index_encoding, E>;
+  using equality_tag =
+      std::integral_constant<bitmap_index_encoding, bitmap_index_encoding::EQUALITY>;
+  using range_tag =
+      std::integral_constant<bitmap_index_encoding, bitmap_index_encoding::RANGE>;
+  using interval_tag =
+      std::integral_constant<bitmap_index_encoding, bitmap_index_encoding::INTERVAL>;
+
+  /// The number of rows.
+  std::size_t n_;
+  /// The cardinality of the value domain.
+  $u32 c_;
+  /// The width of the intervals (interval encoding only).
+  $u32 m_;
+  /// The (compressed) bitmaps.
+  std::vector<B> bitmaps_;
+  /// A bitmap with all bits set to 0.
+  B empty_;
+  /// A bitmap with all bits set to 1. Only constructed for the range
+  /// encoding, otherwise null.
+  std::unique_ptr<B> full_;
+
+  /// Returns the number of bitmaps for the given encoding.
+  static std::size_t
+  bitmap_cnt_for(u32 c) {
+    switch (E) {
+      case bitmap_index_encoding::EQUALITY: return c;
+      case bitmap_index_encoding::RANGE: return c - 1;
+      case bitmap_index_encoding::INTERVAL: return c - ((c + 1) / 2) + 1;
+    }
+    return 0;
+  }
+
+  static std::unique_ptr<B>
+  all_ones(std::size_t n) {
+    bitmap_t bm(n);
+    bm.set();
+    return std::make_unique<B>(bm);
+  }
+
+  /// Returns a skip iterator for the given bitmap.
+  static skip_iter_type __forceinline__
+  it_of(const B& b) {
+    return obtain_run_iterator<const B, run_iterator_type::SKIP>::from(b);
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Construction.
+  //===--------------------------------------------------------------------===//
+  /// Sets or clears the bits of the rows with a value in [value_begin,
+  /// value_end).
+  static void __forceinline__
+  assign_rows(bitmap_t& bm, const bitmap_index_rows_t& r, u32 value_begin,
+      u32 value_end, u1 val) {
+    for (std::size_t i = r.offsets[value_begin]; i < r.offsets[value_end];
+         ++i) {
+      bm[r.rows[i]] = val;
+    }
+  }
+
+  /// Constructs the bitmaps [begin, end). The scratch bitmap needs to be all
+  /// 0 and is reset before returning.
+  void
+  build(const bitmap_index_rows_t& r, u32 begin, u32 end, bitmap_t& scratch,
+      std::vector<std::unique_ptr<B>>& out, equality_tag) const {
+    for ($u32 v = begin; v < end; ++v) {
+      out[v] = std::make_unique<B>(internal::build_from_positions<B>(
+          r.rows.data() + r.offsets[v], r.offsets[v + 1] - r.offsets[v], n_,
+          scratch));
+    }
+  }
+
+  void
+  build(const bitmap_index_rows_t& r, u32 begin, u32 end, bitmap_t& scratch,
+      std::vector<std::unique_ptr<B>>& out, range_tag) const {
+    scratch.resize(n_);
+    // R_{begin-1}
+    assign_rows(scratch, r, 0, begin, true);
+    for ($u32 v = begin; v < end; ++v) {
+      assign_rows(scratch, r, v, v + 1, true);
+      out[v] = std::make_unique<B>(scratch);
+    }
+    scratch.reset();
+  }
+
+  void
+  build(const bitmap_index_rows_t& r, u32 begin, u32 end, bitmap_t& scratch,
+      std::vector<std::unique_ptr<B>>& out, interval_tag) const {
+    if (begin == end) return;
+    scratch.resize(n_);
+    assign_rows(scratch, r, begin, begin + m_, true);
+    out[begin] = std::make_unique<B>(scratch);
+    // Slide the window over the value domain.
+    for ($u32 j = begin + 1; j < end; ++j) {
+      assign_rows(scratch, r, j - 1, j, false);
+      assign_rows(scratch, r, j + m_ - 1, j + m_, true);
+      out[j] = std::make_unique<B>(scratch);
+    }
+    scratch.reset();
+  }
+
+  /// Constructs all bitmaps in parallel.
+  void
+  build(const bitmap_index_rows_t& r, u64 thread_cnt) {
+    const auto cnt = static_cast<$u32>(bitmap_cnt_for(c_));
+    std::vector<std::unique_ptr<B>> out(cnt);
+    const u64 t_cnt = std::max(u64(1), std::min(thread_cnt, u64(cnt)));
+    if (E == bitmap_index_encoding::EQUALITY) {
+      // The bitmaps are constructed independently. The work is distributed
+      // dynamically, as the value frequencies are typically skewed.
+      const u32 chunk_size = std::max(u32(1), static_cast<$u32>(cnt / (t_cnt * 16)));
+      std::atomic<$u32> next { 0 };
+      auto thread_fn = [&](u32 thread_id) {
+        bitmap_t scratch;
+        while (true) {
+          const auto begin = next.fetch_add(chunk_size);
+          if (begin >= cnt) break;
+          build(r, begin, std::min(begin + chunk_size, cnt), scratch, out,
+              encoding_tag());
+        }
+      };
+      internal::bitmap_index_run(thread_fn, t_cnt);
+    }
+    else {
+      // The bitmaps are constructed incrementally. Each thread is assigned a
+      // contiguous range of bitmaps.
+      auto thread_fn = [&](u32 thread_id) {
+        bitmap_t scratch;
+        const auto begin = static_cast<$u32>((u64(cnt) * thread_id) / t_cnt);
+        const auto end = static_cast<$u32>((u64(cnt) * (thread_id + 1)) / t_cnt);
+        build(r, begin, end, scratch, out, encoding_tag());
+      };
+      internal::bitmap_index_run(thread_fn, t_cnt);
+    }
+    bitmaps_.reserve(cnt);
+    for (auto& b : out) {
+      bitmaps_.emplace_back(std::move(*b));
+      b.reset();
+    }
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Evaluation of a single range predicate [lo, hi].
+  //===--------------------------------------------------------------------===//
+  /// Returns the range encoded bitmap R_v, for v in [-1, c).
+  const B& __forceinline__
+  range_bitmap(i64 v) const {
+    if (v < 0) return empty_;
+    if (v + 1 >= c_) return *full_;
+    return bitmaps_[v];
+  }
+
+  /// Returns the interval bitmap I_j.
+  const B& __forceinline__
+  interval_bitmap(u32 j) const {
+    return bitmaps_[j];
+  }
+
+  leaf_iter_type __forceinline__
+  leaf_it(u32 lo, u32 hi, equality_tag) const {
+    assert(lo == hi);
+    return it_of(bitmaps_[lo]);
+  }
+
+  leaf_iter_type __forceinline__
+  leaf_it(u32 lo, u32 hi, range_tag) const {
+    return bitwise_xor_it(it_of(range_bitmap(hi)),
+        it_of(range_bitmap(static_cast<$i64>(lo) - 1)));
+  }
+
+  leaf_iter_type __forceinline__
+  interval_leaf_it(const B& p, const B& q, const B& r, const B& s) const {
+    return bitwise_xor_it(
+        bitwise_xor_it(it_of(p), it_of(q)),
+        bitwise_and_it(it_of(r), it_of(s)));
+  }
+
+  leaf_iter_type __forceinline__
+  leaf_it(u32 lo, u32 hi, interval_tag) const {
+    const auto& e = empty_;
+    u32 len = hi - lo + 1;
+    u32 last = c_ - m_; // The index of the last interval.
+    if (len == m_) {
+      // I_lo
+      return interval_leaf_it(interval_bitmap(lo), e, e, e);
+    }
+    if (len > m_) {
+      // I_lo OR I_{hi-m+1}
+      const auto& a = interval_bitmap(lo);
+      const auto& b = interval_bitmap(hi - m_ + 1);
+      return interval_leaf_it(a, b, a, b);
+    }
+    if (lo <= last) {
+      const auto& a = interval_bitmap(lo);
+      if (hi + 1 <= last) {
+        // I_lo AND NOT I_{hi+1}
+        const auto& b = interval_bitmap(hi + 1);
+        return interval_leaf_it(a, e, a, b);
+      }
+      // I_lo AND I_{hi-m+1}
+      const auto& b = interval_bitmap(hi - m_ + 1);
+      return interval_leaf_it(e, e, a, b);
+    }
+    // I_{hi-m+1} AND NOT I_{lo-m}
+    const auto& a = interval_bitmap(hi - m_ + 1);
+    const auto& b = interval_bitmap(lo - m_);
+    return interval_leaf_it(a, e, a, b);
+  }
+
+  /// Appends the iterators for the given (inclusive) range of values.
+  void
+  append_range(std::vector<leaf_iter_type>& its, u32 lo, u32 hi) const {
+    if (E == bitmap_index_encoding::EQUALITY) {
+      for ($u32 v = lo; v <= hi; ++v) {
+        its.emplace_back(leaf_it(v, v, encoding_tag()));
+      }
+    }
+    else {
+      its.emplace_back(leaf_it(lo, hi, encoding_tag()));
+    }
+  }
+
+public:
+  /// Constructs a bitmap index on the given column. All values need to be in
+  /// the range [0, c). The column is scanned once; the row IDs are
+  /// partitioned by value and the bitmaps are constructed using the given
+  /// number of threads.
+  bitmap_index(const std::vector<$u32>& values, u32 c, u64 thread_cnt = 1)
+      : n_(values.size()),
+        c_(c),
+        m_((c + 1) / 2),
+        empty_(bitmap_t(values.size())),
+        full_(E == bitmap_index_encoding::RANGE
+            ? all_ones(values.size()) : nullptr) {
+    if (c == 0) {
+      throw std::invalid_argument("The cardinality must be greater than 0.");
+    }
+    const auto r = partition_rows(values, c, thread_cnt);
+    build(r, thread_cnt);
+  }
+
+  bitmap_index(const bitmap_index& other) = delete;
+  bitmap_index(bitmap_index&& other) noexcept = default;
+  bitmap_index& operator=(const bitmap_index& other) = delete;
+  bitmap_index& operator=(bitmap_index&& other) noexcept = default;
+  ~bitmap_index() = default;
+
+  /// Returns the number of rows.
+  std::size_t __forceinline__
+  size() const {
+    return n_;
+  }
+
+  /// Returns the cardinality of the value domain.
+  u32 __forceinline__
+  cardinality() const {
+    return c_;
+  }
+
+  /// Returns the number of (stored) bitmaps.
+  std::size_t __forceinline__
+  bitmap_cnt() const {
+    return bitmaps_.size();
+  }
+
+  /// Returns the i-th bitmap.
+  const B& __forceinline__
+  get_bitmap(std::size_t i) const {
+    return bitmaps_[i];
+  }
+
+  /// Returns the size of the index in bytes.
+  std::size_t
+  size_in_bytes() const {
+    std::size_t ret = sizeof(n_) + sizeof(c_) + sizeof(m_);
+    for (const auto& b : bitmaps_) {
+      ret += b.size_in_bytes();
+    }
+    return ret;
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Queries.
+  //===--------------------------------------------------------------------===//
+  /// Returns an iterator over the rows that satisfy the predicate
+  /// lo <= x <= hi.
+  iter_type
+  range_it(u32 lo, u32 hi) const {
+    std::vector<leaf_iter_type> its;
+    const auto h = std::min(hi, c_ - 1);
+    if (lo <= h) {
+      its.reserve(E == bitmap_index_encoding::EQUALITY ? h - lo + 1 : 1);
+      append_range(its, lo, h);
+    }
+    return bitwise_or_kway_it(std::move(its), n_);
+  }
+
+  /// Returns an iterator over the rows that satisfy the predicate x == v.
+  iter_type
+  eq_it(u32 v) const {
+    return range_it(v, v);
+  }
+
+  /// Returns an iterator over the rows that satisfy the predicate
+  /// x IN (values). Consecutive values are evaluated as ranges.
+  iter_type
+  in_it(std::vector<$u32> values) const {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    while (!values.empty() && values.back() >= c_) values.pop_back();
+    std::vector<leaf_iter_type> its;
+    its.reserve(values.size());
+    std::size_t i = 0;
+    while (i < values.size()) {
+      std::size_t j = i + 1;
+      while (j < values.size() && values[j] == values[j - 1] + 1) ++j;
+      append_range(its, values[i], values[j - 1]);
+      i = j;
+    }
+    return bitwise_or_kway_it(std::move(its), n_);
+  }
+
+  /// Returns the rows that satisfy the predicate lo <= x <= hi.
+  boost::dynamic_bitset<$u32>
+  range(u32 lo, u32 hi) const {
+    auto it = range_it(lo, hi);
+    return to_bitmap_from_iterator(it, n_);
+  }
+
+  /// Returns the rows that satisfy the predicate x == v.
+  boost::dynamic_bitset<$u32>
+  eq(u32 v) const {
+    auto it = eq_it(v);
+    return to_bitmap_from_iterator(it, n_);
+  }
+
+  /// Returns the rows that satisfy the predicate x IN (values).
+  boost::dynamic_bitset<$u32>
+  in(const std::vector<$u32>& values) const {
+    auto it = in_it(values);
+    return to_bitmap_from_iterator(it, n_);
+  }
+
+  //===--------------------------------------------------------------------===//
+  static std::string
+  name() {
+    std::string enc;
+    switch (E) {
+      case bitmap_index_encoding::EQUALITY: enc = "equality"; break;
+      case bitmap_index_encoding::RANGE: enc = "range"; break;
+      case bitmap_index_encoding::INTERVAL: enc = "interval"; break;
+    }
+    return "bitmap_index<" + B::name() + "," + enc + ">";
+  }
+
+  /// Returns the index details in JSON format.
+  std::string
+  info() const {
+    return "{\"name\":\"" + name() + "\""
+        + ",\"n\":" + std::to_string(n_)
+        + ",\"c\":" + std::to_string(c_)
+        + ",\"bitmap_cnt\":" + std::to_string(bitmaps_.size())
+        + ",\"size\":" + std::to_string(size_in_bytes())
+        + "}";
+  }
+};
+//===----------------------------------------------------------------------===//
+} // namespace dtl
@@ -0,0 +1,156 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include <dtl/dtl.hpp>
+#include <dtl/thread.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Bulk loading of bitmap indexes.
+//
+// The column is scanned once and the row IDs are partitioned by value. Each
+// thread partitions a contiguous range of rows (radix partitioning with a
+// fan-out of c). As the per-thread partitions are concatenated in thread
+// order, the row IDs of each value are sorted. The sorted row lists are then
+// fed into the bitmap constructors in parallel.
+//===----------------------------------------------------------------------===//
+namespace dtl {
+//===----------------------------------------------------------------------===//
+/// The row IDs of a column, partitioned by value.
+struct bitmap_index_rows_t {
+  /// The row IDs grouped by value. Within a group, the row IDs are sorted.
+  std::vector<$u32> rows;
+  /// The row IDs of value v are stored in rows[offsets[v], offsets[v + 1]).
+  std::vector<$u32> offsets;
+};
+//===----------------------------------------------------------------------===//
+namespace internal {
+//===----------------------------------------------------------------------===//
+/// Runs the given function with the given number of threads.
+template<typename Fn>
+void
+bitmap_index_run(Fn& fn, u64 thread_cnt) {
+  if (thread_cnt <= 1) {
+    fn(0);
+  }
+  else {
+    dtl::run_in_parallel(fn, dtl::this_thread::get_cpu_affinity(),
+        thread_cnt);
+  }
+}
+//===----------------------------------------------------------------------===//
+/// A type that is used to detect constructors which accept any pointer.
+struct any_pointer_probe;
+
+/// Determines whether the bitmap type B can be constructed directly from a
+/// sorted list of positions, i.e., without a plain bitmap as intermediate.
+/// The constructor needs to have the signature
+///   B(const $u32* positions, std::size_t cnt, std::size_t n).
+/// Constructors that accept other pointer types as well, e.g., due to the
+/// implicit conversion of pointers to bool or void*, are not considered.
+template<typename B>
+struct is_position_constructible
+    : std::integral_constant<bool,
+        std::is_constructible<B, const $u32*, std::size_t, std::size_t>::value
+        && !std::is_constructible<B, const any_pointer_probe*, std::size_t,
+            std::size_t>::value> {};
+//===----------------------------------------------------------------------===//
+/// Constructs a bitmap of length n with the given bits set. The positions
+/// need to be sorted. Bitmap types that cannot be constructed from positions
+/// are constructed from the given plain bitmap (scratch), which needs to be of
+/// length n and all 0. The scratch bitmap is reset before returning.
+template<typename B>
+B
+build_from_positions(const $u32* positions, std::size_t cnt, std::size_t n,
+    boost::dynamic_bitset<$u32>& scratch, std::true_type) {
+  return B(positions, cnt, n);
+}
+
+template<typename B>
+B
+build_from_positions(const $u32* positions, std::size_t cnt, std::size_t n,
+    boost::dynamic_bitset<$u32>& scratch, std::false_type) {
+  if (scratch.size() != n) scratch.resize(n);
+  for (std::size_t i = 0; i < cnt; ++i) scratch[positions[i]] = true;
+  B ret(scratch);
+  for (std::size_t i = 0; i < cnt; ++i) scratch[positions[i]] = false;
+  return ret;
+}
+
+template<typename B>
+B
+build_from_positions(const $u32* positions, std::size_t cnt, std::size_t n,
+    boost::dynamic_bitset<$u32>& scratch) {
+  return build_from_positions<B>(positions, cnt, n, scratch,
+      typename is_position_constructible<B>::type());
+}
+//===----------------------------------------------------------------------===//
+} // namespace internal
+//===----------------------------------------------------------------------===//
+/// Partitions the row IDs of the given column by value (in parallel). All
+/// values need to be in [0, c).
+inline bitmap_index_rows_t
+partition_rows(const std::vector<$u32>& values, u32 c, u64 thread_cnt) {
+  const std::size_t n = values.size();
+  const u64 t_cnt = std::max(u64(1),
+      std::min(thread_cnt, u64((n + (1ull << 16) - 1) >> 16)));
+  bitmap_index_rows_t ret;
+  ret.offsets.resize(c + 1, 0);
+  ret.rows.resize(n);
+
+  // The histograms of all threads (thread major).
+  std::vector<$u32> hist(std::size_t(c) * t_cnt, 0);
+  std::atomic<$u32> invalid_cnt { 0 };
+  auto row_begin = [&](u64 thread_id) { return (n * thread_id) / t_cnt; };
+
+  // Phase 1: Build the per-thread histograms.
+  auto hist_fn = [&](u32 thread_id) {
+    $u32 invalid = 0;
+    for (std::size_t i = row_begin(thread_id); i < row_begin(thread_id + 1);
+         ++i) {
+      const auto v = values[i];
+      if (v >= c) {
+        ++invalid;
+        continue;
+      }
+      ++hist[std::size_t(c) * thread_id + v];
+    }
+    if (invalid > 0) invalid_cnt += invalid;
+  };
+  internal::bitmap_index_run(hist_fn, t_cnt);
+  if (invalid_cnt > 0) {
+    throw std::invalid_argument("Value out of range.");
+  }
+
+  // Compute the write positions. The row IDs of value v written by thread t
+  // are placed after those written by threads 0..t-1, which keeps the row
+  // IDs sorted.
+  $u32 sum = 0;
+  for (std::size_t v = 0; v < c; ++v) {
+    ret.offsets[v] = sum;
+    for (std::size_t t = 0; t < t_cnt; ++t) {
+      const auto cnt = hist[t * c + v];
+      hist[t * c + v] = sum;
+      sum += cnt;
+    }
+  }
+  ret.offsets[c] = sum;
+
+  // Phase 2: Scatter the row IDs.
+  auto scatter_fn = [&](u32 thread_id) {
+    for (std::size_t i = row_begin(thread_id); i < row_begin(thread_id + 1);
+         ++i) {
+      auto& write_pos = hist[std::size_t(c) * thread_id + values[i]];
+      ret.rows[write_pos++] = static_cast<$u32>(i);
+    }
+  };
+  internal::bitmap_index_run(scatter_fn, t_cnt);
+  return ret;
+}
+//===----------------------------------------------------------------------===//
+} // namespace dtl
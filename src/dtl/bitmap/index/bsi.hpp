@@ -0,0 +1,421 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include <dtl/bitmap/bitwise_operations.hpp>
+#include <dtl/bitmap/iterator.hpp>
+#include <dtl/bitmap/range_list.hpp>
+#include <dtl/dtl.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+//===----------------------------------------------------------------------===//
+namespace dtl {
+//===----------------------------------------------------------------------===//
+/// A bit-sliced index (BSI) on an unsigned integer column. The index consists
+/// of one (compressed) bitmap per bit of the values, where the i-th slice
+/// contains the rows with the i-th bit set. Comparisons and aggregates are
+/// evaluated slice-wise using run iterators, i.e., without accessing the base
+/// data.
+///
+/// Intermediate and final results of predicates are represented as range
+/// lists.
+template<
+    /// The (compressed) bitmap type of the slices.
+    typename B>
+class bsi {
+public:
+  /// The type of the predicate results.
+  using result_type = range_list<$u32>;
+
+private:
+  using bitmap_t = boost::dynamic_bitset<$u32>;
+  using skip_iter_type =
+      typename obtain_run_iterator<const B, run_iterator_type::SKIP>::type;
+
+  /// The number of rows.
+  std::size_t n_;
+  /// The bit slices, starting with the least significant bit.
+  std::vector<B> slices_;
+  /// The number of 1-bits per slice.
+  std::vector<$u64> slice_popcounts_;
+
+  /// Counts the 1-bits produced by the given run iterator.
+  template<typename It>
+  static u64 __forceinline__
+  count(It&& it) {
+    $u64 cnt = 0;
+    while (!it.end()) {
+      cnt += it.length();
+      it.next();
+    }
+    return cnt;
+  }
+
+  /// Materializes the given run iterator as a range list. Adjacent runs are
+  /// merged. Optionally, the number of 1-bits is determined on the fly.
+  template<typename It>
+  result_type
+  materialize(It&& it, $u64* popcount = nullptr) const {
+    result_type ret;
+    ret.n_ = n_;
+    $u64 cnt = 0;
+    while (!it.end()) {
+      const auto pos = it.pos();
+      const auto len = it.length();
+      cnt += len;
+      if (!ret.ranges_.empty()) {
+        auto& last = ret.ranges_.back();
+        if (last.begin() + last.length() == pos) {
+          last = typename result_type::range(last.begin(), last.length() + len);
+          it.next();
+          continue;
+        }
+      }
+      ret.ranges_.emplace_back(pos, len);
+      it.next();
+    }
+    if (popcount != nullptr) *popcount = cnt;
+    return ret;
+  }
+
+  /// Returns a range list with all bits set.
+  result_type
+  all() const {
+    result_type ret;
+    ret.n_ = n_;
+    if (n_ > 0) ret.ranges_.emplace_back(0, n_);
+    return ret;
+  }
+
+  /// Returns a range list with all bits cleared.
+  result_type
+  none() const {
+    result_type ret;
+    ret.n_ = n_;
+    return ret;
+  }
+
+  skip_iter_type __forceinline__
+  slice_it(std::size_t i) const {
+    return obtain_run_iterator<const B, run_iterator_type::SKIP>::from(
+        slices_[i]);
+  }
+
+  /// Restricts the set of (equal) rows to those where the i-th bit matches the
+  /// given bit. The number of rows that do NOT match is returned via
+  /// mismatch_cnt.
+  void
+  refine(result_type& eq, $u64& eq_cnt, std::size_t i, u1 bit,
+      $u64& mismatch_cnt) const {
+    // EQ AND S_i
+    $u64 match_1_cnt = 0;
+    auto eq_and_slice =
+        materialize(bitwise_and_it(eq.it(), slice_it(i)), &match_1_cnt);
+    if (bit) {
+      mismatch_cnt = eq_cnt - match_1_cnt;
+      eq = std::move(eq_and_slice);
+      eq_cnt = match_1_cnt;
+    }
+    else {
+      // EQ AND NOT S_i = EQ XOR (EQ AND S_i)
+      mismatch_cnt = match_1_cnt;
+      eq = materialize(bitwise_xor_it(eq.it(), eq_and_slice.it()));
+      eq_cnt = eq_cnt - match_1_cnt;
+    }
+  }
+
+
+public:
+  /// Constructs a bit-sliced index on the given column.
+  explicit bsi(const std::vector<$u32>& values)
+      : n_(values.size()) {
+    $u32 max = 0;
+    for (auto v : values) max = std::max(max, v);
+    const std::size_t slice_cnt = max == 0 ? 1 : 32 - dtl::bits::lz_count(max);
+    slices_.reserve(slice_cnt);
+    slice_popcounts_.reserve(slice_cnt);
+    bitmap_t bm(n_);
+    for (std::size_t i = 0; i < slice_cnt; ++i) {
+      bm.reset();
+      for (std::size_t r = 0; r < n_; ++r) {
+        if ((values[r] >> i) & 1) bm[r] = true;
+      }
+      slices_.emplace_back(bm);
+      slice_popcounts_.push_back(bm.count());
+    }
+  }
+
+  bsi(const bsi& other) = delete;
+  bsi(bsi&& other) noexcept = default;
+  bsi& operator=(const bsi& other) = delete;
+  bsi& operator=(bsi&& other) noexcept = default;
+  ~bsi() = default;
+
+  /// Returns the number of rows.
+  std::size_t __forceinline__
+  size() const {
+    return n_;
+  }
+
+  /// Returns the number of slices.
+  std::size_t __forceinline__
+  slice_cnt() const {
+    return slices_.size();
+  }
+
+  /// Returns the i-th slice.
+  const B& __forceinline__
+  get_slice(std::size_t i) const {
+    return slices_[i];
+  }
+
+  /// Returns the size of the index in bytes.
+  std::size_t
+  size_in_bytes() const {
+    std::size_t ret = sizeof(n_)
+        + slice_popcounts_.size() * sizeof(decltype(slice_popcounts_)::value_type);
+    for (const auto& s : slices_) {
+      ret += s.size_in_bytes();
+    }
+    return ret;
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Aggregates.
+  //===--------------------------------------------------------------------===//
+  /// Returns the sum of all values.
+  u64
+  sum() const {
+    $u64 ret = 0;
+    for (std::size_t i = 0; i < slices_.size(); ++i) {
+      ret += slice_popcounts_[i] << i;
+    }
+    return ret;
+  }
+
+  /// Returns the sum of the values of the given rows.
+  template<typename F>
+  u64
+  sum(const F& filter) const {
+    $u64 ret = 0;
+    for (std::size_t i = 0; i < slices_.size(); ++i) {
+      ret += count(bitwise_and_it(
+          obtain_run_iterator<const F, run_iterator_type::SKIP>::from(filter),
+          slice_it(i))) << i;
+    }
+    return ret;
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Comparisons.
+  //===--------------------------------------------------------------------===//
+  /// Returns the rows where x == c.
+  result_type
+  eq(u64 c) const {
+    if (slices_.size() < 64 && (c >> slices_.size()) != 0) return none();
+    result_type eq = all();
+    $u64 eq_cnt = n_;
+    for (std::size_t j = slices_.size(); j > 0 && eq_cnt > 0; --j) {
+      $u64 mismatch_cnt = 0;
+      refine(eq, eq_cnt, j - 1, (c >> (j - 1)) & 1, mismatch_cnt);
+    }
+    return eq;
+  }
+
+  /// Returns the rows where x < c.
+  result_type
+  lt(u64 c) const {
+    if (c == 0) return none();
+    if (slices_.size() < 64 && (c >> slices_.size()) != 0) return all();
+    result_type lt = none();
+    result_type eq = all();
+    $u64 eq_cnt = n_;
+    for (std::size_t j = slices_.size(); j > 0 && eq_cnt > 0; --j) {
+      const auto i = j - 1;
+      const u1 bit = (c >> i) & 1;
+      if (bit) {
+        // The rows in EQ where the i-th bit is 0 qualify. They are disjoint
+        // from the rows that qualified in previous iterations.
+        result_type prev_eq = eq;
+        $u64 mismatch_cnt = 0;
+        refine(eq, eq_cnt, i, true, mismatch_cnt);
+        if (mismatch_cnt > 0) {
+          // LT OR (EQ_prev AND NOT S_i) = LT OR (EQ_prev XOR EQ)
+          lt = materialize(bitwise_or_it(lt.it(),
+              bitwise_xor_it(prev_eq.it(), eq.it())));
+        }
+      }
+      else {
+        $u64 mismatch_cnt = 0;
+        refine(eq, eq_cnt, i, false, mismatch_cnt);
+      }
+    }
+    return lt;
+  }
+
+  /// Returns the rows where x <= c.
+  result_type
+  le(u64 c) const {
+    return c == ~0ull ? all() : lt(c + 1);
+  }
+
+  /// Returns the rows where x >= c.
+  result_type
+  ge(u64 c) const {
+    const auto l = lt(c);
+    const auto a = all();
+    return materialize(bitwise_xor_it(a.it(), l.it()));
+  }
+
+  /// Returns the rows where x > c.
+  result_type
+  gt(u64 c) const {
+    return c == ~0ull ? none() : ge(c + 1);
+  }
+
+  /// Returns the rows where lo <= x <= hi.
+  result_type
+  between(u64 lo, u64 hi) const {
+    if (lo > hi) return none();
+    // The rows where x < lo are a subset of the rows where x <= hi.
+    const auto l = lt(lo);
+    const auto h = le(hi);
+    return materialize(bitwise_xor_it(h.it(), l.it()));
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Fused compare-and-count. Neither the qualifying rows nor any intermediate
+  // results are materialized.
+  //===--------------------------------------------------------------------===//
+  /// Returns the number of rows where x < c.
+  ///
+  /// The slices are traversed simultaneously in a single pass, segment by
+  /// segment. Within a segment, the bits of the relevant slices are constant.
+  /// The comparison of a segment is decided by the most significant slice
+  /// where the bit differs from c, thus the boundaries of the less significant
+  /// slices are skipped.
+  u64
+  count_lt(u64 c) const {
+    if (c == 0) return 0;
+    if (slices_.size() < 64 && (c >> slices_.size()) != 0) return n_;
+    std::vector<skip_iter_type> its;
+    its.reserve(slices_.size());
+    for (std::size_t i = 0; i < slices_.size(); ++i) {
+      its.push_back(slice_it(i));
+    }
+    $u64 cnt = 0;
+    $u64 pos = 0;
+    while (pos < n_) {
+      $u64 segment_end = n_;
+      for (std::size_t j = slices_.size(); j > 0; --j) {
+        auto& it = its[j - 1];
+        if (!it.end() && it.pos() + it.length() <= pos) it.skip_to(pos);
+        const u1 bit = !it.end() && it.pos() <= pos;
+        if (!it.end()) {
+          segment_end = std::min(segment_end,
+              u64(bit ? it.pos() + it.length() : it.pos()));
+        }
+        if (bit != ((c >> (j - 1)) & 1)) {
+          // Decided by the current slice.
+          if (!bit) cnt += segment_end - pos;
+          break;
+        }
+      }
+      pos = segment_end;
+    }
+    return cnt;
+  }
+
+  /// Returns the number of rows where x <= c.
+  u64
+  count_le(u64 c) const {
+    return c == ~0ull ? n_ : count_lt(c + 1);
+  }
+
+  /// Returns the number of rows where x >= c.
+  u64
+  count_ge(u64 c) const {
+    return n_ - count_lt(c);
+  }
+
+  /// Returns the number of rows where x > c.
+  u64
+  count_gt(u64 c) const {
+    return n_ - count_le(c);
+  }
+
+  /// Returns the number of rows where lo <= x <= hi.
+  u64
+  count_between(u64 lo, u64 hi) const {
+    if (lo > hi) return 0;
+    return count_le(hi) - count_lt(lo);
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Top-k.
+  //===--------------------------------------------------------------------===//
+  /// Returns the k rows with the largest values. Ties are broken by row ID,
+  /// i.e., rows with a smaller ID are preferred.
+  result_type
+  top_k(u64 k) const {
+    if (k >= n_) return all();
+    if (k == 0) return none();
+    // The rows that are known to be part of the result.
+    result_type g = none();
+    $u64 g_cnt = 0;
+    // The candidates (the values are equal in the slices seen so far).
+    result_type e = all();
+    $u64 e_cnt = n_;
+    for (std::size_t j = slices_.size(); j > 0; --j) {
+      const auto i = j - 1;
+      $u64 es_cnt = 0;
+      auto es = materialize(bitwise_and_it(e.it(), slice_it(i)), &es_cnt);
+      if (g_cnt + es_cnt > k) {
+        e = std::move(es);
+        e_cnt = es_cnt;
+      }
+      else if (g_cnt + es_cnt < k) {
+        g = materialize(bitwise_or_it(g.it(), es.it()));
+        g_cnt += es_cnt;
+        // E AND NOT S_i = E XOR (E AND S_i)
+        e = materialize(bitwise_xor_it(e.it(), es.it()));
+        e_cnt -= es_cnt;
+      }
+      else {
+        e = std::move(es);
+        e_cnt = es_cnt;
+        break;
+      }
+    }
+    // Add the (k - |G|) candidates with the smallest row IDs.
+    $u64 remaining = k - g_cnt;
+    result_type e_trimmed = none();
+    for (const auto& r : e.ranges_) {
+      if (remaining == 0) break;
+      const auto len = std::min(u64(r.length()), remaining);
+      e_trimmed.ranges_.emplace_back(r.begin(), len);
+      remaining -= len;
+    }
+    return materialize(bitwise_or_it(g.it(), e_trimmed.it()));
+  }
+
+  //===--------------------------------------------------------------------===//
+  static std::string
+  name() {
+    return "bsi<" + B::name() + ">";
+  }
+
+  /// Returns the index details in JSON format.
+  std::string
+  info() const {
+    return "{\"name\":\"" + name() + "\""
+        + ",\"n\":" + std::to_string(n_)
+        + ",\"slice_cnt\":" + std::to_string(slices_.size())
+        + ",\"size\":" + std::to_string(size_in_bytes())
+        + "}";
+  }
+};
+//===----------------------------------------------------------------------===//
+} // namespace dtl
@@ -1,5 +1,7 @@
 #pragma once
 //===----------------------------------------------------------------------===//
+#include "part_store.hpp"
+
 #include <dtl/bitmap/iterator.hpp>
 #include <dtl/dtl.hpp>
 #include <dtl/math.hpp>
@@ -11,6 +13,33 @@
 //===----------------------------------------------------------------------===//
 namespace dtl {
 //===----------------------------------------------------------------------===//
+/// Classifies the partitions of a partitioned bitmap.
+enum class part_kind_t : $u8 {
+  /// All bits in the partition are 0.
+  ALL_0,
+  /// All bits in the partition are 1.
+  ALL_1,
+  /// The partition contains 0's and 1's.
+  MIXED
+};
+//===----------------------------------------------------------------------===//
+/// A compact summary of a single partition (aka zone map). The positions are
+/// relative to the beginning of the partition.
+struct part_summary_t {
+  /// Marks the popcount as unknown, which is the case after updates that
+  /// cannot be reflected in the summary without accessing the partition. In
+  /// that case, the summary is conservative: the partition is considered to
+  /// be mixed, and the positions cover the entire partition.
+  static constexpr $u32 unknown_popcount = ~$u32(0);
+
+  /// The number of 1-bits.
+  $u32 popcount = 0;
+  /// The position of the first 1-bit. Undefined if the partition is all 0.
+  $u32 first = 0;
+  /// The position of the last 1-bit. Undefined if the partition is all 0.
+  $u32 last = 0;
+};
+//===----------------------------------------------------------------------===//
 /// Applies a fixed size partitioning to the given bitmap.
 template<
     /// The (compressed) bitmap type.
@@ -20,22 +49,108 @@ template<
 class part {
   static_assert(dtl::is_power_of_two(P),
       "The partition size must be a power of two.");
+  static_assert(P <= (1ull << 31),
+      "The partition size must not exceed 2^31.");
+
+public:
+  /// The storage of the (compressed) partitions.
+  using store_type = part_store<B>;
+  /// The type through which the partitions are accessed. If B has a flat
+  /// representation, this is a view over the serialized partition.
+  using part_type = typename store_type::part_type;
 
 protected:
-  /// Pointer to the partitions.
-  std::vector<std::unique_ptr<B>> parts_;
+  /// The (compressed) partitions. If B has a flat representation, the
+  /// serialized partitions are stored back-to-back in a single buffer.
+  /// Otherwise, the bitmap instances are stored in a contiguous array. In both
+  /// cases, the slots are in partition order.
+  store_type parts_;
+  /// The summaries of the partitions, which allow to skip over entire
+  /// partitions without touching the (compressed) partitions.
+  std::vector<part_summary_t> summaries_;
   /// The (total) length of the bitmap.
   std::size_t n_;
 
+  /// Determines the summary of the given (compressed) partition.
+  static part_summary_t
+  summarize(const part_type& b) {
+    part_summary_t summary;
+    auto it = b.scan_it();
+    if (!it.end()) {
+      summary.first = static_cast<$u32>(it.pos());
+    }
+    while (!it.end()) {
+      summary.popcount += static_cast<$u32>(it.length());
+      summary.last = static_cast<$u32>(it.pos() + it.length() - 1);
+      it.next();
+    }
+    return summary;
+  }
+
+  /// Updates the summary of a partition after the bit at the given position
+  /// (relative to the partition) has been set to the given value. The
+  /// partition itself is not accessed, thus it is unknown whether the bit has
+  /// actually changed. The summary remains exact if the partition was all 0
+  /// or all 1, otherwise it becomes conservative and needs to be determined
+  /// again, see refresh_summaries().
+  void __forceinline__
+  update_summary(const std::size_t part_idx, u32 pos, u1 val) noexcept {
+    auto& summary = summaries_[part_idx];
+    const auto len = static_cast<$u32>(part_length(part_idx));
+    if (summary.popcount == 0) {
+      if (val) {
+        summary.popcount = 1;
+        summary.first = pos;
+        summary.last = pos;
+      }
+    }
+    else if (summary.popcount == len) {
+      if (!val) {
+        summary.popcount = len - 1;
+        summary.first = (pos == 0) ? 1 : 0;
+        summary.last = (pos == len - 1) ? len - 2 : len - 1;
+      }
+    }
+    else {
+      summary.popcount = part_summary_t::unknown_popcount;
+      summary.first = 0;
+      summary.last = len - 1;
+    }
+  }
+
+  /// Determines the summaries again, which have become conservative due to
+  /// updates.
+  void
+  refresh_summaries() {
+    for (std::size_t p = 0; p < summaries_.size(); ++p) {
+      if (summaries_[p].popcount == part_summary_t::unknown_popcount) {
+        summaries_[p] = summarize(parts_[p]);
+      }
+    }
+  }
+
+  /// Replaces the partition with the given index and determines its summary.
+  void
+  replace_part(const std::size_t part_idx,
+      const boost::dynamic_bitset<$u32>& b) {
+    parts_.replace(part_idx, b);
+    summaries_[part_idx] = summarize(parts_[part_idx]);
+    if (parts_.is_fragmented()) {
+      parts_.compact();
+    }
+  }
+
 public:
   using bitmap_type = B;
   static constexpr std::size_t part_bitlength = P;
 
   /// C'tor (similar to all other implementations)
   explicit part(const boost::dynamic_bitset<$u32>& bitmap)
-      : parts_(), n_(bitmap.size()) {
+      : parts_(), summaries_(), n_(bitmap.size()) {
     const std::size_t part_cnt =
         (bitmap.size() + (part_bitlength - 1)) / part_bitlength;
+    parts_.reserve(part_cnt);
+    summaries_.resize(part_cnt);
 
     for (std::size_t p = 0; p < part_cnt; ++p) {
       // TODO avoid copy, or at least make it faster
@@ -45,13 +160,29 @@ public:
       auto i = (p_begin == 0)
           ? bitmap.find_first()
           : bitmap.find_next(p_begin - 1);
+      auto& summary = summaries_[p];
+      if (i < p_end && i != boost::dynamic_bitset<$u32>::npos) {
+        summary.first = static_cast<$u32>(i % part_bitlength);
+      }
       while (i < p_end && i != boost::dynamic_bitset<$u32>::npos) {
         b[i % part_bitlength] = true;
+        ++summary.popcount;
+        summary.last = static_cast<$u32>(i % part_bitlength);
         i = bitmap.find_next(i);
       }
       // Compress the current partition.
-      auto compressed_part_ptr = std::make_unique<B>(b);
-      parts_.push_back(std::move(compressed_part_ptr));
+      parts_.append(b);
+    }
+    parts_.shrink_to_fit();
+  }
+
+  /// C'tor. Constructs a partitioned bitmap from already compressed
+  /// partitions, e.g., the results of a partition-wise bitwise operation.
+  part(const std::size_t n, store_type&& parts)
+      : parts_(std::move(parts)), summaries_(parts_.size()), n_(n) {
+    assert(parts_.size() == (n_ + (part_bitlength - 1)) / part_bitlength);
+    for (std::size_t p = 0; p < parts_.size(); ++p) {
+      summaries_[p] = summarize(parts_[p]);
     }
   }
 
@@ -75,18 +206,26 @@ public:
     return n_;
   }
 
-  /// Return the size in bytes.
+  /// Return the size in bytes. Note that the size includes the partition
+  /// summaries, which were not accounted for in earlier results. The size of
+  /// the summaries is reported separately, see summaries_size_in_bytes().
   std::size_t __forceinline__
   size_in_bytes() const noexcept {
     std::size_t s = 0;
     for (std::size_t p = 0; p < parts_.size(); ++p) {
-      const auto& part_ptr = parts_[p];
-      s += part_ptr->size_in_bytes();
+      s += parts_[p].size_in_bytes();
     }
-    s += parts_.size() * sizeof(void*);
+    s += parts_.overhead_size_in_bytes();
+    s += summaries_size_in_bytes();
     return s;
   }
 
+  /// Returns the size of the partition summaries in bytes.
+  std::size_t __forceinline__
+  summaries_size_in_bytes() const noexcept {
+    return summaries_.size() * sizeof(part_summary_t);
+  }
+
   /// Returns the name of the instance including the most important parameters
   /// in JSON.
   std::string
@@ -95,6 +234,7 @@ public:
         + ",\"n\":" + std::to_string(n_)
         + ",\"part_cnt\":" + std::to_string(parts_.size())
         + ",\"size\":" + std::to_string(size_in_bytes())
+        + ",\"summaries_size\":" + std::to_string(summaries_size_in_bytes())
         + "}";
   }
 
@@ -102,13 +242,69 @@ public:
   void
   print(std::ostream& os) const noexcept {
     for (std::size_t i = 0; i < parts_.size(); ++i) {
-      os << std::setw(4) << i << ": " << *parts_[i] << std::endl;
+      os << std::setw(4) << i << ": " << parts_[i] << std::endl;
     }
   }
 
   //===--------------------------------------------------------------------===//
   // Read related functions.
   //===--------------------------------------------------------------------===//
+  /// Returns the number of partitions.
+  std::size_t __forceinline__
+  part_cnt() const noexcept {
+    return parts_.size();
+  }
+
+  /// Returns a reference to the (compressed) partition with the given index.
+  const part_type& __forceinline__
+  get_part(const std::size_t part_idx) const noexcept {
+    assert(part_idx < parts_.size());
+    return parts_[part_idx];
+  }
+
+  /// Returns the storage of the (compressed) partitions.
+  const store_type& __forceinline__
+  store() const noexcept {
+    return parts_;
+  }
+
+  /// Returns the summary of the partition with the given index. Note that the
+  /// summary might be conservative after updates, see part_summary_t.
+  const part_summary_t& __forceinline__
+  get_summary(const std::size_t part_idx) const noexcept {
+    assert(part_idx < summaries_.size());
+    return summaries_[part_idx];
+  }
+
+  /// Returns the length of the partition with the given index. Note that
+  /// the last partition might be shorter than the partition size.
+  std::size_t __forceinline__
+  part_length(const std::size_t part_idx) const noexcept {
+    return std::min(part_bitlength, n_ - (part_idx * part_bitlength));
+  }
+
+  /// Classifies the partition with the given index.
+  part_kind_t __forceinline__
+  get_kind(const std::size_t part_idx) const noexcept {
+    const auto popcount = summaries_[part_idx].popcount;
+    if (popcount == 0) return part_kind_t::ALL_0;
+    if (popcount == part_length(part_idx)) return part_kind_t::ALL_1;
+    return part_kind_t::MIXED;
+  }
+
+  /// Returns the number of 1-bits.
+  std::size_t
+  count() const noexcept {
+    std::size_t cnt = 0;
+    for (std::size_t p = 0; p < summaries_.size(); ++p) {
+      const auto popcount = summaries_[p].popcount;
+      cnt += (popcount != part_summary_t::unknown_popcount)
+          ? popcount
+          : summarize(parts_[p]).popcount;
+    }
+    return cnt;
+  }
+
   /// Returns the value of the bit at the given position.
   u1 __forceinline__
   test(const std::size_t pos) const noexcept {
@@ -117,12 +313,13 @@ public:
     //    if (part_idx >= parts_.size()) {
     //      return false;
     //    }
-    const auto& part_ptr = parts_[part_idx];
-    return part_ptr->test(pos % part_bitlength);
+    return parts_[part_idx].test(pos % part_bitlength);
   }
 
   //===--------------------------------------------------------------------===//
-  /// 1-run iterator for partitioned bitmaps.
+  /// 1-run iterator for partitioned bitmaps. The partition summaries are used
+  /// to skip over partitions which are all 0 and to avoid the instantiation
+  /// of nested iterators for partitions which are all 1.
   template<run_iterator_type iter_type>
   class iter {
     /// Reference to the outer instance.
@@ -130,14 +327,14 @@ public:
 
     /// The iterator type of the nested bitmap.
     using nested_iter_type =
-        typename obtain_run_iterator<bitmap_type, iter_type>::type;
+        typename obtain_run_iterator<part_type, iter_type>::type;
 
     // Hack to place nested iterators on heap memory.
     struct heap_iter {
       nested_iter_type iter;
 
-      heap_iter(B* bitmap)
-          : iter(obtain_run_iterator<bitmap_type, iter_type>::from(*bitmap)) {}
+      heap_iter(const part_type* bitmap)
+          : iter(obtain_run_iterator<const part_type, iter_type>::from(*bitmap)) {}
       heap_iter(const heap_iter& other) = delete;
       heap_iter(heap_iter&& other) noexcept = delete;
       heap_iter& operator=(const heap_iter& other) = delete;
@@ -150,7 +347,8 @@ public:
     //===------------------------------------------------------------------===//
     /// The current partition.
     std::size_t current_part_idx_;
-    /// The nested iterator (of the current partition).
+    /// The nested iterator (of the current partition). Null, if the current
+    /// partition is all 1.
     std::unique_ptr<heap_iter> part_iter_;
     /// Points to the beginning of a 1-fill.
     $u64 pos_;
@@ -158,36 +356,53 @@ public:
     $u64 length_;
     //===------------------------------------------------------------------===//
 
-  public:
-    explicit iter(const part& part)
-        : part_bitmap_(part),
-          current_part_idx_(0),
-          part_iter_(nullptr) {
-      // Instantiate the nested iterator.
-      while (true) {
-        auto& current_part = part_bitmap_.parts_[current_part_idx_];
-        assert(current_part != nullptr);
-        part_iter_ = std::make_unique<heap_iter>(current_part.get());
-
-        if (part_iter_->iter.end()) {
-          // The current partition is empty. Continue with the next partition,
-          // if there is any.
-          ++current_part_idx_;
-          if (current_part_idx_ == part_bitmap_.parts_.size()) {
-            // The entire bitmap is 0.
-            pos_ = part_bitmap_.n_;
-            length_ = 0;
+    /// Positions the iterator at the first 1-fill within the current or the
+    /// subsequent partitions.
+    void __forceinline__
+    seek_part() {
+      part_iter_ = nullptr;
+      const auto part_cnt = part_bitmap_.parts_.size();
+      while (current_part_idx_ < part_cnt) {
+        switch (part_bitmap_.get_kind(current_part_idx_)) {
+          case part_kind_t::ALL_0:
+            // Skip the partition.
+            ++current_part_idx_;
+            continue;
+          case part_kind_t::ALL_1:
+            // The entire partition is a single 1-fill.
+            pos_ = current_part_idx_ * part_bitlength;
+            length_ = part_bitmap_.part_length(current_part_idx_);
+            return;
+          case part_kind_t::MIXED: {
+            // Instantiate the iterator of the current partition.
+            part_iter_ = std::make_unique<heap_iter>(
+                &part_bitmap_.parts_[current_part_idx_]);
+            if (part_iter_->iter.end()) {
+              // The summary is conservative (due to updates) and the
+              // partition is actually all 0.
+              part_iter_ = nullptr;
+              ++current_part_idx_;
+              continue;
+            }
+            pos_ = (current_part_idx_ * part_bitlength) + part_iter_->iter.pos();
+            length_ = part_iter_->iter.length();
             return;
           }
-          continue;
-        }
-        else {
-          // Update the iterator state.
-          pos_ = (current_part_idx_ * part_bitlength) + part_iter_->iter.pos();
-          length_ = part_iter_->iter.length();
-          return;
         }
       }
+      // Reached the end.
+      pos_ = part_bitmap_.n_;
+      length_ = 0;
+    }
+
+  public:
+    explicit iter(const part& part)
+        : part_bitmap_(part),
+          current_part_idx_(0),
+          part_iter_(nullptr),
+          pos_(0),
+          length_(0) {
+      seek_part();
     }
 
     iter(iter&&) = default;
@@ -195,55 +410,33 @@ public:
     /// Advance to the next partition if there is any.
     void __forceinline__
     next_part() { // TODO should be private
-      part_iter_ = nullptr;
-      while (true) {
-        ++current_part_idx_;
-        if (current_part_idx_ >= part_bitmap_.parts_.size()) {
-          // Reached the end.
-          pos_ = part_bitmap_.n_;
-          length_ = 0;
-          return;
-        }
-
-        auto& current_part = part_bitmap_.parts_[current_part_idx_];
+      ++current_part_idx_;
+      seek_part();
+    }
 
-        // Instantiate the iterator of the current partition.
-        assert(current_part != nullptr);
-        part_iter_ = std::make_unique<heap_iter>(current_part.get());
-        if (part_iter_->iter.end()) {
-          // The current partition is empty. Continue with the next partition,
-          // if there is any.
-          continue;
-        }
-        else {
+    void __forceinline__
+    next() {
+      assert(!end());
+      if (part_iter_ != nullptr) {
+        assert(!part_iter_->iter.end());
+        part_iter_->iter.next();
+        if (!part_iter_->iter.end()) {
           // Update the iterator state.
           pos_ = (current_part_idx_ * part_bitlength) + part_iter_->iter.pos();
           length_ = part_iter_->iter.length();
           return;
         }
       }
-    }
-
-    void __forceinline__
-    next() {
-      assert(!end());
-      assert(part_iter_.get() != nullptr);
-      assert(!part_iter_->iter.end());
-
-      part_iter_->iter.next();
-      if (!part_iter_->iter.end()) {
-        // Update the iterator state.
-        pos_ = (current_part_idx_ * part_bitlength) + part_iter_->iter.pos();
-        length_ = part_iter_->iter.length();
-        return;
-      }
-
       // Advance to the next partition if there is any.
       next_part();
     }
 
     void __forceinline__
     skip_to(const std::size_t to_pos) {
+      if (to_pos <= pos_) {
+        // Never skip backwards.
+        return;
+      }
       if (to_pos < (pos_ + length_)) {
         length_ -= to_pos - pos_;
         pos_ = to_pos;
@@ -252,13 +445,12 @@ public:
 
       const auto dst_part = to_pos / part_bitlength;
       if (dst_part != current_part_idx_) {
-        assert(dst_part > 0);
         // Skip to the destination partition.
-        current_part_idx_ = dst_part - 1;
-        next_part();
+        current_part_idx_ = dst_part;
+        seek_part();
         // Check if we have reached the end or if we skipped over the
         // destination position.
-        if (end() || pos_ > to_pos) {
+        if (end() || pos_ >= to_pos) {
           return;
         }
       }
@@ -266,7 +458,19 @@ public:
 
       // Skip within the current partition, if necessary.
       if (pos_ < to_pos) {
-        part_iter_->iter.skip_to(to_pos % part_bitlength);
+        const auto to_part_pos = to_pos % part_bitlength;
+        if (part_iter_ == nullptr) {
+          // The current partition is all 1.
+          pos_ = to_pos;
+          length_ = part_bitmap_.part_length(current_part_idx_) - to_part_pos;
+          return;
+        }
+        if (to_part_pos > part_bitmap_.summaries_[current_part_idx_].last) {
+          // There are no more 1-bits in the current partition.
+          next_part();
+          return;
+        }
+        part_iter_->iter.skip_to(to_part_pos);
         if (!part_iter_->iter.end()) {
           // Update the iterator state.
           pos_ = (current_part_idx_ * part_bitlength) + part_iter_->iter.pos();
@@ -0,0 +1,434 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include "part.hpp"
+
+#include <dtl/bitmap/bitwise_operations.hpp>
+#include <dtl/bitmap/iterator.hpp>
+#include <dtl/bitmap/util/bitmap_fun.hpp>
+#include <dtl/dtl.hpp>
+#include <dtl/thread.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Parallel (partition-wise) bitwise operations on partitioned bitmaps.
+//
+// The partitions of two partitioned bitmaps with the same partition size and
+// the same length are aligned. Thus, a bitwise operation can be evaluated
+// independently for each pair of partitions. The partitions are distributed
+// among the threads as follows: Initially, each thread is assigned a
+// contiguous range of partitions, which it processes in small chunks. Threads
+// that run out of work steal chunks from the ranges of the other threads.
+//===----------------------------------------------------------------------===//
+namespace dtl {
+//===----------------------------------------------------------------------===//
+/// A 1-run in the output of a parallel bitwise operation.
+struct part_parallel_run_t {
+  /// The position of the first 1-bit.
+  $u64 pos;
+  /// The number of consecutive 1-bits.
+  $u64 length;
+};
+//===----------------------------------------------------------------------===//
+namespace internal {
+//===----------------------------------------------------------------------===//
+/// Distributes a range of partitions among a fixed number of threads.
+class part_work_queue {
+  /// A range of partitions owned by a single thread. The ranges are cache line
+  /// aligned to avoid false sharing.
+  struct alignas(64) range_t {
+    std::atomic<$u64> begin;
+    $u64 end;
+  };
+
+  /// The per-thread ranges.
+  std::unique_ptr<range_t[]> ranges_;
+  /// The number of threads.
+  u64 thread_cnt_;
+  /// The number of partitions that are claimed at once.
+  u64 chunk_size_;
+
+public:
+  part_work_queue(u64 part_cnt, u64 thread_cnt, u64 chunk_size)
+      : ranges_(new range_t[thread_cnt]),
+        thread_cnt_(thread_cnt),
+        chunk_size_(chunk_size) {
+    assert(thread_cnt > 0);
+    assert(chunk_size > 0);
+    const auto parts_per_thread = (part_cnt + thread_cnt - 1) / thread_cnt;
+    for (std::size_t i = 0; i < thread_cnt; ++i) {
+      ranges_[i].begin = std::min(i * parts_per_thread, part_cnt);
+      ranges_[i].end = std::min((i + 1) * parts_per_thread, part_cnt);
+    }
+  }
+
+  /// Claims the next chunk of partitions. The calling thread first consumes
+  /// its own range and then steals from the other threads. Returns false, if
+  /// there is no work left.
+  u1 __forceinline__
+  claim(u64 thread_id, $u64& part_idx_begin, $u64& part_idx_end) noexcept {
+    for (std::size_t i = 0; i < thread_cnt_; ++i) {
+      auto& r = ranges_[(thread_id + i) % thread_cnt_];
+      if (r.begin.load(std::memory_order_relaxed) >= r.end) continue;
+      const auto b = r.begin.fetch_add(chunk_size_);
+      if (b >= r.end) continue;
+      part_idx_begin = b;
+      part_idx_end = std::min(b + chunk_size_, r.end);
+      return true;
+    }
+    return false;
+  }
+};
+//===----------------------------------------------------------------------===//
+/// Determines, based on the partition summaries, whether the result of a
+/// bitwise operation is all 0 for the given pair of partitions.
+template<typename operation>
+struct part_result_is_all_0 {
+  template<typename PA, typename PB>
+  static u1 __forceinline__
+  test(const PA& a, const PB& b, const std::size_t part_idx) noexcept {
+    return a.get_kind(part_idx) == part_kind_t::ALL_0
+        && b.get_kind(part_idx) == part_kind_t::ALL_0;
+  }
+};
+template<>
+struct part_result_is_all_0<bitwise_and> {
+  template<typename PA, typename PB>
+  static u1 __forceinline__
+  test(const PA& a, const PB& b, const std::size_t part_idx) noexcept {
+    const auto& sa = a.get_summary(part_idx);
+    const auto& sb = b.get_summary(part_idx);
+    // Either one of the partitions is all 0 or the 1-bits do not overlap.
+    return sa.popcount == 0
+        || sb.popcount == 0
+        || sa.last < sb.first
+        || sb.last < sa.first;
+  }
+};
+template<>
+struct part_result_is_all_0<bitwise_xor> {
+  template<typename PA, typename PB>
+  static u1 __forceinline__
+  test(const PA& a, const PB& b, const std::size_t part_idx) noexcept {
+    const auto kind_a = a.get_kind(part_idx);
+    return kind_a != part_kind_t::MIXED && kind_a == b.get_kind(part_idx);
+  }
+};
+//===----------------------------------------------------------------------===//
+/// Evaluates the given bitwise operation for each pair of aligned partitions
+/// in parallel. The callback 'fn' is invoked with the thread id, the
+/// partition index and the (bitwise) run iterator of that partition. Note that the positions produced
+/// by the iterator are relative to the beginning of the partition. Partitions
+/// for which the result is known to be all 0, based on the partition
+/// summaries, are not evaluated; instead 'empty_fn' is invoked (with the thread
+/// id and the partition index).
+template<
+    typename operation,
+    run_iterator_type iter_type,
+    typename BA,
+    typename BB,
+    std::size_t P,
+    typename Fn,
+    typename EmptyFn>
+void
+part_parallel_bitwise(const part<BA, P>& a, const part<BB, P>& b,
+    u64 thread_cnt, Fn fn, EmptyFn empty_fn) {
+  assert(a.size() == b.size());
+  assert(a.part_cnt() == b.part_cnt());
+  using part_ta = const typename part<BA, P>::part_type;
+  using part_tb = const typename part<BB, P>::part_type;
+  using iter_ta = typename obtain_run_iterator<part_ta, iter_type>::type;
+  using iter_tb = typename obtain_run_iterator<part_tb, iter_type>::type;
+  using iter_t = bitwise_iter<iter_ta, iter_tb, operation>;
+
+  const auto part_cnt = a.part_cnt();
+  const auto t_cnt = std::max(u64(1), std::min(thread_cnt, u64(part_cnt)));
+  part_work_queue queue(part_cnt, t_cnt, std::max(u64(1), part_cnt / (t_cnt * 16)));
+
+  auto thread_fn = [&](u32 thread_id) {
+    $u64 part_idx_begin = 0;
+    $u64 part_idx_end = 0;
+    while (queue.claim(thread_id, part_idx_begin, part_idx_end)) {
+      for (std::size_t p = part_idx_begin; p < part_idx_end; ++p) {
+        if (part_result_is_all_0<operation>::test(a, b, p)) {
+          empty_fn(thread_id, p);
+          continue;
+        }
+        iter_t it(
+            obtain_run_iterator<part_ta, iter_type>::from(a.get_part(p)),
+            obtain_run_iterator<part_tb, iter_type>::from(b.get_part(p)));
+        fn(thread_id, p, it);
+      }
+    }
+  };
+  if (t_cnt == 1) {
+    thread_fn(0);
+  }
+  else {
+    dtl::run_in_parallel(thread_fn, dtl::this_thread::get_cpu_affinity(),
+        t_cnt);
+  }
+}
+//===----------------------------------------------------------------------===//
+/// Decodes the given (bitwise) run iterator into a plain bitmap of length P.
+template<std::size_t P, typename It>
+boost::dynamic_bitset<$u32>
+part_parallel_decode(It& it) {
+  boost::dynamic_bitset<$u32> bm(P);
+  while (!it.end()) {
+#ifndef BOOST_DYNAMIC_BITSET_DONT_USE_FRIENDS
+    for (std::size_t i = it.pos(); i < it.pos() + it.length(); ++i) {
+      bm[i] = true;
+    }
+#else
+    // HACK: This gives access to the private members of the boost::dynamic_bitset.
+    dtl::bitmap_fun<$u32>::set(bm.m_bits.data(),
+        it.pos(), it.pos() + it.length());
+#endif
+    it.next();
+  }
+  return bm;
+}
+//===----------------------------------------------------------------------===//
+/// Collects the resulting partitions of a parallel bitwise operation. The
+/// resulting partitions are constructed in place in a pre-allocated
+/// (uninitialized) array, i.e., without a heap allocation per partition.
+/// Afterwards, they are moved into the store, which only transfers the
+/// ownership of the encoded data.
+template<typename B, std::size_t P, u1 is_flat = part_flat_traits<B>::value>
+class part_parallel_result {
+  using slot_t = typename std::aligned_storage<sizeof(B), alignof(B)>::type;
+  std::size_t part_cnt_;
+  std::unique_ptr<slot_t[]> slots_;
+
+  B*
+  slot(const std::size_t part_idx) {
+    return reinterpret_cast<B*>(&slots_[part_idx]);
+  }
+
+public:
+  part_parallel_result(std::size_t part_cnt, u64 /* thread_cnt */)
+      : part_cnt_(part_cnt), slots_(new slot_t[part_cnt]) {}
+
+  /// Compresses and stores the given partition. Thread-safe, as long as each
+  /// partition is stored exactly once.
+  void
+  store(u32 /* thread_id */, const std::size_t part_idx,
+      const boost::dynamic_bitset<$u32>& bm) {
+    new (slot(part_idx)) B(bm);
+  }
+
+  /// Moves the resulting partitions (in partition order) into a store.
+  part_store<B>
+  finalize() {
+    std::vector<B> parts;
+    parts.reserve(part_cnt_);
+    for (std::size_t p = 0; p < part_cnt_; ++p) {
+      parts.push_back(std::move(*slot(p)));
+      slot(p)->~B();
+    }
+    return part_store<B>(std::move(parts));
+  }
+};
+/// Collects the resulting partitions of a parallel bitwise operation, for
+/// bitmap types with a flat representation. Each thread serializes its
+/// partitions into a thread-local buffer. Afterwards, the serialized
+/// partitions are concatenated in partition order into a single buffer.
+template<typename B, std::size_t P>
+class part_parallel_result<B, P, true> {
+  using traits = part_flat_traits<B>;
+  using word_type = typename traits::word_type;
+
+  /// The location of a serialized partition.
+  struct location_t {
+    $u32 thread_id;
+    $u32 word_cnt;
+    std::size_t offset;
+  };
+  /// A thread-local buffer. The buffers are cache line aligned to avoid false
+  /// sharing.
+  struct alignas(64) buffer_t {
+    std::vector<word_type> words;
+  };
+
+  std::vector<location_t> locations_;
+  std::unique_ptr<buffer_t[]> buffers_;
+  u64 thread_cnt_;
+
+public:
+  part_parallel_result(std::size_t part_cnt, u64 thread_cnt)
+      : locations_(part_cnt),
+        buffers_(new buffer_t[thread_cnt]),
+        thread_cnt_(thread_cnt) {}
+
+  /// Compresses and stores the given partition. Thread-safe, as long as each
+  /// partition is stored exactly once.
+  void
+  store(u32 thread_id, const std::size_t part_idx,
+      const boost::dynamic_bitset<$u32>& bm) {
+    auto& words = buffers_[thread_id].words;
+    const auto offset = words.size();
+    traits::serialize(bm, words);
+    locations_[part_idx] = location_t {
+        thread_id, static_cast<$u32>(words.size() - offset), offset};
+  }
+
+  /// Concatenates the serialized partitions (in partition order) into a
+  /// single buffer.
+  part_store<B>
+  finalize() {
+    std::size_t word_cnt = 0;
+    for (std::size_t t = 0; t < thread_cnt_; ++t) {
+      word_cnt += buffers_[t].words.size();
+    }
+    part_store<B> parts;
+    parts.reserve(locations_.size());
+    parts.reserve_words(word_cnt);
+    for (auto& loc : locations_) {
+      parts.append_serialized(
+          buffers_[loc.thread_id].words.data() + loc.offset, loc.word_cnt);
+    }
+    return parts;
+  }
+};
+//===----------------------------------------------------------------------===//
+/// Evaluates the given bitwise operation in parallel. The result is a new
+/// partitioned bitmap (of the same type as the first operand).
+template<
+    typename operation,
+    run_iterator_type iter_type,
+    typename BA,
+    typename BB,
+    std::size_t P>
+part<BA, P>
+part_parallel_bitwise_part(const part<BA, P>& a, const part<BB, P>& b,
+    u64 thread_cnt) {
+  const std::size_t part_cnt = a.part_cnt();
+  const auto t_cnt = std::max(u64(1), std::min(thread_cnt, u64(part_cnt)));
+  part_parallel_result<BA, P> result(part_cnt, t_cnt);
+  part_parallel_bitwise<operation, iter_type>(a, b, t_cnt,
+      [&](u32 thread_id, const std::size_t part_idx, auto& it) {
+        result.store(thread_id, part_idx, part_parallel_decode<P>(it));
+      },
+      [&](u32 thread_id, const std::size_t part_idx) {
+        result.store(thread_id, part_idx, boost::dynamic_bitset<$u32>(P));
+      });
+  return part<BA, P>(a.size(), result.finalize());
+}
+//===----------------------------------------------------------------------===//
+/// Evaluates the given bitwise operation in parallel. The result is the
+/// concatenation of the 1-runs of all partitions. Runs that span over
+/// partition boundaries are merged.
+template<
+    typename operation,
+    run_iterator_type iter_type,
+    typename BA,
+    typename BB,
+    std::size_t P>
+std::vector<part_parallel_run_t>
+part_parallel_bitwise_runs(const part<BA, P>& a, const part<BB, P>& b,
+    u64 thread_cnt) {
+  std::vector<std::vector<part_parallel_run_t>> part_runs(a.part_cnt());
+  part_parallel_bitwise<operation, iter_type>(a, b, thread_cnt,
+      [&](u32 /* thread_id */, const std::size_t part_idx, auto& it) {
+        auto& runs = part_runs[part_idx];
+        u64 offset = part_idx * P;
+        while (!it.end()) {
+          runs.push_back(part_parallel_run_t {offset + it.pos(), it.length()});
+          it.next();
+        }
+      },
+      [](u32 /* thread_id */, const std::size_t /* part_idx */) {
+        // Nothing to do.
+      });
+
+  // Concatenate the partial results.
+  std::size_t run_cnt = 0;
+  for (auto& runs : part_runs) {
+    run_cnt += runs.size();
+  }
+  std::vector<part_parallel_run_t> ret;
+  ret.reserve(run_cnt);
+  for (auto& runs : part_runs) {
+    for (auto& r : runs) {
+      if (!ret.empty() && ret.back().pos + ret.back().length == r.pos) {
+        ret.back().length += r.length;
+      }
+      else {
+        ret.push_back(r);
+      }
+    }
+  }
+  return ret;
+}
+//===----------------------------------------------------------------------===//
+} // namespace internal
+//===----------------------------------------------------------------------===//
+/// Returns the default number of threads used by the parallel operations.
+static inline u64
+part_parallel_default_thread_cnt() {
+  return dtl::this_thread::get_cpu_affinity().count();
+}
+//===----------------------------------------------------------------------===//
+/// Computes the bitwise AND of the two (aligned) partitioned bitmaps in
+/// parallel.
+template<typename BA, typename BB, std::size_t P>
+part<BA, P>
+parallel_and(const part<BA, P>& a, const part<BB, P>& b,
+    u64 thread_cnt = part_parallel_default_thread_cnt()) {
+  return internal::part_parallel_bitwise_part<
+      internal::bitwise_and, run_iterator_type::SKIP>(a, b, thread_cnt);
+}
+/// Computes the bitwise OR of the two (aligned) partitioned bitmaps in
+/// parallel.
+template<typename BA, typename BB, std::size_t P>
+part<BA, P>
+parallel_or(const part<BA, P>& a, const part<BB, P>& b,
+    u64 thread_cnt = part_parallel_default_thread_cnt()) {
+  return internal::part_parallel_bitwise_part<
+      internal::bitwise_or, run_iterator_type::SCAN>(a, b, thread_cnt);
+}
+/// Computes the bitwise XOR of the two (aligned) partitioned bitmaps in
+/// parallel.
+template<typename BA, typename BB, std::size_t P>
+part<BA, P>
+parallel_xor(const part<BA, P>& a, const part<BB, P>& b,
+    u64 thread_cnt = part_parallel_default_thread_cnt()) {
+  return internal::part_parallel_bitwise_part<
+      internal::bitwise_xor, run_iterator_type::SCAN>(a, b, thread_cnt);
+}
+//===----------------------------------------------------------------------===//
+/// Computes the bitwise AND of the two (aligned) partitioned bitmaps in
+/// parallel and returns the resulting 1-runs.
+template<typename BA, typename BB, std::size_t P>
+std::vector<part_parallel_run_t>
+parallel_and_runs(const part<BA, P>& a, const part<BB, P>& b,
+    u64 thread_cnt = part_parallel_default_thread_cnt()) {
+  return internal::part_parallel_bitwise_runs<
+      internal::bitwise_and, run_iterator_type::SKIP>(a, b, thread_cnt);
+}
+/// Computes the bitwise OR of the two (aligned) partitioned bitmaps in
+/// parallel and returns the resulting 1-runs.
+template<typename BA, typename BB, std::size_t P>
+std::vector<part_parallel_run_t>
+parallel_or_runs(const part<BA, P>& a, const part<BB, P>& b,
+    u64 thread_cnt = part_parallel_default_thread_cnt()) {
+  return internal::part_parallel_bitwise_runs<
+      internal::bitwise_or, run_iterator_type::SCAN>(a, b, thread_cnt);
+}
+/// Computes the bitwise XOR of the two (aligned) partitioned bitmaps in
+/// parallel and returns the resulting 1-runs.
+template<typename BA, typename BB, std::size_t P>
+std::vector<part_parallel_run_t>
+parallel_xor_runs(const part<BA, P>& a, const part<BB, P>& b,
+    u64 thread_cnt = part_parallel_default_thread_cnt()) {
+  return internal::part_parallel_bitwise_runs<
+      internal::bitwise_xor, run_iterator_type::SCAN>(a, b, thread_cnt);
+}
+//===----------------------------------------------------------------------===//
+} // namespace dtl
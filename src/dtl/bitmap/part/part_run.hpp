@@ -1,6 +1,9 @@
 #pragma once
 //===----------------------------------------------------------------------===//
+#include "part_store.hpp"
+
 #include <dtl/bitmap/iterator.hpp>
+#include <dtl/bitmap/util/convert.hpp>
 #include <dtl/dtl.hpp>
 #include <dtl/math.hpp>
 
@@ -22,102 +25,126 @@ class part_run {
   static_assert(dtl::is_power_of_two(P),
       "The partition size must be a power of two.");
 
-  /// Encapsulate a partition pointer. Note that partitions which only consist
-  /// of 0's or 1's do not have a bitmap instance on the heap memory. Instead
-  /// the pointer is tagged to indicate whether the the partition is 'single-
-  /// valued'. In that case the 2nd most significant bit of the tagged pointer
-  /// contains the actual (partition-wide) value.
-  struct part_ptr_t {
-    static constexpr auto ptr_tag_mask =
-        uintptr_t(1) << ((sizeof(uintptr_t) * 8) - 1);
-    static constexpr auto value_mask =
-        uintptr_t(1) << ((sizeof(uintptr_t) * 8) - 2);
-
-    /// The tagged pointer. False by default.
-    B* ptr;
-
-    /// C'tor
-    inline part_ptr_t() : ptr(reinterpret_cast<B*>(ptr_tag_mask)) {}
-    inline part_ptr_t(const part_ptr_t& other) = delete;
-    inline part_ptr_t(part_ptr_t&& other) noexcept
-        : ptr(std::move(other.ptr)) {
-      other.ptr = nullptr;
-    }
-    inline part_ptr_t& operator=(const part_ptr_t& other) = delete;
-    inline part_ptr_t& operator=(part_ptr_t&& other) noexcept {
-      ptr = other.ptr;
-      other.ptr = nullptr;
-    };
+  /// Encapsulates a reference to a partition. Note that partitions which only
+  /// consist of 0's or 1's do not have a bitmap instance. Instead the
+  /// reference is tagged to indicate whether the partition is 'single-valued'.
+  /// In that case the 2nd most significant bit of the tagged reference
+  /// contains the actual (partition-wide) value. Otherwise, the reference
+  /// is the index of the slot within the arena.
+  struct part_ref_t {
+    static constexpr $u32 tag_mask = $u32(1) << 31;
+    static constexpr $u32 value_mask = $u32(1) << 30;
 
-    /// D'tor
-    inline ~part_ptr_t() {
-      if (is_pointer() && ptr != nullptr) {
-        delete ptr;
-      }
-    }
+    /// The tagged reference. False by default.
+    $u32 ref = tag_mask;
 
-    /// Returns true if the tagged pointer actually is a pointer, false
+    /// Returns true if the tagged reference actually is an index, false
     /// otherwise.
     inline u1
-    is_pointer() const noexcept {
-      return (reinterpret_cast<uintptr_t>(ptr) & ptr_tag_mask) == 0;
+    is_index() const noexcept {
+      return (ref & tag_mask) == 0;
     }
 
-    /// Returns the pointer to the partition.
-    inline B*
-    get_pointer() const noexcept {
-      assert(is_pointer());
-      return ptr;
+    /// Returns the index of the partition within the arena.
+    inline u32
+    get_index() const noexcept {
+      assert(is_index());
+      return ref;
     }
 
-    /// Sets the pointer. (transfers ownership)
+    /// Sets the index.
     inline void
-    set_pointer(B* p) noexcept {
-      ptr = p;
-      assert(is_pointer());
+    set_index(u32 idx) noexcept {
+      assert((idx & tag_mask) == 0);
+      ref = idx;
     }
 
-    /// Returns true if the tagged pointer is actually a boolean value, false
+    /// Returns true if the tagged reference is actually a boolean value, false
     /// otherwise.
     inline u1
     is_value() const noexcept {
-      return !is_pointer();
+      return !is_index();
     }
 
-    /// Returns the boolean value (which is encoded in this tagged pointer).
+    /// Returns the boolean value (which is encoded in this tagged reference).
     inline u1
     get_value() const noexcept {
       assert(is_value());
-      return (reinterpret_cast<uintptr_t>(ptr) & value_mask) != 0;
+      return (ref & value_mask) != 0;
     }
 
     /// Sets the boolean value.
     inline void
     set_value(u1 val) noexcept {
-      assert(is_value() || ptr == nullptr); // otherwise we would leak memory
-      if (val == true) {
-        ptr = reinterpret_cast<B*>(ptr_tag_mask | value_mask);
-      }
-      else {
-        ptr = reinterpret_cast<B*>(ptr_tag_mask);
-      }
+      ref = val ? (tag_mask | value_mask) : tag_mask;
     }
   };
 
-  /// Pointer to the partitions.
-  std::vector<part_ptr_t> parts_;
+public:
+  /// The storage of the (compressed) partitions.
+  using store_type = part_store<B>;
+  /// The type through which the partitions are accessed. If B has a flat
+  /// representation, this is a view over the serialized partition.
+  using part_type = typename store_type::part_type;
+
+private:
+  /// The references to the partitions.
+  std::vector<part_ref_t> parts_;
+  /// The (compressed) partitions that are neither all 0 nor all 1. If B has a
+  /// flat representation, the serialized partitions are stored back-to-back
+  /// in a single buffer. Otherwise, the bitmap instances are stored in a
+  /// contiguous array. After construction and after each compaction, the
+  /// slots are in partition order.
+  store_type arena_;
   /// The (total) length of the bitmap.
   std::size_t n_;
 
+  /// Adds the given partition to the arena. The partition is appended to the
+  /// arena, thus, the arena is no longer in partition order until the next
+  /// compaction.
+  void
+  install(std::size_t part_idx, const boost::dynamic_bitset<$u32>& b) {
+    const auto arena_idx = arena_.append(b);
+    parts_[part_idx].set_index(static_cast<$u32>(arena_idx));
+  }
+
+  /// Removes the given partition from the arena. The slot becomes garbage,
+  /// which is removed by the next compaction.
+  void
+  release(u32 arena_idx) {
+    arena_.release(arena_idx);
+  }
+
+  /// Rebuilds the arena in partition order and removes the garbage. The
+  /// partition references are updated accordingly.
+  void
+  compact() {
+    std::vector<$u32> order;
+    order.reserve(arena_.size());
+    $u1 is_ordered = true;
+    for (auto& part_ref : parts_) {
+      if (part_ref.is_index()) {
+        const auto arena_idx = part_ref.get_index();
+        is_ordered &= (arena_idx == order.size());
+        part_ref.set_index(static_cast<$u32>(order.size()));
+        order.push_back(arena_idx);
+      }
+    }
+    if (is_ordered && !arena_.has_garbage()) return;
+    arena_.compact(order);
+  }
+
 public:
   using bitmap_type = B;
   static constexpr std::size_t part_bitlength = P;
 
   /// C'tor (similar to all other implementations)
   explicit part_run(const boost::dynamic_bitset<$u32>& bitmap)
-      : parts_(), n_(bitmap.size()) {
+      : parts_(), arena_(), n_(bitmap.size()) {
     const std::size_t part_cnt =
         (bitmap.size() + (part_bitlength - 1)) / part_bitlength;
+    parts_.reserve(part_cnt);
+    arena_.reserve(part_cnt);
 
     for (std::size_t p = 0; p < part_cnt; ++p) {
       // TODO avoid copy
@@ -133,23 +160,24 @@ public:
       }
       // Compress the current partition.
       parts_.emplace_back();
-      auto& part_ptr = parts_.back();
+      auto& part_ref = parts_.back();
       const std::size_t b_count = b.count();
       if (b_count == 0) {
-        assert(part_ptr.is_value());
-        assert(part_ptr.get_value() == false);
-        // Nothing to do here, because the part_ptr is by default false.
+        assert(part_ref.is_value());
+        assert(part_ref.get_value() == false);
+        // Nothing to do here, because the part_ref is by default false.
       }
       else if (b_count == part_bitlength) {
-        assert(part_ptr.is_value());
-        part_ptr.set_value(true);
-        assert(part_ptr.get_value() == true);
+        assert(part_ref.is_value());
+        part_ref.set_value(true);
+        assert(part_ref.get_value() == true);
       }
       else {
-        B* compressed_part = new B(b);
-        part_ptr.set_pointer(compressed_part);
+        install(p, b);
       }
     }
+    // Release the unused capacity.
+    arena_.shrink_to_fit();
   }
 
   part_run(const part_run& other) = delete;
@@ -172,20 +200,28 @@ public:
     return n_;
   }
 
-  /// Return the size in bytes.
+  /// Return the size in bytes. Note that the size includes the partition
+  /// references, which were not accounted for in earlier results. Their size
+  /// is reported separately, see refs_size_in_bytes().
   std::size_t __forceinline__
   size_in_bytes() const noexcept {
     std::size_t s = 0;
-    for (std::size_t p = 0; p < parts_.size(); ++p) {
-      const auto& part_ptr = parts_[p];
-      if (part_ptr.is_pointer()) {
-        s += part_ptr.get_pointer()->size_in_bytes();
+    for (std::size_t i = 0; i < parts_.size(); ++i) {
+      if (parts_[i].is_index()) {
+        s += arena_[parts_[i].get_index()].size_in_bytes();
       }
     }
-    s += parts_.size() * sizeof(part_ptr_t);
+    s += arena_.overhead_size_in_bytes();
+    s += refs_size_in_bytes();
     return s;
   }
 
+  /// Returns the size of the partition references in bytes.
+  std::size_t __forceinline__
+  refs_size_in_bytes() const noexcept {
+    return parts_.size() * sizeof(part_ref_t);
+  }
+
   /// Returns the name of the instance including the most important parameters
   /// in JSON.
   std::string
@@ -194,6 +230,7 @@ public:
         + ",\"n\":" + std::to_string(n_)
         + ",\"part_cnt\":" + std::to_string(parts_.size())
         + ",\"size\":" + std::to_string(size_in_bytes())
+        + ",\"refs_size\":" + std::to_string(refs_size_in_bytes())
         + "}";
   }
 
@@ -202,8 +239,8 @@ public:
   print(std::ostream& os) const noexcept {
     for (std::size_t i = 0; i < parts_.size(); ++i) {
       os << std::setw(4) << i << ": ";
-      if (parts_[i].is_pointer()) {
-        os << *parts_[i].get_pointer() << std::endl;
+      if (parts_[i].is_index()) {
+        os << arena_[parts_[i].get_index()] << std::endl;
       }
       else {
         if (parts_[i].get_value()) {
@@ -216,6 +253,12 @@ public:
     }
   }
 
+  /// Returns the storage of the (compressed) partitions.
+  const store_type& __forceinline__
+  store() const noexcept {
+    return arena_;
+  }
+
   //===--------------------------------------------------------------------===//
   // Read related functions.
   //===--------------------------------------------------------------------===//
@@ -227,11 +270,11 @@ public:
 //    if (part_idx >= parts_.size()) {
 //      return false;
 //    }
-    const auto& part_ptr = parts_[part_idx];
-    if (part_ptr.is_value()) {
-      return part_ptr.get_value();
+    const auto& part_ref = parts_[part_idx];
+    if (part_ref.is_value()) {
+      return part_ref.get_value();
     }
-    return part_ptr.get_pointer()->test(pos % part_bitlength);
+    return arena_[part_ref.get_index()].test(pos % part_bitlength);
   }
 
   //===--------------------------------------------------------------------===//
@@ -243,14 +286,14 @@ public:
 
     /// The iterator type of the nested bitmap.
     using nested_iter_type =
-        typename obtain_run_iterator<bitmap_type, iter_type>::type;
+        typename obtain_run_iterator<part_type, iter_type>::type;
 
     // Hack to place nested iterators on heap memory.
     struct heap_iter {
       nested_iter_type iter;
 
-      heap_iter(B* bitmap)
-          : iter(obtain_run_iterator<bitmap_type, iter_type>::from(*bitmap)) {}
+      heap_iter(const part_type* bitmap)
+          : iter(obtain_run_iterator<const part_type, iter_type>::from(*bitmap)) {}
       heap_iter(const heap_iter& other) = delete;
       heap_iter(heap_iter&& other) noexcept = delete;
       heap_iter& operator=(const heap_iter& other) = delete;
@@ -298,9 +341,9 @@ public:
       // Instantiate the iterator of the current partition.
       while (true) {
         auto& current_part = part_bitmap_.parts_[current_part_idx_];
-        assert(current_part.is_pointer());
-        assert(current_part.get_pointer() != nullptr);
-        part_iter_ = std::make_unique<heap_iter>(current_part.get_pointer());
+        assert(current_part.is_index());
+        part_iter_ = std::make_unique<heap_iter>(
+            &part_bitmap_.arena_[current_part.get_index()]);
 
         if (part_iter_->iter.end()) {
           // The current partition contains a bitmap, but seems to be empty.
@@ -353,9 +396,9 @@ public:
         }
         else {
           // Instantiate the iterator of the current partition.
-          assert(current_part.is_pointer());
-          assert(current_part.get_pointer() != nullptr);
-          part_iter_ = std::make_unique<heap_iter>(current_part.get_pointer());
+          assert(current_part.is_index());
+          part_iter_ = std::make_unique<heap_iter>(
+              &part_bitmap_.arena_[current_part.get_index()]);
           if (part_iter_->iter.end()) {
             // The current partition contains a bitmap, but seems to be empty.
             // Continue with the next partition, if there is any.
@@ -397,6 +440,10 @@ public:
 
     void __forceinline__
     skip_to(const std::size_t to_pos) {
+      if (to_pos <= pos_) {
+        // Never skip backwards.
+        return;
+      }
       if (to_pos < (pos_ + length_)) {
         length_ -= to_pos - pos_;
         pos_ = to_pos;
@@ -483,13 +530,13 @@ public:
     auto& current_part = parts_[part_idx];
     // Helper function to decompress a partition.
     auto decompress = [&]() {
-      if (current_part.is_pointer()) {
-        B* b = current_part.get_pointer();
-        auto dec = dtl::to_bitmap_using_iterator(*b);
+      if (current_part.is_index()) {
+        auto dec = dtl::to_bitmap_using_iterator(
+            arena_[current_part.get_index()]);
         return std::move(dec);
       }
       else {
-        boost::dynamic_bitset<$u32> dec(n_);
+        boost::dynamic_bitset<$u32> dec(part_bitlength);
         if (current_part.get_value() == true) {
           dec.flip();
         }
@@ -499,19 +546,22 @@ public:
     };
     // Helper function to compress a partition.
     auto compress_and_install = [&](boost::dynamic_bitset<$u32>& b) {
-      // Delete outdated bitmap (if exists).
-      if (current_part.is_pointer()) {
-        delete current_part.get_pointer();
-        current_part.set_pointer(nullptr);
-      }
       // Is it a single-run partition?
       const auto b_count = b.count();
       if (b_count == 0 || b_count == part_bitlength) {
+        // Release the outdated bitmap (if exists).
+        if (current_part.is_index()) {
+          release(current_part.get_index());
+        }
         current_part.set_value(b_count == part_bitlength);
       }
+      else if (current_part.is_index()) {
+        // Compress and replace the outdated bitmap.
+        arena_.replace(current_part.get_index(), b);
+      }
       else {
         // Compress.
-        current_part.set_pointer(new B(b));
+        install(part_idx, b);
       }
     };
 
@@ -521,6 +571,17 @@ public:
     dec[i % part_bitlength] = val;
     // Re-compress and install.
     compress_and_install(dec);
+    if (arena_.is_fragmented()) {
+      compact();
+    }
+  }
+
+  /// Restores the partition order of the arena and removes the garbage that
+  /// was left behind by updates.
+  template<typename M>
+  void __forceinline__
+  merge() {
+    compact();
   }
 };
 //===----------------------------------------------------------------------===//
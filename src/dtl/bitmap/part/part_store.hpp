@@ -0,0 +1,398 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include <dtl/dtl.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Storage of the (compressed) partitions of partitioned bitmaps.
+//
+// A partition is stored in a slot. If the bitmap type has a flat (serialized)
+// representation, the serialized partitions are stored back-to-back in a
+// single buffer, which is indexed by arrays of 32-bit offsets and lengths, and
+// the
+// partitions are accessed through (read-only) views over that buffer. Thus,
+// all partitions live in a single allocation and the entire buffer can be
+// serialized with a single memcpy. Otherwise, the bitmap instances are stored
+// in a contiguous array and each instance owns its encoded data.
+//
+// Slots are never moved individually. Replaced or released slots leave a gap
+// (garbage), which is removed when the store is compacted. Compaction
+// re-arranges the slots in the given order, e.g., in partition order.
+//===----------------------------------------------------------------------===//
+namespace dtl {
+//===----------------------------------------------------------------------===//
+/// Determines whether the bitmap type B has a flat (serialized)
+/// representation. Specializations need to provide the following members:
+///  - word_type: The word type of the serialized representation.
+///  - view_type: A read-only bitmap type that operates on a serialized
+///    instance, which is not owned by the view.
+///  - serialize(bitmap, dst): Encodes the given plain bitmap and appends the
+///    serialized representation to dst.
+///  - view(ptr): Returns a view over the serialized instance at ptr.
+template<typename B>
+struct part_flat_traits {
+  static constexpr u1 value = false;
+};
+//===----------------------------------------------------------------------===//
+/// Stores the partitions as bitmap instances in a contiguous array.
+template<typename B, u1 is_flat = part_flat_traits<B>::value>
+class part_store {
+  /// The bitmap instances.
+  std::vector<B> slots_;
+  /// The number of released slots.
+  std::size_t released_cnt_ = 0;
+
+public:
+  /// The type through which the partitions are accessed.
+  using part_type = B;
+
+  part_store() = default;
+
+  /// C'tor. Takes the ownership of the given bitmap instances.
+  explicit part_store(std::vector<B>&& slots)
+      : slots_(std::move(slots)), released_cnt_(0) {}
+
+  part_store(const part_store& other) = delete;
+  part_store(part_store&& other) noexcept = default;
+  part_store& operator=(const part_store& other) = delete;
+  part_store& operator=(part_store&& other) noexcept = default;
+
+  /// Returns the number of slots (including the released ones).
+  std::size_t __forceinline__
+  size() const noexcept {
+    return slots_.size();
+  }
+
+  /// Returns the partition in the given slot.
+  const part_type& __forceinline__
+  operator[](const std::size_t slot_idx) const noexcept {
+    assert(slot_idx < slots_.size());
+    return slots_[slot_idx];
+  }
+
+  /// Returns the (mutable) partition in the given slot. Only supported by
+  /// the non-flat storage.
+  B& __forceinline__
+  get_mutable(const std::size_t slot_idx) noexcept {
+    assert(slot_idx < slots_.size());
+    return slots_[slot_idx];
+  }
+
+  /// Reserves space for the given number of slots.
+  void
+  reserve(const std::size_t slot_cnt) {
+    slots_.reserve(slot_cnt);
+  }
+
+  /// Compresses the given plain bitmap and appends it to a new slot. Returns
+  /// the index of that slot.
+  std::size_t
+  append(const boost::dynamic_bitset<$u32>& b) {
+    slots_.emplace_back(b);
+    return slots_.size() - 1;
+  }
+
+  /// Replaces the partition in the given slot.
+  void
+  replace(const std::size_t slot_idx, const boost::dynamic_bitset<$u32>& b) {
+    slots_[slot_idx] = B(b);
+  }
+
+  /// Releases the given slot. The slot stays occupied until the store is
+  /// compacted.
+  void
+  release(const std::size_t slot_idx) {
+    assert(slot_idx < slots_.size());
+    ++released_cnt_;
+  }
+
+  /// Returns true if there are released slots.
+  u1 __forceinline__
+  has_garbage() const noexcept {
+    return released_cnt_ > 0;
+  }
+
+  /// Returns true if more than half of the slots are garbage.
+  u1 __forceinline__
+  is_fragmented() const noexcept {
+    return released_cnt_ * 2 > slots_.size();
+  }
+
+  /// Re-arranges the slots in the given order. Slots that are not referenced
+  /// are dropped.
+  void
+  compact(const std::vector<$u32>& order) {
+    std::vector<B> slots;
+    slots.reserve(order.size());
+    for (auto slot_idx : order) {
+      slots.push_back(std::move(slots_[slot_idx]));
+    }
+    std::swap(slots_, slots);
+    released_cnt_ = 0;
+  }
+
+  /// Removes the garbage, if any. The order of the slots is retained.
+  void
+  compact() {
+    // The slots are replaced in place. Thus, there is no garbage.
+    assert(released_cnt_ == 0);
+  }
+
+  /// Try to reduce the memory consumption.
+  void
+  shrink_to_fit() {
+    slots_.shrink_to_fit();
+  }
+
+  /// Returns the size of the bookkeeping data in bytes, i.e., the memory that
+  /// is not accounted for by the partitions themselves.
+  std::size_t __forceinline__
+  overhead_size_in_bytes() const noexcept {
+    return 0;
+  }
+};
+//===----------------------------------------------------------------------===//
+/// Stores the serialized partitions back-to-back in a single buffer.
+template<typename B>
+class part_store<B, true> {
+  using traits = part_flat_traits<B>;
+  using word_type = typename traits::word_type;
+
+public:
+  /// The type through which the partitions are accessed.
+  using part_type = typename traits::view_type;
+
+private:
+  /// The serialized partitions.
+  std::vector<word_type> buffer_;
+  /// The offsets (in words) of the serialized partitions within the buffer.
+  std::vector<$u32> offsets_;
+  /// The lengths (in words) of the serialized partitions.
+  std::vector<$u32> lengths_;
+  /// The views over the serialized partitions.
+  std::vector<part_type> views_;
+  /// The number of words in the buffer that are no longer referenced.
+  std::size_t garbage_word_cnt_ = 0;
+  /// The number of released slots.
+  std::size_t released_cnt_ = 0;
+
+  /// Re-creates the views, which is necessary when the buffer has been
+  /// re-allocated.
+  void
+  refresh_views() {
+    views_.clear();
+    views_.reserve(offsets_.capacity());
+    for (auto offset : offsets_) {
+      views_.push_back(traits::view(buffer_.data() + offset));
+    }
+  }
+
+  /// Re-creates the view of the given slot.
+  void
+  refresh_view(const std::size_t slot_idx) {
+    auto* view = &views_[slot_idx];
+    view->~part_type();
+    new (view) part_type(traits::view(buffer_.data() + offsets_[slot_idx]));
+  }
+
+  /// Serializes the given plain bitmap and appends it to the buffer. Returns
+  /// the offset of the serialized partition and sets its length. The views
+  /// are re-created if the buffer has been re-allocated.
+  $u32
+  append_to_buffer(const boost::dynamic_bitset<$u32>& b, $u32& length) {
+    const auto offset = buffer_.size();
+    const auto* data = buffer_.data();
+    traits::serialize(b, buffer_);
+    assert(buffer_.size() <= std::numeric_limits<$u32>::max());
+    if (buffer_.data() != data) {
+      refresh_views();
+    }
+    length = static_cast<$u32>(buffer_.size() - offset);
+    return static_cast<$u32>(offset);
+  }
+
+public:
+  part_store() = default;
+
+  part_store(const part_store& other) = delete;
+  part_store(part_store&& other) noexcept = default;
+  part_store& operator=(const part_store& other) = delete;
+  part_store& operator=(part_store&& other) noexcept = default;
+
+  /// Returns the number of slots (including the released ones).
+  std::size_t __forceinline__
+  size() const noexcept {
+    return offsets_.size();
+  }
+
+  /// Returns the partition in the given slot.
+  const part_type& __forceinline__
+  operator[](const std::size_t slot_idx) const noexcept {
+    assert(slot_idx < views_.size());
+    return views_[slot_idx];
+  }
+
+  /// Reserves space for the given number of slots.
+  void
+  reserve(const std::size_t slot_cnt) {
+    offsets_.reserve(slot_cnt);
+    lengths_.reserve(slot_cnt);
+    views_.reserve(slot_cnt);
+  }
+
+  /// Reserves space for the given number of words in the buffer.
+  void
+  reserve_words(const std::size_t word_cnt) {
+    if (word_cnt > buffer_.capacity()) {
+      buffer_.reserve(word_cnt);
+      refresh_views();
+    }
+  }
+
+  /// Compresses the given plain bitmap and appends it to a new slot. Returns
+  /// the index of that slot.
+  std::size_t
+  append(const boost::dynamic_bitset<$u32>& b) {
+    $u32 length = 0;
+    offsets_.push_back(append_to_buffer(b, length));
+    lengths_.push_back(length);
+    views_.push_back(traits::view(buffer_.data() + offsets_.back()));
+    return offsets_.size() - 1;
+  }
+
+  /// Appends an already serialized partition to a new slot. Returns the index
+  /// of that slot.
+  std::size_t
+  append_serialized(const word_type* ptr, const std::size_t word_cnt) {
+    const auto offset = buffer_.size();
+    const auto* data = buffer_.data();
+    buffer_.insert(buffer_.end(), ptr, ptr + word_cnt);
+    assert(buffer_.size() <= std::numeric_limits<$u32>::max());
+    if (buffer_.data() != data) {
+      refresh_views();
+    }
+    offsets_.push_back(static_cast<$u32>(offset));
+    lengths_.push_back(static_cast<$u32>(word_cnt));
+    views_.push_back(traits::view(buffer_.data() + offset));
+    return offsets_.size() - 1;
+  }
+
+  /// Replaces the partition in the given slot. The new partition is appended
+  /// to the buffer; the space of the old one becomes garbage.
+  void
+  replace(const std::size_t slot_idx, const boost::dynamic_bitset<$u32>& b) {
+    garbage_word_cnt_ += lengths_[slot_idx];
+    offsets_[slot_idx] = append_to_buffer(b, lengths_[slot_idx]);
+    refresh_view(slot_idx);
+  }
+
+  /// Releases the given slot. The slot stays occupied until the store is
+  /// compacted.
+  void
+  release(const std::size_t slot_idx) {
+    garbage_word_cnt_ += lengths_[slot_idx];
+    ++released_cnt_;
+  }
+
+  /// Returns true if there are released or replaced slots.
+  u1 __forceinline__
+  has_garbage() const noexcept {
+    return garbage_word_cnt_ > 0 || released_cnt_ > 0;
+  }
+
+  /// Returns true if more than half of the buffer or of the slots are
+  /// garbage.
+  u1 __forceinline__
+  is_fragmented() const noexcept {
+    return garbage_word_cnt_ * 2 > buffer_.size()
+        || released_cnt_ * 2 > offsets_.size();
+  }
+
+  /// Re-arranges the slots in the given order. Slots that are not referenced
+  /// are dropped. Afterwards, the serialized partitions are stored
+  /// back-to-back in that order.
+  void
+  compact(const std::vector<$u32>& order) {
+    std::size_t word_cnt = 0;
+    for (auto slot_idx : order) {
+      word_cnt += lengths_[slot_idx];
+    }
+    std::vector<word_type> buffer;
+    buffer.reserve(word_cnt);
+    std::vector<$u32> offsets;
+    offsets.reserve(order.size());
+    std::vector<$u32> lengths;
+    lengths.reserve(order.size());
+    for (auto slot_idx : order) {
+      const auto* ptr = buffer_.data() + offsets_[slot_idx];
+      offsets.push_back(static_cast<$u32>(buffer.size()));
+      lengths.push_back(lengths_[slot_idx]);
+      buffer.insert(buffer.end(), ptr, ptr + lengths_[slot_idx]);
+    }
+    std::swap(buffer_, buffer);
+    std::swap(offsets_, offsets);
+    std::swap(lengths_, lengths);
+    garbage_word_cnt_ = 0;
+    released_cnt_ = 0;
+    refresh_views();
+  }
+
+  /// Removes the garbage, if any. The order of the slots is retained.
+  void
+  compact() {
+    if (!has_garbage()) return;
+    std::vector<$u32> order(offsets_.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      order[i] = static_cast<$u32>(i);
+    }
+    compact(order);
+  }
+
+  /// Try to reduce the memory consumption.
+  void
+  shrink_to_fit() {
+    buffer_.shrink_to_fit();
+    offsets_.shrink_to_fit();
+    lengths_.shrink_to_fit();
+    // Note: The views must not be copied, as they may refer to the old buffer.
+    views_.clear();
+    views_.shrink_to_fit();
+    refresh_views();
+  }
+
+  /// Returns the serialized partitions.
+  const std::vector<word_type>& __forceinline__
+  buffer() const noexcept {
+    return buffer_;
+  }
+
+  /// Returns the offset (in words) of the given slot within the buffer.
+  u32 __forceinline__
+  offset(const std::size_t slot_idx) const noexcept {
+    assert(slot_idx < offsets_.size());
+    return offsets_[slot_idx];
+  }
+
+  /// Returns the length (in words) of the given slot.
+  u32 __forceinline__
+  length(const std::size_t slot_idx) const noexcept {
+    assert(slot_idx < lengths_.size());
+    return lengths_[slot_idx];
+  }
+
+  /// Returns the size of the bookkeeping data in bytes, i.e., the memory that
+  /// is not accounted for by the partitions themselves.
+  std::size_t __forceinline__
+  overhead_size_in_bytes() const noexcept {
+    return (offsets_.size() + lengths_.size()) * sizeof($u32);
+  }
+};
+//===----------------------------------------------------------------------===//
+} // namespace dtl
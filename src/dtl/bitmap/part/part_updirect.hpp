@@ -3,6 +3,7 @@
 #include "part.hpp"
 
 #include <dtl/bitmap/iterator.hpp>
+#include <dtl/bitmap/util/convert.hpp>
 #include <dtl/dtl.hpp>
 #include <dtl/math.hpp>
 
@@ -44,18 +45,19 @@ public:
   set(std::size_t i, u1 val) noexcept {
     const auto part_idx = i / P;
     // Decompress the partition.
-    auto dec = dtl::to_bitmap_using_iterator(*this->parts_[part_idx]);
+    auto dec = dtl::to_bitmap_using_iterator(this->parts_[part_idx]);
     // Apply the update.
     dec[i % P] = val;
     // Re-compress and install the partition.
-    auto compressed_part_ptr = std::make_unique<B>(dec);
-    std::swap(compressed_part_ptr, this->parts_[part_idx]);
+    this->replace_part(part_idx, dec);
   }
 
-  /// Does nothing. Just for compatibility reasons.
+  /// Removes the garbage that was left behind by replaced partitions.
   template<typename M>
   void __forceinline__
-  merge() {}
+  merge() {
+    this->parts_.compact();
+  }
 };
 //===----------------------------------------------------------------------===//
 } // namespace dtl
@@ -45,7 +45,9 @@ public:
   set(std::size_t i, u1 val) noexcept {
     // Forward the call.
     const auto part_idx = i / P;
-    this->parts_[part_idx]->set(i % P, val);
+    const auto part_pos = static_cast<$u32>(i % P);
+    this->parts_.get_mutable(part_idx).set(part_pos, val);
+    this->update_summary(part_idx, part_pos, val);
   }
 
   /// Apply the pending updates and clear the diff.
@@ -53,8 +55,9 @@ public:
   void
   merge() {
     for (std::size_t part_idx = 0; part_idx < this->parts_.size(); ++part_idx) {
-      this->parts_[part_idx]->template merge<M>();
+      this->parts_.get_mutable(part_idx).template merge<M>();
     }
+    this->refresh_summaries();
   }
 };
 //===----------------------------------------------------------------------===//
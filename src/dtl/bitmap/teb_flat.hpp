@@ -1,5 +1,6 @@
 #pragma once
 //===----------------------------------------------------------------------===//
+#include "teb_stats.hpp"
 #include "teb_types.hpp"
 #include "util/binary_tree_structure.hpp"
 #include "util/bitmap_fun.hpp"
@@ -11,14 +12,16 @@
 //===----------------------------------------------------------------------===//
 namespace dtl {
 //===----------------------------------------------------------------------===//
-class teb_iter;
+template<u1 _label>
+class teb_run_iter;
 class teb_scan_iter;
 class teb_wrapper;
 //===----------------------------------------------------------------------===//
 /// The TEB logic that is used to access a serialized TEB.
 class teb_flat {
 public: // TODO remove
-  friend class teb_iter;
+  template<u1 _label>
+  friend class teb_run_iter;
   friend class teb_scan_iter;
   friend class teb_wrapper;
 
@@ -248,6 +251,7 @@ public:
 
     auto i = tree_height_ - 1 - level;
     while (!is_leaf_node(node_idx)) {
+      __teb_stats__(visit(tree_height_ - 1 - i));
       u1 direction_bit = dtl::bits::bit_test(pos, i);
       node_idx = 2 * rank_inclusive(node_idx) - 1; // left child
       node_idx += direction_bit; // right child if bit is set, left child otherwise
@@ -324,11 +328,19 @@ public: // TODO revert
     }
     assert(tree_bit_cnt_ > 0);
     const auto i = std::min(node_idx - implicit_1bit_cnt, tree_bit_cnt_ - 1);
+    __teb_stats__(rank_call(&rank_lut_ptr_[i / rank_type::block_bitlength]));
     const auto r = rank_type::get(rank_lut_ptr_, i, tree_ptr_);
     const auto ret_val = implicit_1bit_cnt + r;
     return ret_val;
   }
 
+  /// Computes the (exclusive) rank of the given tree node, i.e., the number
+  /// of inner nodes that precede the given node in level order.
+  size_type __teb_inline__
+  rank_exclusive(size_type node_idx) const noexcept {
+    return node_idx == 0 ? 0 : rank_inclusive(node_idx - 1);
+  }
+
   /// Returns true if the given node is an inner node, false otherwise.
   u1 __teb_inline__
   is_inner_node(size_type node_idx) const noexcept {
@@ -361,6 +373,7 @@ public: // TODO revert
   /// Returns the label at index.
   u1 __teb_inline__
   get_label_by_idx(size_type label_idx) const noexcept {
+    __teb_stats__(label_lookups++);
     const auto implicit_leading_label_cnt = implicit_leading_label_cnt_;
     const auto implicit_trailing_labels_begin =
         label_bit_cnt_ + implicit_leading_label_cnt;
@@ -6,15 +6,21 @@
 #include <dtl/dtl.hpp>
 #include <dtl/static_stack.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <ostream>
 #include <string>
 //===----------------------------------------------------------------------===//
 namespace dtl {
 //===----------------------------------------------------------------------===//
-/// A 1-run iterator for TEBs with efficient skip support.
-class teb_iter {
+/// A run iterator for TEBs with efficient skip support. The template
+/// parameter refers to the label of the leaf nodes the iterator produces, i.e.,
+/// the iterator either produces the 1-fills (default) or the 0-fills.
+template<u1 _label = true>
+class teb_run_iter {
   static constexpr u32 optimization_level_ = 3; // TODO remove
+  /// The label of the fills to produce.
+  static constexpr u1 label_ = _label;
 
   /// The fundamental type to encode paths within the tree.
   using path_t = $u64;
@@ -65,7 +71,7 @@ public:
   /// Constructs an iterator for the given TEB instance. After construction,
   /// the iterator points to the first 1-fill.
   explicit __teb_inline__
-  teb_iter(const teb_flat& teb) noexcept
+  teb_run_iter(const teb_flat& teb) noexcept
       : teb_(teb),
         tree_height_(dtl::teb_util::determine_tree_height(teb.n_)),
         perfect_levels_(teb.perfect_level_cnt_),
@@ -83,14 +89,28 @@ public:
     next();
   }
 
-  teb_iter(teb_iter&&) noexcept = default;
+  teb_run_iter(teb_run_iter&&) noexcept = default;
+
+  /// The padding bits beyond n_actual_ are 0-bits. Thus, 0-fills need to be
+  /// clipped to the actual bitmap size.
+  void __forceinline__
+  clip() noexcept {
+    if (label_) return;
+    if (pos_ >= teb_.n_actual_) {
+      pos_ = teb_.n_actual_;
+      length_ = 0;
+      return;
+    }
+    length_ = std::min(length_, $u64(teb_.n_actual_ - pos_));
+  }
 
   /// Forwards the iterator to the next top node that is either an inner node
-  /// or a leaf node with a 1-label.
+  /// or a leaf node with the desired label.
   void __teb_inline__
   next_top_node() {
     stack_entry& next_node = stack_.push();
     while (++top_node_idx_current_ < top_node_idx_end_) {
+      __teb_stats__(visit(perfect_levels_ - 1));
       const auto is_inner = 0ull + teb_.is_inner_node(top_node_idx_current_);
       const auto rank = teb_.rank_inclusive(top_node_idx_current_);
       if (is_inner) {
@@ -105,10 +125,11 @@ public:
       }
       else {
         // Check label.
-        // We don't want to have leaf nodes with a 0-label on the stack.
+        // We don't want to have leaf nodes with a different label on the
+        // stack.
         const auto label_idx = top_node_idx_current_ - rank;
         const auto label = teb_.get_label_by_idx(label_idx);
-        if (label) {
+        if (label == label_) {
           next_node.node_idx = top_node_idx_current_;
           next_node.path = path_t(top_node_idx_current_ - top_node_idx_begin_);
           // Set the sentinel bit.
@@ -122,222 +143,6 @@ public:
     }
   }
 
-  /// Forwards the iterator to the next 1-fill (if any).
-  /// Use the functions pos() and length() to get the 1-fill the iterator
-  /// is currently pointing to.
-  void __teb_inline__
-  next_off() noexcept __attribute__((flatten, hot)) {
-    while (top_node_idx_current_ < top_node_idx_end_) {
-    outer_loop_begin:
-      while (!stack_.empty()) {
-        // The current node.
-        stack_entry node_info = stack_.top();
-        stack_.pop();
-
-        $u1 label;
-        while (teb_.is_inner_node(node_info.node_idx)) {
-        loop_begin:
-          label = false;
-          // Determine left and right child. - Both exist, because the tree
-          // is full binary.
-          // Note: If the current node is an inner node, the rank is always
-          //       required.
-          u64 right_child_idx = 2 * node_info.rank;
-          u64 left_child_idx = right_child_idx - 1;
-
-          // Determine whether the children are inner or leaf nodes.
-          const auto right_child_is_inner = 0
-              + teb_.is_inner_node(right_child_idx);
-          const auto left_child_is_inner = 0
-              + teb_.is_inner_node(left_child_idx);
-          const auto children_are_inner = (left_child_is_inner << 1) | right_child_is_inner; // TODO fetch both bits in one go
-
-          // Compute the rank for one child, and derive the rank of the
-          // other one.
-          // Rank is required to compute the label index.
-          u64 left_child_rank = teb_.rank_inclusive(left_child_idx);
-          u64 left_child_label_idx = left_child_idx - left_child_rank
-              + left_child_is_inner; // prevent underflow
-          u64 right_child_label_idx = left_child_label_idx + 1
-              - left_child_is_inner; // adjust index if necessary
-
-          //          // TODO Eagerly fetch the labels.
-          //          u1 left_child_label = teb_.get_label_by_idx(left_child_label_idx);
-          //          u1 right_child_label = teb_.get_label_by_idx(right_child_label_idx);
-
-          // Switch over the different cases.
-          switch (children_are_inner) {
-            case 0b00: {
-              //===------------------------------------------------------===//
-              // Both childs are leaf nodes.
-              //===------------------------------------------------------===//
-
-              // Note for UN-optimized TEBs the following holds:
-              //   One child has a 1-label the other has
-              //   a 0-label, which is guaranteed by the bottom-up pruning.
-              //   Thus, right_label == !left_label.
-              //
-              // However, gradual decompression (optimization level >= 2) may
-              // expand nodes and replicate labels. Thus, the sub-tree is no
-              // longer guaranteed to be 'compressed', and therefore, both
-              // labels need to be inspected.
-
-              // Fetch the labels.
-              u1 left_child_label = teb_.get_label_by_idx(left_child_label_idx);
-              u1 right_child_label = teb_.get_label_by_idx(right_child_label_idx);
-
-              if (optimization_level_ < 2) {
-                // Go to the node which has the 1-label.
-                node_info.node_idx = left_child_label ? left_child_idx : right_child_idx;
-                node_info.path = (node_info.path << 1) | !left_child_label;
-                node_info.level++;
-                node_info.rank = left_child_rank;
-                goto produce_output;
-              }
-              else {
-                // The price we pay for better compression ratios.
-                u64 both_labels = 2 * left_child_label + right_child_label;
-                switch (both_labels) {
-                  case 0b00: {
-                    goto outer_loop_begin;
-                  }
-                  case 0b01: {
-                    node_info.node_idx = right_child_idx;
-                    node_info.path = (node_info.path << 1) | 1;
-                    node_info.level++;
-                    node_info.rank = left_child_rank + 1;
-                    goto produce_output;
-                  }
-                  case 0b10: {
-                    node_info.node_idx = left_child_idx;
-                    node_info.path <<= 1;
-                    node_info.level++;
-                    node_info.rank = left_child_rank;
-                    goto produce_output;
-                  }
-                  case 0b11: {
-                    goto produce_output;
-                  }
-                }
-              }
-            }
-            case 0b01: {
-              //===------------------------------------------------------===//
-              // Left child is a leaf, right child is an inner node.
-              //===------------------------------------------------------===//
-              // Determine whether the left child produces an output
-              // (label = 1).
-              u1 left_child_label = teb_.get_label_by_idx(left_child_label_idx);
-
-              // Derive rank of the right child.  The following works, because
-              // the left child is leaf (0-bit) and the right is inner (1-bit).
-              u64 right_child_rank = left_child_rank + 1;
-
-              if (left_child_label) {
-                // Produce the output for the left child iff it has a 1-label,
-                // otherwise it can be ignored.
-                node_info.node_idx = left_child_idx;
-                //                label = true; // TODO remove
-                node_info.path <<= 1;
-                node_info.rank = left_child_rank;
-                node_info.level++;
-                // Push the right child on the stack.
-                stack_entry& right_child_info = stack_.push();
-                right_child_info.node_idx = right_child_idx;
-                right_child_info.path = node_info.path | 1;
-                right_child_info.level = node_info.level;
-                right_child_info.rank = right_child_rank;
-                goto produce_output;
-              }
-              // Else, go to right child, ignoring the left child.
-              node_info.node_idx = right_child_idx;
-              node_info.path = (node_info.path << 1) | 1;
-              node_info.level++;
-              node_info.rank = right_child_rank;
-              goto loop_begin;
-            }
-            case 0b10: {
-              //===------------------------------------------------------===//
-              // Left child is an inner node, right child is a leaf node.
-              //===------------------------------------------------------===//
-
-              // Determine whether the right child produces an output
-              // (label = 1).
-              u1 right_child_label = teb_.get_label_by_idx(right_child_label_idx);
-              if (right_child_label) { // FIXME DEP
-                // Push the right child on the stack iff it has a 1-label,
-                // otherwise the right child is ignored.
-                stack_entry& right_child_info = stack_.push();
-                right_child_info.node_idx = right_child_idx;
-                right_child_info.path = (node_info.path << 1) | 1;
-                right_child_info.level = node_info.level + 1;
-                // Rank of the right child is equal to the rank of the left
-                // child.
-                u64 right_child_rank = left_child_rank;
-                right_child_info.rank = right_child_rank;
-              }
-              // Go to left child.
-              node_info.node_idx = left_child_idx;
-              node_info.path <<= 1;
-              node_info.level++;
-              node_info.rank = left_child_rank;
-              goto loop_begin;
-            }
-            case 0b11: {
-              //===------------------------------------------------------===//
-              // Both children are an inner nodes.
-              //===------------------------------------------------------===//
-
-              u64 right_child_rank = left_child_rank + 1;
-              // Go to left child.
-              node_info.node_idx = left_child_idx;
-              node_info.path <<= 1;
-              node_info.level++;
-              node_info.rank = left_child_rank;
-              // Push the right child on the stack.
-              stack_entry& right_child_info = stack_.push();
-              right_child_info.node_idx = right_child_idx;
-              right_child_info.path = node_info.path | 1;
-              right_child_info.level = node_info.level;
-              right_child_info.rank = right_child_rank;
-              goto loop_begin;
-            }
-            default:
-              __builtin_unreachable();
-          }
-        }
-        // Reached a leaf node.
-        label = teb_.get_label_by_idx(node_info.node_idx - node_info.rank);
-        if (label) {
-        produce_output:
-          // Produce output (a 1-fill).
-          //          const auto lz_cnt_path = dtl::bits::lz_count(node_info.path);
-          //          const auto level = sizeof(path_t) * 8 - 1 - lz_cnt_path;
-          const auto level = node_info.level;
-          // Toggle sentinel bit (= highest bit set) and add offset.
-          pos_ = (node_info.path ^ (1ull << level)) << (tree_height_ - level);
-          // The length of the 1-fill.
-          length_ = teb_.n_ >> level;
-          node_idx_ = node_info.node_idx;
-          path_ = node_info.path;
-          return;
-        }
-      }
-
-      // TODO bypass the stack here
-      ++top_node_idx_current_;
-      stack_entry& next_node = stack_.push();
-      next_node.node_idx = top_node_idx_current_;
-      next_node.path = path_t(top_node_idx_current_ - top_node_idx_begin_);
-      // Set the sentinel bit.
-      next_node.path |= path_t(1) << (perfect_levels_ - 1);
-      next_node.level = perfect_levels_ - 1;
-      next_node.rank = teb_.rank_inclusive(top_node_idx_current_);
-    }
-    pos_ = teb_.n_actual_;
-    length_ = 0;
-  }
-
   void __teb_inline__
   next() noexcept __attribute__((flatten, hot)) {
     assert(!end());
@@ -346,6 +151,7 @@ public:
         // The current node.
         stack_entry node_info = stack_.top();
         stack_.pop();
+        __teb_stats__(visit(node_info.level));
         $u1 node_label = node_info.is_inner == 0;
 
         while (node_info.is_inner) {
@@ -373,7 +179,7 @@ public:
 
           // Eagerly fetch the labels.
           u1 left_child_label = teb_.get_label_by_idx(left_child_label_idx);
-          node_label = left_child_label;
+          node_label = left_child_label == label_;
           u1 right_child_label = teb_.get_label_by_idx(right_child_label_idx);
 
           // Push right child on the stack and go to left child.
@@ -382,8 +188,10 @@ public:
           node_info.level++;
           node_info.rank = left_child_rank;
           node_info.is_inner = left_child_is_inner;
+          __teb_stats__(visit(node_info.level));
           // Push the right child only if necessary.
-          u1 push_right_child = (right_child_is_inner | right_child_label);
+          u1 push_right_child =
+              (right_child_is_inner | (right_child_label == label_));
           stack_entry& right_child_info = stack_.push();
           right_child_info.node_idx = right_child_idx;
           right_child_info.path = node_info.path | 1;
@@ -402,6 +210,7 @@ public:
           length_ = teb_.n_ >> level;
           node_idx_ = node_info.node_idx;
           path_ = node_info.path;
+          clip();
           return;
         }
       }
@@ -416,6 +225,7 @@ public:
   /// Navigate to the desired position, starting from the trees' root node.
   void __teb_inline__
   nav_from_root_to(const std::size_t to_pos) noexcept {
+    __teb_stats__(nav_from_root_calls++);
     //===------------------------------------------------------------------===//
     // (Re-)initialize the iterator state.
     stack_.clear();
@@ -443,12 +253,13 @@ public:
     auto rank = teb_.rank_inclusive(node_idx_);
     std::size_t i = tree_height_ - level - 1;
     while (true) {
+      __teb_stats__(visit(level));
       // First check, if this is already a leaf node.
       if (teb_.is_leaf_node(node_idx_)) {
         // Reached the desired position.
         const auto label_idx = node_idx_ - rank;
         const auto label = teb_.get_label_by_idx(label_idx);
-        if (label) {
+        if (label == label_) {
           // Found the corresponding leaf node.
           // Toggle sentinel bit (= highest bit set) and add offset.
           pos_ = (path_ ^ (1ull << level)) << (tree_height_ - level);
@@ -457,6 +268,7 @@ public:
           // Adjust the current position and fill-length.
           length_ -= to_pos - pos_;
           pos_ = to_pos;
+          clip();
           return;
         }
         else {
@@ -476,10 +288,12 @@ public:
       const auto right_child_is_inner = teb_.is_inner_node(right_child_idx);
       const auto left_child_rank = right_child_rank - right_child_is_inner;
       level++;
+      __teb_stats__(descent_steps++);
       if (!direction_bit) {
         // Push the right child only if necessary.
         if (right_child_is_inner
-            || teb_.get_label_by_idx(right_child_idx - right_child_rank)) {
+            || teb_.get_label_by_idx(right_child_idx - right_child_rank)
+                == label_) {
           stack_entry& right_child_info = stack_.push();
           right_child_info.node_idx = right_child_idx;
           right_child_info.path = (path_ << 1) | 1;
@@ -509,6 +323,7 @@ public:
   nav_to(const std::size_t to_pos) noexcept {
     assert(to_pos >= pos_ + length_);
     assert(perfect_levels_ > 0);
+    __teb_stats__(nav_to_calls++);
     // Fast path.  If the skip distance is larger than the range spanned by
     // the current subtree, we immediately start navigating downwards from the
     // root node.  Thus, we do not need to compute the common ancestor node.
@@ -578,6 +393,7 @@ public:
         return;
       }
       stack_.pop();
+      __teb_stats__(climb_steps++);
     }
     node_idx_ = node_idx;
     path_ = path;
@@ -707,4 +523,9 @@ public:
   }
 };
 //===----------------------------------------------------------------------===//
+/// A 1-run iterator for TEBs with efficient skip support.
+using teb_iter = teb_run_iter<true>;
+/// A 0-run iterator for TEBs with efficient skip support.
+using teb_zero_iter = teb_run_iter<false>;
+//===----------------------------------------------------------------------===//
 } // namespace dtl
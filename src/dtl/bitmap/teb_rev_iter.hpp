@@ -0,0 +1,274 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include "teb_flat.hpp"
+#include "teb_util.hpp"
+
+#include <dtl/dtl.hpp>
+#include <dtl/static_stack.hpp>
+
+#include <algorithm>
+#include <cassert>
+//===----------------------------------------------------------------------===//
+namespace dtl {
+//===----------------------------------------------------------------------===//
+/// A reverse 1-run iterator for TEBs. The iterator produces the 1-runs in
+/// descending order, starting with the last one. The positions and lengths
+/// refer to the original bitmap, i.e., the current 1-run is
+/// [pos(), pos() + length()).
+///
+/// The tree is traversed in a mirrored pre-order, i.e., the right sub-tree is
+/// visited before the left sub-tree, and the top nodes are visited from right
+/// to left.
+class teb_rev_iter {
+  /// The fundamental type to encode paths within the tree.
+  using path_t = $u64;
+
+  struct stack_entry {
+    $u64 node_idx;
+    path_t path;
+    $u64 rank;
+    $u64 level;
+    $u64 is_inner;
+  };
+
+  /// Reference to the TEB instance.
+  const teb_flat& teb_;
+  /// The height of the tree structure.
+  u64 tree_height_;
+  /// The number of perfect levels in the tree structure.
+  u64 perfect_levels_;
+  /// First node index in the last perfect level.
+  u64 top_node_idx_begin_;
+  /// Last node index + 1 in the last perfect level.
+  u64 top_node_idx_end_;
+  /// The current top node. The top nodes are exhausted when the current top
+  /// node is the first one and the stack is empty.
+  $u64 top_node_idx_current_;
+  /// The stack contains the tree nodes that need to be visited.
+  static_stack<stack_entry, 32> stack_;
+  /// Points to the beginning of the current 1-fill.
+  $u64 pos_;
+  /// The length of the current 1-fill.
+  $u64 length_;
+
+  /// Pushes the given top node on the stack, if it is an inner node or a leaf
+  /// node with a 1-label.
+  void __teb_inline__
+  push_top_node(u64 node_idx) noexcept {
+    __teb_stats__(visit(perfect_levels_ - 1));
+    const auto is_inner = 0ull + teb_.is_inner_node(node_idx);
+    const auto rank = teb_.rank_inclusive(node_idx);
+    if (!is_inner && !teb_.get_label_by_idx(node_idx - rank)) {
+      // We don't want to have leaf nodes with a 0-label on the stack.
+      return;
+    }
+    stack_entry& node = stack_.push();
+    node.node_idx = node_idx;
+    node.path = path_t(node_idx - top_node_idx_begin_);
+    // Set the sentinel bit.
+    node.path |= path_t(1) << (perfect_levels_ - 1);
+    node.level = perfect_levels_ - 1;
+    node.rank = rank;
+    node.is_inner = is_inner;
+  }
+
+  /// Moves to the preceding top node that is either an inner node or a leaf
+  /// node with a 1-label.
+  void __teb_inline__
+  prev_top_node() noexcept {
+    while (stack_.empty() && top_node_idx_current_ != top_node_idx_begin_) {
+      --top_node_idx_current_;
+      push_top_node(top_node_idx_current_);
+    }
+  }
+
+  /// Sets the current 1-fill to the given leaf node. Returns false, if the
+  /// 1-fill lies entirely within the padding of the tree.
+  u1 __teb_inline__
+  produce_output(const path_t path, u64 level, u64 limit) noexcept {
+    // Toggle sentinel bit (= highest bit set) and add offset.
+    const $u64 b = (path ^ (1ull << level)) << (tree_height_ - level);
+    const $u64 e = std::min($u64(b + (teb_.n_ >> level)), limit);
+    if (b >= e) return false;
+    pos_ = b;
+    length_ = e - b;
+    return true;
+  }
+
+public:
+  /// Constructs a reverse iterator for the given TEB instance. After
+  /// construction, the iterator points to the last 1-fill.
+  explicit __teb_inline__
+  teb_rev_iter(const teb_flat& teb) noexcept
+      : teb_(teb),
+        tree_height_(dtl::teb_util::determine_tree_height(teb.n_)),
+        perfect_levels_(teb.perfect_level_cnt_),
+        top_node_idx_begin_((1ull << (teb.perfect_level_cnt_ - 1)) - 1),
+        top_node_idx_end_((1ull << teb.perfect_level_cnt_) - 1),
+        top_node_idx_current_((1ull << teb.perfect_level_cnt_) - 1),
+        pos_(teb.n_actual_),
+        length_(0) {
+    prev();
+  }
+
+  teb_rev_iter(teb_rev_iter&&) noexcept = default;
+
+  /// Moves the iterator to the preceding 1-fill (if any).
+  void __teb_inline__
+  prev() noexcept __attribute__((flatten, hot)) {
+    while (true) {
+      // Push the preceding top node on the stack (if necessary).
+      prev_top_node();
+      if (stack_.empty()) break;
+      // The current node.
+      stack_entry node_info = stack_.top();
+      stack_.pop();
+      __teb_stats__(visit(node_info.level));
+      $u1 node_label = node_info.is_inner == 0;
+
+      while (node_info.is_inner) {
+        // Determine left and right child. - Both exist, because the tree
+        // is full binary.
+        u64 right_child_idx = 2 * node_info.rank;
+        u64 left_child_idx = right_child_idx - 1;
+
+        // Determine whether the children are inner or leaf nodes.
+        const auto right_child_is_inner = 0ull
+            + teb_.is_inner_node(right_child_idx);
+        const auto left_child_is_inner = 0ull
+            + teb_.is_inner_node(left_child_idx);
+
+        // Compute the rank for one child, and derive the rank of the
+        // other one.
+        u64 left_child_rank = teb_.rank_inclusive(left_child_idx);
+        u64 right_child_rank = left_child_rank + right_child_is_inner;
+
+        // Determine the label indices in L.
+        u64 left_child_label_idx = left_child_idx - left_child_rank
+            + left_child_is_inner; // prevent underflow
+        u64 right_child_label_idx = left_child_label_idx + 1
+            - left_child_is_inner; // adjust index if necessary
+
+        // Eagerly fetch the labels.
+        u1 left_child_label = teb_.get_label_by_idx(left_child_label_idx);
+        u1 right_child_label = teb_.get_label_by_idx(right_child_label_idx);
+        node_label = right_child_label;
+
+        // Push left child on the stack and go to right child.
+        stack_entry& left_child_info = stack_.push();
+        left_child_info.node_idx = left_child_idx;
+        left_child_info.path = node_info.path << 1;
+        left_child_info.level = node_info.level + 1;
+        left_child_info.rank = left_child_rank;
+        left_child_info.is_inner = left_child_is_inner;
+        // Keep the left child only if necessary.
+        u1 push_left_child = (left_child_is_inner | left_child_label);
+        stack_.cnt_ = push_left_child ? stack_.cnt_ : stack_.cnt_ - 1;
+
+        node_info.node_idx = right_child_idx;
+        node_info.path = (node_info.path << 1) | 1;
+        node_info.level++;
+        node_info.rank = right_child_rank;
+        node_info.is_inner = right_child_is_inner;
+        __teb_stats__(visit(node_info.level));
+      }
+      // Reached a leaf node.
+      if (node_label
+          && produce_output(node_info.path, node_info.level, teb_.n_actual_)) {
+        return;
+      }
+    }
+    pos_ = teb_.n_actual_;
+    length_ = 0;
+  }
+
+  /// Moves the iterator backwards, such that the current 1-fill ends at or
+  /// before the given position (inclusive). The 1-fill is clipped if the
+  /// given position is within the current 1-fill. The iterator navigates from
+  /// the root node of the corresponding top node to the destination.
+  void __teb_inline__
+  skip_back_to(const std::size_t to_pos) noexcept {
+    if (end() || to_pos + 1 >= pos_ + length_) {
+      return;
+    }
+    if (to_pos >= pos_) {
+      length_ = to_pos + 1 - pos_;
+      return;
+    }
+    __teb_stats__(nav_from_root_calls++);
+    // (Re-)initialize the iterator state.
+    stack_.clear();
+    $u64 level = perfect_levels_ - 1;
+    const auto top_node_offset = to_pos >> (tree_height_ - level);
+    path_t path = (path_t(1) << level) | top_node_offset;
+    top_node_idx_current_ = top_node_idx_begin_ + top_node_offset;
+    $u64 node_idx = top_node_idx_current_;
+    __teb_stats__(visit(level));
+    auto rank = teb_.rank_inclusive(node_idx);
+    std::size_t i = tree_height_ - level - 1;
+    while (teb_.is_inner_node(node_idx)) {
+      // Navigate downwards the tree.
+      // 0 -> go to left child, 1 -> go to right child
+      u1 direction_bit = dtl::bits::bit_test(to_pos, i);
+      i--;
+      const auto right_child_idx = 2 * rank;
+      const auto left_child_idx = right_child_idx - 1;
+      const auto right_child_rank = teb_.rank_inclusive(right_child_idx);
+      const auto right_child_is_inner = teb_.is_inner_node(right_child_idx);
+      const auto left_child_rank = right_child_rank - right_child_is_inner;
+      level++;
+      __teb_stats__(descent_steps++);
+      __teb_stats__(visit(level));
+      if (direction_bit) {
+        // Push the left child only if necessary.
+        const auto left_child_is_inner = teb_.is_inner_node(left_child_idx);
+        if (left_child_is_inner
+            || teb_.get_label_by_idx(left_child_idx - left_child_rank)) {
+          stack_entry& left_child_info = stack_.push();
+          left_child_info.node_idx = left_child_idx;
+          left_child_info.path = path << 1;
+          left_child_info.level = level;
+          left_child_info.rank = left_child_rank;
+          left_child_info.is_inner = 0ull + left_child_is_inner;
+        }
+        // Go to right child.
+        path = (path << 1) | 1;
+        node_idx = right_child_idx;
+        rank = right_child_rank;
+      }
+      else {
+        // Go to left child.
+        path <<= 1;
+        node_idx = left_child_idx;
+        rank = left_child_rank;
+      }
+    }
+    // Reached a leaf node.
+    if (teb_.get_label_by_idx(node_idx - rank)
+        && produce_output(path, level, std::min($u64(to_pos + 1), $u64(teb_.n_actual_)))) {
+      return;
+    }
+    // Search backwards to the preceding 1-fill.
+    prev();
+  }
+
+  /// Returns true if the iterator reached the end, false otherwise.
+  u1 __forceinline__
+  end() const noexcept {
+    return length_ == 0;
+  }
+
+  /// Returns the starting position of the current 1-fill.
+  u64 __forceinline__
+  pos() const noexcept {
+    return pos_;
+  }
+
+  /// Returns the length of the current 1-fill.
+  u64 __forceinline__
+  length() const noexcept {
+    return length_;
+  }
+};
+//===----------------------------------------------------------------------===//
+} // namespace dtl
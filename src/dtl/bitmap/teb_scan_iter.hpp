@@ -19,8 +19,13 @@
 //===----------------------------------------------------------------------===//
 namespace dtl {
 //===----------------------------------------------------------------------===//
-/// 1-fill iterator, WITHOUT efficient skip support. The scan iterator falls
+/// 1-fill iterator, with efficient skip support. The scan iterator falls
 /// back to a regular iterator if the level offsets are not present.
+///
+/// The iterator decodes the 1-fills in batches. Skipping within the current
+/// batch is a simple forward scan. Otherwise, the scanners are re-positioned
+/// at the leaf node that contains the target position, which costs one rank
+/// query per tree level, and batch decoding continues from there.
 class teb_scan_iter {
   static constexpr u32 optimization_level_ = 3; // TODO remove
 
@@ -121,6 +126,7 @@ public:
         fallback_to_default_iter(!teb.has_level_offsets()),
         default_iter(nullptr) {
     if (fallback_to_default_iter) {
+      __teb_stats__(default_iter_fallbacks++);
       default_iter = std::make_unique<teb_iter>(teb);
       results_[0].pos = default_iter->pos();
       results_[0].length = default_iter->length();
@@ -218,10 +224,12 @@ public:
   $u1 first_ = true;
   void
   get_next_batch() {
+    __teb_stats__(batches++);
     if (fallback_to_default_iter) {
       // Fall back to the default iterator, as the given TEB instance does not
       // provide the necessary meta data to perform a tree scan.
       next_batch_from_default_iter();
+      __teb_stats__(batch_runs += result_cnt_);
       return;
     }
     const auto tree_levels = tree_height_ + 1;
@@ -275,6 +283,7 @@ public:
 //    #endif
 //    #endif
     // clang-format on
+    __teb_stats__(batch_runs += result_cnt_);
   }
 
   void
@@ -1338,6 +1347,7 @@ public:
     while (true) {
       auto node_idx = scanner_states_[path_level].node_idx_;
       auto node_is_inner = teb_.is_inner_node(node_idx);
+      __teb_stats__(visit(path_level));
 
       while (node_is_inner) {
         // ~~~ Push right child on the stack and go to left child.
@@ -1346,6 +1356,7 @@ public:
         path <<= 1;
         node_idx = scanner_states_[path_level].node_idx_;
         node_is_inner = teb_.is_inner_node(node_idx);
+        __teb_stats__(visit(path_level));
       }
       // Reached a leaf node.
       const auto label_idx = scanner_states_[path_level].label_idx_;
@@ -1390,8 +1401,71 @@ public:
     result_cnt_ = result_cnt;
   }
 
-  /// Forwards the iterator to the given position. - Note: This functions
-  /// simply calls next() until the desired position has been reached.
+  /// Initializes the scanners of the given level and all levels below,
+  /// where the given node is the next node to visit on the given level. The
+  /// next node on the subsequent level is the first child of an inner node
+  /// that succeeds the given node.
+  void
+  seek_scanners(u64 level, u64 node_idx) noexcept {
+    $u64 idx = node_idx;
+    for (std::size_t l = level; l < teb_.encoded_tree_height_; ++l) {
+      const auto rank = teb_.rank_exclusive(idx);
+      scanner_states_[l].init(idx, idx - rank);
+      idx = 2 * rank + 1;
+    }
+  }
+
+  /// Positions the scanners at the leaf node that contains the given
+  /// position. The next batch starts with that leaf node and may therefore
+  /// contain 1-fills that end before the given position.
+  void
+  seek(const std::size_t to_pos) noexcept __attribute__((noinline)) {
+    const auto tree_levels = tree_height_ + 1;
+    const auto u = perfect_levels_ - 1;
+    if (perfect_levels_ == tree_levels) {
+      // The bitmap is not compressed.
+      scan_path_ = to_pos;
+      return;
+    }
+    const auto top_node_idx =
+        top_node_idx_begin_ + (to_pos >> (tree_height_ - u));
+    if (perfect_levels_ == tree_levels - 1
+        || perfect_levels_ == tree_levels - 2) {
+      // The specialized implementations scan top node by top node.
+      scan_path_ = (top_node_idx - top_node_idx_begin_) << (tree_height_ - u);
+      seek_scanners(u, top_node_idx);
+      return;
+    }
+
+    // Walk downwards to the leaf node that contains the given position and
+    // update the scanners of the levels along the path.
+    $u64 node_idx = top_node_idx;
+    $u64 level = u;
+    while (teb_.is_inner_node(node_idx)) {
+      __teb_stats__(visit(level));
+      const auto rank = teb_.rank_inclusive(node_idx);
+      // The AVX-512 implementation expects the scanners to point to the nodes
+      // on the current path, whereas the scalar implementation expects them
+      // to point to the next unvisited nodes.
+#ifdef __AVX512BW__
+      scanner_states_[level].init(node_idx, node_idx + 1 - rank);
+#else
+      scanner_states_[level].init(node_idx + 1, node_idx + 1 - rank);
+#endif
+      u1 direction_bit =
+          dtl::bits::bit_test(to_pos, tree_height_ - 1 - level);
+      node_idx = 2 * rank - 1 + direction_bit;
+      ++level;
+    }
+    __teb_stats__(visit(level));
+    seek_scanners(level, node_idx);
+    scan_path_ = to_pos >> (tree_height_ - level);
+    scan_path_level_ = level;
+    top_node_idx_current_ = top_node_idx;
+    first_time_stack_ = false;
+  }
+
+  /// Forwards the iterator to the given position.
   void
   skip_to(const std::size_t to_pos) noexcept __attribute__((noinline)) {
     if (to_pos >= teb_.n_actual_) {
@@ -1401,6 +1475,31 @@ public:
       result_read_pos_ = 0;
       return;
     }
+    if (end() || pos() >= to_pos) return;
+
+    const auto& last_result = results_[result_cnt_ - 1];
+    const auto is_last_batch = last_result.pos == teb_.n_actual_;
+    const auto batch_end = last_result.pos + last_result.length;
+    // Re-positioning the scanners costs about as much as decoding a batch.
+    // Thus, if the desired position is likely covered by the next batch, we
+    // continue with the scan instead.
+    const auto batch_span = batch_end - results_[0].pos;
+    if (!is_last_batch && batch_end <= to_pos
+        && to_pos - batch_end >= batch_span) {
+      // The desired position is beyond the current batch.
+      if (fallback_to_default_iter) {
+        default_iter->skip_to(to_pos);
+        results_[0].pos = default_iter->pos();
+        results_[0].length = default_iter->length();
+        result_cnt_ = 1;
+        result_read_pos_ = 0;
+        return;
+      }
+      seek(to_pos);
+      result_cnt_ = 0;
+      result_read_pos_ = 0;
+      get_next_batch();
+    }
 
     while (!end() && pos() + length() <= to_pos) {
       next();
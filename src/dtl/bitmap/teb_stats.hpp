@@ -0,0 +1,174 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include <dtl/dtl.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+//===----------------------------------------------------------------------===//
+// Hot-path instrumentation of the TEB logic and the TEB iterators.
+//
+// The counters are maintained only if TEB_STATS is defined at compile time.
+// Otherwise, the macro __teb_stats__ expands to nothing and the
+// instrumentation has no runtime costs.
+//===----------------------------------------------------------------------===//
+#if defined(TEB_STATS)
+#define __teb_stats__(stmt) \
+  { auto& __stats = dtl::teb_stats::local(); __stats.stmt; }
+#else
+#define __teb_stats__(stmt)
+#endif
+//===----------------------------------------------------------------------===//
+namespace dtl {
+//===----------------------------------------------------------------------===//
+/// The counters collected by teb_flat, teb_iter and teb_scan_iter. Each thread
+/// has its own instance, which is obtained using teb_stats::local().
+struct teb_stats {
+  /// True, if the counters are maintained.
+#if defined(TEB_STATS)
+  static constexpr u1 enabled = true;
+#else
+  static constexpr u1 enabled = false;
+#endif
+  static constexpr std::size_t max_level_cnt = 32;
+  static constexpr std::size_t cache_line_size = 64;
+
+  /// The number of tree nodes visited per level. Note: The AVX-512 and the
+  /// specialized (2- and 3-level) scan kernels do not record node visits.
+  std::array<$u64, max_level_cnt> nodes_visited;
+  /// The number of rank queries on the tree structure (excluding the implicit
+  /// inner nodes, whose rank is computed arithmetically).
+  $u64 rank_calls = 0;
+  /// The number of rank queries that touched a different cache line of the
+  /// rank LuT than the preceding rank query.
+  $u64 lut_cache_line_touches = 0;
+  /// The number of label lookups.
+  $u64 label_lookups = 0;
+  /// The number of nav_to() calls.
+  $u64 nav_to_calls = 0;
+  /// The number of navigations that (re-)started from a top node, i.e., the
+  /// calls of teb_iter::nav_from_root_to() and the backward navigations of
+  /// teb_rev_iter::skip_back_to(). Note that nav_to() may fall back to
+  /// nav_from_root_to() after it already climbed up the tree, in which case
+  /// the navigation is also counted in climb_steps.
+  $u64 nav_from_root_calls = 0;
+  /// The total number of upward steps (stack pops) in nav_to().
+  $u64 climb_steps = 0;
+  /// The total number of downward steps in nav_downwards().
+  $u64 descent_steps = 0;
+  /// The number of batches produced by the scan iterator.
+  $u64 batches = 0;
+  /// The total number of 1-runs produced in these batches.
+  $u64 batch_runs = 0;
+  /// The number of scan iterators that fell back to the default iterator.
+  $u64 default_iter_fallbacks = 0;
+  /// The cache line of the most recent LuT access.
+  std::uintptr_t last_lut_cache_line = 0;
+
+  teb_stats() {
+    reset();
+  }
+
+  /// Returns the counters of the calling thread.
+  static teb_stats&
+  local() {
+    static thread_local teb_stats instance;
+    return instance;
+  }
+
+  /// Resets all counters to zero.
+  void
+  reset() {
+    nodes_visited.fill(0);
+    rank_calls = 0;
+    lut_cache_line_touches = 0;
+    label_lookups = 0;
+    nav_to_calls = 0;
+    nav_from_root_calls = 0;
+    climb_steps = 0;
+    descent_steps = 0;
+    batches = 0;
+    batch_runs = 0;
+    default_iter_fallbacks = 0;
+    last_lut_cache_line = 0;
+  }
+
+  /// Records a node visit.
+  void __forceinline__
+  visit(std::size_t level) {
+    ++nodes_visited[level < max_level_cnt ? level : max_level_cnt - 1];
+  }
+
+  /// Records a rank query that reads the given LuT entry.
+  void __forceinline__
+  rank_call(const void* lut_entry) {
+    ++rank_calls;
+    const auto cache_line =
+        reinterpret_cast<std::uintptr_t>(lut_entry) / cache_line_size;
+    lut_cache_line_touches += cache_line != last_lut_cache_line;
+    last_lut_cache_line = cache_line;
+  }
+
+  /// Returns the total number of visited nodes.
+  u64
+  total_nodes_visited() const {
+    $u64 cnt = 0;
+    for (auto c : nodes_visited) cnt += c;
+    return cnt;
+  }
+
+  /// Accumulates the counters of the given instance.
+  teb_stats&
+  operator+=(const teb_stats& other) {
+    for (std::size_t i = 0; i < max_level_cnt; ++i) {
+      nodes_visited[i] += other.nodes_visited[i];
+    }
+    rank_calls += other.rank_calls;
+    lut_cache_line_touches += other.lut_cache_line_touches;
+    label_lookups += other.label_lookups;
+    nav_to_calls += other.nav_to_calls;
+    nav_from_root_calls += other.nav_from_root_calls;
+    climb_steps += other.climb_steps;
+    descent_steps += other.descent_steps;
+    batches += other.batches;
+    batch_runs += other.batch_runs;
+    default_iter_fallbacks += other.default_iter_fallbacks;
+    return *this;
+  }
+
+  /// Returns the counters in JSON.
+  std::string
+  info() const {
+    std::string nodes = "[";
+    std::size_t level_cnt = max_level_cnt;
+    while (level_cnt > 0 && nodes_visited[level_cnt - 1] == 0) --level_cnt;
+    for (std::size_t i = 0; i < level_cnt; ++i) {
+      if (i > 0) nodes += ",";
+      nodes += std::to_string(nodes_visited[i]);
+    }
+    nodes += "]";
+    return "{\"enabled\":" + std::string(enabled ? "true" : "false")
+        + ",\"nodes_visited\":" + nodes
+        + ",\"rank_calls\":" + std::to_string(rank_calls)
+        + ",\"lut_cache_line_touches\":" + std::to_string(lut_cache_line_touches)
+        + ",\"label_lookups\":" + std::to_string(label_lookups)
+        + ",\"nav_to_calls\":" + std::to_string(nav_to_calls)
+        + ",\"nav_from_root_calls\":" + std::to_string(nav_from_root_calls)
+        + ",\"climb_steps\":" + std::to_string(climb_steps)
+        + ",\"descent_steps\":" + std::to_string(descent_steps)
+        + ",\"batches\":" + std::to_string(batches)
+        + ",\"batch_runs\":" + std::to_string(batch_runs)
+        + ",\"default_iter_fallbacks\":" + std::to_string(default_iter_fallbacks)
+        + "}";
+  }
+
+  /// For debugging purposes.
+  void
+  print(std::ostream& os) const {
+    os << info();
+  }
+};
+//===----------------------------------------------------------------------===//
+} // namespace dtl
@@ -0,0 +1,95 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include "teb_flat.hpp"
+#include "teb_iter.hpp"
+#include "teb_rev_iter.hpp"
+#include "teb_scan_iter.hpp"
+#include "teb_types.hpp"
+
+#include <dtl/dtl.hpp>
+
+#include <string>
+//===----------------------------------------------------------------------===//
+namespace dtl {
+//===----------------------------------------------------------------------===//
+/// A read-only TEB that operates on a serialized TEB, which is NOT owned by
+/// the view. This is used to access the partitions of partitioned TEBs, which
+/// are stored back-to-back in a single buffer.
+class teb_view {
+  /// The TEB logic.
+  teb_flat teb_;
+
+public:
+  /// C'tor
+  explicit teb_view(const teb_word_type* ptr) : teb_(ptr) {}
+
+  // Note: The TEB logic may refer to data that is owned by the instance (the
+  //       rank LuT of small trees). Thus, copies are re-initialized from the
+  //       serialized TEB.
+  teb_view(const teb_view& other) : teb_(other.teb_.ptr_) {}
+  teb_view(teb_view&& other) noexcept : teb_(other.teb_.ptr_) {}
+  teb_view& operator=(const teb_view& other) = delete;
+  teb_view& operator=(teb_view&& other) = delete;
+
+  /// Return the name of the implementation.
+  static std::string
+  name() noexcept {
+    return "teb_view";
+  }
+
+  /// Returns a 1-fill iterator, with efficient skip support.
+  teb_iter __teb_inline__
+  it() const noexcept {
+    return std::move(teb_iter(teb_));
+  }
+
+  /// Returns a 1-fill iterator, optimized for scans (with skip support).
+  teb_scan_iter __teb_inline__
+  scan_it() const noexcept {
+    return std::move(teb_scan_iter(teb_));
+  }
+
+  /// Returns a 0-fill iterator, with efficient skip support.
+  teb_zero_iter __teb_inline__
+  zero_it() const noexcept {
+    return std::move(teb_zero_iter(teb_));
+  }
+
+  /// Returns a reverse 1-fill iterator, which produces the 1-fills in
+  /// descending order.
+  teb_rev_iter __teb_inline__
+  rit() const noexcept {
+    return std::move(teb_rev_iter(teb_));
+  }
+
+  using skip_iter_type = teb_iter;
+  using scan_iter_type = teb_scan_iter;
+  using rev_iter_type = teb_rev_iter;
+  using zero_iter_type = teb_zero_iter;
+
+  /// Returns the length of the original bitmap.
+  std::size_t __teb_inline__
+  size() const noexcept {
+    return teb_.size();
+  }
+
+  /// Returns the value of the bit at the given position.
+  u1 __teb_inline__
+  test(const std::size_t pos) const noexcept {
+    return teb_.test(pos);
+  }
+
+  /// Return the size in bytes.
+  std::size_t __teb_inline__
+  size_in_bytes() const noexcept {
+    return teb_.size_in_bytes();
+  }
+
+  /// For debugging purposes.
+  void
+  print(std::ostream& os) const noexcept {
+    teb_.print(os);
+  }
+};
+//===----------------------------------------------------------------------===//
+} // namespace dtl
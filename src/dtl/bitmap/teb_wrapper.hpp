@@ -3,8 +3,11 @@
 #include "teb_builder.hpp"
 #include "teb_flat.hpp"
 #include "teb_iter.hpp"
+#include "teb_rev_iter.hpp"
 #include "teb_scan_iter.hpp"
 #include "teb_types.hpp"
+#include "teb_view.hpp"
+#include "part/part_store.hpp"
 
 #include <dtl/dtl.hpp>
 
@@ -61,14 +64,29 @@ public:
     return std::move(teb_iter(*teb_));
   }
 
-  /// Returns a 1-fill iterator, with WITHOUT efficient skip support.
+  /// Returns a 1-fill iterator, optimized for scans (with skip support).
   teb_scan_iter __teb_inline__
   scan_it() const noexcept {
     return std::move(teb_scan_iter(*teb_));
   }
 
+  /// Returns a 0-fill iterator, with efficient skip support.
+  teb_zero_iter __teb_inline__
+  zero_it() const noexcept {
+    return std::move(teb_zero_iter(*teb_));
+  }
+
+  /// Returns a reverse 1-fill iterator, which produces the 1-fills in
+  /// descending order.
+  teb_rev_iter __teb_inline__
+  rit() const noexcept {
+    return std::move(teb_rev_iter(*teb_));
+  }
+
   using skip_iter_type = teb_iter;
   using scan_iter_type = teb_scan_iter;
+  using rev_iter_type = teb_rev_iter;
+  using zero_iter_type = teb_zero_iter;
 
   /// Returns the length of the original bitmap.
   std::size_t __teb_inline__
@@ -130,4 +148,28 @@ public:
   }
 };
 //===----------------------------------------------------------------------===//
+/// Partitioned TEBs store the serialized partitions back-to-back in a single
+/// buffer.
+template<>
+struct part_flat_traits<teb_wrapper> {
+  static constexpr u1 value = true;
+  using word_type = teb_word_type;
+  using view_type = teb_view;
+
+  /// Encodes the given bitmap and appends the serialized TEB to dst.
+  static void
+  serialize(const boost::dynamic_bitset<$u32>& bitmap,
+      std::vector<word_type>& dst) {
+    dtl::teb_builder builder(bitmap);
+    const auto offset = dst.size();
+    dst.resize(offset + builder.serialized_size_in_words());
+    builder.serialize(dst.data() + offset);
+  }
+
+  static view_type
+  view(const word_type* ptr) {
+    return view_type(ptr);
+  }
+};
+//===----------------------------------------------------------------------===//
 } // namespace dtl
\ No newline at end of file
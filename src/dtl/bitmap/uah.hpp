@@ -1,11 +1,13 @@
 #pragma once
 //===----------------------------------------------------------------------===//
+#include <dtl/bitmap/util/bitmap_fun.hpp>
+#include <dtl/bitmap/util/hybrid_fun.hpp>
 #include <dtl/bitmap/util/plain_bitmap.hpp>
-#include <dtl/bitmap/util/plain_bitmap_iter.hpp>
 #include <dtl/dtl.hpp>
 
 #include <boost/dynamic_bitset.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <type_traits>
 #include <vector>
@@ -14,6 +16,10 @@ namespace dtl {
 //===----------------------------------------------------------------------===//
 /// Un-Aligned Hybrid: An RLE compressed representation of a bitmap of length N.
 /// Unlike WAH or BBC, the encoding is not word or byte aligned.
+///
+/// The literal words are encoded and decoded multiple at a time, and the run
+/// boundaries are searched for by comparing multiple words at once (AVX2 and
+/// AVX-512), see hybrid_fun and bitmap_fun::find_first_mismatch.
 template<typename _word_type = u32>
 class uah {
 
@@ -29,6 +35,10 @@ protected:
   /// The number of bits that can be stored in a literal word.
   static constexpr std::size_t payload_bit_cnt = word_bitlength - 1;
   static constexpr word_type all_ones = word_type(~word_type(0));
+  /// The number of literal words that are encoded at a time.
+  static constexpr std::size_t literal_batch_size = 64;
+
+  using hf = dtl::hybrid_fun<word_type>;
 
   /// The encoded bitmap.
   std::vector<word_type> data_;
@@ -177,38 +187,109 @@ protected:
     append_run(true, len);
   }
 
+  /// Encodes the given plain bitmap of length n. A run that is shorter than
+  /// payload_bit_cnt bits becomes part of a literal word, together with the
+  /// subsequent bits. Thus, whenever the next payload_bit_cnt bits contain
+  /// 0's and 1's, they are stored in a literal word, otherwise the run
+  /// becomes a fill. Consecutive literals are encoded in batches
+  /// (hybrid_fun::encode_literals). The run boundaries are searched for by
+  /// comparing multiple words at once (bitmap_fun::find_first_mismatch).
+  inline void
+  encode(const $u32* bitmap, const std::size_t n) {
+    using fn = dtl::bitmap_fun<$u32>;
+    assert(data_.empty());
+    word_type literals[literal_batch_size];
+    std::size_t i = 0;
+    while (i + payload_bit_cnt <= n) {
+      const std::size_t literal_cnt =
+          hf::encode_literals(bitmap, i, n, literals, literal_batch_size);
+      data_.insert(data_.end(), literals, literals + literal_cnt);
+      i += literal_cnt * payload_bit_cnt;
+      encoded_bitmap_length_ += literal_cnt * payload_bit_cnt;
+      if (literal_cnt == literal_batch_size || i + payload_bit_cnt > n) {
+        continue;
+      }
+      // The current run is at least payload_bit_cnt bits long.
+      const u1 val = fn::test(bitmap, i);
+      const std::size_t e = val
+          ? fn::find_first_zero(bitmap, i, n)
+          : fn::find_first(bitmap, i, n);
+      if (data_.empty()) {
+        init(val);
+      }
+      append_run(val, e - i);
+      i = e;
+      const auto& w = data_.back();
+      if (i < n && extract_fill_length(w) < payload_bit_cnt) {
+        // The run has been split into multiple fill words, and the last one is
+        // short. Such a fill becomes part of the next literal word.
+        const std::size_t len = extract_fill_length(w);
+        data_.pop_back();
+        encoded_bitmap_length_ -= len;
+        i -= len;
+      }
+    }
+    remaining_bit_cnt_in_last_literal_word_ = 0;
+    if (i < n) {
+      // Less than payload_bit_cnt bits remain.
+      const u1 val = fn::test(bitmap, i);
+      const std::size_t e = val
+          ? fn::find_first_zero(bitmap, i, n)
+          : fn::find_first(bitmap, i, n);
+      if (e == n) {
+        // The remaining bits form a single run.
+        if (data_.empty()) {
+          init(val);
+        }
+        append_run(val, n - i);
+      }
+      else {
+        // The remaining bits are stored in a literal word.
+        const $u64 payload = hf::fetch_payload(bitmap, i, n - i);
+        data_.push_back(static_cast<word_type>(payload << 1));
+        encoded_bitmap_length_ += n - i;
+        remaining_bit_cnt_in_last_literal_word_ = payload_bit_cnt - (n - i);
+      }
+    }
+    if (data_.empty()) {
+      // The bitmap is empty.
+      init(true);
+    }
+  }
+
 public:
   uah() = default;
 
   explicit uah(const boost::dynamic_bitset<$u32>& in) {
-    // Obtain a 1-run iterator for the input bitmap.
-    dtl::plain_bitmap_iter<boost::dynamic_bitset<$u32>> it(in);
-    // Append runs to the compressed bitmap.
+    encode(in.m_bits.data(), in.size());
+    // Try to reduce the memory consumption.
+    shrink();
+  }
+
+  /// Constructs a bitmap of length n from the given (sorted) positions of the
+  /// 1-bits, without using a plain bitmap as intermediate.
+  uah(const $u32* positions, std::size_t cnt, std::size_t n) {
+    const std::size_t first = cnt > 0 ? positions[0] : n;
+    init(first == 0);
     std::size_t i = 0;
-    if (it.pos() > 0) {
-      // The bitmap starts with a 0-run.
-      init(false);
-      auto len = it.pos() - i;
-      append_zero_run(len);
-      i += len;
-    }
-    else {
-      // The bitmap starts with a 0-run.
-      init(true);
-    }
-    while (!it.end()) {
-      auto len = it.length();
-      append_one_run(len);
-      i += len;
-      it.next();
-      if (!it.end()) {
-        len = it.pos() - i;
-        append_zero_run(len);
-        i += len;
+    std::size_t j = 0;
+    while (j < cnt) {
+      // Determine the next 1-run.
+      const std::size_t b = positions[j];
+      std::size_t e = b + 1;
+      ++j;
+      while (j < cnt && positions[j] == e) {
+        ++e;
+        ++j;
+      }
+      if (b > i) {
+        append_zero_run(b - i);
       }
+      append_one_run(e - b);
+      i = e;
     }
-    if (i < in.size()) {
-      append_zero_run(in.size() - i);
+    if (i < n) {
+      append_zero_run(n - i);
     }
     // Try to reduce the memory consumption.
     shrink();
@@ -234,26 +315,42 @@ public:
   }
 
   /// Conversion to an plain bitmap. // TODO remove
+  /// Consecutive literal words are decoded in batches (see
+  /// hybrid_fun::decode_literals).
   dtl::plain_bitmap<$u64>
   to_plain_bitmap() {
     dtl::plain_bitmap<$u64> ret(encoded_bitmap_length_, false);
     std::size_t i = 0;
-    for (std::size_t word_idx = 0; word_idx < data_.size(); ++word_idx) {
+    std::size_t word_idx = 0;
+    while (word_idx < data_.size()) {
       auto& w = data_[word_idx];
       if (is_fill_word(w)) {
         auto val = extract_fill_value(w);
         auto len = extract_fill_length(w);
         ret.set(i, i + len, val);
         i += len;
+        ++word_idx;
+      }
+      else if (word_idx < data_.size() - 1) {
+        // Decode the consecutive literal words. The last word is excluded, as
+        // it might be incomplete.
+        const std::size_t literal_cnt = hf::find_first_fill_word(
+            data_.data() + word_idx, data_.data() + data_.size() - 1);
+        hf::decode_literals(data_.data() + word_idx, literal_cnt,
+            ret.data_begin(), i);
+        i += literal_cnt * payload_bit_cnt;
+        word_idx += literal_cnt;
       }
       else {
-        const std::size_t cnt = word_idx == data_.size() - 1
-            ? payload_bit_cnt - remaining_bit_cnt_in_last_literal_word_
-            : payload_bit_cnt;
-        for (std::size_t k = 0; k < cnt; ++k) {
-          ret.set(i + k, dtl::bits::bit_test(w, k + 1));
+        // The last word is a literal.
+        const std::size_t cnt =
+            payload_bit_cnt - remaining_bit_cnt_in_last_literal_word_;
+        if (cnt > 0) {
+          // Store the entire payload at once.
+          ret.store_bits(i, i + cnt, static_cast<$u64>(w >> 1));
         }
         i += cnt;
+        ++word_idx;
       }
     }
     if (i < encoded_bitmap_length_) {
@@ -350,11 +447,8 @@ public:
           }
           else {
             const std::size_t b = dtl::bits::tz_count(payload);
-            std::size_t e = b + 1;
-            for (; e < payload_bit_cnt; ++e) {
-              u1 is_set = dtl::bits::bit_test(payload, e);
-              if (!is_set) break;
-            }
+            const std::size_t e =
+                b + dtl::bits::tz_count(~$u64(payload >> b));
             pos_ += b;
             length_ = e - b;
             in_word_idx_ = e;
@@ -401,11 +495,8 @@ public:
             }
             else {
               const std::size_t b = dtl::bits::tz_count(payload);
-              std::size_t e = b + 1;
-              for (; e < (payload_bit_cnt - in_word_idx_); ++e) {
-                u1 is_set = dtl::bits::bit_test(payload, e);
-                if (!is_set) break;
-              }
+              const std::size_t e =
+                  b + dtl::bits::tz_count(~$u64(payload >> b));
               pos_ += b;
               length_ = e - b;
               in_word_idx_ += e;
@@ -464,9 +555,136 @@ public:
     }
   };
   //===--------------------------------------------------------------------===//
+  /// Reverse 1-run iterator. Produces the 1-runs in descending order. The
+  /// code words are self-describing, thus the bitmap is decoded backwards
+  /// starting at the last word.
+  class riter {
+    const uah& outer_;
+
+    /// The number of words that have not been loaded yet. The current word
+    /// is the one at index word_idx_.
+    std::size_t word_idx_;
+    /// The bit position where the current word starts.
+    $u64 word_begin_;
+    /// The number of (leading) bits of the current word, that have not been
+    /// consumed yet.
+    std::size_t in_word_idx_;
+
+    //===------------------------------------------------------------------===//
+    // Iterator state
+    //===------------------------------------------------------------------===//
+    /// Points to the beginning of a 1-run.
+    $u64 pos_;
+    /// The length of the current 1-run.
+    $u64 length_;
+    //===------------------------------------------------------------------===//
+
+    /// Loads the preceding word. Returns false, if there is none.
+    u1 __forceinline__
+    load_prev_word() {
+      if (word_idx_ == 0) return false;
+      --word_idx_;
+      const word_type w = outer_.data_[word_idx_];
+      if (is_fill_word(w)) {
+        in_word_idx_ = extract_fill_length(w);
+      }
+      else {
+        in_word_idx_ = word_idx_ == outer_.data_.size() - 1
+            ? payload_bit_cnt - outer_.remaining_bit_cnt_in_last_literal_word_
+            : payload_bit_cnt;
+      }
+      word_begin_ -= in_word_idx_;
+      return true;
+    }
+
+  public:
+    explicit __forceinline__
+    riter(const uah& outer)
+        : outer_(outer),
+          word_idx_(outer.data_.size()),
+          word_begin_(outer.encoded_bitmap_length_),
+          in_word_idx_(0),
+          pos_(outer.encoded_bitmap_length_), length_(0) {
+      prev();
+    }
+
+    /// Move the iterator to the preceding 1-run.
+    void __forceinline__
+    prev() {
+      while (in_word_idx_ > 0 || load_prev_word()) {
+        if (in_word_idx_ == 0) continue;
+        const word_type w = outer_.data_[word_idx_];
+        if (is_fill_word(w)) {
+          if (extract_fill_value(w) == true) {
+            pos_ = word_begin_;
+            length_ = in_word_idx_;
+            in_word_idx_ = 0;
+            return;
+          }
+        }
+        else {
+          const $u64 payload = ($u64(w) >> 1)
+              & ((1ull << in_word_idx_) - 1);
+          if (payload != 0) {
+            const std::size_t e = 64 - dtl::bits::lz_count(payload);
+            const $u64 zeros = ~payload & ((1ull << e) - 1);
+            const std::size_t b =
+                zeros == 0 ? 0 : 64 - dtl::bits::lz_count(zeros);
+            pos_ = word_begin_ + b;
+            length_ = e - b;
+            in_word_idx_ = b;
+            return;
+          }
+        }
+        in_word_idx_ = 0;
+      }
+      pos_ = outer_.encoded_bitmap_length_;
+      length_ = 0;
+    }
+
+    /// Move the iterator backwards to the desired position. Afterwards, the
+    /// current 1-run ends at or before the given position (inclusive).
+    void __forceinline__
+    skip_back_to(const std::size_t to_pos) {
+      if (end() || to_pos + 1 >= pos_ + length_) {
+        return;
+      }
+      if (to_pos >= pos_) {
+        length_ = to_pos + 1 - pos_;
+        return;
+      }
+      // Skip over the words that start after the desired position.
+      while (word_begin_ > to_pos) {
+        if (!load_prev_word()) {
+          pos_ = outer_.encoded_bitmap_length_;
+          length_ = 0;
+          return;
+        }
+      }
+      in_word_idx_ = std::min(in_word_idx_, to_pos + 1 - word_begin_);
+      prev();
+    }
+
+    u1 __forceinline__
+    end() const noexcept {
+      return length_ == 0;
+    }
+
+    u64 __forceinline__
+    pos() const noexcept {
+      return pos_;
+    }
+
+    u64 __forceinline__
+    length() const noexcept {
+      return length_;
+    }
+  };
+  //===--------------------------------------------------------------------===//
 
   using skip_iter_type = iter;
   using scan_iter_type = iter;
+  using rev_iter_type = riter;
 
   /// Returns a 1-run iterator.
   skip_iter_type __forceinline__
@@ -480,6 +698,12 @@ public:
     return scan_iter_type(*this);
   }
 
+  /// Returns a reverse 1-run iterator.
+  rev_iter_type __forceinline__
+  rit() const {
+    return rev_iter_type(*this);
+  }
+
   /// Returns the name of the instance including the most important parameters
   /// in JSON.
   std::string
@@ -63,6 +63,11 @@ public:
     init_skip_offsets();
   }
 
+  uah_skip(const $u32* positions, std::size_t cnt, std::size_t n)
+      : super(positions, cnt, n), offsets_() {
+    init_skip_offsets();
+  }
+
   ~uah_skip() = default;
   uah_skip(const uah_skip& other) = default;
   uah_skip(uah_skip&& other) noexcept = default;
@@ -172,11 +177,8 @@ public:
           }
           else {
             const std::size_t b = dtl::bits::tz_count(payload);
-            std::size_t e = b + 1;
-            for (; e < payload_bit_cnt; ++e) {
-              u1 is_set = dtl::bits::bit_test(payload, e);
-              if (!is_set) break;
-            }
+            const std::size_t e =
+                b + dtl::bits::tz_count(~$u64(payload >> b));
             pos_ += b;
             length_ = e - b;
             in_word_idx_ = e;
@@ -223,11 +225,8 @@ public:
             }
             else {
               const std::size_t b = dtl::bits::tz_count(payload);
-              std::size_t e = b + 1;
-              for (; e < (payload_bit_cnt - in_word_idx_); ++e) {
-                u1 is_set = dtl::bits::bit_test(payload, e);
-                if (!is_set) break;
-              }
+              const std::size_t e =
+                  b + dtl::bits::tz_count(~$u64(payload >> b));
               pos_ += b;
               length_ = e - b;
               in_word_idx_ += e;
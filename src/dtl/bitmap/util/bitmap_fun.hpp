@@ -1,9 +1,12 @@
 #pragma once
 //===----------------------------------------------------------------------===//
+#include "popcount.hpp"
+
 #include <dtl/bits.hpp>
 #include <dtl/dtl.hpp>
 #include <dtl/simd.hpp>
 
+#include <algorithm>
 #include <cassert>
 //===----------------------------------------------------------------------===//
 namespace dtl {
@@ -186,6 +189,98 @@ struct bitmap_fun {
     }
   }
 
+  /// Returns the index of the first word in [bitmap_begin, bitmap_end) that
+  /// is not equal to the given word. If there is no such word, the number of
+  /// words is returned. Used to skip over long fills (all-0 or all-1 words).
+  static inline std::size_t
+  find_first_mismatch(
+      const word_type* bitmap_begin,
+      const word_type* bitmap_end,
+      const word_type w) {
+#ifdef __AVX512BW__
+    return find_first_mismatch_avx512(bitmap_begin, bitmap_end, w);
+#elif __AVX2__
+    return find_first_mismatch_avx2(bitmap_begin, bitmap_end, w);
+#else
+    return find_first_mismatch_x86(bitmap_begin, bitmap_end, w);
+#endif
+  }
+
+  /// Fall back implementation of 'find_first_mismatch()'; when neither AVX2
+  /// nor AVX512 is available.
+  static inline std::size_t
+  find_first_mismatch_x86(
+      const word_type* bitmap_begin,
+      const word_type* bitmap_end,
+      const word_type w) {
+    const std::size_t word_cnt = bitmap_end - bitmap_begin;
+    std::size_t i = 0;
+    while (i < word_cnt && bitmap_begin[i] == w) {
+      ++i;
+    }
+    return i;
+  }
+
+  /// Replicates the given word to fill an 8-byte SIMD lane.
+  static constexpr u64
+  replicate_word(const word_type w, const std::size_t i = 0) {
+    return i == sizeof($u64) / sizeof(word_type)
+        ? 0ull
+        : (static_cast<$u64>(w) << (i * word_bitlength))
+            | replicate_word(w, i + 1);
+  }
+
+#ifdef __AVX2__
+  /// AVX2 implementation of 'find_first_mismatch()'. Compares 32 bytes at a
+  /// time.
+  static inline std::size_t
+  find_first_mismatch_avx2(
+      const word_type* bitmap_begin,
+      const word_type* bitmap_end,
+      const word_type w) {
+    const std::size_t word_cnt = bitmap_end - bitmap_begin;
+    constexpr std::size_t words_per_vec = sizeof(__m256i) / sizeof(word_type);
+    const __m256i w_v = _mm256_set1_epi64x(
+        static_cast<long long>(replicate_word(w)));
+    std::size_t i = 0;
+    for (; i + words_per_vec <= word_cnt; i += words_per_vec) {
+      const __m256i d = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(bitmap_begin + i));
+      const $u32 eq_mask = static_cast<$u32>(
+          _mm256_movemask_epi8(_mm256_cmpeq_epi8(d, w_v)));
+      if (eq_mask != ~$u32(0)) {
+        return i + dtl::bits::tz_count(~eq_mask) / sizeof(word_type);
+      }
+    }
+    return i + find_first_mismatch_x86(bitmap_begin + i, bitmap_end, w);
+  }
+#endif
+
+#ifdef __AVX512BW__
+  /// AVX-512 implementation of 'find_first_mismatch()'. Compares 64 bytes at
+  /// a time.
+  static inline std::size_t
+  find_first_mismatch_avx512(
+      const word_type* bitmap_begin,
+      const word_type* bitmap_end,
+      const word_type w) {
+    const std::size_t word_cnt = bitmap_end - bitmap_begin;
+    constexpr std::size_t words_per_vec = sizeof(__m512i) / sizeof(word_type);
+    const __m512i w_v = _mm512_set1_epi64(
+        static_cast<long long>(replicate_word(w)));
+    std::size_t i = 0;
+    for (; i + words_per_vec <= word_cnt; i += words_per_vec) {
+      const __m512i d = _mm512_loadu_si512(
+          reinterpret_cast<const void*>(bitmap_begin + i));
+      const $u64 neq_mask = _mm512_cmpneq_epi8_mask(d, w_v);
+      if (neq_mask != 0) {
+        return i + dtl::bits::tz_count(neq_mask) / sizeof(word_type);
+      }
+    }
+    return i + find_first_mismatch_x86(bitmap_begin + i, bitmap_end, w);
+  }
+#endif
+
   /// Find the first set bit.  Returns the index of the first set bit. If no
   /// bits are set, the length of the bitmap is returned.
   static std::size_t __forceinline__
@@ -241,14 +336,14 @@ struct bitmap_fun {
       if (w_b != 0) {
         return b + dtl::bits::tz_count(w_b);
       }
-      for (std::size_t k = x + 1; k < y; ++k) {
-        const word_type w = bitmap[k];
-        if (w != 0) {
-          return b
-              + (word_bitlength - X_off)
-              + ((k - (x + 1)) * word_bitlength)
-              + dtl::bits::tz_count(w);
-        }
+      // Skip over the intermediate 0-words.
+      const std::size_t k =
+          x + 1 + find_first_mismatch(&bitmap[x + 1], &bitmap[y], word_type(0));
+      if (k < y) {
+        return b
+            + (word_bitlength - X_off)
+            + ((k - (x + 1)) * word_bitlength)
+            + dtl::bits::tz_count(bitmap[k]);
       }
       const word_type w_e = bitmap[y] & Y;
       if (w_e != 0) {
@@ -261,6 +356,49 @@ struct bitmap_fun {
     return e;
   }
 
+  /// Find the first unset bit [b,e). Returns 'e' if all bits in [b,e) are 1.
+  static std::size_t __forceinline__
+  find_first_zero(const word_type* bitmap,
+      const std::size_t b,
+      const std::size_t e) {
+    if (e <= b) return e;
+    const auto x = b / word_bitlength;
+    const auto y = (e - 1) / word_bitlength;
+
+    const auto X_off = (b % word_bitlength);
+    const word_type X = ~word_type(0) << X_off;
+    const word_type Y = ~word_type(0) >> ((word_bitlength - (e % word_bitlength)) % word_bitlength);
+
+    if (x == y) {
+      const word_type w = word_type(~bitmap[x]) & (X & Y);
+      if (w == 0) return e;
+      return b + dtl::bits::tz_count(w >> X_off);
+    }
+    else {
+      const word_type w_b = word_type(~bitmap[x]) >> X_off;
+      if (w_b != 0) {
+        return b + dtl::bits::tz_count(w_b);
+      }
+      // Skip over the intermediate 1-words.
+      const std::size_t k =
+          x + 1 + find_first_mismatch(&bitmap[x + 1], &bitmap[y], ~word_type(0));
+      if (k < y) {
+        return b
+            + (word_bitlength - X_off)
+            + ((k - (x + 1)) * word_bitlength)
+            + dtl::bits::tz_count(word_type(~bitmap[k]));
+      }
+      const word_type w_e = word_type(~bitmap[y]) & Y;
+      if (w_e != 0) {
+        return b
+            + ((y - x) * word_bitlength)
+            - X_off
+            + dtl::bits::tz_count(w_e);
+      }
+    }
+    return e;
+  }
+
   /// Find the first set bit [b,e). Returns 'e' if all bits in [b,e) are 0.
   /// This function is supposed to be called, when the underlying bitmap is
   /// dense.
@@ -344,6 +482,10 @@ struct bitmap_fun {
   count(const word_type* __restrict bitmap_begin,
       const word_type* __restrict bitmap_end) {
     const std::size_t word_cnt = bitmap_end - bitmap_begin;
+    if (sizeof(word_type) == sizeof($u64)) {
+      return dtl::popcount::count(
+          reinterpret_cast<const $u64*>(bitmap_begin), word_cnt);
+    }
     std::size_t pop_cnt = 0;
     for (std::size_t word_idx = 0; word_idx < word_cnt; ++word_idx) {
       pop_cnt += dtl::bits::pop_count(bitmap_begin[word_idx]);
@@ -356,30 +498,36 @@ struct bitmap_fun {
   count(const word_type* bitmap,
       const std::size_t b,
       const std::size_t e) {
-    if (e <= b) return 0;
-    const auto x = b / word_bitlength;
-    const auto y = (e - 1) / word_bitlength;
-
-    const auto X_off = (b % word_bitlength);
-    const word_type X = ~word_type(0) << X_off;
-    const word_type Y = ~word_type(0) >> ((word_bitlength - (e % word_bitlength)) % word_bitlength);
+    return count_range(bitmap, nullptr, b, e);
+  }
 
-    if (x == y) {
-      const word_type w = bitmap[x] & (X & Y);
-      return dtl::bits::pop_count(w);
+  /// Count the set bits in the bitwise AND of the two given bitmaps.
+  static std::size_t __forceinline__
+  and_count(const word_type* __restrict a_begin,
+      const word_type* __restrict a_end,
+      const word_type* __restrict b_begin) {
+    const std::size_t word_cnt = a_end - a_begin;
+    if (sizeof(word_type) == sizeof($u64)) {
+      return dtl::popcount::and_count(
+          reinterpret_cast<const $u64*>(a_begin),
+          reinterpret_cast<const $u64*>(b_begin), word_cnt);
     }
-    else {
-      std::size_t pop_cnt = 0;
-      const word_type w_b = bitmap[x] >> X_off;
-      pop_cnt += dtl::bits::pop_count(w_b);
-      for (std::size_t k = x + 1; k < y; ++k) {
-        const word_type w = bitmap[k];
-        pop_cnt += dtl::bits::pop_count(w);
-      }
-      const word_type w_e = bitmap[y] & Y;
-      pop_cnt += dtl::bits::pop_count(w_e);
-      return pop_cnt;
+    std::size_t pop_cnt = 0;
+    for (std::size_t word_idx = 0; word_idx < word_cnt; ++word_idx) {
+      pop_cnt += dtl::bits::pop_count(
+          word_type(a_begin[word_idx] & b_begin[word_idx]));
     }
+    return pop_cnt;
+  }
+
+  /// Count the set bits in the bitwise AND of the two given bitmaps within
+  /// the range [b,e).
+  static std::size_t __forceinline__
+  and_count(const word_type* bitmap_a,
+      const word_type* bitmap_b,
+      const std::size_t b,
+      const std::size_t e) {
+    return count_range(bitmap_a, bitmap_b, b, e);
   }
 
   /// Scans the bitmap (that consists of a single word) for set bits and produces
@@ -583,10 +731,7 @@ struct bitmap_fun {
       const word_type* __restrict b_begin,
       const word_type* __restrict b_end
       ) {
-    const std::size_t word_cnt = dst_end - dst_begin;
-    for (std::size_t i = 0; i < word_cnt; ++i) {
-      dst_begin[i] = a_begin[i] & b_begin[i];
-    }
+    apply<op_and>(dst_begin, dst_end - dst_begin, a_begin, b_begin);
   }
 
   /// Compute the bitwise OR.
@@ -599,10 +744,7 @@ struct bitmap_fun {
       const word_type* __restrict b_begin,
       const word_type* __restrict b_end
       ) {
-    const std::size_t word_cnt = dst_end - dst_begin;
-    for (std::size_t i = 0; i < word_cnt; ++i) {
-      dst_begin[i] = a_begin[i] | b_begin[i];
-    }
+    apply<op_or>(dst_begin, dst_end - dst_begin, a_begin, b_begin);
   }
 
   /// Compute the bitwise XOR.
@@ -615,10 +757,7 @@ struct bitmap_fun {
       const word_type* __restrict b_begin,
       const word_type* __restrict b_end
       ) {
-    const std::size_t word_cnt = dst_end - dst_begin;
-    for (std::size_t i = 0; i < word_cnt; ++i) {
-      dst_begin[i] = a_begin[i] ^ b_begin[i];
-    }
+    apply<op_xor>(dst_begin, dst_end - dst_begin, a_begin, b_begin);
   }
 
   /// Compute the bitwise NOT.
@@ -629,10 +768,7 @@ struct bitmap_fun {
       const word_type* __restrict src_begin,
       const word_type* __restrict src_end
       ) {
-    const std::size_t word_cnt = dst_end - dst_begin;
-    for (std::size_t i = 0; i < word_cnt; ++i) {
-      dst_begin[i] = ~src_begin[i];
-    }
+    apply<op_not>(dst_begin, dst_end - dst_begin, src_begin, src_begin);
   }
 
   /// Compute the bitwise a AND (NOT b).
@@ -645,13 +781,308 @@ struct bitmap_fun {
       const word_type* __restrict b_begin,
       const word_type* __restrict b_end
   ) {
+    apply<op_and_not>(dst_begin, dst_end - dst_begin, a_begin, b_begin);
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Fused operations.
+  //===--------------------------------------------------------------------===//
+  /// The truth tables of the three operands of a ternary operation. The truth
+  /// table of an arbitrary expression is obtained by evaluating the
+  /// expression on these constants, e.g., (a & b) | ~c is encoded as
+  /// u8((ternary_a & ternary_b) | ~ternary_c). The encoding is the same as
+  /// for the AVX-512 'vpternlog' instruction.
+  static constexpr u8 ternary_a = 0xF0;
+  static constexpr u8 ternary_b = 0xCC;
+  static constexpr u8 ternary_c = 0xAA;
+
+  /// Compute an arbitrary bitwise function of three operands in a single
+  /// pass, where the function is given by its truth table _imm8 (see
+  /// 'ternary_a'). The destination may refer to any of the operands.
+  template<u8 _imm8>
+  static inline void
+  bitwise_ternary(
+      word_type* dst_begin,
+      word_type* dst_end,
+      const word_type* a_begin,
+      const word_type* b_begin,
+      const word_type* c_begin) {
+    apply<op_ternary<_imm8>>(
+        dst_begin, dst_end - dst_begin, a_begin, b_begin, c_begin);
+  }
+
+  /// Compute the bitwise AND of all the given operands in a single,
+  /// cache-blocked pass. The destination may refer to the first operand.
+  static inline void
+  bitwise_and_n(
+      word_type* dst_begin,
+      word_type* dst_end,
+      const word_type* const* operands,
+      const std::size_t operand_cnt) {
+    apply_n<op_and, op_ternary<ternary_a & ternary_b & ternary_c>>(
+        dst_begin, dst_end, operands, operand_cnt);
+  }
+
+  /// Compute the bitwise OR of all the given operands in a single,
+  /// cache-blocked pass. The destination may refer to the first operand.
+  static inline void
+  bitwise_or_n(
+      word_type* dst_begin,
+      word_type* dst_end,
+      const word_type* const* operands,
+      const std::size_t operand_cnt) {
+    apply_n<op_or, op_ternary<ternary_a | ternary_b | ternary_c>>(
+        dst_begin, dst_end, operands, operand_cnt);
+  }
+
+  /// Compute the bitwise XOR of all the given operands in a single,
+  /// cache-blocked pass. The destination may refer to the first operand.
+  static inline void
+  bitwise_xor_n(
+      word_type* dst_begin,
+      word_type* dst_end,
+      const word_type* const* operands,
+      const std::size_t operand_cnt) {
+    apply_n<op_xor, op_ternary<ternary_a ^ ternary_b ^ ternary_c>>(
+        dst_begin, dst_end, operands, operand_cnt);
+  }
+
+private:
+  //===--------------------------------------------------------------------===//
+  // Kernels.
+  //===--------------------------------------------------------------------===//
+  /// The number of words processed per block by the n-ary operations. The
+  /// block of the destination (8 KiB) is supposed to stay in L1 while the
+  /// operands are streamed.
+  static constexpr std::size_t block_word_cnt = 8192 / sizeof(word_type);
+
+  // Each operation is defined for plain words and, if available, for AVX2
+  // and AVX-512 registers. Unary and binary operations ignore the
+  // superfluous operands.
+  struct op_and {
+    static word_type __forceinline__
+    word(word_type a, word_type b, word_type) { return a & b; }
+#ifdef __AVX2__
+    static __m256i __forceinline__
+    avx2(__m256i a, __m256i b, __m256i) { return _mm256_and_si256(a, b); }
+#endif
+#ifdef __AVX512F__
+    static __m512i __forceinline__
+    avx512(__m512i a, __m512i b, __m512i) { return _mm512_and_si512(a, b); }
+#endif
+  };
+
+  struct op_or {
+    static word_type __forceinline__
+    word(word_type a, word_type b, word_type) { return a | b; }
+#ifdef __AVX2__
+    static __m256i __forceinline__
+    avx2(__m256i a, __m256i b, __m256i) { return _mm256_or_si256(a, b); }
+#endif
+#ifdef __AVX512F__
+    static __m512i __forceinline__
+    avx512(__m512i a, __m512i b, __m512i) { return _mm512_or_si512(a, b); }
+#endif
+  };
+
+  struct op_xor {
+    static word_type __forceinline__
+    word(word_type a, word_type b, word_type) { return a ^ b; }
+#ifdef __AVX2__
+    static __m256i __forceinline__
+    avx2(__m256i a, __m256i b, __m256i) { return _mm256_xor_si256(a, b); }
+#endif
+#ifdef __AVX512F__
+    static __m512i __forceinline__
+    avx512(__m512i a, __m512i b, __m512i) { return _mm512_xor_si512(a, b); }
+#endif
+  };
+
+  struct op_and_not {
+    static word_type __forceinline__
+    word(word_type a, word_type b, word_type) { return a & ~b; }
+#ifdef __AVX2__
+    static __m256i __forceinline__
+    avx2(__m256i a, __m256i b, __m256i) { return _mm256_andnot_si256(b, a); }
+#endif
+#ifdef __AVX512F__
+    static __m512i __forceinline__
+    avx512(__m512i a, __m512i b, __m512i) { return _mm512_andnot_si512(b, a); }
+#endif
+  };
+
+  struct op_not {
+    static word_type __forceinline__
+    word(word_type a, word_type, word_type) { return ~a; }
+#ifdef __AVX2__
+    static __m256i __forceinline__
+    avx2(__m256i a, __m256i, __m256i) {
+      return _mm256_xor_si256(a, _mm256_set1_epi32(-1));
+    }
+#endif
+#ifdef __AVX512F__
+    static __m512i __forceinline__
+    avx512(__m512i a, __m512i, __m512i) {
+      return _mm512_ternarylogic_epi64(a, a, a, 0x55);
+    }
+#endif
+  };
+
+  /// Evaluates the minterms of the given truth table. Used when 'vpternlog'
+  /// is not available. As the truth table is known at compile time, the
+  /// expression is folded by the compiler.
+  template<u8 _imm8, typename T, typename and_fn, typename or_fn,
+      typename not_fn>
+  static T __forceinline__
+  eval_ternary(T a, T b, T c, T zero, and_fn and_, or_fn or_, not_fn not_) {
+    T ret = zero;
+    for (std::size_t i = 0; i < 8; ++i) {
+      if (((_imm8 >> i) & 1) == 0) continue;
+      const T x = (i & 4) ? a : not_(a);
+      const T y = (i & 2) ? b : not_(b);
+      const T z = (i & 1) ? c : not_(c);
+      ret = or_(ret, and_(and_(x, y), z));
+    }
+    return ret;
+  }
+
+  template<u8 _imm8>
+  struct op_ternary {
+    static word_type __forceinline__
+    word(word_type a, word_type b, word_type c) {
+      return eval_ternary<_imm8>(a, b, c, word_type(0),
+          [](word_type x, word_type y) { return word_type(x & y); },
+          [](word_type x, word_type y) { return word_type(x | y); },
+          [](word_type x) { return word_type(~x); });
+    }
+#ifdef __AVX2__
+    static __m256i __forceinline__
+    avx2(__m256i a, __m256i b, __m256i c) {
+      return eval_ternary<_imm8>(a, b, c, _mm256_setzero_si256(),
+          [](__m256i x, __m256i y) { return _mm256_and_si256(x, y); },
+          [](__m256i x, __m256i y) { return _mm256_or_si256(x, y); },
+          [](__m256i x) { return _mm256_xor_si256(x, _mm256_set1_epi32(-1)); });
+    }
+#endif
+#ifdef __AVX512F__
+    static __m512i __forceinline__
+    avx512(__m512i a, __m512i b, __m512i c) {
+      return _mm512_ternarylogic_epi64(a, b, c, _imm8);
+    }
+#endif
+  };
+
+  /// Applies the given operation word by word; dst[i] = op(a[i], b[i], c[i]).
+  /// The destination may refer to any of the operands.
+  template<typename op>
+  static inline void
+  apply(word_type* dst, const std::size_t word_cnt,
+      const word_type* a, const word_type* b, const word_type* c = nullptr) {
+    if (c == nullptr) c = a;
+    std::size_t i = 0;
+#ifdef __AVX512F__
+    constexpr std::size_t words_per_vec512 = sizeof(__m512i) / sizeof(word_type);
+    for (; i + words_per_vec512 <= word_cnt; i += words_per_vec512) {
+      const __m512i r = op::avx512(
+          _mm512_loadu_si512(reinterpret_cast<const void*>(a + i)),
+          _mm512_loadu_si512(reinterpret_cast<const void*>(b + i)),
+          _mm512_loadu_si512(reinterpret_cast<const void*>(c + i)));
+      _mm512_storeu_si512(reinterpret_cast<void*>(dst + i), r);
+    }
+#endif
+#ifdef __AVX2__
+    constexpr std::size_t words_per_vec256 = sizeof(__m256i) / sizeof(word_type);
+    for (; i + words_per_vec256 <= word_cnt; i += words_per_vec256) {
+      const __m256i r = op::avx2(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)),
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + i)));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), r);
+    }
+#endif
+    for (; i < word_cnt; ++i) {
+      dst[i] = op::word(a[i], b[i], c[i]);
+    }
+  }
+
+  /// Applies the given associative operation to n operands. Within each
+  /// block, two operands at a time are folded into the destination using the
+  /// corresponding ternary operation.
+  template<typename op, typename op3>
+  static inline void
+  apply_n(
+      word_type* dst_begin,
+      word_type* dst_end,
+      const word_type* const* operands,
+      const std::size_t operand_cnt) {
+    assert(operand_cnt > 0);
     const std::size_t word_cnt = dst_end - dst_begin;
-    for (std::size_t i = 0; i < word_cnt; ++i) {
-      dst_begin[i] = a_begin[i] & ~b_begin[i];
+    for (std::size_t b = 0; b < word_cnt; b += block_word_cnt) {
+      const std::size_t cnt = std::min(block_word_cnt, word_cnt - b);
+      word_type* dst = dst_begin + b;
+      std::size_t i = 1;
+      if (operand_cnt == 1) {
+        if (dst != operands[0] + b) {
+          std::copy(operands[0] + b, operands[0] + b + cnt, dst);
+        }
+      }
+      else if (operand_cnt == 2) {
+        apply<op>(dst, cnt, operands[0] + b, operands[1] + b);
+        i = 2;
+      }
+      else {
+        apply<op3>(dst, cnt,
+            operands[0] + b, operands[1] + b, operands[2] + b);
+        i = 3;
+      }
+      for (; i + 1 < operand_cnt; i += 2) {
+        apply<op3>(dst, cnt, dst, operands[i] + b, operands[i + 1] + b);
+      }
+      if (i < operand_cnt) {
+        apply<op>(dst, cnt, dst, operands[i] + b);
+      }
+    }
+  }
+
+  /// Count the set bits in [b,e) of bitmap_a, or of (bitmap_a & bitmap_b) if
+  /// bitmap_b is not a nullptr. The unaligned head and tail words are masked
+  /// and the words in between are counted using the (vectorized) popcount.
+  static std::size_t __forceinline__
+  count_range(const word_type* bitmap_a,
+      const word_type* bitmap_b,
+      const std::size_t b,
+      const std::size_t e) {
+    if (e <= b) return 0;
+    const auto x = b / word_bitlength;
+    const auto y = (e - 1) / word_bitlength;
+
+    const auto X_off = (b % word_bitlength);
+    const word_type X = ~word_type(0) << X_off;
+    const word_type Y = ~word_type(0) >> ((word_bitlength - (e % word_bitlength)) % word_bitlength);
+
+    auto fetch = [&](std::size_t k) {
+      return bitmap_b == nullptr
+          ? bitmap_a[k]
+          : word_type(bitmap_a[k] & bitmap_b[k]);
+    };
+
+    if (x == y) {
+      const word_type w = fetch(x) & (X & Y);
+      return dtl::bits::pop_count(w);
+    }
+    else {
+      std::size_t pop_cnt = 0;
+      const word_type w_b = fetch(x) >> X_off;
+      pop_cnt += dtl::bits::pop_count(w_b);
+      pop_cnt += bitmap_b == nullptr
+          ? count(&bitmap_a[x + 1], &bitmap_a[y])
+          : and_count(&bitmap_a[x + 1], &bitmap_a[y], &bitmap_b[x + 1]);
+      const word_type w_e = fetch(y) & Y;
+      pop_cnt += dtl::bits::pop_count(w_e);
+      return pop_cnt;
     }
   }
 
-private:
   // Construction not allowed.
   bitmap_fun() = delete;
 };
@@ -123,8 +123,12 @@ public:
     }
     else {
       // Classic code path.
-      init_labels();
-      prune_tree();
+      $u1 pruning_terminated = false;
+      const auto level = init_bottom_levels(pruning_terminated);
+      init_labels(level);
+      if (!pruning_terminated) {
+        prune_tree(level);
+      }
 
       // Run space optimizations.
       if (optimization_level_ > 1) {
@@ -165,9 +169,36 @@ public:
   void __attribute__((noinline, hot, flatten))
   init_tree(const boost::dynamic_bitset<$u32>& bitmap) {
     u64 length = max_node_cnt_;
-    u64 height = height_;
     // Copy the input bitmap to the last level of the tree.
-    {
+    if (n_ >= 32) {
+      // The labels of the leaf nodes start at bit index n (due to the +1
+      // offset), which is aligned to a 32-bit word boundary. Thus, the input
+      // words can be copied as a whole.
+      $u32* blocks = &reinterpret_cast<$u32*>(labels_.data())[n_ / 32];
+      const std::size_t block_cnt = bitmap.num_blocks();
+#ifndef BOOST_DYNAMIC_BITSET_DONT_USE_FRIENDS
+      boost::to_block_range(bitmap, blocks);
+#else
+      // HACK: This gives access to the private members of the boost::dynamic_bitset.
+      std::memcpy(blocks, bitmap.m_bits.data(), block_cnt * sizeof($u32));
+#endif
+      // Find the first and the last set bit.
+      first_bit_idx_ = n_;
+      last_bit_idx_ = n_;
+      for (std::size_t i = 0; i < block_cnt; ++i) {
+        if (blocks[i] != 0) {
+          first_bit_idx_ = i * 32 + dtl::bits::tz_count(blocks[i]);
+          break;
+        }
+      }
+      for (std::size_t i = block_cnt; i > 0; --i) {
+        if (blocks[i - 1] != 0) {
+          last_bit_idx_ = (i - 1) * 32 + 31 - dtl::bits::lz_count(blocks[i - 1]);
+          break;
+        }
+      }
+    }
+    else {
       auto i = bitmap.find_first();
       first_bit_idx_ = (i != boost::dynamic_bitset<$u32>::npos) ? i : n_;
       last_bit_idx_ = first_bit_idx_;
@@ -189,7 +220,15 @@ public:
   /// structure.
   void __attribute__((noinline))
   init_labels() {
-    for (auto level = last_level(); level > 0; --level) {
+    init_labels(last_level());
+  }
+
+  /// Propagate the label bits along the tree (bottom-up), starting at the
+  /// given level. The labels of the nodes at and below that level need to be
+  /// initialized already.
+  void __attribute__((noinline))
+  init_labels(u64 from_level) {
+    for (auto level = from_level; level > 0; --level) {
       const auto src_node_idx_begin = first_node_idx_at_level(level);
       const auto src_node_idx_end = first_node_idx_at_level(level + 1);
       const auto dst_node_idx_begin = first_node_idx_at_level(level - 1);
@@ -240,8 +279,15 @@ public:
   /// Note: The counters are thereby invalidated.
   void __attribute__((noinline))
   prune_tree() {
+    prune_tree(last_level());
+  }
+
+  /// Bottom-up pruning (loss-less), starting at the given level. The levels
+  /// below need to be pruned already.
+  void __attribute__((noinline))
+  prune_tree(u64 from_level) {
     D(init_counters();)
-    for (auto level = last_level(); level > 0; --level) {
+    for (auto level = from_level; level > 0; --level) {
       $u64 collapse_cnt = 0;
       const auto src_node_idx_begin = first_node_idx_at_level(level);
       const auto src_node_idx_end = first_node_idx_at_level(level + 1);
@@ -331,6 +377,121 @@ public:
     counters_are_valid = false;
   }
 
+  /// The max. number of (bottom) levels that are constructed by
+  /// init_bottom_levels(), i.e., the height of a subtree with 64 leaf words.
+  static constexpr std::size_t word_level_cnt = 6;
+
+  /// Fused and word-parallel construction of the bottom levels of the tree,
+  /// which combines init_labels() and prune_tree() for these levels.
+  ///
+  /// A node is a leaf iff the leaf labels within its subtree are either all 0
+  /// or all 1. Thus, the labels (OR) and the pruning decisions (OR != AND) of
+  /// the bottom levels are fully determined by the leaf labels. The levels
+  /// are derived in a single pass over the leaf labels, 64 nodes at a time,
+  /// rather than in separate passes for the labels and the tree structure.
+  /// Only the (up to six) levels with at least 64 nodes are processed here;
+  /// the remaining levels are left to init_labels(level) and
+  /// prune_tree(level).
+  ///
+  /// Returns the level at which the construction needs to continue. The flag
+  /// 'pruning_terminated' is set, if prune_tree() would have terminated within
+  /// the processed levels, in which case pruning must not continue.
+  u64 __attribute__((noinline, hot))
+  init_bottom_levels($u1& pruning_terminated) {
+    pruning_terminated = false;
+    u64 height = last_level();
+    if (height <= word_level_cnt) return height;
+    // The number of levels to process, excluding the leaf level.
+    u64 level_cnt = std::min(word_level_cnt, height - word_level_cnt);
+
+    constexpr u64 m = 0x5555555555555555;
+    $u64* label_ptr = labels_.data();
+    $u64* inner_ptr = is_inner_node_.data();
+    $u64* active_ptr = is_active_node_.data();
+
+    // The word index of the first node at the given level.
+    auto first_word_idx_at_level = [&](u64 level) {
+      return label_idx_of_node(first_node_idx_at_level(level)) / 64;
+    };
+    // The word indexes of the first node per level (k = 0 refers to the leaf
+    // level, k = 1 to the level above) and the number of collapsed nodes per
+    // level.
+    $u64 level_word_idx[word_level_cnt + 1] = { 0 };
+    $u64 collapse_cnt[word_level_cnt + 1] = { 0 };
+    for (std::size_t k = 0; k <= level_cnt; ++k) {
+      level_word_idx[k] = first_word_idx_at_level(height - k);
+    }
+
+    // The leaf words are processed in blocks. The labels of a block are
+    // reduced level by level within the two buffers below, where the bits
+    // refer to the OR and the AND of the leaf labels within the subtree of
+    // the corresponding node. Thus, each step processes 64 nodes at a time.
+    u64 block_word_cnt = 1ull << level_cnt;
+    $u64 labels_or[1ull << word_level_cnt];
+    $u64 labels_and[1ull << word_level_cnt];
+
+    const auto leaf_word_cnt = n_ / 64;
+    for (std::size_t b = 0; b < leaf_word_cnt; b += block_word_cnt) {
+      std::memcpy(labels_or, &label_ptr[level_word_idx[0] + b],
+          block_word_cnt * sizeof($u64));
+      std::memcpy(labels_and, labels_or, block_word_cnt * sizeof($u64));
+      for (std::size_t k = 1; k <= level_cnt; ++k) {
+        // The number of words at the current level within the block.
+        const auto word_cnt = block_word_cnt >> k;
+        const auto dst_word_idx = level_word_idx[k] + (b >> k);
+        const auto src_word_idx = level_word_idx[k - 1] + (b >> (k - 1));
+        for (std::size_t j = 0; j < word_cnt; ++j) {
+          u64 or_lo = labels_or[2 * j];
+          u64 or_hi = labels_or[2 * j + 1];
+          u64 and_lo = labels_and[2 * j];
+          u64 and_hi = labels_and[2 * j + 1];
+          u64 label_or = _pext_u64(or_lo | (or_lo >> 1), m) // FIXME non-portable code
+              | (_pext_u64(or_hi | (or_hi >> 1), m) << 32);
+          u64 label_and = _pext_u64(and_lo & (and_lo >> 1), m) // FIXME non-portable code
+              | (_pext_u64(and_hi & (and_hi >> 1), m) << 32);
+          // A node is an inner node if the labels in its subtree are mixed.
+          u64 inner = label_or ^ label_and;
+          collapse_cnt[k] += 64 - dtl::bits::pop_count(inner);
+          // The child nodes are inactive if the parent node is collapsed.
+          $u64 active_lo = _pdep_u64(inner, m); // FIXME non-portable code
+          $u64 active_hi = _pdep_u64(inner >> 32, m); // FIXME non-portable code
+          active_lo |= active_lo << 1;
+          active_hi |= active_hi << 1;
+
+          label_ptr[dst_word_idx + j] = label_or;
+          inner_ptr[dst_word_idx + j] = inner;
+          active_ptr[src_word_idx + 2 * j] = active_lo;
+          active_ptr[src_word_idx + 2 * j + 1] = active_hi;
+          labels_or[j] = label_or;
+          labels_and[j] = label_and;
+        }
+      }
+    }
+
+    // Determine the level at which prune_tree() would have terminated and
+    // revert the pruning of the levels above.
+    for (std::size_t k = 1; k <= level_cnt; ++k) {
+      auto node_cnt_in_next_higher_level = 1ull << (height - k);
+      auto leaf_node_cnt_in_next_higher_level = collapse_cnt[k];
+      auto inner_node_cnt_in_next_higher_level =
+          node_cnt_in_next_higher_level - collapse_cnt[k];
+      if (leaf_node_cnt_in_next_higher_level < inner_node_cnt_in_next_higher_level/2) {
+        pruning_terminated = true;
+        for (std::size_t j = k + 1; j <= level_cnt; ++j) {
+          const auto b = first_node_idx_at_level(height - j);
+          const auto e = first_node_idx_at_level(height - j + 1);
+          is_inner_node_.set(b + offset, e + offset);
+          is_active_node_.set(e + offset, 2 * e + 1 + offset);
+        }
+        break;
+      }
+    }
+    // Invalidate the counters.
+    counters_are_valid = false;
+    D(validate_active_nodes();)
+    return height - level_cnt;
+  }
+
   /// Determine the total number of tree nodes and which of these nodes need
   /// to be stored explicitly.
   void __attribute__((noinline))
@@ -699,12 +860,26 @@ public:
       std::size_t explicit_tree_node_cnt,
       std::size_t explicit_label_cnt,
       std::size_t perfect_level_cnt) {
+    return estimate_encoded_size_in_bytes(n_, explicit_tree_node_cnt,
+        explicit_label_cnt, perfect_level_cnt);
+  }
+
+  /// Estimates the size in bytes of a TEB with the given number of explicit
+  /// tree nodes and labels, where n refers to the length of the bitmap
+  /// (rounded up to the next power of two). This allows for estimating the
+  /// size of a TEB without constructing the bitmap tree.
+  static std::size_t __forceinline__
+  estimate_encoded_size_in_bytes(
+      u64 n,
+      std::size_t explicit_tree_node_cnt,
+      std::size_t explicit_label_cnt,
+      std::size_t perfect_level_cnt) {
     constexpr u64 block_bitlength = 64; // TODO remove magic number - refer to teb storage typse
     constexpr u64 block_size = block_bitlength / 8;
     $u64 bytes = 0;
 
     // Bit-length of the original bitmap.
-    bytes += sizeof(n_);
+    bytes += sizeof(n);
 
     // The stored length of the tree structure.
     bytes += 4;
@@ -724,7 +899,7 @@ public:
     // size of the header, T and R.
 
     // Level offsets for T and L, which are required by the tree scan algorithm.
-    const auto encoded_tree_height = dtl::log_2(n_) + 1; // FIXME could be lower, but its unlikely
+    const auto encoded_tree_height = dtl::log_2(n) + 1; // FIXME could be lower, but its unlikely
     assert(encoded_tree_height >= perfect_level_cnt);
 
     if (explicit_tree_node_cnt > 1024) {
@@ -895,7 +1070,7 @@ public:
         << l_os.str() << std::endl;
   }
 
-private:
+protected:
   /// Expands the VERY FIRST explicit node. // TODO generalize to expand arbitrary nodes
   template<u1 fast>
   void
@@ -1011,34 +1186,111 @@ private:
 #endif
   }
 
+  /// A snapshot of the counters and of the cached node indexes, which are
+  /// updated when the tree is modified.
+  struct counter_state {
+    std::size_t inner_node_cnt;
+    std::size_t leading_inner_node_cnt;
+    std::size_t trailing_leaf_node_cnt;
+    std::size_t leading_0label_cnt;
+    std::size_t trailing_0label_cnt;
+    range_t explicit_node_idxs;
+    std::size_t first_node_idx_with_1label;
+    std::size_t last_node_idx_with_1label;
+  };
+
+  /// Returns a snapshot of the current counters.
+  counter_state __forceinline__
+  save_counters() const noexcept {
+    return counter_state {
+        inner_node_cnt_,
+        leading_inner_node_cnt_,
+        trailing_leaf_node_cnt_,
+        leading_0label_cnt_,
+        trailing_0label_cnt_,
+        explicit_node_idxs_,
+        first_node_idx_with_1label_,
+        last_node_idx_with_1label_ };
+  }
+
+  /// Restores the counters from the given snapshot.
+  void __forceinline__
+  restore_counters(const counter_state& state) noexcept {
+    inner_node_cnt_ = state.inner_node_cnt;
+    leading_inner_node_cnt_ = state.leading_inner_node_cnt;
+    trailing_leaf_node_cnt_ = state.trailing_leaf_node_cnt;
+    leading_0label_cnt_ = state.leading_0label_cnt;
+    trailing_0label_cnt_ = state.trailing_0label_cnt;
+    explicit_node_idxs_ = state.explicit_node_idxs;
+    first_node_idx_with_1label_ = state.first_node_idx_with_1label;
+    last_node_idx_with_1label_ = state.last_node_idx_with_1label;
+  }
+
+  /// Reverts the expansions (see set_inner<true>) of the nodes within the
+  /// index range [begin, end). As the expansions do not update the active
+  /// node map, the expanded nodes are identified by their inactive child
+  /// nodes. The counters are NOT updated.
+  ///
+  /// This relies on the invariant that the left child of every inner node of
+  /// the pruned tree is active (i.e., the active node map is up to date when
+  /// run_optimize() starts), because otherwise, an original inner node would
+  /// be mistaken for an expanded one.
+  void __attribute__((noinline))
+  undo_expansions(u64 begin, u64 end) {
+    for (auto idx = begin; idx < end; ++idx) {
+      if (is_inner_node(idx) && !is_active_node(left_child_of(idx))) {
+        is_inner_node_.clear(idx + offset);
+      }
+    }
+  }
+
+  /// Gradual decompression. Starting with the pruned tree, the leaf nodes are
+  /// expanded one by one (in level order) to find the tree instance with the
+  /// minimum (estimated) size. The expansions are applied to the tree itself,
+  /// rather than to a copy, and the expansions beyond the minimum are undone
+  /// afterwards. Thus, the memory footprint does not increase.
   void __attribute__((noinline))
   run_optimize() {
     // Optimization level 2.
     if (optimization_level_ > 1) {
-      // Gradual decompression.
       // Find the tree instance with the minimum size.
       auto min_idx = explicit_node_idxs_.begin;
       auto min_level = level_of(min_idx);
       auto min_size = estimate_encoded_size_in_bytes();
       const std::size_t threshold = std::max(1024ul, uncompressed_size / 10);
-      auto cpy = *this; // Work with a copy.
 
+      // The state of the pruned tree.
+      const auto initial_counters = save_counters();
+#ifndef NDEBUG
+      // Validate the invariant that undo_expansions() relies on.
+      for (auto i = explicit_node_idxs_.begin;
+           i < first_node_idx_at_level(last_level()); ++i) {
+        assert(!is_inner_node(i) || is_active_node(left_child_of(i)));
+      }
+#endif
+      // The state of the tree instance with the minimum size.
+      auto min_counters = initial_counters;
+      // Identifies the tree instance with the minimum size, whose state is
+      // recorded in 'min_counters'. If false, the minimum is the initial tree.
+      $u1 min_is_expanded = false;
+
+      u64 start_idx = explicit_node_idxs_.begin;
       {
-        u64 start_idx = cpy.explicit_node_idxs_.begin;
-        $u64 idx = cpy.explicit_node_idxs_.begin;
+        $u64 idx = explicit_node_idxs_.begin;
         $u64 prev_idx = 0;
-        $u64 idx_level = cpy.level_of(idx);
+        // The expanded nodes are in [start_idx, expanded_idx_end).
+        $u64 expanded_idx_end = start_idx;
+        $u64 idx_level = level_of(idx);
         u64 last_pruning_level = last_level();
         $u64 old_level = idx_level;
-        auto prev_level_size = cpy.estimate_encoded_size_in_bytes();
-        auto prev_level_min_size = min_size;
+        auto prev_level_size = estimate_encoded_size_in_bytes();
         while (idx_level < last_pruning_level
             && !(min_level + 2 < idx_level)) {
-          assert(cpy.is_leaf_node(idx));
+          assert(is_leaf_node(idx));
 
           if (idx_level > old_level) {
             {
-              auto now_size = cpy.estimate_encoded_size_in_bytes();
+              auto now_size = estimate_encoded_size_in_bytes();
               if (now_size > prev_level_size && old_level != min_level) {
                 goto expand_done;
               }
@@ -1047,19 +1299,19 @@ private:
               }
             }
             old_level = idx_level;
-            if (idx_level < cpy.last_level()) {
-              auto last_explicit_node = cpy.explicit_node_idxs_.end - 1;
-              auto level_of_last_explicit_node = cpy.level_of(last_explicit_node);
+            if (idx_level < last_level()) {
+              auto last_explicit_node = explicit_node_idxs_.end - 1;
+              auto level_of_last_explicit_node = level_of(last_explicit_node);
               if (level_of_last_explicit_node == idx_level + 1) {
                 auto parent_of_last_explicit_node =
-                    cpy.parent_of(level_of_last_explicit_node);
-                auto x_b = cpy.first_node_idx_at_level(idx_level);
+                    parent_of(level_of_last_explicit_node);
+                auto x_b = first_node_idx_at_level(idx_level);
                 auto x_e = parent_of_last_explicit_node;
                 auto y_b = parent_of_last_explicit_node + 1;
-                auto y_e = cpy.first_node_idx_at_level(idx_level + 1);
-                i64 x_ones = cpy.is_inner_node_.count(x_b + offset, x_e + offset);
+                auto y_e = first_node_idx_at_level(idx_level + 1);
+                i64 x_ones = is_inner_node_.count(x_b + offset, x_e + offset);
                 i64 x_zeros = (x_e - x_b) - x_ones;
-                i64 y_ones = cpy.is_inner_node_.count(y_b + offset, y_e + offset);
+                i64 y_ones = is_inner_node_.count(y_b + offset, y_e + offset);
                 i64 y_zeros = (y_e - y_b) - y_ones;
                 auto r = -(x_zeros + y_zeros) + 2 * x_zeros - (x_ones + y_ones);
                 if (r > 0) {
@@ -1067,9 +1319,9 @@ private:
                 }
               }
               else {
-                auto b = cpy.first_node_idx_at_level(idx_level);
-                auto e = cpy.first_node_idx_at_level(idx_level + 1);
-                auto ones = cpy.is_inner_node_.count(
+                auto b = first_node_idx_at_level(idx_level);
+                auto e = first_node_idx_at_level(idx_level + 1);
+                auto ones = is_inner_node_.count(
                     b + offset,
                     e + offset);
                 auto zeros = (e - b) - ones;
@@ -1080,13 +1332,16 @@ private:
             }
           }
 
-          cpy.template set_inner<true>(idx);
-          const auto compressed_size = cpy.estimate_encoded_size_in_bytes();
+          set_inner<true>(idx);
+          expanded_idx_end = idx + 1;
+          const auto compressed_size = estimate_encoded_size_in_bytes();
           // Estimates the size of a TEB.
           if (compressed_size <= min_size) { // less than or EQUAL because we prefer more balanced trees.
             min_idx = idx;
-            min_level = cpy.level_of(idx);
+            min_level = level_of(idx);
             min_size = compressed_size;
+            min_counters = save_counters();
+            min_is_expanded = true;
           }
           if (compressed_size > min_size + threshold) {
             goto expand_done;
@@ -1102,20 +1357,19 @@ private:
           // Within that range, T can increase and decrease in size.
           //  with every expand, 1-bit is added to T, however there may be
           //  following inner nodes which then become implicit.
-          if (cpy.explicit_node_idxs_.begin > cpy.explicit_node_idxs_.end) {
+          if (explicit_node_idxs_.begin > explicit_node_idxs_.end) {
             goto tree_implicit;
           }
 
           // Next
           prev_idx = idx;
-          idx = cpy.explicit_node_idxs_.begin;
-          idx_level = cpy.level_of(idx);
+          idx = explicit_node_idxs_.begin;
+          idx_level = level_of(idx);
         }
 
         // Check if decompression stopped at the minimum sized tree.
         if (min_idx == prev_idx) {
-          // Take the working copy as is.
-          *this = cpy;
+          // Keep the current tree instance.
           // Fix active node map.
           is_active_node_.set(start_idx + offset,
               std::min(max_node_cnt_, right_child_of(idx) + 1) + offset);
@@ -1126,8 +1380,7 @@ private:
         goto expand_done;
 
 tree_implicit:
-        // Take the working copy as is.
-        *this = cpy;
+        // Keep the current tree instance.
         // Fix active node map.
         is_active_node_.set(start_idx + offset,
             std::min(max_node_cnt_, right_child_of(idx) + 1) + offset);
@@ -1142,13 +1395,23 @@ expand_done:
           uncompress();
           return;
         }
+
+        // Revert the expansions beyond the tree instance with the minimum
+        // size.
+        if (min_is_expanded) {
+          undo_expansions(min_idx + 1, expanded_idx_end);
+          restore_counters(min_counters);
+        }
+        else {
+          undo_expansions(start_idx, expanded_idx_end);
+          restore_counters(initial_counters);
+        }
       }
 
-      // Restore the tree instance with the minimum size. Expand the tree down
-      // to the node 'min_idx' which identifies the smallest tree instance found
-      // in the previous step.
+      // Expand the tree down to the node 'min_idx' which identifies the
+      // smallest tree instance found in the previous step. If the expansions
+      // have been reverted to that instance already, this is a no-op.
       {
-        const auto start_idx = explicit_node_idxs_.begin;
         const std::size_t expand_until_idx =
             std::min(first_node_idx_at_level(height_) - 1, min_idx);
         while (explicit_node_idxs_.begin <= expand_until_idx) {
@@ -0,0 +1,452 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include "bitmap_fun.hpp"
+
+#include <dtl/bits.hpp>
+#include <dtl/dtl.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+//===----------------------------------------------------------------------===//
+namespace dtl {
+//===----------------------------------------------------------------------===//
+/// Static functions to encode and decode the literal words of the hybrid
+/// run-length encodings XAH and UAH. A literal word stores payload_bit_cnt
+/// consecutive bits of the plain bitmap in its upper bits, the least
+/// significant bit (the fill flag) is 0.
+///
+/// Multiple literal words are processed at a time, using AVX2 or AVX-512. The
+/// SIMD implementations operate on 64-bit lanes, each holding a payload and
+/// its bit offset within a byte. Thus, they are only used for word types with
+/// at most 32 bits. 64-bit words are processed one at a time.
+template<typename _word_type>
+struct hybrid_fun {
+  using word_type = _word_type;
+  static constexpr std::size_t word_bitlength = sizeof(word_type) * 8;
+  /// The number of bits that can be stored in a literal word.
+  static constexpr std::size_t payload_bit_cnt = word_bitlength - 1;
+  static constexpr $u64 payload_mask = (1ull << payload_bit_cnt) - 1;
+  /// True, if the SIMD implementations can be used.
+  static constexpr u1 simd_enabled = word_bitlength <= 32;
+
+  /// Fetch cnt (<= 63) consecutive bits of the given plain bitmap, starting
+  /// at position b.
+  static inline $u64
+  fetch_payload(const $u32* bitmap, const std::size_t b, const std::size_t cnt) {
+    assert(cnt > 0 && cnt < 64);
+    std::size_t block_idx = b / 32;
+    std::size_t fetched_cnt = 32 - (b % 32);
+    $u64 bits = bitmap[block_idx] >> (b % 32);
+    while (fetched_cnt < cnt) {
+      ++block_idx;
+      bits |= $u64(bitmap[block_idx]) << fetched_cnt;
+      fetched_cnt += 32;
+    }
+    return bits & ((1ull << cnt) - 1);
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Encoding
+  //===--------------------------------------------------------------------===//
+  /// Encodes the consecutive chunks of payload_bit_cnt bits of the given plain
+  /// bitmap of length n, starting at bit position b, as literal words. Stops
+  /// at the first chunk that is all 0 or all 1, at the first incomplete chunk,
+  /// or after max_cnt chunks. The literal words are written to 'dst', which
+  /// must have space for max_cnt words. Returns the number of literal words.
+  static inline std::size_t
+  encode_literals(const $u32* bitmap, const std::size_t b, const std::size_t n,
+      word_type* dst, const std::size_t max_cnt) {
+    std::size_t cnt = 0;
+    if (simd_enabled) {
+#ifdef __AVX512F__
+      cnt = encode_literals_avx512(bitmap, b, n, dst, max_cnt);
+#elif __AVX2__
+      cnt = encode_literals_avx2(bitmap, b, n, dst, max_cnt);
+#endif
+    }
+    // Process the remaining chunks, which could not be processed in batches.
+    return cnt + encode_literals_x86(bitmap, b + cnt * payload_bit_cnt, n,
+        dst + cnt, max_cnt - cnt);
+  }
+
+  /// Fall back implementation of 'encode_literals()'; when neither AVX2 nor
+  /// AVX512 is available.
+  static inline std::size_t
+  encode_literals_x86(const $u32* bitmap, std::size_t b, const std::size_t n,
+      word_type* dst, const std::size_t max_cnt) {
+    std::size_t cnt = 0;
+    while (cnt < max_cnt && b + payload_bit_cnt <= n) {
+      const $u64 payload = fetch_payload(bitmap, b, payload_bit_cnt);
+      if (payload == 0 || payload == payload_mask) break;
+      dst[cnt] = static_cast<word_type>(payload << 1);
+      ++cnt;
+      b += payload_bit_cnt;
+    }
+    return cnt;
+  }
+
+#ifdef __AVX2__
+  /// AVX2 implementation of 'encode_literals()'. Classifies and encodes 4
+  /// chunks at a time. Each chunk is gathered from the plain bitmap using an
+  /// unaligned 8-byte load and shifted by its bit offset.
+  static inline std::size_t
+  encode_literals_avx2(const $u32* bitmap, std::size_t b, const std::size_t n,
+      word_type* dst, const std::size_t max_cnt) {
+    constexpr std::size_t lane_cnt = 4;
+    // The number of bytes that can be read from the plain bitmap.
+    const std::size_t byte_cnt = ((n + 31) / 32) * sizeof($u32);
+    const auto* bytes = reinterpret_cast<const long long*>(bitmap);
+    const __m256i lane_offsets = _mm256_setr_epi64x(
+        0, payload_bit_cnt, 2 * payload_bit_cnt, 3 * payload_bit_cnt);
+    const __m256i mask = _mm256_set1_epi64x(payload_mask);
+    const __m256i seven = _mm256_set1_epi64x(7);
+    const __m256i zero = _mm256_setzero_si256();
+    alignas(32) $u64 literals[lane_cnt];
+    std::size_t cnt = 0;
+    while (cnt + lane_cnt <= max_cnt) {
+      const std::size_t e = b + lane_cnt * payload_bit_cnt;
+      // The chunks need to be complete, and the 8-byte loads must not exceed
+      // the plain bitmap.
+      if (e > n || (e - payload_bit_cnt) / 8 + 8 > byte_cnt) break;
+      const __m256i pos = _mm256_add_epi64(
+          _mm256_set1_epi64x(static_cast<long long>(b)), lane_offsets);
+      __m256i v = _mm256_i64gather_epi64(bytes, _mm256_srli_epi64(pos, 3), 1);
+      v = _mm256_and_si256(
+          _mm256_srlv_epi64(v, _mm256_and_si256(pos, seven)), mask);
+      const __m256i is_fill = _mm256_or_si256(
+          _mm256_cmpeq_epi64(v, zero), _mm256_cmpeq_epi64(v, mask));
+      const $u32 fill_mask = static_cast<$u32>(
+          _mm256_movemask_pd(_mm256_castsi256_pd(is_fill)));
+      // Note: All lanes are written, but only the literals up to the first
+      //       fill are valid.
+      _mm256_store_si256(reinterpret_cast<__m256i*>(literals),
+          _mm256_slli_epi64(v, 1));
+      for (std::size_t l = 0; l < lane_cnt; ++l) {
+        dst[cnt + l] = static_cast<word_type>(literals[l]);
+      }
+      if (fill_mask != 0) {
+        return cnt + dtl::bits::tz_count(fill_mask);
+      }
+      cnt += lane_cnt;
+      b = e;
+    }
+    return cnt;
+  }
+#endif
+
+#ifdef __AVX512F__
+  /// AVX-512 implementation of 'encode_literals()'. Classifies and encodes 8
+  /// chunks at a time.
+  static inline std::size_t
+  encode_literals_avx512(const $u32* bitmap, std::size_t b, const std::size_t n,
+      word_type* dst, const std::size_t max_cnt) {
+    constexpr std::size_t lane_cnt = 8;
+    // The number of bytes that can be read from the plain bitmap.
+    const std::size_t byte_cnt = ((n + 31) / 32) * sizeof($u32);
+    const __m512i lane_offsets = _mm512_set_epi64(
+        7 * payload_bit_cnt, 6 * payload_bit_cnt, 5 * payload_bit_cnt,
+        4 * payload_bit_cnt, 3 * payload_bit_cnt, 2 * payload_bit_cnt,
+        payload_bit_cnt, 0);
+    const __m512i mask = _mm512_set1_epi64(payload_mask);
+    const __m512i seven = _mm512_set1_epi64(7);
+    const __m512i zero = _mm512_setzero_si512();
+    std::size_t cnt = 0;
+    while (cnt + lane_cnt <= max_cnt) {
+      const std::size_t e = b + lane_cnt * payload_bit_cnt;
+      // The chunks need to be complete, and the 8-byte loads must not exceed
+      // the plain bitmap.
+      if (e > n || (e - payload_bit_cnt) / 8 + 8 > byte_cnt) break;
+      const __m512i pos = _mm512_add_epi64(
+          _mm512_set1_epi64(static_cast<long long>(b)), lane_offsets);
+      __m512i v = _mm512_i64gather_epi64(
+          _mm512_srli_epi64(pos, 3), bitmap, 1);
+      v = _mm512_and_si512(
+          _mm512_srlv_epi64(v, _mm512_and_si512(pos, seven)), mask);
+      const $u32 fill_mask = static_cast<$u32>(
+          _mm512_cmpeq_epi64_mask(v, zero) | _mm512_cmpeq_epi64_mask(v, mask));
+      // Note: All lanes are written, but only the literals up to the first
+      //       fill are valid.
+      store_words_avx512(dst + cnt, _mm512_slli_epi64(v, 1));
+      if (fill_mask != 0) {
+        return cnt + dtl::bits::tz_count(fill_mask);
+      }
+      cnt += lane_cnt;
+      b = e;
+    }
+    return cnt;
+  }
+
+  /// Stores the 8 (64-bit) lanes as words, using a narrowing store.
+  static inline void
+  store_words_avx512(word_type* dst, const __m512i v) {
+    switch (sizeof(word_type)) {
+      case 1: _mm512_mask_cvtepi64_storeu_epi8(dst, __mmask8(0xff), v); break;
+      case 2: _mm512_mask_cvtepi64_storeu_epi16(dst, __mmask8(0xff), v); break;
+      case 4: _mm512_mask_cvtepi64_storeu_epi32(dst, __mmask8(0xff), v); break;
+      default: _mm512_storeu_si512(dst, v);
+    }
+  }
+#endif
+
+  //===--------------------------------------------------------------------===//
+  // Decoding
+  //===--------------------------------------------------------------------===//
+  /// Returns the index of the first fill word in [begin, end). If there is no
+  /// such word, the number of words is returned. Used to determine the number
+  /// of consecutive literal words.
+  static inline std::size_t
+  find_first_fill_word(const word_type* begin, const word_type* end) {
+#ifdef __AVX512BW__
+    return find_first_fill_word_avx512(begin, end);
+#elif __AVX2__
+    return find_first_fill_word_avx2(begin, end);
+#else
+    return find_first_fill_word_x86(begin, end);
+#endif
+  }
+
+  /// Fall back implementation of 'find_first_fill_word()'; when neither AVX2
+  /// nor AVX512 is available.
+  static inline std::size_t
+  find_first_fill_word_x86(const word_type* begin, const word_type* end) {
+    const std::size_t word_cnt = end - begin;
+    std::size_t i = 0;
+    while (i < word_cnt && (begin[i] & word_type(1)) == 0) {
+      ++i;
+    }
+    return i;
+  }
+
+#ifdef __AVX2__
+  /// AVX2 implementation of 'find_first_fill_word()'. Tests 32 bytes at a
+  /// time.
+  static inline std::size_t
+  find_first_fill_word_avx2(const word_type* begin, const word_type* end) {
+    const std::size_t word_cnt = end - begin;
+    constexpr std::size_t words_per_vec = sizeof(__m256i) / sizeof(word_type);
+    // Only the fill flags remain (in the lowest byte of each word).
+    const __m256i flag_v = _mm256_set1_epi64x(static_cast<long long>(
+        bitmap_fun<word_type>::replicate_word(word_type(1))));
+    const __m256i zero = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + words_per_vec <= word_cnt; i += words_per_vec) {
+      const __m256i d = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(begin + i));
+      const $u32 fill_mask = ~static_cast<$u32>(_mm256_movemask_epi8(
+          _mm256_cmpeq_epi8(_mm256_and_si256(d, flag_v), zero)));
+      if (fill_mask != 0) {
+        return i + dtl::bits::tz_count(fill_mask) / sizeof(word_type);
+      }
+    }
+    return i + find_first_fill_word_x86(begin + i, end);
+  }
+#endif
+
+#ifdef __AVX512BW__
+  /// AVX-512 implementation of 'find_first_fill_word()'. Tests 64 bytes at a
+  /// time.
+  static inline std::size_t
+  find_first_fill_word_avx512(const word_type* begin, const word_type* end) {
+    const std::size_t word_cnt = end - begin;
+    constexpr std::size_t words_per_vec = sizeof(__m512i) / sizeof(word_type);
+    const __m512i flag_v = _mm512_set1_epi64(static_cast<long long>(
+        bitmap_fun<word_type>::replicate_word(word_type(1))));
+    std::size_t i = 0;
+    for (; i + words_per_vec <= word_cnt; i += words_per_vec) {
+      const __m512i d = _mm512_loadu_si512(
+          reinterpret_cast<const void*>(begin + i));
+      const $u64 fill_mask = _mm512_test_epi8_mask(d, flag_v);
+      if (fill_mask != 0) {
+        return i + dtl::bits::tz_count(fill_mask) / sizeof(word_type);
+      }
+    }
+    return i + find_first_fill_word_x86(begin + i, end);
+  }
+#endif
+
+  /// Decodes the given cnt (complete) literal words and stores their payloads
+  /// in the plain bitmap 'dst', starting at bit position b.
+  static inline void
+  decode_literals(const word_type* src, std::size_t cnt, $u64* dst,
+      std::size_t b) {
+#if defined(__AVX512F__) || defined(__AVX2__)
+    // Short runs are decoded one at a time, as the SIMD implementation does
+    // not pay off.
+    if (simd_enabled && cnt >= decode_simd_min_cnt) {
+      // The literals are decoded in batches, using a scratch buffer.
+      while (cnt > 0) {
+        const std::size_t batch_cnt = std::min(cnt, std::size_t(decode_batch_size));
+        decode_literal_batch(src, batch_cnt, dst, b);
+        src += batch_cnt;
+        cnt -= batch_cnt;
+        b += batch_cnt * payload_bit_cnt;
+      }
+      return;
+    }
+#endif
+    decode_literals_x86(src, cnt, dst, b);
+  }
+
+  /// Fall back implementation of 'decode_literals()'; when neither AVX2 nor
+  /// AVX512 is available.
+  static inline void
+  decode_literals_x86(const word_type* src, const std::size_t cnt, $u64* dst,
+      std::size_t b) {
+    using fn = dtl::bitmap_fun<$u64>;
+    for (std::size_t i = 0; i < cnt; ++i) {
+      fn::store_bits(dst, b, b + payload_bit_cnt,
+          static_cast<$u64>(src[i] >> 1));
+      b += payload_bit_cnt;
+    }
+  }
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+  /// The max. number of literal words that are decoded in one batch.
+  static constexpr std::size_t decode_batch_size = 1024;
+  /// The min. number of literal words for the SIMD implementation to be used.
+  static constexpr std::size_t decode_simd_min_cnt = 16;
+  /// The max. number of payloads that contribute to a single (64-bit) word of
+  /// the plain bitmap.
+  static constexpr std::size_t decode_term_cnt =
+      (payload_bit_cnt + 62) / payload_bit_cnt + 1;
+  /// The payload index of an output word is determined using a multiplication
+  /// instead of a division, which is exact for bit offsets < 2^16.
+  static constexpr std::size_t div_shift = 22;
+  static constexpr $u64 div_mul =
+      ((1ull << div_shift) + payload_bit_cnt - 1) / payload_bit_cnt;
+  static_assert(decode_batch_size * payload_bit_cnt < (1ull << 16)
+          || !simd_enabled,
+      "The bit offsets within a batch must be less than 2^16.");
+
+  /// Decodes up to decode_batch_size literal words. The words of the plain
+  /// bitmap that are entirely covered by the literals are assembled multiple
+  /// at a time, from the payloads that overlap with them. The (partially
+  /// covered) words at the boundaries are written one payload at a time.
+  static inline void
+  decode_literal_batch(const word_type* src, const std::size_t cnt, $u64* dst,
+      const std::size_t b) {
+    assert(cnt <= decode_batch_size);
+    // The zero-extended payloads, padded with zeros.
+    alignas(64) $u64 payloads[decode_batch_size + decode_term_cnt];
+    for (std::size_t i = 0; i < cnt; ++i) {
+      payloads[i] = static_cast<$u64>(src[i] >> 1);
+    }
+    for (std::size_t i = cnt; i < cnt + decode_term_cnt; ++i) {
+      payloads[i] = 0;
+    }
+    const std::size_t e = b + cnt * payload_bit_cnt;
+    // The range of output words that are entirely covered.
+    const std::size_t out_begin = (b + 63) / 64;
+    const std::size_t out_end = std::max(out_begin, e / 64);
+#ifdef __AVX512F__
+    const std::size_t out_simd_end =
+        decode_words_avx512(payloads, dst, b, out_begin, out_end);
+#else
+    const std::size_t out_simd_end =
+        decode_words_avx2(payloads, dst, b, out_begin, out_end);
+#endif
+    // Write the payloads that overlap with the remaining words one at a time.
+    // Bits that have already been written above, are written again with the
+    // same values.
+    using fn = dtl::bitmap_fun<$u64>;
+    const std::size_t head_end = (out_begin == out_simd_end)
+        ? cnt
+        : std::min(cnt,
+            (out_begin * 64 - b + payload_bit_cnt - 1) / payload_bit_cnt);
+    const std::size_t tail_begin = (out_begin == out_simd_end)
+        ? cnt
+        : (out_simd_end * 64 - b) / payload_bit_cnt;
+    for (std::size_t i = 0; i < head_end; ++i) {
+      const auto p = b + i * payload_bit_cnt;
+      fn::store_bits(dst, p, p + payload_bit_cnt, payloads[i]);
+    }
+    for (std::size_t i = tail_begin; i < cnt; ++i) {
+      const auto p = b + i * payload_bit_cnt;
+      fn::store_bits(dst, p, p + payload_bit_cnt, payloads[i]);
+    }
+  }
+#endif
+
+#ifdef __AVX2__
+  /// AVX2 implementation of the assembly of the output words, 4 words at a
+  /// time. Returns the end of the range of output words that have been
+  /// written.
+  static inline std::size_t
+  decode_words_avx2(const $u64* payloads, $u64* dst, const std::size_t b,
+      const std::size_t out_begin, const std::size_t out_end) {
+    constexpr std::size_t lane_cnt = 4;
+    const auto* src = reinterpret_cast<const long long*>(payloads);
+    const __m256i lane_offsets = _mm256_setr_epi64x(0, 64, 128, 192);
+    const __m256i mul = _mm256_set1_epi64x(div_mul);
+    const __m256i w = _mm256_set1_epi64x(payload_bit_cnt);
+    std::size_t o = out_begin;
+    for (; o + lane_cnt <= out_end; o += lane_cnt) {
+      // The bit offsets of the output words, relative to the first literal.
+      const __m256i r = _mm256_add_epi64(
+          _mm256_set1_epi64x(static_cast<long long>(o * 64 - b)),
+          lane_offsets);
+      // The index of the first payload and the offset within that payload.
+      __m256i k = _mm256_srli_epi64(_mm256_mul_epu32(r, mul), div_shift);
+      const __m256i s = _mm256_sub_epi64(r, _mm256_mul_epu32(k, w));
+      __m256i acc = _mm256_srlv_epi64(_mm256_i64gather_epi64(src, k, 8), s);
+      // Shift the subsequent payloads into place. Shifts by 64 or more bits
+      // result in 0.
+      __m256i sh = _mm256_sub_epi64(w, s);
+      for (std::size_t t = 1; t < decode_term_cnt; ++t) {
+        k = _mm256_add_epi64(k, _mm256_set1_epi64x(1));
+        acc = _mm256_or_si256(acc,
+            _mm256_sllv_epi64(_mm256_i64gather_epi64(src, k, 8), sh));
+        sh = _mm256_add_epi64(sh, w);
+      }
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + o), acc);
+    }
+    return o;
+  }
+#endif
+
+#ifdef __AVX512F__
+  /// AVX-512 implementation of the assembly of the output words, 8 words at a
+  /// time. Returns the end of the range of output words that have been
+  /// written.
+  static inline std::size_t
+  decode_words_avx512(const $u64* payloads, $u64* dst, const std::size_t b,
+      const std::size_t out_begin, const std::size_t out_end) {
+    constexpr std::size_t lane_cnt = 8;
+    const __m512i lane_offsets = _mm512_set_epi64(
+        448, 384, 320, 256, 192, 128, 64, 0);
+    const __m512i mul = _mm512_set1_epi64(div_mul);
+    const __m512i w = _mm512_set1_epi64(payload_bit_cnt);
+    const __m512i one = _mm512_set1_epi64(1);
+    std::size_t o = out_begin;
+    for (; o + lane_cnt <= out_end; o += lane_cnt) {
+      // The bit offsets of the output words, relative to the first literal.
+      const __m512i r = _mm512_add_epi64(
+          _mm512_set1_epi64(static_cast<long long>(o * 64 - b)),
+          lane_offsets);
+      // The index of the first payload and the offset within that payload.
+      __m512i k = _mm512_srli_epi64(_mm512_mul_epu32(r, mul), div_shift);
+      const __m512i s = _mm512_sub_epi64(r, _mm512_mul_epu32(k, w));
+      __m512i acc = _mm512_srlv_epi64(
+          _mm512_i64gather_epi64(k, payloads, 8), s);
+      // Shift the subsequent payloads into place. Shifts by 64 or more bits
+      // result in 0.
+      __m512i sh = _mm512_sub_epi64(w, s);
+      for (std::size_t t = 1; t < decode_term_cnt; ++t) {
+        k = _mm512_add_epi64(k, one);
+        acc = _mm512_or_si512(acc,
+            _mm512_sllv_epi64(_mm512_i64gather_epi64(k, payloads, 8), sh));
+        sh = _mm512_add_epi64(sh, w);
+      }
+      _mm512_storeu_si512(dst + o, acc);
+    }
+    return o;
+  }
+#endif
+};
+//===----------------------------------------------------------------------===//
+} // namespace dtl
@@ -262,6 +262,83 @@ public:
     return std::move(ret);
   }
 
+  /// Bitwise AND (in-place)
+  plain_bitmap& __forceinline__
+  operator&=(const plain_bitmap& other) {
+    assert(size() == other.size());
+    const word_type* operands[] = { this->data_begin(), other.data_begin() };
+    fn::bitwise_and_n(this->data_begin(), this->data_end(), operands, 2);
+    return *this;
+  }
+
+  /// Bitwise OR (in-place)
+  plain_bitmap& __forceinline__
+  operator|=(const plain_bitmap& other) {
+    assert(size() == other.size());
+    const word_type* operands[] = { this->data_begin(), other.data_begin() };
+    fn::bitwise_or_n(this->data_begin(), this->data_end(), operands, 2);
+    return *this;
+  }
+
+  /// Bitwise XOR (in-place)
+  plain_bitmap& __forceinline__
+  operator^=(const plain_bitmap& other) {
+    assert(size() == other.size());
+    const word_type* operands[] = { this->data_begin(), other.data_begin() };
+    fn::bitwise_xor_n(this->data_begin(), this->data_end(), operands, 2);
+    return *this;
+  }
+
+  /// Computes an arbitrary bitwise function of three bitmaps in a single pass
+  /// without materializing intermediate results. The function is given by
+  /// its truth table (see bitmap_fun::ternary_a), e.g., a & b & ~c is
+  /// computed by ternary<u8(fn::ternary_a & fn::ternary_b & ~fn::ternary_c)>.
+  template<u8 _imm8>
+  static plain_bitmap __forceinline__
+  ternary(const plain_bitmap& a, const plain_bitmap& b, const plain_bitmap& c) {
+    assert(a.size() == b.size());
+    assert(a.size() == c.size());
+    plain_bitmap ret(a.size(), false);
+    fn::template bitwise_ternary<_imm8>(
+        ret.data_begin(), ret.data_end(),
+        a.data_begin(), b.data_begin(), c.data_begin());
+    return ret;
+  }
+
+  /// Computes this = f(this, b, c) in-place, where f is given by its truth
+  /// table (see ternary()).
+  template<u8 _imm8>
+  plain_bitmap& __forceinline__
+  ternary_assign(const plain_bitmap& b, const plain_bitmap& c) {
+    assert(size() == b.size());
+    assert(size() == c.size());
+    fn::template bitwise_ternary<_imm8>(
+        this->data_begin(), this->data_end(),
+        this->data_begin(), b.data_begin(), c.data_begin());
+    return *this;
+  }
+
+  /// Bitwise AND of this bitmap and all the given bitmaps (in-place). The
+  /// result is computed in a single, cache-blocked pass.
+  plain_bitmap&
+  and_assign(const std::vector<const plain_bitmap*>& others) {
+    return apply_n_assign(others, fn::bitwise_and_n);
+  }
+
+  /// Bitwise OR of this bitmap and all the given bitmaps (in-place). The
+  /// result is computed in a single, cache-blocked pass.
+  plain_bitmap&
+  or_assign(const std::vector<const plain_bitmap*>& others) {
+    return apply_n_assign(others, fn::bitwise_or_n);
+  }
+
+  /// Bitwise XOR of this bitmap and all the given bitmaps (in-place). The
+  /// result is computed in a single, cache-blocked pass.
+  plain_bitmap&
+  xor_assign(const std::vector<const plain_bitmap*>& others) {
+    return apply_n_assign(others, fn::bitwise_xor_n);
+  }
+
   /// Test for equality.
   $u1
   operator==(const plain_bitmap& other) const {
@@ -341,8 +418,14 @@ public:
     return ret_val;
   }
 
+  /// Counts the number of set bits.
+  std::size_t __forceinline__
+  count() const noexcept {
+    return count(0, n_);
+  }
+
   /// Counts the number of set bits within the range [b,e).
-  std::size_t __attribute__((noinline))
+  std::size_t __forceinline__
   count(std::size_t b, std::size_t e) const noexcept {
     const auto ret_val = fn::count(bitmap_.data(), b, e);
 #ifndef NDEBUG
@@ -355,6 +438,33 @@ public:
     return ret_val;
   }
 
+  /// Counts the number of set bits in the bitwise AND of this and the other
+  /// bitmap, without materializing the result.
+  std::size_t __forceinline__
+  and_count(const plain_bitmap& other) const noexcept {
+    return and_count(other, 0, n_);
+  }
+
+  /// Counts the number of set bits in the bitwise AND of this and the other
+  /// bitmap within the range [b,e).
+  std::size_t __forceinline__
+  and_count(const plain_bitmap& other, std::size_t b, std::size_t e)
+      const noexcept {
+    assert(size() == other.size());
+    assert(b <= e);
+    assert(e <= n_);
+    const auto ret_val = fn::and_count(
+        bitmap_.data(), other.bitmap_.data(), b, e);
+#ifndef NDEBUG
+    std::size_t cntr = 0;
+    for (std::size_t i = b; i <  e; ++i) {
+      cntr += test(i) && other.test(i);
+    }
+    assert(cntr == ret_val);
+#endif
+    return ret_val;
+  }
+
   void
   print(std::ostream& os) const noexcept {
     for (std::size_t i = 0; i < n_; ++i) {
@@ -367,6 +477,23 @@ public:
   writer(std::size_t start_idx) {
     return bitmap_writer<word_type>(bitmap_.data(), start_idx);
   }
+
+private:
+  /// Applies the given n-ary bitmap function (in-place).
+  template<typename fn_t>
+  plain_bitmap&
+  apply_n_assign(const std::vector<const plain_bitmap*>& others, fn_t fun) {
+    std::vector<const word_type*> operands;
+    operands.reserve(others.size() + 1);
+    operands.push_back(this->data_begin());
+    for (auto* other : others) {
+      assert(size() == other->size());
+      operands.push_back(other->data_begin());
+    }
+    fun(this->data_begin(), this->data_end(),
+        operands.data(), operands.size());
+    return *this;
+  }
 };
 //===----------------------------------------------------------------------===//
 } // namespace dtl
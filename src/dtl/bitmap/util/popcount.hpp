@@ -0,0 +1,350 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include <dtl/bits.hpp>
+#include <dtl/dtl.hpp>
+
+#include <algorithm>
+#include <cstddef>
+
+#include <immintrin.h>
+//===----------------------------------------------------------------------===//
+namespace dtl {
+//===----------------------------------------------------------------------===//
+/// Population count over (large) arrays of 64-bit words.
+///
+/// Three implementations are provided, (i) a scalar one, (ii) the Harley-Seal
+/// carry-save adder approach using AVX2 (Mula, Kurz, Lemire: Faster
+/// Population Counts Using AVX2 Instructions), and (iii) one based on the
+/// AVX-512 VPOPCNTDQ instruction. The SIMD implementations are compiled using
+/// target attributes, i.e., independent of the compiler flags, and the
+/// fastest one supported by the CPU is selected at runtime.
+struct popcount {
+  using word_type = $u64;
+
+  /// The signature of the popcount kernels. If 'b' is not a nullptr, the
+  /// bitwise AND of 'a' and 'b' is counted.
+  using kernel_fn = std::size_t (*)(
+      const word_type* a, const word_type* b, std::size_t word_cnt);
+
+  /// The signature of the block-wise popcount kernels.
+  using block_kernel_fn = std::size_t (*)(
+      const word_type* data, std::size_t word_cnt,
+      std::size_t words_per_block, $u32* prefix_cnt);
+
+  /// Arrays smaller than this are counted using the scalar implementation,
+  /// to avoid the overhead of the indirect function call.
+  static constexpr std::size_t dispatch_threshold = 16;
+
+  /// Counts the set bits in the given array of words.
+  static std::size_t __forceinline__
+  count(const word_type* data, const std::size_t word_cnt) {
+    if (word_cnt < dispatch_threshold) {
+      return count_x86(data, nullptr, word_cnt);
+    }
+    return get_kernel()(data, nullptr, word_cnt);
+  }
+
+  /// Counts the set bits in the bitwise AND of the given arrays, without
+  /// materializing the intermediate result.
+  static std::size_t __forceinline__
+  and_count(const word_type* a, const word_type* b,
+      const std::size_t word_cnt) {
+    if (word_cnt < dispatch_threshold) {
+      return count_x86(a, b, word_cnt);
+    }
+    return get_kernel()(a, b, word_cnt);
+  }
+
+  /// Counts the set bits block-wise, where each block consists of
+  /// 'words_per_block' words (except for the last one). The number of set
+  /// bits preceding the i-th block is written to prefix_cnt[i]. Returns the
+  /// total number of set bits. Used to construct rank lookup tables.
+  static std::size_t __forceinline__
+  block_count(const word_type* data, const std::size_t word_cnt,
+      const std::size_t words_per_block, $u32* prefix_cnt) {
+    return get_block_kernel()(data, word_cnt, words_per_block, prefix_cnt);
+  }
+
+  /// Returns the name of the implementation selected at runtime.
+  static const char*
+  name() {
+    const auto kernel = get_kernel();
+    if (kernel == &count_avx512) return "avx512";
+    if (kernel == &count_avx2) return "avx2";
+    return "x86";
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Scalar implementation.
+  //===--------------------------------------------------------------------===//
+  static std::size_t
+  count_x86(const word_type* a, const word_type* b, std::size_t word_cnt) {
+    std::size_t cnt[4] = {0, 0, 0, 0};
+    std::size_t i = 0;
+    for (; i + 4 <= word_cnt; i += 4) {
+      for (std::size_t j = 0; j < 4; ++j) {
+        cnt[j] += dtl::bits::pop_count(load(a, b, i + j));
+      }
+    }
+    for (; i < word_cnt; ++i) {
+      cnt[0] += dtl::bits::pop_count(load(a, b, i));
+    }
+    return cnt[0] + cnt[1] + cnt[2] + cnt[3];
+  }
+
+  static std::size_t
+  block_count_x86(const word_type* data, std::size_t word_cnt,
+      std::size_t words_per_block, $u32* prefix_cnt) {
+    std::size_t total = 0;
+    std::size_t block_idx = 0;
+    for (std::size_t i = 0; i < word_cnt; i += words_per_block) {
+      prefix_cnt[block_idx++] = static_cast<$u32>(total);
+      const std::size_t end = std::min(i + words_per_block, word_cnt);
+      for (std::size_t j = i; j < end; ++j) {
+        total += dtl::bits::pop_count(data[j]);
+      }
+    }
+    return total;
+  }
+
+  //===--------------------------------------------------------------------===//
+  // AVX2 implementation (Harley-Seal).
+  //===--------------------------------------------------------------------===//
+  static std::size_t __attribute__((target("avx2")))
+  count_avx2(const word_type* a, const word_type* b, std::size_t word_cnt) {
+    constexpr std::size_t words_per_vec = sizeof(__m256i) / sizeof(word_type);
+    const std::size_t vec_cnt = word_cnt / words_per_vec;
+
+    __m256i total = _mm256_setzero_si256();
+    __m256i ones = _mm256_setzero_si256();
+    __m256i twos = _mm256_setzero_si256();
+    __m256i fours = _mm256_setzero_si256();
+    __m256i eights = _mm256_setzero_si256();
+    __m256i sixteens;
+    __m256i twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+
+    std::size_t i = 0;
+    for (; i + 16 <= vec_cnt; i += 16) {
+      csa_avx2(twos_a, ones, ones,
+          load_avx2(a, b, i + 0), load_avx2(a, b, i + 1));
+      csa_avx2(twos_b, ones, ones,
+          load_avx2(a, b, i + 2), load_avx2(a, b, i + 3));
+      csa_avx2(fours_a, twos, twos, twos_a, twos_b);
+      csa_avx2(twos_a, ones, ones,
+          load_avx2(a, b, i + 4), load_avx2(a, b, i + 5));
+      csa_avx2(twos_b, ones, ones,
+          load_avx2(a, b, i + 6), load_avx2(a, b, i + 7));
+      csa_avx2(fours_b, twos, twos, twos_a, twos_b);
+      csa_avx2(eights_a, fours, fours, fours_a, fours_b);
+      csa_avx2(twos_a, ones, ones,
+          load_avx2(a, b, i + 8), load_avx2(a, b, i + 9));
+      csa_avx2(twos_b, ones, ones,
+          load_avx2(a, b, i + 10), load_avx2(a, b, i + 11));
+      csa_avx2(fours_a, twos, twos, twos_a, twos_b);
+      csa_avx2(twos_a, ones, ones,
+          load_avx2(a, b, i + 12), load_avx2(a, b, i + 13));
+      csa_avx2(twos_b, ones, ones,
+          load_avx2(a, b, i + 14), load_avx2(a, b, i + 15));
+      csa_avx2(fours_b, twos, twos, twos_a, twos_b);
+      csa_avx2(eights_b, fours, fours, fours_a, fours_b);
+      csa_avx2(sixteens, eights, eights, eights_a, eights_b);
+      total = _mm256_add_epi64(total, pop_count_avx2(sixteens));
+    }
+    total = _mm256_slli_epi64(total, 4);
+    total = _mm256_add_epi64(total,
+        _mm256_slli_epi64(pop_count_avx2(eights), 3));
+    total = _mm256_add_epi64(total,
+        _mm256_slli_epi64(pop_count_avx2(fours), 2));
+    total = _mm256_add_epi64(total,
+        _mm256_slli_epi64(pop_count_avx2(twos), 1));
+    total = _mm256_add_epi64(total, pop_count_avx2(ones));
+    for (; i < vec_cnt; ++i) {
+      total = _mm256_add_epi64(total, pop_count_avx2(load_avx2(a, b, i)));
+    }
+    std::size_t cnt =
+        static_cast<std::size_t>(_mm256_extract_epi64(total, 0))
+        + static_cast<std::size_t>(_mm256_extract_epi64(total, 1))
+        + static_cast<std::size_t>(_mm256_extract_epi64(total, 2))
+        + static_cast<std::size_t>(_mm256_extract_epi64(total, 3));
+    for (std::size_t j = vec_cnt * words_per_vec; j < word_cnt; ++j) {
+      cnt += dtl::bits::pop_count(load(a, b, j));
+    }
+    return cnt;
+  }
+
+  //===--------------------------------------------------------------------===//
+  // AVX-512 implementation (VPOPCNTDQ).
+  //===--------------------------------------------------------------------===//
+  static std::size_t __attribute__((target("avx512f,avx512vpopcntdq")))
+  count_avx512(const word_type* a, const word_type* b, std::size_t word_cnt) {
+    constexpr std::size_t words_per_vec = sizeof(__m512i) / sizeof(word_type);
+    __m512i acc_0 = _mm512_setzero_si512();
+    __m512i acc_1 = _mm512_setzero_si512();
+    __m512i acc_2 = _mm512_setzero_si512();
+    __m512i acc_3 = _mm512_setzero_si512();
+    std::size_t i = 0;
+    for (; i + 4 * words_per_vec <= word_cnt; i += 4 * words_per_vec) {
+      acc_0 = _mm512_add_epi64(acc_0, _mm512_popcnt_epi64(
+          load_avx512(a, b, i + 0 * words_per_vec)));
+      acc_1 = _mm512_add_epi64(acc_1, _mm512_popcnt_epi64(
+          load_avx512(a, b, i + 1 * words_per_vec)));
+      acc_2 = _mm512_add_epi64(acc_2, _mm512_popcnt_epi64(
+          load_avx512(a, b, i + 2 * words_per_vec)));
+      acc_3 = _mm512_add_epi64(acc_3, _mm512_popcnt_epi64(
+          load_avx512(a, b, i + 3 * words_per_vec)));
+    }
+    for (; i + words_per_vec <= word_cnt; i += words_per_vec) {
+      acc_0 = _mm512_add_epi64(acc_0, _mm512_popcnt_epi64(
+          load_avx512(a, b, i)));
+    }
+    if (i < word_cnt) {
+      // Process the remaining words using a masked load.
+      const __mmask8 mask = static_cast<__mmask8>((1u << (word_cnt - i)) - 1);
+      __m512i v = _mm512_maskz_loadu_epi64(mask, a + i);
+      if (b != nullptr) {
+        v = _mm512_and_si512(v, _mm512_maskz_loadu_epi64(mask, b + i));
+      }
+      acc_1 = _mm512_add_epi64(acc_1, _mm512_popcnt_epi64(v));
+    }
+    const __m512i acc = _mm512_add_epi64(
+        _mm512_add_epi64(acc_0, acc_1), _mm512_add_epi64(acc_2, acc_3));
+    return static_cast<std::size_t>(_mm512_reduce_add_epi64(acc));
+  }
+
+  static std::size_t __attribute__((target("avx512f,avx512vpopcntdq")))
+  block_count_avx512(const word_type* data, std::size_t word_cnt,
+      std::size_t words_per_block, $u32* prefix_cnt) {
+    constexpr std::size_t words_per_vec = sizeof(__m512i) / sizeof(word_type);
+    if (words_per_block % words_per_vec != 0) {
+      return block_count_x86(data, word_cnt, words_per_block, prefix_cnt);
+    }
+    // Eight blocks are processed at once. The per-lane counts of the eight
+    // blocks are reduced using a transposition, which results in a single
+    // vector that contains the counts of the eight blocks.
+    const std::size_t batch_word_cnt = 8 * words_per_block;
+    std::size_t total = 0;
+    std::size_t block_idx = 0;
+    std::size_t i = 0;
+    for (; i + batch_word_cnt <= word_cnt; i += batch_word_cnt) {
+      __m512i c[8];
+      for (std::size_t k = 0; k < 8; ++k) {
+        const word_type* block = data + i + k * words_per_block;
+        c[k] = _mm512_popcnt_epi64(
+            _mm512_loadu_si512(reinterpret_cast<const void*>(block)));
+        for (std::size_t j = words_per_vec; j < words_per_block;
+             j += words_per_vec) {
+          c[k] = _mm512_add_epi64(c[k], _mm512_popcnt_epi64(
+              _mm512_loadu_si512(reinterpret_cast<const void*>(block + j))));
+        }
+      }
+      const __m512i p01 = _mm512_add_epi64(
+          _mm512_unpacklo_epi64(c[0], c[1]), _mm512_unpackhi_epi64(c[0], c[1]));
+      const __m512i p23 = _mm512_add_epi64(
+          _mm512_unpacklo_epi64(c[2], c[3]), _mm512_unpackhi_epi64(c[2], c[3]));
+      const __m512i p45 = _mm512_add_epi64(
+          _mm512_unpacklo_epi64(c[4], c[5]), _mm512_unpackhi_epi64(c[4], c[5]));
+      const __m512i p67 = _mm512_add_epi64(
+          _mm512_unpacklo_epi64(c[6], c[7]), _mm512_unpackhi_epi64(c[6], c[7]));
+      const __m512i q0123 = _mm512_add_epi64(
+          _mm512_shuffle_i64x2(p01, p23, 0b10001000),
+          _mm512_shuffle_i64x2(p01, p23, 0b11011101));
+      const __m512i q4567 = _mm512_add_epi64(
+          _mm512_shuffle_i64x2(p45, p67, 0b10001000),
+          _mm512_shuffle_i64x2(p45, p67, 0b11011101));
+      const __m512i r = _mm512_add_epi64(
+          _mm512_shuffle_i64x2(q0123, q4567, 0b10001000),
+          _mm512_shuffle_i64x2(q0123, q4567, 0b11011101));
+      alignas(64) $u64 block_cnt[8];
+      _mm512_store_si512(reinterpret_cast<void*>(block_cnt), r);
+      for (std::size_t k = 0; k < 8; ++k) {
+        prefix_cnt[block_idx++] = static_cast<$u32>(total);
+        total += block_cnt[k];
+      }
+    }
+    // The remaining blocks.
+    for (; i < word_cnt; i += words_per_block) {
+      prefix_cnt[block_idx++] = static_cast<$u32>(total);
+      total += count_avx512(data + i, nullptr,
+          std::min(words_per_block, word_cnt - i));
+    }
+    return total;
+  }
+
+private:
+  /// Loads the i-th word (or the bitwise AND of two words).
+  static word_type __forceinline__
+  load(const word_type* a, const word_type* b, std::size_t i) {
+    return b == nullptr ? a[i] : a[i] & b[i];
+  }
+
+  static __m256i __attribute__((target("avx2"), always_inline))
+  load_avx2(const word_type* a, const word_type* b, std::size_t vec_idx) {
+    const __m256i v = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(a) + vec_idx);
+    if (b == nullptr) return v;
+    return _mm256_and_si256(v, _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(b) + vec_idx));
+  }
+
+  static __m512i __attribute__((target("avx512f"), always_inline))
+  load_avx512(const word_type* a, const word_type* b, std::size_t i) {
+    const __m512i v = _mm512_loadu_si512(reinterpret_cast<const void*>(a + i));
+    if (b == nullptr) return v;
+    return _mm512_and_si512(v,
+        _mm512_loadu_si512(reinterpret_cast<const void*>(b + i)));
+  }
+
+  /// Carry-save adder.
+  static void __attribute__((target("avx2"), always_inline))
+  csa_avx2(__m256i& h, __m256i& l, __m256i a, __m256i b, __m256i c) {
+    const __m256i u = _mm256_xor_si256(a, b);
+    h = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+    l = _mm256_xor_si256(u, c);
+  }
+
+  /// Computes the population count of each 64-bit lane, using a nibble
+  /// lookup table.
+  static __m256i __attribute__((target("avx2"), always_inline))
+  pop_count_avx2(__m256i v) {
+    const __m256i lookup = _mm256_setr_epi8(
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    const __m256i lo = _mm256_and_si256(v, low_mask);
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi32(v, 4), low_mask);
+    const __m256i cnt = _mm256_add_epi8(
+        _mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+    return _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+  }
+
+  /// Selects the popcount kernel based on the capabilities of the CPU.
+  static kernel_fn
+  get_kernel() {
+    static const kernel_fn kernel = []() -> kernel_fn {
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx512vpopcntdq")) return &count_avx512;
+      if (__builtin_cpu_supports("avx2")) return &count_avx2;
+      return &count_x86;
+    }();
+    return kernel;
+  }
+
+  /// Selects the block-wise popcount kernel based on the capabilities of the
+  /// CPU.
+  static block_kernel_fn
+  get_block_kernel() {
+    static const block_kernel_fn kernel = []() -> block_kernel_fn {
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx512vpopcntdq")) {
+        return &block_count_avx512;
+      }
+      return &block_count_x86;
+    }();
+    return kernel;
+  }
+
+  // Pure static.
+  popcount() = delete;
+};
+//===----------------------------------------------------------------------===//
+} // namespace dtl
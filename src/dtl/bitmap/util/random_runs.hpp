@@ -0,0 +1,254 @@
+#pragma once
+//===----------------------------------------------------------------------===//
+#include "bitmap_fun.hpp"
+
+#include <dtl/dtl.hpp>
+#include <dtl/thread.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Fast generation of random bitmaps. Instead of sampling the two-state Markov
+// process bit by bit, the lengths of the 1-runs and the 0-runs are sampled
+// directly from the geometric distributions implied by the clustering factor f
+// and the bit density d, and the runs are written word-wise.
+//
+// The number of 1-bits and the number of 1-runs are determined upfront
+// (round(n * d) and round(n * d / f)) and the sampled run lengths are scaled to
+// match them exactly. Thus, the actual f and d deviate from the given ones only
+// due to rounding and no rejection sampling is required.
+//
+// Uniformly populated bitmaps are generated using skip sampling, i.e., the
+// distances between the 1-bits are sampled, which does not constrain the
+// number of 1-runs.
+//
+// The bitmap is generated in independent segments, which can be processed in
+// parallel. The result depends only on the seed, not on the number of threads.
+//===----------------------------------------------------------------------===//
+namespace dtl {
+//===----------------------------------------------------------------------===//
+namespace internal {
+//===----------------------------------------------------------------------===//
+/// Scales the given values, such that they sum up to the given total. The
+/// scaled values are rounded to the nearest integer and the remaining
+/// difference is distributed round-robin, starting at the given index.
+static void
+fit_to_total(std::vector<$u64>& values, u64 total, u64 start_idx) {
+  const auto cnt = values.size();
+  if (cnt == 0) return;
+  $u64 sum = 0;
+  for (auto v : values) sum += v;
+  if (sum == 0) {
+    std::fill(values.begin(), values.end(), total / cnt);
+    sum = (total / cnt) * cnt;
+  }
+  else if (sum != total) {
+    f64 scale = static_cast<$f64>(total) / sum;
+    sum = 0;
+    for (auto& v : values) {
+      v = static_cast<$u64>(v * scale + 0.5);
+      sum += v;
+    }
+  }
+  // Correct the rounding errors.
+  std::size_t i = start_idx % cnt;
+  while (sum < total) {
+    ++values[i];
+    ++sum;
+    i = (i + 1 == cnt) ? 0 : i + 1;
+  }
+  while (sum > total) {
+    if (values[i] > 0) {
+      --values[i];
+      --sum;
+    }
+    i = (i + 1 == cnt) ? 0 : i + 1;
+  }
+}
+//===----------------------------------------------------------------------===//
+/// Populates the given vector with samples from a geometric distribution, i.e.,
+/// the number of failures before the first success with the given probability.
+static void
+sample_geometric(std::vector<$u64>& values, f64 p, std::mt19937_64& gen) {
+  if (p >= 1.0) {
+    std::fill(values.begin(), values.end(), 0);
+    return;
+  }
+  std::geometric_distribution<$u64> dis(p);
+  for (auto& v : values) v = dis(gen);
+}
+//===----------------------------------------------------------------------===//
+/// Generates the 1-runs within [begin, end) and passes them to the given
+/// function. The parameters one_cnt and run_cnt refer to the number of 1-bits
+/// and 1-runs within the segment. If tail_gap is set, the segment ends with at
+/// least one 0-bit, so that the 1-runs do not merge with the ones of the
+/// subsequent segment.
+template<typename fn_t>
+static void
+gen_runs_markov(u64 begin, u64 end, u64 one_cnt, u64 run_cnt, f64 f, f64 d,
+    u1 tail_gap, std::mt19937_64& gen, fn_t set_fn) {
+  if (run_cnt == 0) return;
+  const auto zero_cnt = (end - begin) - one_cnt;
+  // The probabilities of the state transitions 1 -> 0 and 0 -> 1.
+  const auto q = std::min(1.0, 1.0 / f);
+  const auto p = std::min(1.0, d / ((1.0 - d) * f));
+
+  // The lengths of the 1-runs exceeding the min. length of 1.
+  std::vector<$u64> one_lengths(run_cnt);
+  sample_geometric(one_lengths, q, gen);
+  fit_to_total(one_lengths, one_cnt - run_cnt, gen());
+
+  // The lengths of the 0-runs exceeding the min. length. The first and the
+  // last 0-run are optional (min. length of 0), the ones in between have a
+  // min. length of 1.
+  std::vector<$u64> zero_lengths(run_cnt + 1);
+  sample_geometric(zero_lengths, p, gen);
+  std::bernoulli_distribution starts_with_zero(1.0 - d);
+  if (!starts_with_zero(gen)) zero_lengths.front() = 0;
+  if (!starts_with_zero(gen) && !tail_gap) zero_lengths.back() = 0;
+  const auto zero_cnt_min = (run_cnt - 1) + (tail_gap ? 1 : 0);
+  fit_to_total(zero_lengths, zero_cnt - zero_cnt_min, gen());
+
+  $u64 pos = begin + zero_lengths[0];
+  for (std::size_t i = 0; i < run_cnt; ++i) {
+    const auto length = one_lengths[i] + 1;
+    set_fn(pos, pos + length);
+    pos += length;
+    if (i + 1 < run_cnt) pos += zero_lengths[i + 1] + 1;
+  }
+  assert(pos + zero_lengths.back() + (tail_gap ? 1 : 0) == end);
+}
+//===----------------------------------------------------------------------===//
+/// Sets the bits in [b, e) of the given bitmap.
+static void
+set_range(boost::dynamic_bitset<$u32>& bm, u64 b, u64 e) {
+#ifndef BOOST_DYNAMIC_BITSET_DONT_USE_FRIENDS
+  for (std::size_t i = b; i < e; ++i) {
+    bm[i] = true;
+  }
+#else
+  // HACK: This gives access to the private members of the boost::dynamic_bitset.
+  dtl::bitmap_fun<$u32>::set(bm.m_bits.data(), b, e);
+#endif
+}
+//===----------------------------------------------------------------------===//
+/// Calls the given function for each segment of (at most) segment_size bits
+/// of a bitmap of length n. The segments are distributed among thread_cnt
+/// threads. The segment boundaries are word aligned, so that the segments can
+/// be populated concurrently.
+template<typename fn_t>
+static void
+for_each_segment(u64 n, u64 thread_cnt, u64 segment_size, fn_t fn) {
+  const auto seg_size = std::max(u64(64), (segment_size + 63) / 64 * 64);
+  const auto seg_cnt = (n + seg_size - 1) / seg_size;
+  auto gen_segment = [&](u64 seg_idx) {
+    const auto begin = seg_idx * seg_size;
+    const auto end = std::min(n, begin + seg_size);
+    fn(seg_idx, begin, end);
+  };
+  const auto t_cnt = std::max(u64(1), std::min(thread_cnt, seg_cnt));
+  if (t_cnt == 1) {
+    for ($u64 s = 0; s < seg_cnt; ++s) gen_segment(s);
+  }
+  else {
+    std::atomic<$u64> next_seg { 0 };
+    auto thread_fn = [&](u32 /* thread_id */) {
+      for ($u64 s = next_seg++; s < seg_cnt; s = next_seg++) gen_segment(s);
+    };
+    dtl::run_in_parallel(thread_fn, dtl::this_thread::get_cpu_affinity(),
+        t_cnt);
+  }
+}
+//===----------------------------------------------------------------------===//
+/// Returns the seed of the random number generator of the given segment.
+static u64
+segment_seed(u64 seed, u64 seg_idx) {
+  return seed + 0x9e3779b97f4a7c15ull * (seg_idx + 1);
+}
+//===----------------------------------------------------------------------===//
+} // namespace internal
+//===----------------------------------------------------------------------===//
+/// Generates a random bitmap of length n with the clustering factor f (the
+/// average length of the 1-runs) and the bit density d.
+///
+/// The bitmap is generated in segments of (at most) segment_size bits, which
+/// are distributed among thread_cnt threads.
+static boost::dynamic_bitset<$u32>
+gen_random_bitmap_markov_runs(u64 n, f64 f, f64 d, u64 seed,
+    u64 thread_cnt = 1, u64 segment_size = 1ull << 20) {
+  boost::dynamic_bitset<$u32> bm(n);
+  const auto one_cnt = static_cast<$u64>(std::llround(n * d));
+  if (one_cnt == 0) return bm;
+  if (one_cnt >= n) {
+    bm.set();
+    return bm;
+  }
+  const auto zero_cnt = n - one_cnt;
+  auto run_cnt = static_cast<$u64>(std::llround(one_cnt / f));
+  run_cnt = std::max(run_cnt, u64(1));
+  run_cnt = std::min(run_cnt, one_cnt);
+  run_cnt = std::min(run_cnt, zero_cnt + 1);
+
+  // Distributes the 1-bits and the 1-runs proportionally among the segments.
+  auto prefix = [&](u64 cnt, u64 pos) {
+    return static_cast<$u64>(std::llround(
+        static_cast<$f64>(cnt) * static_cast<$f64>(pos) / n));
+  };
+
+  internal::for_each_segment(n, thread_cnt, segment_size,
+      [&](u64 seg_idx, u64 begin, u64 end) {
+    const auto seg_one_cnt = prefix(one_cnt, end) - prefix(one_cnt, begin);
+    const auto seg_zero_cnt = (end - begin) - seg_one_cnt;
+    $u64 seg_run_cnt = prefix(run_cnt, end) - prefix(run_cnt, begin);
+    if (seg_one_cnt == 0) return;
+    seg_run_cnt = std::max(seg_run_cnt, u64(1));
+    seg_run_cnt = std::min(seg_run_cnt, seg_one_cnt);
+    seg_run_cnt = std::min(seg_run_cnt, seg_zero_cnt + 1);
+    const u1 tail_gap = end != n && seg_zero_cnt >= seg_run_cnt;
+    std::mt19937_64 gen(internal::segment_seed(seed, seg_idx));
+    internal::gen_runs_markov(begin, end, seg_one_cnt, seg_run_cnt, f, d,
+        tail_gap, gen, [&](u64 b, u64 e) {
+          internal::set_range(bm, b, e);
+        });
+  });
+  return bm;
+}
+//===----------------------------------------------------------------------===//
+/// Generates a uniformly populated random bitmap of length n with the bit
+/// density d, i.e., each bit is set independently with probability d. The
+/// number of 1-bits thus follows a binomial distribution with mean n * d.
+/// The positions of the 1-bits are determined by sampling the distances
+/// between them (skip sampling). For d > 0.5, the positions of the 0-bits are
+/// sampled instead.
+///
+/// The bitmap is generated in segments of (at most) segment_size bits, which
+/// are distributed among thread_cnt threads.
+static boost::dynamic_bitset<$u32>
+gen_random_bitmap_uniform_runs(u64 n, f64 d, u64 seed,
+    u64 thread_cnt = 1, u64 segment_size = 1ull << 20) {
+  boost::dynamic_bitset<$u32> bm(n);
+  if (d <= 0.0) return bm;
+  if (d >= 1.0) {
+    bm.set();
+    return bm;
+  }
+  const u1 sample_zeros = d > 0.5;
+  const f64 p = sample_zeros ? 1.0 - d : d;
+  internal::for_each_segment(n, thread_cnt, segment_size,
+      [&](u64 seg_idx, u64 begin, u64 end) {
+    std::mt19937_64 gen(internal::segment_seed(seed, seg_idx));
+    std::geometric_distribution<$u64> skip(p);
+    if (sample_zeros) internal::set_range(bm, begin, end);
+    for ($u64 pos = begin + skip(gen); pos < end; pos += skip(gen) + 1) {
+      bm[pos] = !sample_zeros;
+    }
+  });
+  return bm;
+}
+//===----------------------------------------------------------------------===//
+} // namespace dtl
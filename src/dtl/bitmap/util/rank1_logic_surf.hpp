@@ -1,5 +1,7 @@
 #pragma once
 //===----------------------------------------------------------------------===//
+#include "popcount.hpp"
+
 #include <dtl/dtl.hpp>
 #include <dtl/math.hpp>
 
@@ -68,22 +70,17 @@ public:
       const word_type* const bitmap_begin,
       const word_type* const bitmap_end,
       size_type* lut) noexcept {
+    static_assert(std::is_same<word_type, $u64>::value,
+        "The popcount kernels require 64-bit words.");
     u64 bitmap_word_cnt = bitmap_end - bitmap_begin;
     u64 bitmap_bitlength = bitmap_word_cnt * word_bitlength;
     u64 block_cnt = (bitmap_bitlength + block_bitlength - 1) / block_bitlength;
     u64 lut_entry_cnt = block_cnt + 1;
 
-    size_type bit_cntr = 0;
-    for ($u64 i = 0; i < block_cnt; ++i) {
-      lut[i] = bit_cntr;
-      const auto word_cnt_in_current_block =
-          (i + 1) * words_per_block <= bitmap_word_cnt
-          ? words_per_block
-          : bitmap_word_cnt % words_per_block;
-      const auto nbits = word_cnt_in_current_block * word_bitlength;
-      bit_cntr += popcount_linear(
-          bitmap_begin, i * words_per_block, nbits);
-    }
+    // Count the bits block-wise, using the fastest popcount available.
+    const size_type bit_cntr = static_cast<size_type>(
+        dtl::popcount::block_count(
+            bitmap_begin, bitmap_word_cnt, words_per_block, lut));
     lut[lut_entry_cnt - 1] = bit_cntr;
   }
 
@@ -0,0 +1,118 @@
+#include "bitwise_operations_helper.hpp"
+#include "gtest/gtest.h"
+
+#include <dtl/bitmap/any_bitmap.hpp>
+#include <dtl/bitmap/bitwise_expression.hpp>
+#include <dtl/bitmap/concise.hpp>
+#include <dtl/bitmap/position_list.hpp>
+#include <dtl/bitmap/teb_wrapper.hpp>
+#include <dtl/bitmap/uah.hpp>
+#include <dtl/bitmap/util/random_runs.hpp>
+#include <dtl/bitmap/xah.hpp>
+#include <dtl/dtl.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <functional>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Tests the type-erased bitmaps and the runtime composition of type-erased run
+// iterators. The codecs of the operands are chosen at runtime.
+//===----------------------------------------------------------------------===//
+using bitset_t = boost::dynamic_bitset<$u32>;
+//===----------------------------------------------------------------------===//
+/// Validates the given run iterator, using (random) skips if max_distance > 0.
+static void
+validate(dtl::any_run_iter&& it, const bitset_t& expected,
+    std::size_t max_distance, $u32 seed) {
+  validate_run_iterator(it, expected, max_distance, seed);
+}
+//===----------------------------------------------------------------------===//
+/// The codecs, which are chosen at runtime.
+static const std::vector<std::function<dtl::any_bitmap(const bitset_t&)>>
+    encoders = {
+        dtl::any_bitmap::encode<dtl::teb_wrapper>,
+        dtl::any_bitmap::encode<dtl::uah32>,
+        dtl::any_bitmap::encode<dtl::xah32>,
+        dtl::any_bitmap::encode<dtl::concise>,
+        dtl::any_bitmap::encode<dtl::position_list<$u32>>,
+    };
+//===----------------------------------------------------------------------===//
+TEST(any_bitmap,
+    wrap) {
+  const auto bs = dtl::gen_random_bitmap_markov_runs(12345, 8, 0.1, 42);
+  for (const auto& encode : encoders) {
+    const auto b = encode(bs);
+    ASSERT_EQ(b.size(), bs.size());
+    ASSERT_GT(b.size_in_bytes(), 0);
+    ASSERT_FALSE(b.name().empty());
+    for (std::size_t i = 0; i < bs.size(); i += 7) {
+      ASSERT_EQ(b.test(i), bs[i]);
+    }
+    validate(b.it(), bs, 0, 1);
+    validate(b.scan_it(), bs, 0, 1);
+    validate(b.it(), bs, 64, 2);
+    validate(b.it(), bs, bs.size() / 4, 3);
+    // Copies share the encoded bitmap.
+    const auto c = b;
+    validate(c.it(), bs, 0, 1);
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(any_bitmap,
+    runtime_composition) {
+  for (auto n : { 64ull, 1000ull, 12345ull, 1ull << 16 }) {
+    for (auto d : { 0.01, 0.1, 0.5 }) {
+      for (auto f : { 1.5, 8.0, 64.0 }) {
+        if (d / (1.0 - d) > f) continue;
+        const auto bs_a = dtl::gen_random_bitmap_markov_runs(n, f, d, 1);
+        const auto bs_b = dtl::gen_random_bitmap_markov_runs(n, f, d, 2);
+        const auto bs_c = dtl::gen_random_bitmap_markov_runs(n, f, 0.5, 3);
+        for (std::size_t i = 0; i < encoders.size(); ++i) {
+          // Mix the codecs of the operands.
+          const auto a = encoders[i](bs_a);
+          const auto b = encoders[(i + 1) % encoders.size()](bs_b);
+          const auto c = encoders[(i + 2) % encoders.size()](bs_c);
+          for (auto max_distance : { 0ull, 128ull }) {
+            validate(dtl::any_and_it(a.it(), b.it()), bs_a & bs_b,
+                max_distance, 1);
+            validate(dtl::any_or_it(a.it(), b.it()), bs_a | bs_b,
+                max_distance, 2);
+            validate(dtl::any_and_not_it(a.it(), b.it()), bs_a - bs_b,
+                max_distance, 3);
+            validate(dtl::any_not_it(a.it()), ~bs_a, max_distance, 4);
+            // Nested operations.
+            validate(dtl::any_and_it(dtl::any_or_it(a.it(), b.it()),
+                         dtl::any_not_it(c.it())),
+                (bs_a | bs_b) & ~bs_c, max_distance, 5);
+            validate(dtl::any_or_it(dtl::any_and_it(a.it(), c.it()),
+                         dtl::any_and_not_it(b.it(), c.it())),
+                (bs_a & bs_c) | (bs_b - bs_c), max_distance, 6);
+          }
+          validate(dtl::any_xor_it(a.it(), b.it()), bs_a ^ bs_b, 0, 1);
+        }
+      }
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(any_bitmap,
+    bitwise_expression) {
+  const auto n = 1ull << 16;
+  std::vector<bitset_t> bitsets;
+  std::vector<dtl::any_bitmap> bitmaps;
+  for (std::size_t i = 0; i < encoders.size(); ++i) {
+    bitsets.push_back(
+        dtl::gen_random_bitmap_markov_runs(n, 16, 0.9 - 0.15 * i, 10 + i));
+    bitmaps.push_back(encoders[i](bitsets.back()));
+  }
+  auto e = dtl::bitwise_leaf_expr(bitmaps[0]);
+  auto expected = bitsets[0];
+  for (std::size_t i = 1; i < bitmaps.size(); ++i) {
+    e = dtl::bitwise_and_expr(std::move(e),
+        dtl::bitwise_leaf_expr(bitmaps[i]));
+    expected &= bitsets[i];
+  }
+  ASSERT_EQ(dtl::bitwise_to_bitset(e), expected);
+}
+//===----------------------------------------------------------------------===//
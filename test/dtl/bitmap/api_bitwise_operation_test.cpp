@@ -293,6 +293,76 @@ TYPED_TEST(api_bitwise_operation_test, bitwise_xor_random_iter) {
   }
 }
 //===----------------------------------------------------------------------===//
+// Difference / bitwise and-not.
+TYPED_TEST(api_bitwise_operation_test, bitwise_and_not_iter) {
+  using T = TypeParam;
+
+  for (std::size_t a = 1; a < (1u << LEN); a++) {
+    dtl::bitmap bm_a(LEN, a);
+    T tm_a(bm_a);
+
+    for (std::size_t b = 0; b < (1u << LEN); b++) {
+      dtl::bitmap bm_b(LEN, b);
+      dtl::bitmap bm_expected = bm_a & ~bm_b;
+
+      T tm_b(bm_b);
+      const auto bm_actual = bitwise_and_not_iter(tm_a, tm_b);
+
+      ASSERT_EQ(bm_actual, bm_expected)
+          << "Test (a & ~b) failed for a=" << bm_a << " (" << a << ")"
+          << " and b=" << bm_b << "(" << b << ")" << std::endl;
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+TYPED_TEST(api_bitwise_operation_test, bitwise_and_not_random_iter) {
+  using T = TypeParam;
+  static u64 n = RANDOM_LENGTH;
+  for (std::size_t r = 0; r < RANDOM_REPEAT; ++r) {
+    auto bm_a = gen_random_bitmap_uniform(n, std::min(0.025 * r, 1.0));
+    auto bm_b = gen_random_bitmap_uniform(n, std::min(0.01 * r, 1.0));
+
+    auto bm_expected = bm_a & ~bm_b;
+
+    T tm_a(bm_a);
+    T tm_b(bm_b);
+    const auto bm_actual = bitwise_and_not_iter(tm_a, tm_b);
+
+    ASSERT_EQ(bm_actual, bm_expected);
+  }
+}
+//===----------------------------------------------------------------------===//
+// Complement / bitwise not.
+TYPED_TEST(api_bitwise_operation_test, bitwise_not_iter) {
+  using T = TypeParam;
+
+  for (std::size_t a = 0; a < (1u << LEN); a++) {
+    dtl::bitmap bm_a(LEN, a);
+    dtl::bitmap bm_expected = ~bm_a;
+
+    T tm_a(bm_a);
+    const auto bm_actual = bitwise_not_iter(tm_a);
+
+    ASSERT_EQ(bm_actual, bm_expected)
+        << "Test (~a) failed for a=" << bm_a << " (" << a << ")" << std::endl;
+  }
+}
+//===----------------------------------------------------------------------===//
+TYPED_TEST(api_bitwise_operation_test, bitwise_not_random_iter) {
+  using T = TypeParam;
+  static u64 n = RANDOM_LENGTH;
+  for (std::size_t r = 0; r < RANDOM_REPEAT; ++r) {
+    auto bm_a = gen_random_bitmap_uniform(n, std::min(0.02 * r, 1.0));
+
+    auto bm_expected = ~bm_a;
+
+    T tm_a(bm_a);
+    const auto bm_actual = bitwise_not_iter(tm_a);
+
+    ASSERT_EQ(bm_actual, bm_expected);
+  }
+}
+//===----------------------------------------------------------------------===//
 // Special case of bitwise xor which occurs with range encoding (RE). In
 // range-encoded indexes, the following holds: Each bit that is set in the i-th
 // bitmap, then these bits are also set in the (i+1)-th bitmap.
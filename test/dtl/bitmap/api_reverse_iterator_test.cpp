@@ -0,0 +1,173 @@
+#include "gtest/gtest.h"
+
+#include <dtl/bitmap/bitwise_operations.hpp>
+#include <dtl/bitmap/concise.hpp>
+#include <dtl/bitmap/concise_skip.hpp>
+#include <dtl/bitmap/position_list.hpp>
+#include <dtl/bitmap/teb_wrapper.hpp>
+#include <dtl/bitmap/uah.hpp>
+#include <dtl/bitmap/uah_skip.hpp>
+#include <dtl/bitmap/util/random_runs.hpp>
+#include <dtl/bitmap/xah.hpp>
+#include <dtl/bitmap/xah_skip.hpp>
+#include <dtl/dtl.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <random>
+//===----------------------------------------------------------------------===//
+// Typed API tests for the reverse run iterators, i.e., the 1-runs are
+// produced in descending order.
+//===----------------------------------------------------------------------===//
+using bitset_t = boost::dynamic_bitset<$u32>;
+//===----------------------------------------------------------------------===//
+/// Returns the bitmaps used in the tests below.
+static std::vector<bitset_t>
+gen_bitmaps() {
+  std::vector<bitset_t> ret;
+  for (auto n : { 64ull, 1000ull, 1ull << 12, 12345ull, 1ull << 16 }) {
+    bitset_t empty(n);
+    ret.push_back(empty);
+    ret.push_back(~empty);
+    $u32 seed = 42;
+    for (auto d : { 0.01, 0.1, 0.5, 0.9 }) {
+      for (auto f : { 1.5, 8.0, 64.0 }) {
+        if (d / (1.0 - d) > f) continue;
+        ret.push_back(dtl::gen_random_bitmap_markov_runs(n, f, d, seed++));
+      }
+    }
+  }
+  return ret;
+}
+//===----------------------------------------------------------------------===//
+/// Returns the position of the last 1-bit at or before the given position, or
+/// the bitmap length if there is none.
+static std::size_t
+find_last_until(const bitset_t& bs, std::size_t pos) {
+  for (std::size_t i = std::min(pos + 1, bs.size()); i > 0; --i) {
+    if (bs[i - 1]) return i - 1;
+  }
+  return bs.size();
+}
+//===----------------------------------------------------------------------===//
+/// Moves backwards through the bitmap using the given reverse iterator and
+/// validates the iterator after each step. The 1-runs are not required to be
+/// maximal. With a probability of skip_pct percent, the iterator is moved
+/// backwards using skip_back_to() instead of prev().
+template<typename rev_iter_t>
+static void
+validate(rev_iter_t&& it, const bitset_t& expected, $u32 skip_pct,
+    std::size_t max_distance, $u32 seed) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<std::size_t> distance(1, max_distance);
+  const auto n = expected.size();
+  std::size_t expected_last = find_last_until(expected, n);
+  bitset_t seen(n);
+  while (true) {
+    ASSERT_EQ(it.end(), expected_last == n);
+    if (it.end()) break;
+    ASSERT_GT(it.length(), 0);
+    ASSERT_EQ(it.pos() + it.length() - 1, expected_last);
+    for (std::size_t i = it.pos(); i <= expected_last; ++i) {
+      ASSERT_TRUE(expected[i]) << "pos=" << i;
+      seen[i] = true;
+    }
+    if (gen() % 100 < skip_pct) {
+      const auto d = distance(gen);
+      if (d > expected_last) {
+        // Skip to the very first position.
+        expected_last = expected[0] ? 0 : n;
+        it.skip_back_to(0);
+      }
+      else {
+        const auto to_pos = expected_last - d;
+        expected_last = find_last_until(expected, to_pos);
+        it.skip_back_to(to_pos);
+      }
+    }
+    else {
+      expected_last = it.pos() == 0 ? n : find_last_until(expected, it.pos() - 1);
+      it.prev();
+    }
+  }
+  if (skip_pct == 0) {
+    // All 1-bits need to be produced.
+    ASSERT_EQ(seen, expected);
+  }
+}
+//===----------------------------------------------------------------------===//
+// Fixture for the parameterized test case.
+template<typename T>
+class api_reverse_iterator_test : public ::testing::Test {};
+
+using reverse_iterator_types_under_test = ::testing::Types<
+    dtl::teb_wrapper,
+    dtl::uah8,
+    dtl::uah32,
+    dtl::uah64,
+    dtl::uah_skip<u32, 2>,
+    dtl::xah8,
+    dtl::xah32,
+    dtl::xah64,
+    dtl::xah_skip<u32, 2>,
+    dtl::concise,
+    dtl::concise_skip<2>,
+    dtl::position_list<$u32>
+>;
+TYPED_TEST_CASE(api_reverse_iterator_test, reverse_iterator_types_under_test);
+//===----------------------------------------------------------------------===//
+TYPED_TEST(api_reverse_iterator_test, single_bits) {
+  using T = TypeParam;
+  for (auto n : { 64ull, 1000ull }) {
+    for (auto i : { 0ull, 1ull, 31ull, 62ull, 63ull, n - 1 }) {
+      bitset_t bs(n);
+      bs[i] = true;
+      T t(bs);
+      auto it = t.rit();
+      ASSERT_FALSE(it.end());
+      ASSERT_EQ(it.pos(), i);
+      ASSERT_EQ(it.length(), 1);
+      it.prev();
+      ASSERT_TRUE(it.end());
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+TYPED_TEST(api_reverse_iterator_test, prev) {
+  using T = TypeParam;
+  for (const auto& bs : gen_bitmaps()) {
+    T t(bs);
+    validate(t.rit(), bs, 0, 1, 1);
+  }
+}
+//===----------------------------------------------------------------------===//
+TYPED_TEST(api_reverse_iterator_test, skip_back_to) {
+  using T = TypeParam;
+  for (const auto& bs : gen_bitmaps()) {
+    T t(bs);
+    validate(t.rit(), bs, 75, 16, 1);
+    validate(t.rit(), bs, 75, 1024, 2);
+    validate(t.rit(), bs, 75, bs.size() / 4 + 1, 3);
+  }
+}
+//===----------------------------------------------------------------------===//
+TYPED_TEST(api_reverse_iterator_test, bitwise_operations) {
+  using T = TypeParam;
+  const auto bitmaps = gen_bitmaps();
+  for (std::size_t i = 0; i + 1 < bitmaps.size(); ++i) {
+    const auto& bs_a = bitmaps[i];
+    const auto& bs_b = bitmaps[i + 1];
+    if (bs_a.size() != bs_b.size()) continue;
+    T a(bs_a);
+    T b(bs_b);
+    validate(dtl::bitwise_and_rit(a.rit(), b.rit()), bs_a & bs_b, 0, 1, 1);
+    validate(dtl::bitwise_or_rit(a.rit(), b.rit()), bs_a | bs_b, 0, 1, 1);
+    validate(dtl::bitwise_xor_rit(a.rit(), b.rit()), bs_a ^ bs_b, 0, 1, 1);
+    validate(dtl::bitwise_and_rit(a.rit(), b.rit()), bs_a & bs_b, 50, 256, 2);
+    validate(dtl::bitwise_or_rit(a.rit(), b.rit()), bs_a | bs_b, 50, 256, 2);
+    // Nested operations.
+    validate(dtl::bitwise_or_rit(dtl::bitwise_and_rit(a.rit(), b.rit()),
+                 b.rit()), (bs_a & bs_b) | bs_b, 50, 64, 3);
+  }
+}
+//===----------------------------------------------------------------------===//
@@ -140,3 +140,24 @@ TYPED_TEST(api_run_iterator_skip_test, skip_next) {
   skip_next_test<T>(8, 0b10000101, 2, 7, 1);
 }
 //===----------------------------------------------------------------------===//
+template<typename T>
+void skip_backwards_test() {
+  dtl::bitmap b(8, 0b11001101);
+  T tm(b);
+  auto it = tm.it();
+  it.skip_to(3);
+  ASSERT_EQ(it.pos(), 3);
+  // Skipping backwards does not move the iterator.
+  it.skip_to(1);
+  ASSERT_EQ(it.pos(), 3);
+  it.skip_to(3);
+  ASSERT_EQ(it.pos(), 3);
+  it.skip_to(7);
+  ASSERT_EQ(it.pos(), 7);
+}
+//===----------------------------------------------------------------------===//
+TEST(api_run_iterator_skip_test, skip_backwards) {
+  skip_backwards_test<dtl::elias_fano>();
+  skip_backwards_test<dtl::delta_bp128>();
+}
+//===----------------------------------------------------------------------===//
@@ -4,12 +4,16 @@
 
 #include <dtl/bitmap/bah.hpp>
 #include <dtl/bitmap/bbc.hpp>
+#include <dtl/bitmap/bbc_skip.hpp>
 #include <dtl/bitmap/concise.hpp>
+#include <dtl/bitmap/concise_skip.hpp>
+#include <dtl/bitmap/delta_bp128.hpp>
 #include <dtl/bitmap/diff/diff.hpp>
 #include <dtl/bitmap/diff/merge.hpp>
 #include <dtl/bitmap/dynamic_bitmap.hpp>
 #include <dtl/bitmap/dynamic_roaring_bitmap.hpp>
 #include <dtl/bitmap/dynamic_wah.hpp>
+#include <dtl/bitmap/elias_fano.hpp>
 #include <dtl/bitmap/part/part.hpp>
 #include <dtl/bitmap/part/part_run.hpp>
 #include <dtl/bitmap/part/part_updirect.hpp>
@@ -131,9 +135,16 @@ using types_under_test = ::testing::Types<
     part_range_list_8,
     part_range_list_16,
     dtl::bbc,
+    dtl::bbc_skip<2>, // Skip distance is intentionally chosen small, as the bitmaps in the test are also rather small.
     dtl::concise,
+    dtl::concise_skip<2>, // Skip distance is intentionally chosen small, as the bitmaps in the test are also rather small.
 
     dtl::bah,
-    dtl::part<dtl::bah, 1ull << 16>
+    dtl::part<dtl::bah, 1ull << 16>,
+
+    dtl::elias_fano,
+    dtl::part<dtl::elias_fano, 1ull << 8>,
+    dtl::delta_bp128,
+    dtl::part<dtl::delta_bp128, 1ull << 8>
     >;
 //===----------------------------------------------------------------------===//
@@ -0,0 +1,154 @@
+#include "gtest/gtest.h"
+
+#include <dtl/bitmap/auto_bitmap.hpp>
+#include <dtl/bitmap/util/random_runs.hpp>
+#include <dtl/dtl.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <algorithm>
+#include <sstream>
+//===----------------------------------------------------------------------===//
+// Tests the size estimation of the codec advisor and the automatic codec
+// selection.
+//===----------------------------------------------------------------------===//
+using bitset_t = boost::dynamic_bitset<$u32>;
+//===----------------------------------------------------------------------===//
+/// Returns the bitmaps used in the tests below.
+static std::vector<bitset_t>
+gen_bitmaps() {
+  std::vector<bitset_t> ret;
+  for (auto n : { 64ull, 1000ull, 12345ull, 1ull << 16 }) {
+    bitset_t empty(n);
+    ret.push_back(empty);
+    ret.push_back(~empty);
+    $u32 seed = 42;
+    for (auto d : { 0.001, 0.01, 0.1, 0.5, 0.9 }) {
+      for (auto f : { 1.5, 8.0, 64.0, 1024.0 }) {
+        if (d / (1.0 - d) > f) continue;
+        ret.push_back(dtl::gen_random_bitmap_markov_runs(n, f, d, seed++));
+      }
+    }
+  }
+  return ret;
+}
+//===----------------------------------------------------------------------===//
+/// Returns the estimate of the given codec.
+static dtl::codec_estimate
+find(const std::vector<dtl::codec_estimate>& estimates, dtl::auto_codec c) {
+  for (const auto& e : estimates) {
+    if (e.codec == c) return e;
+  }
+  return dtl::codec_estimate { c, 0, 0.0, 0.0 };
+}
+//===----------------------------------------------------------------------===//
+/// Returns the reference TEB size estimate, which is obtained by constructing
+/// the pruned bitmap tree (without any further space optimizations).
+static std::size_t
+teb_reference_estimate(const bitset_t& bs) {
+  using tree_t = dtl::bitmap_tree<>;
+  dtl::bitmap_tree<1> tree(bs);
+  tree.init_counters();
+  const auto n_pow2 = dtl::next_power_of_two(bs.size());
+  const std::size_t inner_node_cnt = tree.get_inner_node_cnt();
+  const std::size_t perfect_level_cnt = tree.get_perfect_level_cnt();
+  const auto pruned_size = tree_t::estimate_encoded_size_in_bytes(n_pow2,
+      2 * inner_node_cnt + 1 - ((1ull << (perfect_level_cnt - 1)) - 1),
+      inner_node_cnt + 1, perfect_level_cnt);
+  // The uncompressed tree has explicit labels from the first to the last
+  // 1-bit.
+  std::size_t label_cnt = 0;
+  for (auto i = bs.find_first(); i != bitset_t::npos; i = bs.find_next(i)) {
+    label_cnt = i - bs.find_first() + 1;
+  }
+  const auto uncompressed_size = tree_t::estimate_encoded_size_in_bytes(
+      n_pow2, 0, label_cnt, dtl::log_2(n_pow2) + 1);
+  return std::min(pruned_size, uncompressed_size);
+}
+//===----------------------------------------------------------------------===//
+TEST(auto_bitmap,
+    size_estimation) {
+  for (const auto& bs : gen_bitmaps()) {
+    std::stringstream info;
+    info << "n=" << bs.size() << ", count=" << bs.count();
+    const auto estimates = dtl::estimate_codecs(bs);
+    ASSERT_EQ(estimates.size(), 8);
+    // The estimates of the following codecs are exact.
+    ASSERT_EQ(find(estimates, dtl::auto_codec::bitmap).size_in_bytes,
+        dtl::dynamic_bitmap<$u32>(bs).size_in_bytes()) << info.str();
+    ASSERT_EQ(find(estimates, dtl::auto_codec::position_list).size_in_bytes,
+        dtl::position_list<$u32>(bs).size_in_bytes()) << info.str();
+    ASSERT_EQ(find(estimates, dtl::auto_codec::range_list).size_in_bytes,
+        dtl::range_list<$u32>(bs).size_in_bytes()) << info.str();
+    ASSERT_EQ(find(estimates, dtl::auto_codec::elias_fano).size_in_bytes,
+        dtl::elias_fano(bs).size_in_bytes()) << info.str();
+    ASSERT_EQ(find(estimates, dtl::auto_codec::delta_bp128).size_in_bytes,
+        dtl::delta_bp128(bs).size_in_bytes()) << info.str();
+    ASSERT_EQ(find(estimates, dtl::auto_codec::xah32).size_in_bytes,
+        dtl::xah32(bs).size_in_bytes()) << info.str();
+    // The CONCISE estimate is an upper bound, as the piggybacked dirty bits
+    // are not accounted for.
+    ASSERT_GE(find(estimates, dtl::auto_codec::concise).size_in_bytes,
+        dtl::concise(bs).size_in_bytes()) << info.str();
+    // The TEB estimate is the size of the pruned tree, or of the uncompressed
+    // tree if that is smaller, which is an upper bound of the actual size.
+    const auto teb_estimate =
+        find(estimates, dtl::auto_codec::teb).size_in_bytes;
+    ASSERT_EQ(teb_estimate, teb_reference_estimate(bs)) << info.str();
+    ASSERT_GE(teb_estimate, dtl::teb_wrapper(bs).size_in_bytes())
+        << info.str();
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(auto_bitmap,
+    choose_codec) {
+  for (const auto& bs : gen_bitmaps()) {
+    const auto estimates = dtl::estimate_codecs(bs);
+    $u64 min_size = std::numeric_limits<$u64>::max();
+    for (const auto& e : estimates) min_size = std::min(min_size, e.size_in_bytes);
+
+    const auto b = dtl::choose_codec(bs, dtl::codec_objective::size());
+    ASSERT_EQ(b.estimate().size_in_bytes, min_size);
+    ASSERT_EQ(b.size(), bs.size());
+    // Validate the wrapped bitmap.
+    bitset_t decoded(bs.size());
+    auto it = b.it();
+    while (!it.end()) {
+      for (auto i = it.pos(); i < it.pos() + it.length(); ++i) decoded[i] = true;
+      it.next();
+    }
+    ASSERT_EQ(decoded, bs) << b.name();
+    for (std::size_t i = 0; i < bs.size(); i += 13) {
+      ASSERT_EQ(b.test(i), bs[i]);
+    }
+
+    // A plain bitmap supports the fastest skips.
+    const auto b_skip = dtl::choose_codec(bs, dtl::codec_objective::skip());
+    ASSERT_EQ(b_skip.codec(), dtl::auto_codec::bitmap);
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(auto_bitmap,
+    objectives) {
+  // Sparse bitmaps favor (compressed) lists, clustered ones the run-length
+  // encodings.
+  const auto sparse =
+      dtl::gen_random_bitmap_markov_runs(1ull << 16, 1.0 + 1e-9, 0.001, 1);
+  const auto s = dtl::choose_codec(sparse).codec();
+  ASSERT_TRUE(s == dtl::auto_codec::position_list
+      || s == dtl::auto_codec::elias_fano
+      || s == dtl::auto_codec::delta_bp128) << dtl::auto_codec_name(s);
+  const auto clustered =
+      dtl::gen_random_bitmap_markov_runs(1ull << 16, 1024.0, 0.1, 2);
+  const auto c = dtl::choose_codec(clustered).codec();
+  ASSERT_TRUE(c == dtl::auto_codec::range_list || c == dtl::auto_codec::teb);
+  // Dense random bitmaps are stored uncompressed.
+  const auto dense =
+      dtl::gen_random_bitmap_markov_runs(1ull << 16, 2.0, 0.5, 3);
+  ASSERT_EQ(dtl::choose_codec(dense).codec(), dtl::auto_codec::bitmap);
+  // A mix of objectives.
+  const auto mixed = dtl::choose_codec(clustered,
+      dtl::codec_objective::mix(1.0, 1.0, 0.1));
+  ASSERT_EQ(mixed.size(), clustered.size());
+}
+//===----------------------------------------------------------------------===//
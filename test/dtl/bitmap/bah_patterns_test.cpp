@@ -0,0 +1,40 @@
+#include "gtest/gtest.h"
+
+#include <dtl/bitmap/bah_patterns.hpp>
+#include <dtl/dtl.hpp>
+
+#include <random>
+//===----------------------------------------------------------------------===//
+// Tests for the BAH pattern lookups.
+//===----------------------------------------------------------------------===//
+TEST(bah_patterns, oep_code_roundtrip) {
+  for (std::size_t code = 0; code < dtl::bah_oep_cnt; ++code) {
+    const auto pattern = dtl::get_oep(code);
+    ASSERT_EQ(code, dtl::get_oep_code(pattern));
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(bah_patterns, tep_code_roundtrip) {
+  for (std::size_t code = 0; code < dtl::bah_tep_cnt; ++code) {
+    const auto pattern = dtl::get_tep(code);
+    ASSERT_EQ(code, dtl::get_tep_code(pattern));
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(bah_patterns, lookup_non_encodable_words) {
+  std::mt19937 gen(42);
+  for (std::size_t i = 0; i < 100000; ++i) {
+    const dtl::bah_word_t word = gen();
+    const auto oep_code = dtl::get_oep_code(word);
+    if (oep_code != dtl::bah_code_not_found) {
+      ASSERT_EQ(word, dtl::get_oep(oep_code));
+    }
+    const auto tep_code = dtl::get_tep_code(word);
+    if (tep_code != dtl::bah_code_not_found) {
+      ASSERT_EQ(word, dtl::get_tep(tep_code));
+    }
+  }
+  ASSERT_EQ(dtl::bah_code_not_found, dtl::get_oep_code(0));
+  ASSERT_EQ(dtl::bah_code_not_found, dtl::get_oep_code(0b101));
+}
+//===----------------------------------------------------------------------===//
@@ -0,0 +1,151 @@
+#include "api_types.hpp"
+#include "gtest/gtest.h"
+
+#include <dtl/bitmap.hpp>
+#include <dtl/bitmap/index/bitmap_index.hpp>
+#include <dtl/bitmap/util/convert.hpp>
+#include <dtl/dtl.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Tests for the bitmap index (equality, range and interval encoding).
+//===----------------------------------------------------------------------===//
+constexpr std::size_t RANDOM_LENGTH = (1ull << 10) + 42;
+using enc = dtl::bitmap_index_encoding;
+//===----------------------------------------------------------------------===//
+using bitmap_index_types_under_test = ::testing::Types<
+    dtl::bitmap_index<teb_v2, enc::EQUALITY>,
+    dtl::bitmap_index<teb_v2, enc::RANGE>,
+    dtl::bitmap_index<teb_v2, enc::INTERVAL>,
+    dtl::bitmap_index<wah, enc::EQUALITY>,
+    dtl::bitmap_index<wah, enc::INTERVAL>,
+    dtl::bitmap_index<dtl::xah32, enc::RANGE>,
+    dtl::bitmap_index<dtl::xah32, enc::INTERVAL>
+    >;
+//===----------------------------------------------------------------------===//
+// Fixture for the parameterized test case.
+template<typename T>
+class bitmap_index_test : public ::testing::Test {};
+TYPED_TEST_CASE(bitmap_index_test, bitmap_index_types_under_test);
+//===----------------------------------------------------------------------===//
+/// Generates a (partially clustered) integer sequence in [0, c).
+std::vector<$u32>
+gen_values(u32 c, std::mt19937& gen) {
+  std::vector<$u32> values(RANDOM_LENGTH);
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    values[i] = (gen() % 4 == 0)
+        ? static_cast<$u32>(gen() % c)
+        : static_cast<$u32>((i * c) / values.size());
+  }
+  return values;
+}
+//===----------------------------------------------------------------------===//
+TYPED_TEST(bitmap_index_test, range_queries) {
+  using T = TypeParam;
+  std::mt19937 gen(42);
+  for (u32 c : {1u, 2u, 3u, 4u, 7u, 8u, 13u}) {
+    const auto values = gen_values(c, gen);
+    T index(values, c);
+    ASSERT_EQ(values.size(), index.size());
+    for ($u32 lo = 0; lo < c; ++lo) {
+      for ($u32 hi = lo; hi <= c; ++hi) {
+        dtl::bitmap expected(values.size());
+        for (std::size_t i = 0; i < values.size(); ++i) {
+          expected[i] = values[i] >= lo && values[i] <= hi;
+        }
+        ASSERT_EQ(expected, index.range(lo, hi))
+            << "c=" << c << ", lo=" << lo << ", hi=" << hi;
+        if (lo == hi) {
+          ASSERT_EQ(expected, index.eq(lo));
+        }
+      }
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+TYPED_TEST(bitmap_index_test, in_list_queries) {
+  using T = TypeParam;
+  std::mt19937 gen(42);
+  for (u32 c : {5u, 16u, 33u}) {
+    const auto values = gen_values(c, gen);
+    T index(values, c);
+    for (std::size_t r = 0; r < 50; ++r) {
+      std::vector<$u32> in_list(gen() % 8);
+      for (auto& v : in_list) v = static_cast<$u32>(gen() % c);
+      dtl::bitmap expected(values.size());
+      for (std::size_t i = 0; i < values.size(); ++i) {
+        expected[i] = std::find(in_list.begin(), in_list.end(), values[i])
+            != in_list.end();
+      }
+      ASSERT_EQ(expected, index.in(in_list));
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+TYPED_TEST(bitmap_index_test, skip_to) {
+  using T = TypeParam;
+  std::mt19937 gen(42);
+  u32 c = 9;
+  const auto values = gen_values(c, gen);
+  T index(values, c);
+  for ($u32 lo = 0; lo < c; ++lo) {
+    for ($u32 hi = lo; hi < c; ++hi) {
+      const auto expected = index.range(lo, hi);
+      auto it = index.range_it(lo, hi);
+      std::size_t to_pos = 0;
+      while (!it.end()) {
+        to_pos = std::max(to_pos + gen() % 64, it.pos());
+        it.skip_to(to_pos);
+        const auto next = (to_pos == 0)
+            ? expected.find_first()
+            : expected.find_next(to_pos - 1);
+        if (next == dtl::bitmap::npos) {
+          ASSERT_TRUE(it.end());
+        }
+        else {
+          ASSERT_EQ(next, it.pos());
+        }
+      }
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+TYPED_TEST(bitmap_index_test, parallel_load) {
+  using T = TypeParam;
+  std::mt19937 gen(42);
+  for (u32 c : {1u, 6u, 100u}) {
+    const auto values = gen_values(c, gen);
+    T expected(values, c);
+    for (auto thread_cnt : {2, 3, 8}) {
+      T index(values, c, thread_cnt);
+      ASSERT_EQ(expected.bitmap_cnt(), index.bitmap_cnt());
+      for (std::size_t i = 0; i < index.bitmap_cnt(); ++i) {
+        ASSERT_EQ(dtl::to_bitmap_using_iterator(expected.get_bitmap(i)),
+            dtl::to_bitmap_using_iterator(index.get_bitmap(i)));
+      }
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+/// A bitmap type with a constructor that accepts any pointer as first
+/// argument (through the implicit conversion to bool).
+struct bool_constructible {
+  bool_constructible(u1 val, std::size_t cnt, std::size_t n) {}
+};
+/// A bitmap type with a constructor that takes sorted positions.
+struct position_constructible {
+  position_constructible(const $u32* positions, std::size_t cnt,
+      std::size_t n) {}
+};
+//===----------------------------------------------------------------------===//
+TEST(bitmap_index, position_constructible) {
+  using dtl::internal::is_position_constructible;
+  ASSERT_TRUE(is_position_constructible<position_constructible>::value);
+  ASSERT_TRUE(is_position_constructible<dtl::xah32>::value);
+  ASSERT_FALSE(is_position_constructible<bool_constructible>::value);
+  ASSERT_FALSE(is_position_constructible<teb_v2>::value);
+  ASSERT_FALSE(is_position_constructible<dtl::bitmap>::value);
+}
+//===----------------------------------------------------------------------===//
@@ -0,0 +1,147 @@
+#include "bitwise_operations_helper.hpp"
+#include "gtest/gtest.h"
+
+#include <dtl/bitmap/bitwise_expression.hpp>
+#include <dtl/bitmap/position_list.hpp>
+#include <dtl/bitmap/teb_wrapper.hpp>
+#include <dtl/bitmap/uah.hpp>
+#include <dtl/bitmap/util/random_runs.hpp>
+#include <dtl/bitmap/xah.hpp>
+#include <dtl/dtl.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+//===----------------------------------------------------------------------===//
+// Typed tests for the evaluation of bitwise expressions. The results are
+// validated against the bitwise operations of boost::dynamic_bitset.
+//===----------------------------------------------------------------------===//
+using bitset_t = boost::dynamic_bitset<$u32>;
+//===----------------------------------------------------------------------===//
+/// Validates the iterator of the given expression, using (random) skips if
+/// max_distance > 0.
+template<typename T>
+static void
+validate(const dtl::bitwise_expr<T>& e, const bitset_t& expected,
+    std::size_t max_distance, $u32 seed) {
+  auto it = dtl::bitwise_expr_it(e);
+  validate_run_iterator(it, expected, max_distance, seed);
+  // The fused consumers.
+  ASSERT_EQ(dtl::bitwise_count(e), expected.count());
+  ASSERT_EQ(dtl::bitwise_to_bitset(e), expected);
+  std::vector<$u32> positions;
+  dtl::bitwise_positions(e, positions);
+  ASSERT_EQ(positions.size(), expected.count());
+  for (auto p : positions) ASSERT_TRUE(expected[p]);
+}
+//===----------------------------------------------------------------------===//
+// Fixture for the parameterized test case.
+template<typename T>
+class bitwise_expression_test : public ::testing::Test {};
+
+using types_under_test = ::testing::Types<
+    dtl::teb_wrapper,
+    dtl::uah32,
+    dtl::xah32,
+    dtl::position_list<$u32>
+>;
+TYPED_TEST_CASE(bitwise_expression_test, types_under_test);
+//===----------------------------------------------------------------------===//
+TYPED_TEST(bitwise_expression_test, flattening) {
+  using T = TypeParam;
+  const auto bs = dtl::gen_random_bitmap_markov_runs(1000, 8, 0.5, 1);
+  const T a(bs), b(bs), c(bs);
+  using dtl::bitwise_leaf_expr;
+  const auto e = dtl::bitwise_or_expr(
+      dtl::bitwise_and_expr(
+          dtl::bitwise_and_expr(bitwise_leaf_expr(a), bitwise_leaf_expr(b)),
+          bitwise_leaf_expr(c)),
+      dtl::bitwise_or_expr(bitwise_leaf_expr(a), bitwise_leaf_expr(b)));
+  using kind = typename dtl::bitwise_expr<T>::kind;
+  ASSERT_EQ(e.get_kind(), kind::disjunction);
+  ASSERT_EQ(e.children().size(), 3);
+  ASSERT_EQ(e.children()[0].get_kind(), kind::conjunction);
+  ASSERT_EQ(e.children()[0].children().size(), 3);
+  ASSERT_EQ(e.leaf_cnt(), 5);
+  ASSERT_EQ(e.size(), 1000);
+}
+//===----------------------------------------------------------------------===//
+TYPED_TEST(bitwise_expression_test, conjunction) {
+  using T = TypeParam;
+  for (auto n : { 64ull, 12345ull, 1ull << 16 }) {
+    for (std::size_t k = 2; k <= 8; ++k) {
+      std::vector<bitset_t> bitsets;
+      std::vector<T> bitmaps;
+      bitsets.reserve(k);
+      bitmaps.reserve(k);
+      bitset_t expected(n);
+      expected.set();
+      for (std::size_t i = 0; i < k; ++i) {
+        // Vary the density, such that the inputs need to be reordered.
+        bitsets.push_back(
+            dtl::gen_random_bitmap_markov_runs(n, 16, 0.95 - 0.1 * i,
+                k * 10 + i));
+        bitmaps.emplace_back(bitsets.back());
+        expected &= bitsets.back();
+      }
+      auto e = dtl::bitwise_leaf_expr(bitmaps[0]);
+      for (std::size_t i = 1; i < k; ++i) {
+        e = dtl::bitwise_and_expr(std::move(e),
+            dtl::bitwise_leaf_expr(bitmaps[i]));
+      }
+      ASSERT_EQ(e.children().size(), k);
+      validate(e, expected, 0, 1);
+      validate(e, expected, 64, 2);
+      validate(e, expected, n / 8, 3);
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+TYPED_TEST(bitwise_expression_test, nested) {
+  using T = TypeParam;
+  for (auto n : { 64ull, 1000ull, 12345ull, 1ull << 16 }) {
+    for (auto d : { 0.01, 0.1, 0.5 }) {
+      for (auto f : { 1.5, 8.0, 64.0 }) {
+        if (d / (1.0 - d) > f) continue;
+        const auto bs_a = dtl::gen_random_bitmap_markov_runs(n, f, d, 1);
+        const auto bs_b = dtl::gen_random_bitmap_markov_runs(n, f, d, 2);
+        const auto bs_c = dtl::gen_random_bitmap_markov_runs(n, f, 0.5, 3);
+        const auto bs_d = dtl::gen_random_bitmap_markov_runs(n, f, 0.9, 4);
+        const T a(bs_a), b(bs_b), c(bs_c), d(bs_d);
+        using dtl::bitwise_and_expr;
+        using dtl::bitwise_leaf_expr;
+        using dtl::bitwise_or_expr;
+        // (a OR b) AND (c AND d), with cardinality hints.
+        const auto e0 = bitwise_and_expr(
+            bitwise_or_expr(bitwise_leaf_expr(a, bs_a.count() + 1),
+                bitwise_leaf_expr(b, bs_b.count() + 1)),
+            bitwise_and_expr(bitwise_leaf_expr(c, bs_c.count() + 1),
+                bitwise_leaf_expr(d, bs_d.count() + 1)));
+        const auto expected0 = (bs_a | bs_b) & (bs_c & bs_d);
+        validate(e0, expected0, 0, 1);
+        validate(e0, expected0, 128, 2);
+        // (a AND c) OR (b AND d) OR (a AND b AND c)
+        const auto e1 = bitwise_or_expr(
+            bitwise_or_expr(
+                bitwise_and_expr(bitwise_leaf_expr(a), bitwise_leaf_expr(c)),
+                bitwise_and_expr(bitwise_leaf_expr(b), bitwise_leaf_expr(d))),
+            bitwise_and_expr(
+                bitwise_and_expr(bitwise_leaf_expr(a), bitwise_leaf_expr(b)),
+                bitwise_leaf_expr(c)));
+        const auto expected1 = (bs_a & bs_c) | (bs_b & bs_d)
+            | (bs_a & bs_b & bs_c);
+        validate(e1, expected1, 0, 1);
+        validate(e1, expected1, 128, 2);
+        // ((a OR b) AND c) OR d
+        const auto e2 = bitwise_or_expr(
+            bitwise_and_expr(
+                bitwise_or_expr(bitwise_leaf_expr(a), bitwise_leaf_expr(b)),
+                bitwise_leaf_expr(c)),
+            bitwise_leaf_expr(d));
+        const auto expected2 = ((bs_a | bs_b) & bs_c) | bs_d;
+        validate(e2, expected2, 0, 1);
+        validate(e2, expected2, n / 4, 2);
+      }
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
@@ -1,8 +1,56 @@
 #pragma once
 //===----------------------------------------------------------------------===//
+#include "gtest/gtest.h"
+
 #include <dtl/bitmap.hpp>
 #include <dtl/bitmap/bitwise_operations.hpp>
 #include <dtl/dtl.hpp>
+
+#include <random>
+#include <string>
+//===----------------------------------------------------------------------===//
+/// Returns the position of the first 1-bit at or after the given position, or
+/// the bitmap length if there is none.
+static std::size_t
+find_from(const dtl::bitmap& bs, std::size_t pos) {
+  if (pos >= bs.size()) return bs.size();
+  if (bs[pos]) return pos;
+  const auto p = bs.find_next(pos);
+  return p == dtl::bitmap::npos ? bs.size() : p;
+}
+//===----------------------------------------------------------------------===//
+/// Validates the given run iterator against the expected bitmap. If
+/// max_distance > 0, the iterator is forwarded using (random) skips with
+/// distances of varying length, otherwise only next() is used. The 1-runs are
+/// not required to be maximal.
+template<typename It>
+static void
+validate_run_iterator(It& it, const dtl::bitmap& expected,
+    std::size_t max_distance, $u32 seed, const std::string& info = "") {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<std::size_t> distance(1,
+      std::max(max_distance, std::size_t(1)));
+  std::size_t expected_pos = find_from(expected, 0);
+  while (true) {
+    ASSERT_EQ(it.end(), expected_pos == expected.size()) << info;
+    if (it.end()) break;
+    ASSERT_EQ(it.pos(), expected_pos) << info;
+    ASSERT_GT(it.length(), 0) << info;
+    for (std::size_t i = it.pos(); i < it.pos() + it.length(); ++i) {
+      ASSERT_TRUE(expected[i]) << info << ", pos=" << i;
+    }
+    if (max_distance == 0 || gen() % 4 == 0) {
+      // Forward to the next 1-fill.
+      expected_pos = find_from(expected, it.pos() + it.length());
+      it.next();
+    }
+    else {
+      const auto to_pos = it.pos() + distance(gen);
+      expected_pos = find_from(expected, to_pos);
+      it.skip_to(to_pos);
+    }
+  }
+}
 //===----------------------------------------------------------------------===//
 template<typename T>
 dtl::bitmap
@@ -349,3 +397,39 @@ bitwise_xor_re_iter(const T& bitmap_a, const T& bitmap_b) {
   return ret_val;
 }
 //===----------------------------------------------------------------------===//
+template<typename T>
+dtl::bitmap
+bitwise_and_not_iter(const T& bitmap_a, const T& bitmap_b) {
+  dtl::bitmap ret_val(bitmap_a.size());
+  auto and_not_it = dtl::bitwise_and_not_it(bitmap_a.scan_it(), bitmap_b.it());
+  while (!and_not_it.end()) {
+    const auto begin = and_not_it.pos();
+    const auto end = and_not_it.pos() + and_not_it.length();
+    for (std::size_t i = begin; i < end; ++i) {
+      // Make sure, no bits are set more than once.
+      assert(ret_val[i] == false);
+      ret_val[i] = true;
+    }
+    and_not_it.next();
+  }
+  return ret_val;
+}
+//===----------------------------------------------------------------------===//
+template<typename T>
+dtl::bitmap
+bitwise_not_iter(const T& bitmap_a) {
+  dtl::bitmap ret_val(bitmap_a.size());
+  auto not_it = dtl::not_it(bitmap_a.it(), bitmap_a.size());
+  while (!not_it.end()) {
+    const auto begin = not_it.pos();
+    const auto end = not_it.pos() + not_it.length();
+    for (std::size_t i = begin; i < end; ++i) {
+      // Make sure, no bits are set more than once.
+      assert(ret_val[i] == false);
+      ret_val[i] = true;
+    }
+    not_it.next();
+  }
+  return ret_val;
+}
+//===----------------------------------------------------------------------===//
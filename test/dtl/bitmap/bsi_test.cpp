@@ -0,0 +1,108 @@
+#include "api_types.hpp"
+#include "gtest/gtest.h"
+
+#include <dtl/bitmap.hpp>
+#include <dtl/bitmap/index/bsi.hpp>
+#include <dtl/bitmap/util/convert.hpp>
+#include <dtl/dtl.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Tests for the bit-sliced index.
+//===----------------------------------------------------------------------===//
+constexpr std::size_t RANDOM_LENGTH = (1ull << 10) + 42;
+//===----------------------------------------------------------------------===//
+using bsi_types_under_test = ::testing::Types<
+    dtl::bsi<teb_v2>,
+    dtl::bsi<wah>,
+    dtl::bsi<dtl::xah32>
+    >;
+//===----------------------------------------------------------------------===//
+// Fixture for the parameterized test case.
+template<typename T>
+class bsi_test : public ::testing::Test {};
+TYPED_TEST_CASE(bsi_test, bsi_types_under_test);
+//===----------------------------------------------------------------------===//
+/// Generates a (partially clustered) integer sequence in [0, max].
+std::vector<$u32>
+gen_values(u32 max, std::mt19937& gen) {
+  std::vector<$u32> values(RANDOM_LENGTH);
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    values[i] = (gen() % 3 == 0)
+        ? static_cast<$u32>(gen() % (u64(max) + 1))
+        : static_cast<$u32>((i * max) / values.size());
+  }
+  return values;
+}
+//===----------------------------------------------------------------------===//
+TYPED_TEST(bsi_test, sum) {
+  using T = TypeParam;
+  std::mt19937 gen(42);
+  for (u32 max : {0u, 1u, 100u, 1u << 20}) {
+    const auto values = gen_values(max, gen);
+    T index(values);
+    $u64 expected = 0;
+    $u64 expected_lt = 0;
+    for (auto v : values) {
+      expected += v;
+      if (v < max / 2) expected_lt += v;
+    }
+    ASSERT_EQ(expected, index.sum());
+    ASSERT_EQ(expected_lt, index.sum(index.lt(max / 2)));
+  }
+}
+//===----------------------------------------------------------------------===//
+TYPED_TEST(bsi_test, comparisons) {
+  using T = TypeParam;
+  std::mt19937 gen(42);
+  for (u32 max : {0u, 1u, 7u, 100u, 1000u}) {
+    const auto values = gen_values(max, gen);
+    T index(values);
+    for ($u64 c = 0; c <= max + 2; c += 1 + max / 50) {
+      const $u64 hi = c + gen() % 10;
+      dtl::bitmap lt(values.size());
+      dtl::bitmap eq(values.size());
+      dtl::bitmap ge(values.size());
+      dtl::bitmap between(values.size());
+      for (std::size_t i = 0; i < values.size(); ++i) {
+        lt[i] = values[i] < c;
+        eq[i] = values[i] == c;
+        ge[i] = values[i] >= c;
+        between[i] = values[i] >= c && values[i] <= hi;
+      }
+      ASSERT_EQ(lt, dtl::to_bitmap_using_iterator(index.lt(c)));
+      ASSERT_EQ(eq, dtl::to_bitmap_using_iterator(index.eq(c)));
+      ASSERT_EQ(ge, dtl::to_bitmap_using_iterator(index.ge(c)));
+      ASSERT_EQ(between, dtl::to_bitmap_using_iterator(index.between(c, hi)));
+      // Fused compare-and-count.
+      ASSERT_EQ(lt.count(), index.count_lt(c));
+      ASSERT_EQ(ge.count(), index.count_ge(c));
+      ASSERT_EQ(between.count(), index.count_between(c, hi));
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+TYPED_TEST(bsi_test, top_k) {
+  using T = TypeParam;
+  std::mt19937 gen(42);
+  for (u32 max : {0u, 7u, 1000u}) {
+    const auto values = gen_values(max, gen);
+    T index(values);
+    for (std::size_t k : {0ul, 1ul, 10ul, values.size() / 3, values.size()}) {
+      const auto top = dtl::to_bitmap_using_iterator(index.top_k(k));
+      ASSERT_EQ(k, top.count());
+      // The k-th largest value.
+      auto sorted = values;
+      std::sort(sorted.begin(), sorted.end(), std::greater<$u32>());
+      for (std::size_t i = 0; i < values.size(); ++i) {
+        if (k == 0) break;
+        if (values[i] > sorted[k - 1]) ASSERT_TRUE(top[i]);
+        if (values[i] < sorted[k - 1]) ASSERT_FALSE(top[i]);
+      }
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
@@ -169,6 +169,7 @@ TYPED_TEST(part_diff_test, random_updates) {
         enc.template merge<merge_type>();
 
         dtl::bitmap dec = dtl::to_bitmap_using_iterator(enc);
+        ASSERT_EQ(plain.count(), enc.count());
         ASSERT_EQ(plain, dec)
             << "Failed to apply updates:\n"
             << "              :'" << update << "'\n"
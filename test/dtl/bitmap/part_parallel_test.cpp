@@ -0,0 +1,72 @@
+#include "api_types.hpp"
+#include "experiments/util/gen.hpp"
+#include "gtest/gtest.h"
+
+#include <dtl/bitmap.hpp>
+#include <dtl/bitmap/part/part_parallel.hpp>
+#include <dtl/bitmap/util/convert.hpp>
+#include <dtl/dtl.hpp>
+
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Tests for the parallel bitwise operations on partitioned bitmaps.
+//===----------------------------------------------------------------------===//
+constexpr std::size_t RANDOM_REPEAT = 10;
+constexpr std::size_t RANDOM_LENGTH = (1ull << 12) + 42;
+//===----------------------------------------------------------------------===//
+using part_parallel_types_under_test = ::testing::Types<
+    dtl::part<teb_v2, 1ull << 8>,
+    dtl::part<wah, 1ull << 8>,
+    dtl::part<dtl::xah32, 1ull << 8>,
+    dtl::part<dtl::range_list<$u8>, 1ull << 8>
+    >;
+//===----------------------------------------------------------------------===//
+// Fixture for the parameterized test case.
+template<typename T>
+class part_parallel_test : public ::testing::Test {};
+TYPED_TEST_CASE(part_parallel_test, part_parallel_types_under_test);
+//===----------------------------------------------------------------------===//
+/// Reconstructs a plain bitmap from the given runs.
+dtl::bitmap
+to_bitmap(const std::vector<dtl::part_parallel_run_t>& runs, u64 n) {
+  dtl::bitmap bm(n);
+  for (std::size_t i = 0; i < runs.size(); ++i) {
+    const auto& r = runs[i];
+    // Adjacent runs need to be merged.
+    if (i > 0) {
+      EXPECT_LT(runs[i - 1].pos + runs[i - 1].length, r.pos);
+    }
+    for (std::size_t j = r.pos; j < r.pos + r.length; ++j) {
+      bm[j] = true;
+    }
+  }
+  return bm;
+}
+//===----------------------------------------------------------------------===//
+TYPED_TEST(part_parallel_test, bitwise_operations) {
+  using T = TypeParam;
+  for (auto thread_cnt : {1, 2, 3, 8}) {
+    for (std::size_t r = 0; r < RANDOM_REPEAT; ++r) {
+      const auto d = 0.05 * (r + 1);
+      dtl::bitmap bm_a = gen_random_bitmap_uniform(RANDOM_LENGTH, 1.0 - d);
+      dtl::bitmap bm_b = gen_random_bitmap_uniform(RANDOM_LENGTH, d);
+      T a(bm_a);
+      T b(bm_b);
+
+      ASSERT_EQ(dtl::to_bitmap_using_iterator(dtl::parallel_and(a, b, thread_cnt)),
+          bm_a & bm_b);
+      ASSERT_EQ(dtl::to_bitmap_using_iterator(dtl::parallel_or(a, b, thread_cnt)),
+          bm_a | bm_b);
+      ASSERT_EQ(dtl::to_bitmap_using_iterator(dtl::parallel_xor(a, b, thread_cnt)),
+          bm_a ^ bm_b);
+
+      ASSERT_EQ(to_bitmap(dtl::parallel_and_runs(a, b, thread_cnt), RANDOM_LENGTH),
+          bm_a & bm_b);
+      ASSERT_EQ(to_bitmap(dtl::parallel_or_runs(a, b, thread_cnt), RANDOM_LENGTH),
+          bm_a | bm_b);
+      ASSERT_EQ(to_bitmap(dtl::parallel_xor_runs(a, b, thread_cnt), RANDOM_LENGTH),
+          bm_a ^ bm_b);
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
@@ -0,0 +1,148 @@
+#include "experiments/util/gen.hpp"
+#include "gtest/gtest.h"
+
+#include <dtl/bitmap.hpp>
+#include <dtl/bitmap/part/part_run.hpp>
+#include <dtl/bitmap/part/part_updirect.hpp>
+#include <dtl/bitmap/teb_wrapper.hpp>
+#include <dtl/bitmap/util/convert.hpp>
+#include <dtl/bitmap/xah.hpp>
+#include <dtl/dtl.hpp>
+
+#include <random>
+//===----------------------------------------------------------------------===//
+// Tests for the storage of the partitions of partitioned bitmaps.
+//===----------------------------------------------------------------------===//
+constexpr std::size_t RANDOM_LENGTH = (1ull << 12) + 42;
+constexpr std::size_t P = 1ull << 8;
+//===----------------------------------------------------------------------===//
+/// Generates a bitmap that contains partitions which are all 0, all 1 and
+/// mixed.
+dtl::bitmap
+gen_bitmap(f64 d) {
+  dtl::bitmap bm = gen_random_bitmap_uniform(RANDOM_LENGTH, d);
+  for (std::size_t i = 512; i < 1536; ++i) bm[i] = true;
+  for (std::size_t i = 2048; i < 3072; ++i) bm[i] = false;
+  return bm;
+}
+//===----------------------------------------------------------------------===//
+/// Applies random updates to the partitioned bitmap and the plain bitmap.
+template<typename T>
+void
+apply_random_updates(T& t, dtl::bitmap& bm, std::size_t update_cnt) {
+  std::mt19937 gen(42);
+  for (std::size_t i = 0; i < update_cnt; ++i) {
+    const std::size_t pos = gen() % bm.size();
+    const u1 val = (gen() % 2) == 0;
+    t.set(pos, val);
+    bm[pos] = val;
+  }
+}
+//===----------------------------------------------------------------------===//
+/// Validates that the serialized partitions are stored back-to-back in the
+/// order of the slots, without any garbage in between.
+template<typename S>
+void
+validate_contiguous(const S& store) {
+  std::size_t word_cnt = 0;
+  for (std::size_t i = 0; i < store.size(); ++i) {
+    ASSERT_EQ(word_cnt, store.offset(i));
+    word_cnt += store.length(i);
+  }
+  ASSERT_EQ(word_cnt, store.buffer().size());
+}
+//===----------------------------------------------------------------------===//
+TEST(part_store, flat_partitions_are_contiguous) {
+  using T = dtl::part_updirect<dtl::teb_wrapper, P>;
+  static_assert(dtl::part_flat_traits<dtl::teb_wrapper>::value,
+      "TEBs are expected to have a flat representation.");
+  auto bm = gen_bitmap(0.25);
+  T t(bm);
+  ASSERT_EQ(t.part_cnt(), t.store().size());
+  validate_contiguous(t.store());
+  ASSERT_EQ(bm, dtl::to_bitmap_using_iterator(t));
+
+  // Updates append the new partitions to the buffer.
+  apply_random_updates(t, bm, 100);
+  ASSERT_EQ(bm, dtl::to_bitmap_using_iterator(t));
+  for (std::size_t i = 0; i < bm.size(); ++i) {
+    ASSERT_EQ(bm[i], t.test(i));
+  }
+
+  // Merging removes the garbage.
+  t.template merge<void>();
+  validate_contiguous(t.store());
+  ASSERT_EQ(bm, dtl::to_bitmap_using_iterator(t));
+}
+//===----------------------------------------------------------------------===//
+TEST(part_store, part_run_arena_is_in_partition_order) {
+  using T = dtl::part_run<dtl::teb_wrapper, P>;
+  auto bm = gen_bitmap(0.25);
+  T t(bm);
+  validate_contiguous(t.store());
+
+  // Updates turn partitions into single-valued partitions and vice versa.
+  apply_random_updates(t, bm, 1000);
+  for (std::size_t i = 512; i < 1536; ++i) {
+    t.set(i, true);
+    bm[i] = true;
+  }
+  for (std::size_t i = 2048; i < 3072; ++i) {
+    t.set(i, false);
+    bm[i] = false;
+  }
+  t.set(2048 + 7, true);
+  bm[2048 + 7] = true;
+  ASSERT_EQ(bm, dtl::to_bitmap_using_iterator(t));
+
+  // After merging, the arena contains exactly the mixed partitions, stored
+  // back-to-back in partition order.
+  t.template merge<void>();
+  validate_contiguous(t.store());
+  std::size_t mixed_cnt = 0;
+  for (std::size_t b = 0; b < bm.size(); b += P) {
+    const auto e = std::min(b + P, bm.size());
+    std::size_t c = 0;
+    for (std::size_t i = b; i < e; ++i) c += bm[i];
+    mixed_cnt += (c != 0 && c != P);
+  }
+  ASSERT_EQ(mixed_cnt, t.store().size());
+  std::size_t slot_idx = 0;
+  for (std::size_t b = 0; b < bm.size(); b += P) {
+    const auto e = std::min(b + P, bm.size());
+    std::size_t c = 0;
+    for (std::size_t i = b; i < e; ++i) c += bm[i];
+    if (c == 0 || c == P) continue;
+    // The partition is in the slot that corresponds to its rank among the
+    // mixed partitions.
+    const auto& part = t.store()[slot_idx];
+    for (std::size_t i = b; i < e; ++i) {
+      ASSERT_EQ(bm[i], part.test(i - b));
+    }
+    ++slot_idx;
+  }
+  ASSERT_EQ(bm, dtl::to_bitmap_using_iterator(t));
+}
+//===----------------------------------------------------------------------===//
+TEST(part_store, non_flat_partitions) {
+  static_assert(!dtl::part_flat_traits<dtl::xah32>::value,
+      "XAH is not expected to have a flat representation.");
+  {
+    using T = dtl::part_updirect<dtl::xah32, P>;
+    auto bm = gen_bitmap(0.25);
+    T t(bm);
+    apply_random_updates(t, bm, 1000);
+    t.template merge<void>();
+    ASSERT_EQ(bm, dtl::to_bitmap_using_iterator(t));
+  }
+  {
+    using T = dtl::part_run<dtl::xah32, P>;
+    auto bm = gen_bitmap(0.25);
+    T t(bm);
+    apply_random_updates(t, bm, 1000);
+    ASSERT_EQ(bm, dtl::to_bitmap_using_iterator(t));
+    t.template merge<void>();
+    ASSERT_EQ(bm, dtl::to_bitmap_using_iterator(t));
+  }
+}
+//===----------------------------------------------------------------------===//
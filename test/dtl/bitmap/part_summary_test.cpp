@@ -0,0 +1,122 @@
+#include "api_types.hpp"
+#include "experiments/util/gen.hpp"
+#include "gtest/gtest.h"
+
+#include <dtl/bitmap.hpp>
+#include <dtl/bitmap/part/part.hpp>
+#include <dtl/bitmap/part/part_updirect.hpp>
+#include <dtl/bitmap/util/convert.hpp>
+#include <dtl/dtl.hpp>
+
+#include <random>
+//===----------------------------------------------------------------------===//
+// Tests for the partition summaries (zone maps) of partitioned bitmaps.
+//===----------------------------------------------------------------------===//
+constexpr std::size_t RANDOM_LENGTH = (1ull << 12) + 42;
+//===----------------------------------------------------------------------===//
+using part_summary_types_under_test = ::testing::Types<
+    part_8_teb,
+    part_8_wah,
+    dtl::part_updirect<dtl::xah32, 1ull << 8>,
+    // Updates are forwarded to the partitions.
+    part_position_list_8
+    >;
+//===----------------------------------------------------------------------===//
+// Fixture for the parameterized test case.
+template<typename T>
+class part_summary_test : public ::testing::Test {};
+TYPED_TEST_CASE(part_summary_test, part_summary_types_under_test);
+//===----------------------------------------------------------------------===//
+/// Generates a bitmap that contains partitions which are all 0, all 1 and
+/// mixed.
+dtl::bitmap
+gen_bitmap(f64 d) {
+  dtl::bitmap bm = gen_random_bitmap_uniform(RANDOM_LENGTH, d);
+  for (std::size_t i = 300; i < 1500; ++i) bm[i] = true;
+  for (std::size_t i = 2000; i < 3100; ++i) bm[i] = false;
+  return bm;
+}
+//===----------------------------------------------------------------------===//
+/// Validates the skip_to function against the plain bitmap.
+template<typename T>
+void
+validate_skip_to(const T& t, const dtl::bitmap& bm) {
+  for (std::size_t to_pos = 0; to_pos < bm.size(); to_pos += 37) {
+    auto it = t.it();
+    it.skip_to(to_pos);
+    const auto expected = (to_pos == 0)
+        ? bm.find_first()
+        : bm.find_next(to_pos - 1);
+    if (expected == dtl::bitmap::npos) {
+      ASSERT_TRUE(it.end());
+    }
+    else {
+      ASSERT_FALSE(it.end());
+      ASSERT_EQ(expected, it.pos());
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+TYPED_TEST(part_summary_test, count_and_skip) {
+  using T = TypeParam;
+  for (auto d : {0.01, 0.25, 0.75}) {
+    const auto bm = gen_bitmap(d);
+    T t(bm);
+    ASSERT_EQ(bm.count(), t.count());
+    ASSERT_EQ(bm, dtl::to_bitmap_using_iterator(t));
+    validate_skip_to(t, bm);
+  }
+}
+//===----------------------------------------------------------------------===//
+TYPED_TEST(part_summary_test, summary_after_updates) {
+  using T = TypeParam;
+  std::mt19937 gen(42);
+  auto bm = gen_bitmap(0.25);
+  T t(bm);
+  for (std::size_t i = 0; i < 1000; ++i) {
+    const std::size_t pos = gen() % bm.size();
+    const u1 val = (gen() % 2) == 0;
+    t.set(pos, val);
+    bm[pos] = val;
+  }
+  ASSERT_EQ(bm.count(), t.count());
+  ASSERT_EQ(bm, dtl::to_bitmap_using_iterator(t));
+  validate_skip_to(t, bm);
+}
+//===----------------------------------------------------------------------===//
+TEST(part_summary, size_accounting) {
+  const auto bm = gen_bitmap(0.25);
+  const std::size_t part_cnt = (bm.size() + 255) / 256;
+  // The partition summaries are included in the size and reported separately.
+  {
+    part_8_teb t(bm);
+    ASSERT_EQ(part_cnt * sizeof(dtl::part_summary_t),
+        t.summaries_size_in_bytes());
+    ASSERT_GT(t.size_in_bytes(), t.summaries_size_in_bytes());
+    ASSERT_NE(std::string::npos, t.info().find("\"summaries_size\":"
+        + std::to_string(t.summaries_size_in_bytes())));
+  }
+  // Same for the partition references of part_run. The offsets and lengths
+  // of the serialized partitions are included in the size as well.
+  {
+    std::size_t mixed_cnt = 0;
+    for (std::size_t b = 0; b < bm.size(); b += 256) {
+      const auto e = std::min(b + 256, bm.size());
+      std::size_t c = 0;
+      for (std::size_t i = b; i < e; ++i) c += bm[i];
+      mixed_cnt += (c != 0 && c != e - b);
+    }
+    part_run_8_teb t(bm);
+    ASSERT_EQ(part_cnt * sizeof($u32), t.refs_size_in_bytes());
+    ASSERT_GT(t.size_in_bytes(),
+        t.refs_size_in_bytes() + 2 * mixed_cnt * sizeof($u32));
+    ASSERT_NE(std::string::npos, t.info().find("\"refs_size\":"
+        + std::to_string(t.refs_size_in_bytes())));
+
+    // Without any mixed partitions, the references are all that is stored.
+    part_run_8_teb empty(dtl::bitmap(bm.size()));
+    ASSERT_EQ(part_cnt * sizeof($u32), empty.refs_size_in_bytes());
+    ASSERT_EQ(empty.refs_size_in_bytes(), empty.size_in_bytes());
+  }
+}
+//===----------------------------------------------------------------------===//
@@ -0,0 +1,94 @@
+#include "bitwise_operations_helper.hpp"
+#include "gtest/gtest.h"
+
+#include <dtl/bitmap/teb_wrapper.hpp>
+#include <dtl/bitmap/util/random_runs.hpp>
+#include <dtl/dtl.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <sstream>
+//===----------------------------------------------------------------------===//
+// Tests the skip support of the TEB scan iterator. The bitmaps are chosen such
+// that all the specialized batch implementations are covered.
+//===----------------------------------------------------------------------===//
+/// Skips through the bitmap with (random) distances of varying length and
+/// validates the iterator after each step.
+static void
+skip_test(const boost::dynamic_bitset<$u32>& bs, std::size_t max_distance,
+    $u32 seed) {
+  dtl::teb_wrapper enc(bs);
+  std::stringstream info;
+  info << "n=" << bs.size() << ", count=" << bs.count()
+       << ", max_distance=" << max_distance << ", teb=" << enc.info();
+  auto it = enc.scan_it();
+  validate_run_iterator(it, bs, max_distance, seed, info.str());
+}
+//===----------------------------------------------------------------------===//
+TEST(teb_scan_iter,
+    skip_sparse) {
+  for (auto n : { 1ull << 10, 1ull << 16, 1ull << 20 }) {
+    const auto bs = dtl::gen_random_bitmap_markov_runs(n, 4, 0.005, 42);
+    skip_test(bs, 64, 1);
+    skip_test(bs, 4096, 2);
+    skip_test(bs, n / 4, 3);
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(teb_scan_iter,
+    skip_uniform) {
+  for (auto n : { 1ull << 10, 1ull << 16, 1ull << 20 }) {
+    for (auto d : { 0.02, 0.25, 0.5, 0.75 }) {
+      const auto bs =
+          dtl::gen_random_bitmap_markov_runs(n, 1.0 / (1.0 - d), d, 7);
+      skip_test(bs, 16, 1);
+      skip_test(bs, 1024, 2);
+      skip_test(bs, n / 8, 3);
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(teb_scan_iter,
+    skip_clustered) {
+  for (auto n : { 1ull << 12, 1ull << 18 }) {
+    for (auto f : { 2.0, 4.0, 8.0, 64.0 }) {
+      const auto bs = dtl::gen_random_bitmap_markov_runs(n, f, 0.5, 13);
+      skip_test(bs, 16, 1);
+      skip_test(bs, 512, 2);
+      skip_test(bs, n / 8, 3);
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(teb_scan_iter,
+    skip_weakly_compressed) {
+  // Only the lowest levels are compressed, which is handled by the specialized
+  // 2-level and 3-level batch implementations.
+  for (auto n : { 1ull << 16, 1ull << 18 }) {
+    for (auto d : { 0.25, 0.3 }) {
+      const auto bs = dtl::gen_random_bitmap_markov_runs(n, 3.0, d, 17);
+      skip_test(bs, 8, 1);
+      skip_test(bs, 256, 2);
+      skip_test(bs, n / 8, 3);
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(teb_scan_iter,
+    skip_dense) {
+  for (auto n : { 1ull << 12, 1ull << 18 }) {
+    const auto bs = ~dtl::gen_random_bitmap_markov_runs(n, 1.0, 0.002, 21);
+    skip_test(bs, 16, 1);
+    skip_test(bs, 2048, 2);
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(teb_scan_iter,
+    skip_non_power_of_two_length) {
+  for (auto n : { 1000ull, 12345ull, 100000ull }) {
+    const auto bs = dtl::gen_random_bitmap_markov_runs(n, 3, 0.1, 5);
+    skip_test(bs, 32, 1);
+    skip_test(bs, 1000, 2);
+  }
+}
+//===----------------------------------------------------------------------===//
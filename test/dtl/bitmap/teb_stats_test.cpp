@@ -0,0 +1,124 @@
+#include "gtest/gtest.h"
+
+#include <dtl/bitmap/teb_stats.hpp>
+#include <dtl/bitmap/teb_wrapper.hpp>
+#include <dtl/dtl.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <random>
+//===----------------------------------------------------------------------===//
+// The counters are only maintained if the tests are compiled with TEB_STATS
+// (cmake -DTEB_STATS=ON). Otherwise, the counters need to remain zero.
+//===----------------------------------------------------------------------===//
+static const u1 stats_enabled = dtl::teb_stats::enabled;
+//===----------------------------------------------------------------------===//
+static boost::dynamic_bitset<$u32>
+gen_bitmap(std::size_t n, $u32 density_pct) {
+  std::mt19937 gen(42);
+  boost::dynamic_bitset<$u32> bs(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    bs[i] = (gen() % 100) < density_pct;
+  }
+  return bs;
+}
+//===----------------------------------------------------------------------===//
+TEST(teb_stats,
+    accumulate_and_reset) {
+  dtl::teb_stats a;
+  dtl::teb_stats b;
+  a.visit(0);
+  a.visit(3);
+  b.visit(3);
+  b.visit(dtl::teb_stats::max_level_cnt + 10); // Clamped to the last level.
+  u64 lut[16] = {};
+  b.rank_call(&lut[0]);
+  b.rank_call(&lut[1]); // Same cache line.
+  b.rank_call(&lut[8]); // Next cache line.
+  a += b;
+  ASSERT_EQ(a.nodes_visited[0], 1);
+  ASSERT_EQ(a.nodes_visited[3], 2);
+  ASSERT_EQ(a.nodes_visited[dtl::teb_stats::max_level_cnt - 1], 1);
+  ASSERT_EQ(a.total_nodes_visited(), 4);
+  ASSERT_EQ(a.rank_calls, 3);
+  ASSERT_LE(b.lut_cache_line_touches, 3);
+  ASSERT_GE(b.lut_cache_line_touches, 2);
+  a.reset();
+  ASSERT_EQ(a.total_nodes_visited(), 0);
+  ASSERT_EQ(a.rank_calls, 0);
+  ASSERT_EQ(a.lut_cache_line_touches, 0);
+}
+//===----------------------------------------------------------------------===//
+TEST(teb_stats,
+    iterator_counters) {
+  const auto bs = gen_bitmap(1ull << 16, 2);
+  dtl::teb_wrapper enc(bs);
+  auto& stats = dtl::teb_stats::local();
+
+  // Iterate over the 1-runs.
+  stats.reset();
+  std::size_t bit_cnt = 0;
+  auto it = enc.it();
+  while (!it.end()) {
+    bit_cnt += it.length();
+    it.next();
+  }
+  ASSERT_EQ(bit_cnt, bs.count());
+  if (stats_enabled) {
+    ASSERT_GT(stats.total_nodes_visited(), 0);
+    ASSERT_GT(stats.label_lookups, 0);
+    ASSERT_LE(stats.lut_cache_line_touches, stats.rank_calls);
+  }
+  else {
+    ASSERT_EQ(stats.total_nodes_visited(), 0);
+    ASSERT_EQ(stats.rank_calls, 0);
+  }
+
+  // Skip through the bitmap.
+  stats.reset();
+  auto skip_it = enc.it();
+  while (!skip_it.end()) {
+    skip_it.skip_to(skip_it.pos() + skip_it.length() + 1000);
+  }
+  if (stats_enabled) {
+    ASSERT_GT(stats.nav_to_calls, 0);
+    ASSERT_GT(stats.descent_steps, 0);
+  }
+  else {
+    ASSERT_EQ(stats.nav_to_calls, 0);
+    ASSERT_EQ(stats.descent_steps, 0);
+  }
+
+  // Point lookups.
+  stats.reset();
+  for (std::size_t i = 0; i < bs.size(); i += 97) {
+    ASSERT_EQ(enc.test(i), bs[i]);
+  }
+  ASSERT_EQ(stats.total_nodes_visited() > 0, stats_enabled);
+}
+//===----------------------------------------------------------------------===//
+TEST(teb_stats,
+    scan_iterator_counters) {
+  const auto bs = gen_bitmap(1ull << 16, 2);
+  dtl::teb_wrapper enc(bs);
+  auto& stats = dtl::teb_stats::local();
+  stats.reset();
+  std::size_t bit_cnt = 0;
+  std::size_t run_cnt = 0;
+  auto it = enc.scan_it();
+  while (!it.end()) {
+    bit_cnt += it.length();
+    ++run_cnt;
+    it.next();
+  }
+  ASSERT_EQ(bit_cnt, bs.count());
+  if (stats_enabled && stats.default_iter_fallbacks == 0) {
+    ASSERT_GT(stats.batches, 0);
+    // Runs that span multiple batches are merged by the iterator.
+    ASSERT_GE(stats.batch_runs, run_cnt);
+  }
+  if (!stats_enabled) {
+    ASSERT_EQ(stats.batches, 0);
+  }
+}
+//===----------------------------------------------------------------------===//
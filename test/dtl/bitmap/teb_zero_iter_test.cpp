@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+
+#include <dtl/bitmap/teb_wrapper.hpp>
+#include <dtl/bitmap/util/random_runs.hpp>
+#include <dtl/dtl.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <random>
+//===----------------------------------------------------------------------===//
+// Tests the TEB 0-run iterator, which produces the 0-fills of a TEB. The
+// 0-fills are validated against the complement of the original bitmap.
+//===----------------------------------------------------------------------===//
+/// Returns the position of the first 0-bit at or after the given position, or
+/// the bitmap length if there is none.
+static std::size_t
+find_zero_from(const boost::dynamic_bitset<$u32>& bs, std::size_t pos) {
+  for (std::size_t i = pos; i < bs.size(); ++i) {
+    if (!bs[i]) return i;
+  }
+  return bs.size();
+}
+//===----------------------------------------------------------------------===//
+/// Iterates over the 0-fills, using (random) skips if max_distance > 0.
+static void
+zero_iter_test(const boost::dynamic_bitset<$u32>& bs, std::size_t max_distance,
+    $u32 seed) {
+  dtl::teb_wrapper enc(bs);
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<std::size_t> distance(1, max_distance + 1);
+  boost::dynamic_bitset<$u32> zeros(bs.size());
+  auto it = enc.zero_it();
+  std::size_t expected_pos = find_zero_from(bs, 0);
+  while (true) {
+    ASSERT_EQ(it.end(), expected_pos == bs.size());
+    if (it.end()) break;
+    ASSERT_EQ(it.pos(), expected_pos);
+    ASSERT_GT(it.length(), 0);
+    ASSERT_LE(it.pos() + it.length(), bs.size());
+    for (std::size_t i = it.pos(); i < it.pos() + it.length(); ++i) {
+      ASSERT_FALSE(bs[i]) << "pos=" << i;
+      zeros[i] = true;
+    }
+    if (max_distance == 0 || gen() % 2 == 0) {
+      expected_pos = find_zero_from(bs, it.pos() + it.length());
+      it.next();
+    }
+    else {
+      const auto to_pos = it.pos() + distance(gen);
+      expected_pos = find_zero_from(bs, to_pos);
+      it.skip_to(to_pos);
+    }
+  }
+  if (max_distance == 0) {
+    ASSERT_EQ(zeros, ~bs);
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(teb_zero_iter,
+    all_and_no_bits_set) {
+  for (auto n : { 64ull, 1000ull, 1ull << 16 }) {
+    boost::dynamic_bitset<$u32> bs(n);
+    zero_iter_test(bs, 0, 1);
+    bs.set();
+    zero_iter_test(bs, 0, 1);
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(teb_zero_iter,
+    next) {
+  for (auto n : { 1ull << 10, 12345ull, 1ull << 16 }) {
+    for (auto d : { 0.01, 0.1, 0.5, 0.9 }) {
+      for (auto f : { 2.0, 8.0, 64.0 }) {
+        if (d / (1.0 - d) > f) continue;
+        zero_iter_test(dtl::gen_random_bitmap_markov_runs(n, f, d, 42), 0, 1);
+      }
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(teb_zero_iter,
+    skip_to) {
+  for (auto n : { 1ull << 10, 12345ull, 1ull << 16 }) {
+    for (auto d : { 0.01, 0.1, 0.5, 0.9 }) {
+      for (auto f : { 2.0, 8.0, 64.0 }) {
+        if (d / (1.0 - d) > f) continue;
+        const auto bs = dtl::gen_random_bitmap_markov_runs(n, f, d, 7);
+        zero_iter_test(bs, 16, 1);
+        zero_iter_test(bs, 1024, 2);
+        zero_iter_test(bs, n / 4, 3);
+      }
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
@@ -9,6 +9,7 @@
 
 #include <dtl/bitmap/util/plain_bitmap.hpp>
 #include <chrono>
+#include <random>
 //===----------------------------------------------------------------------===//
 TEST(bitmap_fun,
     fetch_words) {
@@ -397,3 +398,183 @@ TEST(bitmap_fun,
   ASSERT_EQ(2, bm.find_next_zero(0, bm.size()));
 }
 //===----------------------------------------------------------------------===//
+TEST(bitmap_fun,
+    bitwise_operations) {
+  using bmf = dtl::bitmap_fun<$u8>;
+  std::mt19937 gen(42);
+  // Odd word counts, to test the remainders of the vectorized kernels.
+  for (std::size_t word_cnt : {0, 1, 31, 33, 64, 127, 20000}) {
+    std::vector<$u8> a(word_cnt), b(word_cnt), dst(word_cnt);
+    for (std::size_t i = 0; i < word_cnt; ++i) {
+      a[i] = static_cast<$u8>(gen());
+      b[i] = static_cast<$u8>(gen());
+    }
+    bmf::bitwise_and(dst.data(), dst.data() + word_cnt,
+        a.data(), a.data() + word_cnt, b.data(), b.data() + word_cnt);
+    for (std::size_t i = 0; i < word_cnt; ++i) {
+      ASSERT_EQ($u8(a[i] & b[i]), dst[i]);
+    }
+    bmf::bitwise_or(dst.data(), dst.data() + word_cnt,
+        a.data(), a.data() + word_cnt, b.data(), b.data() + word_cnt);
+    for (std::size_t i = 0; i < word_cnt; ++i) {
+      ASSERT_EQ($u8(a[i] | b[i]), dst[i]);
+    }
+    bmf::bitwise_xor(dst.data(), dst.data() + word_cnt,
+        a.data(), a.data() + word_cnt, b.data(), b.data() + word_cnt);
+    for (std::size_t i = 0; i < word_cnt; ++i) {
+      ASSERT_EQ($u8(a[i] ^ b[i]), dst[i]);
+    }
+    bmf::bitwise_and_not(dst.data(), dst.data() + word_cnt,
+        a.data(), a.data() + word_cnt, b.data(), b.data() + word_cnt);
+    for (std::size_t i = 0; i < word_cnt; ++i) {
+      ASSERT_EQ($u8(a[i] & ~b[i]), dst[i]);
+    }
+    bmf::bitwise_not(dst.data(), dst.data() + word_cnt,
+        a.data(), a.data() + word_cnt);
+    for (std::size_t i = 0; i < word_cnt; ++i) {
+      ASSERT_EQ($u8(~a[i]), dst[i]);
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(bitmap_fun,
+    fused_bitwise_operations) {
+  using bmf = dtl::bitmap_fun<$u64>;
+  constexpr u8 a_and_b_and_not_c =
+      u8(bmf::ternary_a & bmf::ternary_b & ~bmf::ternary_c);
+  constexpr u8 a_or_b_xor_c =
+      u8(bmf::ternary_a | (bmf::ternary_b ^ bmf::ternary_c));
+  std::mt19937_64 gen(42);
+  for (std::size_t word_cnt : {1, 7, 8, 9, 5000}) {
+    std::vector<std::vector<$u64>> operands(7, std::vector<$u64>(word_cnt));
+    for (auto& op : operands) {
+      for (auto& w : op) {
+        w = gen();
+      }
+    }
+    const auto& a = operands[0];
+    const auto& b = operands[1];
+    const auto& c = operands[2];
+    std::vector<$u64> dst(word_cnt);
+    bmf::bitwise_ternary<a_and_b_and_not_c>(dst.data(), dst.data() + word_cnt,
+        a.data(), b.data(), c.data());
+    for (std::size_t i = 0; i < word_cnt; ++i) {
+      ASSERT_EQ(a[i] & b[i] & ~c[i], dst[i]);
+    }
+    bmf::bitwise_ternary<a_or_b_xor_c>(dst.data(), dst.data() + word_cnt,
+        a.data(), b.data(), c.data());
+    for (std::size_t i = 0; i < word_cnt; ++i) {
+      ASSERT_EQ(a[i] | (b[i] ^ c[i]), dst[i]);
+    }
+
+    // n-ary operations, in-place.
+    for (std::size_t operand_cnt = 1; operand_cnt <= operands.size();
+         ++operand_cnt) {
+      std::vector<const $u64*> ptrs;
+      for (std::size_t k = 0; k < operand_cnt; ++k) {
+        ptrs.push_back(operands[k].data());
+      }
+      std::vector<$u64> and_res(a), or_res(a), xor_res(a);
+      ptrs[0] = and_res.data();
+      bmf::bitwise_and_n(and_res.data(), and_res.data() + word_cnt,
+          ptrs.data(), operand_cnt);
+      ptrs[0] = or_res.data();
+      bmf::bitwise_or_n(or_res.data(), or_res.data() + word_cnt,
+          ptrs.data(), operand_cnt);
+      ptrs[0] = xor_res.data();
+      bmf::bitwise_xor_n(xor_res.data(), xor_res.data() + word_cnt,
+          ptrs.data(), operand_cnt);
+      for (std::size_t i = 0; i < word_cnt; ++i) {
+        $u64 expected_and = a[i];
+        $u64 expected_or = a[i];
+        $u64 expected_xor = a[i];
+        for (std::size_t k = 1; k < operand_cnt; ++k) {
+          expected_and &= operands[k][i];
+          expected_or |= operands[k][i];
+          expected_xor ^= operands[k][i];
+        }
+        ASSERT_EQ(expected_and, and_res[i]);
+        ASSERT_EQ(expected_or, or_res[i]);
+        ASSERT_EQ(expected_xor, xor_res[i]);
+      }
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(bitmap_fun,
+    plain_bitmap_operations) {
+  using bitmap_t = dtl::plain_bitmap<$u64>;
+  using bmf = dtl::bitmap_fun<$u64>;
+  constexpr u8 a_and_b_and_not_c =
+      u8(bmf::ternary_a & bmf::ternary_b & ~bmf::ternary_c);
+  constexpr u8 a_or_b_xor_c =
+      u8(bmf::ternary_a | (bmf::ternary_b ^ bmf::ternary_c));
+  std::mt19937_64 gen(42);
+  for (std::size_t n : {64, 1000, 65536 + 17}) {
+    std::vector<bitmap_t> bms(5, bitmap_t(n, false));
+    for (auto& bm : bms) {
+      for (std::size_t i = 0; i < n; ++i) {
+        if (gen() % 3 == 0) bm.set(i);
+      }
+    }
+    const auto& a = bms[0];
+    const auto& b = bms[1];
+    const auto& c = bms[2];
+    // Validates the given bitmap against the given reference function.
+    auto validate = [&](const bitmap_t& actual, auto ref_fn) {
+      ASSERT_EQ(n, actual.size());
+      for (std::size_t i = 0; i < n; ++i) {
+        ASSERT_EQ(ref_fn(i), actual.test(i)) << "n=" << n << ", i=" << i;
+      }
+    };
+
+    bitmap_t r = a;
+    r &= b;
+    validate(r, [&](std::size_t i) { return a.test(i) && b.test(i); });
+    r = a;
+    r |= b;
+    validate(r, [&](std::size_t i) { return a.test(i) || b.test(i); });
+    r = a;
+    r ^= b;
+    validate(r, [&](std::size_t i) { return a.test(i) != b.test(i); });
+
+    validate(bitmap_t::ternary<a_and_b_and_not_c>(a, b, c),
+        [&](std::size_t i) { return a.test(i) && b.test(i) && !c.test(i); });
+    validate(bitmap_t::ternary<a_or_b_xor_c>(a, b, c),
+        [&](std::size_t i) { return a.test(i) || (b.test(i) != c.test(i)); });
+    r = a;
+    r.ternary_assign<a_and_b_and_not_c>(b, c);
+    validate(r,
+        [&](std::size_t i) { return a.test(i) && b.test(i) && !c.test(i); });
+
+    // n-ary operations, in-place.
+    const std::vector<const bitmap_t*> others { &bms[1], &bms[2], &bms[3],
+        &bms[4] };
+    r = a;
+    r.and_assign(others);
+    validate(r, [&](std::size_t i) {
+      $u1 ret = a.test(i);
+      for (auto* o : others) ret = ret && o->test(i);
+      return ret;
+    });
+    r = a;
+    r.or_assign(others);
+    validate(r, [&](std::size_t i) {
+      $u1 ret = a.test(i);
+      for (auto* o : others) ret = ret || o->test(i);
+      return ret;
+    });
+    r = a;
+    r.xor_assign(others);
+    validate(r, [&](std::size_t i) {
+      $u1 ret = a.test(i);
+      for (auto* o : others) ret = ret != o->test(i);
+      return ret;
+    });
+    // No other operands.
+    r = a;
+    r.and_assign({});
+    validate(r, [&](std::size_t i) { return a.test(i); });
+  }
+}
+//===----------------------------------------------------------------------===//
@@ -0,0 +1,249 @@
+#include "gtest/gtest.h"
+
+#include <dtl/bitmap/util/bitmap_tree.hpp>
+#include <dtl/bitmap/util/random_runs.hpp>
+#include <dtl/dtl.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Tests the construction of bitmap trees against straightforward reference
+// implementations.
+//===----------------------------------------------------------------------===//
+using bitset_t = boost::dynamic_bitset<$u32>;
+//===----------------------------------------------------------------------===//
+/// Gives access to the individual construction steps of the bitmap tree.
+class bitmap_tree_under_test : public dtl::bitmap_tree<3> {
+  using super = dtl::bitmap_tree<3>;
+
+public:
+  /// Initializes a perfect binary tree on top of the given bitmap.
+  explicit bitmap_tree_under_test(const bitset_t& bitmap)
+      : super(bitmap.size()) {
+    init_tree(bitmap);
+    uncompressed_size = estimate_encoded_size_in_bytes();
+  }
+
+  using super::init_bottom_levels;
+  using super::init_labels;
+  using super::prune_tree;
+  using super::init_counters;
+  using super::run_optimize;
+
+  /// Gradual decompression (reference implementation). The expansions are
+  /// applied to a copy of the tree, which is discarded afterwards. The tree
+  /// instance with the minimum size is then re-constructed from the original
+  /// tree.
+  void
+  run_optimize_reference() {
+    auto min_idx = explicit_node_idxs_.begin;
+    auto min_level = level_of(min_idx);
+    auto min_size = estimate_encoded_size_in_bytes();
+    const std::size_t threshold = std::max(1024ul, uncompressed_size / 10);
+    auto cpy = *this; // Work with a copy.
+
+    {
+      u64 start_idx = cpy.explicit_node_idxs_.begin;
+      $u64 idx = cpy.explicit_node_idxs_.begin;
+      $u64 prev_idx = 0;
+      $u64 idx_level = cpy.level_of(idx);
+      u64 last_pruning_level = last_level();
+      $u64 old_level = idx_level;
+      auto prev_level_size = cpy.estimate_encoded_size_in_bytes();
+      while (idx_level < last_pruning_level
+          && !(min_level + 2 < idx_level)) {
+        if (idx_level > old_level) {
+          {
+            auto now_size = cpy.estimate_encoded_size_in_bytes();
+            if (now_size > prev_level_size && old_level != min_level) {
+              goto expand_done;
+            }
+            prev_level_size = now_size;
+          }
+          old_level = idx_level;
+          if (idx_level < cpy.last_level()) {
+            auto last_explicit_node = cpy.explicit_node_idxs_.end - 1;
+            auto level_of_last_explicit_node =
+                cpy.level_of(last_explicit_node);
+            if (level_of_last_explicit_node == idx_level + 1) {
+              auto parent_of_last_explicit_node =
+                  cpy.parent_of(level_of_last_explicit_node);
+              auto x_b = cpy.first_node_idx_at_level(idx_level);
+              auto x_e = parent_of_last_explicit_node;
+              auto y_b = parent_of_last_explicit_node + 1;
+              auto y_e = cpy.first_node_idx_at_level(idx_level + 1);
+              i64 x_ones = cpy.is_inner_node_.count(x_b + offset, x_e + offset);
+              i64 x_zeros = (x_e - x_b) - x_ones;
+              i64 y_ones = cpy.is_inner_node_.count(y_b + offset, y_e + offset);
+              i64 y_zeros = (y_e - y_b) - y_ones;
+              auto r = -(x_zeros + y_zeros) + 2 * x_zeros - (x_ones + y_ones);
+              if (r > 0) {
+                goto expand_done;
+              }
+            }
+            else {
+              auto b = cpy.first_node_idx_at_level(idx_level);
+              auto e = cpy.first_node_idx_at_level(idx_level + 1);
+              auto ones = cpy.is_inner_node_.count(b + offset, e + offset);
+              auto zeros = (e - b) - ones;
+              if (zeros / 2 > ones) {
+                goto expand_done;
+              }
+            }
+          }
+        }
+
+        cpy.set_inner<true>(idx);
+        const auto compressed_size = cpy.estimate_encoded_size_in_bytes();
+        if (compressed_size <= min_size) {
+          min_idx = idx;
+          min_level = cpy.level_of(idx);
+          min_size = compressed_size;
+        }
+        if (compressed_size > min_size + threshold) {
+          goto expand_done;
+        }
+        if (cpy.explicit_node_idxs_.begin > cpy.explicit_node_idxs_.end) {
+          goto tree_implicit;
+        }
+        prev_idx = idx;
+        idx = cpy.explicit_node_idxs_.begin;
+        idx_level = cpy.level_of(idx);
+      }
+
+      if (min_idx == prev_idx) {
+        *this = cpy;
+        is_active_node_.set(start_idx + offset,
+            std::min(max_node_cnt_, right_child_of(idx) + 1) + offset);
+        return;
+      }
+      goto expand_done;
+
+tree_implicit:
+      *this = cpy;
+      is_active_node_.set(start_idx + offset,
+          std::min(max_node_cnt_, right_child_of(idx) + 1) + offset);
+      return;
+
+expand_done:
+      if (min_size > uncompressed_size) {
+        uncompress();
+        return;
+      }
+    }
+
+    {
+      const auto start_idx = explicit_node_idxs_.begin;
+      const std::size_t expand_until_idx =
+          std::min(first_node_idx_at_level(height_) - 1, min_idx);
+      while (explicit_node_idxs_.begin <= expand_until_idx) {
+        set_inner<true>(explicit_node_idxs_.begin);
+      }
+      is_active_node_.set(start_idx + offset,
+          std::min(max_node_cnt_, right_child_of(expand_until_idx) + 1)
+              + offset);
+    }
+  }
+
+  /// Returns the counters, which are required to estimate the TEB size.
+  std::vector<std::size_t>
+  counters() {
+    return {
+        get_inner_node_cnt(),
+        get_leading_inner_node_cnt(),
+        get_trailing_leaf_node_cnt(),
+        get_first_explicit_node_idx(),
+        get_last_explicit_node_idx(),
+        get_leading_0label_cnt(),
+        get_trailing_0label_cnt(),
+        get_first_node_idx_with_1label(),
+        get_last_node_idx_with_1label(),
+        estimate_encoded_size_in_bytes() };
+  }
+};
+//===----------------------------------------------------------------------===//
+/// Compares the structure, the labels and the counters of the given trees.
+static void
+assert_equal(bitmap_tree_under_test& expected, bitmap_tree_under_test& actual,
+    const std::string& info) {
+  ASSERT_TRUE(expected.is_inner_node_ == actual.is_inner_node_) << info;
+  ASSERT_TRUE(expected.is_active_node_ == actual.is_active_node_) << info;
+  ASSERT_TRUE(expected.labels_ == actual.labels_) << info;
+  ASSERT_EQ(expected.counters(), actual.counters()) << info;
+}
+//===----------------------------------------------------------------------===//
+/// Iterates over the bitmaps under test.
+template<typename fn_t>
+static void
+for_each_bitmap(fn_t fn, const std::vector<$u64>& ns = { 8ull, 64ull, 100ull,
+                             1000ull, 4096ull, 12345ull, 1ull << 16,
+                             (1ull << 17) + 5 }) {
+  $u64 seed = 1;
+  for (auto n : ns) {
+    for (auto d : { 0.0, 0.0001, 0.001, 0.01, 0.1, 0.3, 0.5, 0.9, 0.99, 1.0 }) {
+      for (auto f : { 1.0, 1.5, 4.0, 16.0, 64.0, 1024.0 }) {
+        if (d < 1.0 && d / (1.0 - d) > f) continue;
+        std::stringstream info;
+        info << "n=" << n << ", f=" << f << ", d=" << d;
+        fn(dtl::gen_random_bitmap_markov_runs(n, f, d, seed++), info.str());
+      }
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(bitmap_tree,
+    run_optimize_in_place) {
+  // The gradual decompression is applied in place. The resulting tree needs
+  // to be identical to the one obtained by working with a copy.
+  for_each_bitmap([](const bitset_t& bs, const std::string& info) {
+    bitmap_tree_under_test expected(bs);
+    expected.init_labels();
+    expected.prune_tree();
+    expected.init_counters();
+    bitmap_tree_under_test actual = expected;
+
+    expected.run_optimize_reference();
+    actual.run_optimize();
+    assert_equal(expected, actual, info);
+  });
+}
+//===----------------------------------------------------------------------===//
+TEST(bitmap_tree,
+    init_bottom_levels) {
+  // The fused construction of the bottom levels followed by the level-wise
+  // construction of the remaining levels needs to result in the same tree as
+  // the level-wise construction of all levels.
+  std::vector<$u64> ns;
+  for (std::size_t h = 1; h <= 17; ++h) {
+    ns.push_back(1ull << h);
+  }
+  ns.push_back(1000);
+  ns.push_back((1ull << 17) + 5);
+  std::size_t terminated_cnt = 0;
+  std::size_t not_terminated_cnt = 0;
+  for_each_bitmap([&](const bitset_t& bs, const std::string& info) {
+    bitmap_tree_under_test expected(bs);
+    expected.init_labels();
+    expected.prune_tree();
+    expected.init_counters();
+
+    bitmap_tree_under_test actual(bs);
+    $u1 pruning_terminated = false;
+    const auto level = actual.init_bottom_levels(pruning_terminated);
+    actual.init_labels(level);
+    if (!pruning_terminated) {
+      actual.prune_tree(level);
+    }
+    actual.init_counters();
+    assert_equal(expected, actual, info);
+    ++(pruning_terminated ? terminated_cnt : not_terminated_cnt);
+  },
+      ns);
+  // Both cases need to be covered.
+  ASSERT_GT(terminated_cnt, 0);
+  ASSERT_GT(not_terminated_cnt, 0);
+}
+//===----------------------------------------------------------------------===//
@@ -0,0 +1,124 @@
+#include "gtest/gtest.h"
+
+#include <dtl/bitmap/util/plain_bitmap.hpp>
+#include <dtl/bitmap/util/popcount.hpp>
+#include <dtl/dtl.hpp>
+
+#include <random>
+#include <vector>
+//===----------------------------------------------------------------------===//
+namespace {
+/// Reference implementation.
+std::size_t
+popcount_ref(const $u64* a, const $u64* b, std::size_t word_cnt) {
+  std::size_t cnt = 0;
+  for (std::size_t i = 0; i < word_cnt; ++i) {
+    cnt += __builtin_popcountll(b == nullptr ? a[i] : a[i] & b[i]);
+  }
+  return cnt;
+}
+
+/// Returns the popcount kernels supported by the current CPU.
+std::vector<dtl::popcount::kernel_fn>
+supported_kernels() {
+  std::vector<dtl::popcount::kernel_fn> ret { &dtl::popcount::count_x86 };
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    ret.push_back(&dtl::popcount::count_avx2);
+  }
+  if (__builtin_cpu_supports("avx512vpopcntdq")) {
+    ret.push_back(&dtl::popcount::count_avx512);
+  }
+  return ret;
+}
+
+/// Returns the block-wise popcount kernels supported by the current CPU.
+std::vector<dtl::popcount::block_kernel_fn>
+supported_block_kernels() {
+  std::vector<dtl::popcount::block_kernel_fn> ret {
+      &dtl::popcount::block_count_x86 };
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512vpopcntdq")) {
+    ret.push_back(&dtl::popcount::block_count_avx512);
+  }
+  return ret;
+}
+} // anonymous namespace
+//===----------------------------------------------------------------------===//
+TEST(popcount, kernels) {
+  std::mt19937_64 gen(42);
+  // Includes sizes that are not a multiple of the Harley-Seal block size.
+  for (std::size_t word_cnt : {0, 1, 3, 4, 15, 16, 63, 64, 65, 1000, 4099}) {
+    std::vector<$u64> a(word_cnt), b(word_cnt);
+    for (std::size_t i = 0; i < word_cnt; ++i) {
+      a[i] = gen();
+      b[i] = gen();
+    }
+    for (auto kernel : supported_kernels()) {
+      ASSERT_EQ(popcount_ref(a.data(), nullptr, word_cnt),
+          kernel(a.data(), nullptr, word_cnt));
+      ASSERT_EQ(popcount_ref(a.data(), b.data(), word_cnt),
+          kernel(a.data(), b.data(), word_cnt));
+    }
+    ASSERT_EQ(popcount_ref(a.data(), nullptr, word_cnt),
+        dtl::popcount::count(a.data(), word_cnt));
+    ASSERT_EQ(popcount_ref(a.data(), b.data(), word_cnt),
+        dtl::popcount::and_count(a.data(), b.data(), word_cnt));
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(popcount, block_count) {
+  std::mt19937_64 gen(42);
+  // The AVX-512 kernel processes batches of eight blocks, if the block size is
+  // a multiple of eight words, and falls back to the scalar kernel otherwise.
+  for (std::size_t words_per_block : {1, 3, 4, 8, 16, 24}) {
+    for (std::size_t word_cnt : {0, 1, 8, 9, 63, 64, 65, 100, 1024, 1031}) {
+      std::vector<$u64> data(word_cnt);
+      for (auto& w : data) w = gen();
+      const std::size_t block_cnt =
+          (word_cnt + words_per_block - 1) / words_per_block;
+      std::vector<$u32> expected_lut(block_cnt);
+      for (std::size_t i = 0; i < block_cnt; ++i) {
+        expected_lut[i] = static_cast<$u32>(
+            popcount_ref(data.data(), nullptr, i * words_per_block));
+      }
+      const auto expected_total =
+          popcount_ref(data.data(), nullptr, word_cnt);
+      for (auto kernel : supported_block_kernels()) {
+        std::vector<$u32> lut(block_cnt);
+        ASSERT_EQ(expected_total,
+            kernel(data.data(), word_cnt, words_per_block, lut.data()));
+        ASSERT_EQ(expected_lut, lut);
+      }
+      std::vector<$u32> lut(block_cnt);
+      ASSERT_EQ(expected_total, dtl::popcount::block_count(
+          data.data(), word_cnt, words_per_block, lut.data()));
+      ASSERT_EQ(expected_lut, lut);
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(popcount, plain_bitmap_range_count) {
+  std::mt19937_64 gen(42);
+  const std::size_t n = 3000;
+  dtl::plain_bitmap<$u64> a(n, false), b(n, false);
+  for (std::size_t i = 0; i < n; ++i) {
+    if (gen() % 3 == 0) a.set(i);
+    if (gen() % 2 == 0) b.set(i);
+  }
+  for (std::size_t rep = 0; rep < 1000; ++rep) {
+    std::size_t begin = gen() % (n + 1);
+    std::size_t end = gen() % (n + 1);
+    if (begin > end) std::swap(begin, end);
+    std::size_t expected_cnt = 0;
+    std::size_t expected_and_cnt = 0;
+    for (std::size_t i = begin; i < end; ++i) {
+      expected_cnt += a.test(i);
+      expected_and_cnt += a.test(i) && b.test(i);
+    }
+    ASSERT_EQ(expected_cnt, a.count(begin, end));
+    ASSERT_EQ(expected_and_cnt, a.and_count(b, begin, end));
+  }
+  ASSERT_EQ((a & b).count(), a.and_count(b));
+}
+//===----------------------------------------------------------------------===//
@@ -0,0 +1,118 @@
+#include "gtest/gtest.h"
+
+#include <dtl/bitmap/util/random_runs.hpp>
+#include <dtl/dtl.hpp>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <vector>
+//===----------------------------------------------------------------------===//
+// Tests the run-length-based generation of random bitmaps.
+//===----------------------------------------------------------------------===//
+using bitset_t = boost::dynamic_bitset<$u32>;
+//===----------------------------------------------------------------------===//
+/// Returns the lengths of the 1-runs in the given bitmap.
+static std::vector<$u64>
+one_run_lengths(const bitset_t& bs) {
+  std::vector<$u64> ret;
+  $u64 length = 0;
+  for (std::size_t i = 0; i < bs.size(); ++i) {
+    if (bs[i]) {
+      ++length;
+    }
+    else if (length > 0) {
+      ret.push_back(length);
+      length = 0;
+    }
+  }
+  if (length > 0) ret.push_back(length);
+  return ret;
+}
+//===----------------------------------------------------------------------===//
+TEST(random_runs,
+    markov_parameters) {
+  for (auto n : { 1000ull, 12345ull, 1ull << 20, (1ull << 20) + 123 }) {
+    for (auto d : { 0.001, 0.01, 0.1, 0.5, 0.9 }) {
+      for (auto f : { 1.0, 1.5, 8.0, 64.0 }) {
+        if (d / (1.0 - d) > f) continue;
+        std::stringstream info;
+        info << "n=" << n << ", f=" << f << ", d=" << d;
+        const auto bs = dtl::gen_random_bitmap_markov_runs(n, f, d, 42,
+            1, 1ull << 16);
+        ASSERT_EQ(bs.size(), n) << info.str();
+        const auto one_cnt = bs.count();
+        ASSERT_EQ(one_cnt, static_cast<std::size_t>(std::llround(n * d)))
+            << info.str();
+        // The number of 1-runs can only be off due to rounding.
+        const auto runs = one_run_lengths(bs);
+        const auto expected_run_cnt = one_cnt / f;
+        ASSERT_LE(std::abs(runs.size() - expected_run_cnt),
+            std::max(1.0, 0.02 * expected_run_cnt)) << info.str();
+      }
+    }
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(random_runs,
+    run_length_distribution) {
+  // The lengths of the 1-runs follow a geometric distribution with mean f.
+  u64 n = 1ull << 22;
+  f64 f = 8.0;
+  f64 d = 0.25;
+  const auto bs = dtl::gen_random_bitmap_markov_runs(n, f, d, 1);
+  const auto runs = one_run_lengths(bs);
+  std::vector<$u64> histogram(4, 0);
+  for (auto l : runs) {
+    if (l <= histogram.size()) ++histogram[l - 1];
+  }
+  for (std::size_t l = 1; l <= histogram.size(); ++l) {
+    f64 expected = runs.size() * std::pow(1.0 - 1.0 / f, l - 1) / f;
+    ASSERT_NEAR(histogram[l - 1], expected, 0.05 * expected) << "l=" << l;
+  }
+}
+//===----------------------------------------------------------------------===//
+TEST(random_runs,
+    deterministic) {
+  u64 n = (1ull << 22) + 77;
+  const auto a = dtl::gen_random_bitmap_markov_runs(n, 4.0, 0.1, 7, 1);
+  const auto b = dtl::gen_random_bitmap_markov_runs(n, 4.0, 0.1, 7, 4);
+  const auto c = dtl::gen_random_bitmap_markov_runs(n, 4.0, 0.1, 8, 4);
+  ASSERT_EQ(a, b);
+  ASSERT_NE(a, c);
+}
+//===----------------------------------------------------------------------===//
+TEST(random_runs,
+    uniform) {
+  u64 n = 1ull << 20;
+  for (auto d : { 0.0, 0.0001, 0.01, 0.25, 0.5, 0.75, 0.99, 1.0 }) {
+    const auto bs = dtl::gen_random_bitmap_uniform_runs(n, d, 3, 2);
+    ASSERT_EQ(bs.size(), n);
+    if (d == 0.0 || d == 1.0) {
+      ASSERT_EQ(bs.count(), static_cast<std::size_t>(n * d));
+      continue;
+    }
+    // Each bit is set independently with probability d. Thus, the number of
+    // 1-bits follows a binomial distribution.
+    const auto sigma = std::sqrt(n * d * (1 - d));
+    ASSERT_NEAR(bs.count(), n * d, 5 * sigma) << "d=" << d;
+    // The expected number of 1-runs is n*d*(1-d) (ignoring the boundary).
+    const auto run_cnt = one_run_lengths(bs).size();
+    ASSERT_NEAR(run_cnt, n * d * (1 - d), 5 * sigma + 1) << "d=" << d;
+  }
+  // The number of 1-bits is not fixed, i.e., different seeds result in
+  // different counts.
+  std::vector<std::size_t> counts;
+  for ($u64 seed = 0; seed < 8; ++seed) {
+    counts.push_back(
+        dtl::gen_random_bitmap_uniform_runs(n, 0.1, seed).count());
+  }
+  std::sort(counts.begin(), counts.end());
+  ASSERT_NE(counts.front(), counts.back());
+  // The result depends only on the seed.
+  ASSERT_EQ(dtl::gen_random_bitmap_uniform_runs(n, 0.3, 5, 1, 1ull << 16),
+      dtl::gen_random_bitmap_uniform_runs(n, 0.3, 5, 4, 1ull << 16));
+}
+//===----------------------------------------------------------------------===//
@@ -148,3 +148,34 @@ TYPED_TEST(xah_test, run_iterator_test) {
   }
 }
 //===----------------------------------------------------------------------===//
+/// Test the construction from a sorted list of positions.
+template<typename T>
+void
+construct_from_positions_test() {
+  const auto LEN = 12;
+  for (auto i = 0; i < (1u << LEN); ++i) {
+    dtl::bitmap b(LEN, i);
+    std::vector<$u32> positions;
+    for (std::size_t k = 0; k < LEN; ++k) {
+      if (b[k]) positions.push_back(static_cast<$u32>(k));
+    }
+    T expected(b);
+    T enc(positions.data(), positions.size(), LEN);
+    ASSERT_EQ(expected.size_in_bytes(), enc.size_in_bytes());
+    ASSERT_EQ(b, dtl::to_bitmap_using_iterator(enc))
+        << "Construction failed for i=" << i
+        << ". - '" << b << "'\n"
+        << enc
+        << std::endl;
+  }
+}
+
+TEST(xah_test, construct_from_positions) {
+  construct_from_positions_test<dtl::uah8>();
+  construct_from_positions_test<dtl::uah64>();
+  construct_from_positions_test<dtl::uah_skip<u32, 1>>();
+  construct_from_positions_test<dtl::xah8>();
+  construct_from_positions_test<dtl::xah32>();
+  construct_from_positions_test<dtl::xah_skip<u16, 1>>();
+}
+//===----------------------------------------------------------------------===//
@@ -0,0 +1,189 @@
+#include "gtest/gtest.h"
+
+#include "experiments/util/dataset_store.hpp"
+
+#include <dtl/bitmap.hpp>
+#include <dtl/bitmap/util/random.hpp>
+#include <dtl/bitmap/util/random_runs.hpp>
+#include <dtl/dtl.hpp>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+//===----------------------------------------------------------------------===//
+// Tests the binary dataset store of the experiments.
+//===----------------------------------------------------------------------===//
+using kind = dataset_store::kind;
+//===----------------------------------------------------------------------===//
+/// Returns the name of a temporary (non-existing) file.
+static std::string
+tmp_file(const std::string& name) {
+  const auto file = "/tmp/dataset_store_test_" + std::to_string(::getpid())
+      + "_" + name;
+  std::remove(file.c_str());
+  return file;
+}
+//===----------------------------------------------------------------------===//
+/// Returns the size of the given file in bytes.
+static std::size_t
+file_size(const std::string& file) {
+  FILE* fp = std::fopen(file.c_str(), "rb");
+  std::fseek(fp, 0, SEEK_END);
+  const auto size = static_cast<std::size_t>(std::ftell(fp));
+  std::fclose(fp);
+  return size;
+}
+//===----------------------------------------------------------------------===//
+TEST(dataset_store,
+    store_and_reopen) {
+  const auto file = tmp_file("reopen");
+  std::vector<dtl::bitmap> bitmaps;
+  std::vector<$i64> ids;
+  {
+    dataset_store store(file);
+    ASSERT_TRUE(store.empty());
+    for (std::size_t i = 0; i < 12; ++i) {
+      const auto n = 1000 + i * 77;
+      const auto f = 1.0 + (i % 2) * 3.0;
+      const auto d = 0.1 * (1 + i % 3);
+      bitmaps.push_back(dtl::gen_random_bitmap_markov_runs(n, f, d, i));
+      ids.push_back(store.store_bitmap(n, f, d, bitmaps.back()));
+      ASSERT_EQ(store.load_bitmap(ids.back()), bitmaps.back());
+    }
+  }
+  dataset_store store(file);
+  ASSERT_EQ(store.count(), bitmaps.size());
+  ASSERT_EQ(store.ids(), ids);
+  for (std::size_t i = 0; i < bitmaps.size(); ++i) {
+    ASSERT_EQ(store.load_bitmap(ids[i]), bitmaps[i]);
+    const auto& e = store.info(kind::bitmap, ids[i]);
+    ASSERT_EQ(e.n, bitmaps[i].size());
+    ASSERT_EQ(e.d_actual, dtl::determine_bit_density(bitmaps[i]));
+  }
+  // The catalog is rebuilt when the file is opened.
+  for (std::size_t i = 0; i < bitmaps.size(); ++i) {
+    const auto n = 1000 + i * 77;
+    const auto f = 1.0 + (i % 2) * 3.0;
+    const auto d = 0.1 * (1 + i % 3);
+    const auto found = store.find_bitmaps(n, f, d);
+    ASSERT_EQ(found.size(), 1);
+    ASSERT_EQ(found[0], ids[i]);
+  }
+  ASSERT_TRUE(store.find_bitmaps(1000, 2.0, 0.1).empty());
+  // New records get the next ID.
+  ASSERT_EQ(store.store_bitmap(bitmaps[0].size(), 1.0, 0.1, bitmaps[0]),
+      ids.back() + 1);
+  ASSERT_EQ(store.find_bitmaps(bitmaps[0].size(), 1.0, 0.1).size(), 2);
+  std::remove(file.c_str());
+}
+//===----------------------------------------------------------------------===//
+TEST(dataset_store,
+    truncated_tail) {
+  const auto file = tmp_file("truncated");
+  const auto b0 = dtl::gen_random_bitmap_markov_runs(5000, 4.0, 0.2, 1);
+  const auto b1 = dtl::gen_random_bitmap_markov_runs(7000, 4.0, 0.2, 2);
+  std::size_t size_after_first = 0;
+  {
+    dataset_store store(file);
+    store.import_bitmap(1, b0.size(), 4.0, 0.2, b0);
+    size_after_first = file_size(file);
+    store.import_bitmap(2, b1.size(), 4.0, 0.2, b1);
+  }
+  // Simulate a crash while the second record was written.
+  ASSERT_EQ(::truncate(file.c_str(), file_size(file) - 100), 0);
+  {
+    dataset_store store(file);
+    ASSERT_EQ(store.count(), 1);
+    ASSERT_TRUE(store.contains(kind::bitmap, 1));
+    ASSERT_FALSE(store.contains(kind::bitmap, 2));
+    ASSERT_EQ(store.load_bitmap(1), b0);
+    // The incomplete record is discarded.
+    ASSERT_EQ(file_size(file), size_after_first);
+    // Append a shorter record.
+    const auto b2 = dtl::gen_random_bitmap_markov_runs(100, 4.0, 0.2, 3);
+    store.import_bitmap(2, b2.size(), 4.0, 0.2, b2);
+  }
+  dataset_store store(file);
+  ASSERT_EQ(store.count(), 2);
+  ASSERT_EQ(store.load_bitmap(1), b0);
+  ASSERT_EQ(store.load_bitmap(2).size(), 100);
+  std::remove(file.c_str());
+}
+//===----------------------------------------------------------------------===//
+TEST(dataset_store,
+    zero_copy_views) {
+  const auto file = tmp_file("views");
+  dataset_store store(file);
+  for (auto n : { 1ull, 31ull, 32ull, 33ull, 100ull, 1000ull, 4096ull }) {
+    dtl::bitmap b(n);
+    b.set();
+    const auto id = store.store_bitmap(n, 0.0, 1.0, b);
+
+    const auto v32 = store.view_bitmap<$u32>(id);
+    ASSERT_EQ(v32.data_.size(), (n + 31) / 32);
+    const auto v64 = store.view_bitmap<$u64>(id);
+    ASSERT_EQ(v64.data_.size(), (n + 63) / 64);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(v64.data_.begin()) % 8, 0);
+    for (std::size_t i = 0; i < n; ++i) {
+      ASSERT_TRUE(v64.test(i));
+      ASSERT_TRUE(v32.test(i));
+    }
+    // The bits that exceed the length of the bitmap are zero.
+    for (std::size_t i = n; i < v64.data_.size() * 64; ++i) {
+      ASSERT_FALSE(v64.test(i)) << "n=" << n << ", i=" << i;
+    }
+  }
+  std::remove(file.c_str());
+}
+//===----------------------------------------------------------------------===//
+TEST(dataset_store,
+    sequences) {
+  const auto file = tmp_file("sequences");
+  const dataset_store::seq_t s0 { 1, 1, 2, 3, 3, 3, 0 };
+  const dataset_store::seq_t s1 { 7, 7, 7 };
+  {
+    dataset_store store(file);
+    ASSERT_EQ(store.store_sequence(s0.size(), 4, 2.0, s0), 1);
+    ASSERT_EQ(store.store_sequence(s1.size(), 8, 3.0, s1), 2);
+  }
+  dataset_store store(file);
+  ASSERT_EQ(store.count(kind::sequence), 2);
+  ASSERT_TRUE(store.empty(kind::bitmap));
+  ASSERT_EQ(store.load_sequence(1), s0);
+  const auto v = store.view_sequence(2);
+  ASSERT_EQ(dataset_store::seq_t(v.begin(), v.end()), s1);
+  ASSERT_EQ(store.find_sequences(s0.size(), 4, 2.0),
+      std::vector<$i64> { 1 });
+  ASSERT_TRUE(store.find_sequences(s0.size(), 4, 3.0).empty());
+  std::remove(file.c_str());
+}
+//===----------------------------------------------------------------------===//
+TEST(dataset_store,
+    mixed_kinds) {
+  // Bitmaps and sequences have separate ID spaces.
+  const auto file = tmp_file("mixed");
+  const auto b = dtl::gen_random_bitmap_markov_runs(1000, 4.0, 0.3, 1);
+  const dataset_store::seq_t s { 1, 2, 3 };
+  {
+    dataset_store store(file);
+    store.import_bitmap(1, b.size(), 4.0, 0.3, b);
+    store.import_sequence(1, s.size(), 3, 1.0, s);
+    ASSERT_THROW(store.import_bitmap(1, b.size(), 4.0, 0.3, b),
+        std::invalid_argument);
+  }
+  dataset_store store(file);
+  ASSERT_TRUE(store.contains(kind::bitmap, 1));
+  ASSERT_TRUE(store.contains(kind::sequence, 1));
+  ASSERT_FALSE(store.contains(kind::sequence, 2));
+  ASSERT_EQ(store.count(kind::bitmap), 1);
+  ASSERT_EQ(store.count(kind::sequence), 1);
+  ASSERT_EQ(store.load_bitmap(1), b);
+  ASSERT_EQ(store.load_sequence(1), s);
+  ASSERT_EQ(store.store_bitmap(b.size(), 4.0, 0.3, b), 2);
+  ASSERT_EQ(store.store_sequence(s.size(), 3, 1.0, s), 2);
+  ASSERT_THROW(store.load_sequence(3), std::runtime_error);
+  std::remove(file.c_str());
+}
+//===----------------------------------------------------------------------===//